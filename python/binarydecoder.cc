@@ -0,0 +1,482 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Decoder of complete binary FastRPC messages
+ * into Python objects.
+ *
+ */
+
+#include "binarydecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <frpcinternals.h>
+#include <frpcstreamerror.h>
+
+#include "fastrpcmodule.h"
+
+namespace FRPC { namespace Python {
+
+namespace {
+
+// the same limits as in BinUnMarshaller_t
+const uint64_t ELEMENT_SIZE_LIMIT = 1u << 30u;
+
+// deeper data are left to BinUnMarshaller_t which does not recurse
+const std::size_t MAX_DEPTH = 256;
+
+/** Thrown when the message is left to BinUnMarshaller_t. */
+struct Fallback_t {};
+
+class Depth_t {
+public:
+    explicit Depth_t(std::size_t &depth)
+        : depth(depth)
+    {
+        if (++depth > MAX_DEPTH) {
+            --depth;
+            throw Fallback_t();
+        }
+    }
+
+    ~Depth_t() {
+        --depth;
+    }
+
+private:
+    std::size_t &depth;
+};
+
+int64_t safeNegate(int64_t value) {
+    // see BinUnMarshaller_t, the minimum is kept as is
+    if (value == std::numeric_limits<int64_t>::min())
+        return value;
+    return -value;
+}
+
+int64_t zigzagDecode(int64_t s) {
+    auto n = static_cast<uint64_t>(s);
+    return static_cast<int64_t>((n >> 1u) ^ (-(s & 1)));
+}
+
+std::size_t getVersionedLengthSize(bool longer, unsigned char tag) {
+    if (longer) return (tag & 0x7u) + 1;
+    std::size_t size = (tag & 0x7u);
+    if (size == 0 || size > 4) {
+        throw StreamError_t("Illegal element length");
+    }
+    return size;
+}
+
+int64_t getInt64(const char *data, std::size_t size) {
+    uint64_t number = 0;
+#ifdef FRPC_BIG_ENDIAN
+    for (std::size_t i = size; i > 0; --i)
+        number = (number << 8u) | static_cast<unsigned char>(data[i - 1]);
+#else
+    memcpy(&number, data, size);
+#endif
+    return static_cast<int64_t>(number);
+}
+
+double getDouble(const char *data) {
+    double value = 0;
+#ifdef FRPC_BIG_ENDIAN
+    char tmp[8] = {
+        data[7], data[6], data[5], data[4], data[3], data[2], data[1], data[0]
+    };
+    memcpy(&value, tmp, sizeof(value));
+#else
+    memcpy(&value, data, sizeof(value));
+#endif
+    return value;
+}
+
+// needs 10 bytes of data
+DateTimeInternal_t getDateTime(const char *data) {
+    DateTimeInternal_t dateTime;
+    dateTime.year  = static_cast<uint16_t>((data[9] << 3) | ((data[8] & 0xe0) >> 5));
+    dateTime.month = static_cast<uint8_t>((data[8] & 0x1e) >> 1);
+    dateTime.day = static_cast<uint8_t>(((data[8] & 0x01) << 4) |(((data[7] & 0xf0) >> 4)));
+    dateTime.hour = static_cast<uint8_t>(((data[7] & 0x0f) << 1) | ((data[6] & 0x80) >> 7));
+    dateTime.minute = static_cast<uint8_t>(((data[6] & 0x7e) >> 1));
+    dateTime.sec = static_cast<uint8_t>(((data[6] & 0x01) << 5) | ((data[5] & 0xf8) >> 3));
+    dateTime.weekDay = static_cast<uint8_t>((data[5] & 0x07));
+    dateTime.unixTime = static_cast<int32_t>(getInt64(&data[1], 4));
+    dateTime.timeZone = data[0];
+    return dateTime;
+}
+
+// needs 14 bytes of data
+DateTimeInternal_t getDateTimeV3(const char *data) {
+    DateTimeInternal_t dateTime;
+    dateTime.year  = static_cast<uint16_t>((data[13] << 3) | ((data[12] & 0xe0) >> 5));
+    dateTime.month = static_cast<uint8_t>((data[12] & 0x1e) >> 1);
+    dateTime.day = static_cast<uint8_t>(((data[12] & 0x01) << 4) |(((data[11] & 0xf0) >> 4)));
+    dateTime.hour = static_cast<uint8_t>(((data[11] & 0x0f) << 1) | ((data[10] & 0x80) >> 7));
+    dateTime.minute = static_cast<uint8_t>(((data[10] & 0x7e) >> 1));
+    dateTime.sec = static_cast<uint8_t>(((data[10] & 0x01) << 5) | ((data[9] & 0xf8) >> 3));
+    dateTime.weekDay = (data[9] & 0x07);
+    int64_t time64 = getInt64(&data[1], 8);
+    dateTime.unixTime = time64;
+
+    if (sizeof(time_t) < sizeof(time64)) {
+        if (dateTime.unixTime != time64) {
+            throw StreamError_t(
+                        "time_t can't hold the received timestamp value");
+        }
+    }
+
+    dateTime.timeZone = data[0];
+    return dateTime;
+}
+
+/** Checks size of array or struct the same way as BinUnMarshaller_t. */
+std::size_t checkCount(int64_t count, const char *name, const char *tooLong)
+{
+    if (count < 0)
+        throw StreamError_t(std::string(name) + " entity invalid size");
+
+    if (count >> 32)
+        throw StreamError_t(tooLong);
+
+    if (static_cast<uint64_t>(count) >= ELEMENT_SIZE_LIMIT)
+        throw StreamError_t(std::string(name) + " entity too large");
+
+    return static_cast<std::size_t>(count);
+}
+
+} // namespace
+
+BinaryDecoder_t::~BinaryDecoder_t() {
+    for (PyObject *key: keys)
+        Py_DECREF(key);
+}
+
+const char* BinaryDecoder_t::take(std::size_t size) {
+    if (size > static_cast<std::size_t>(end - data))
+        throw StreamError_t("Stream not complete");
+    const char *result = data;
+    data += size;
+    return result;
+}
+
+PyObject* BinaryDecoder_t::decode(const char *data, std::size_t size,
+                                  PyObject *&methodName)
+{
+    this->data = data;
+    end = data + size;
+    depth = 0;
+    for (PyObject *key: keys)
+        Py_DECREF(key);
+    keys.clear();
+
+    const unsigned char magic[] = {0xCA, 0x11};
+    const char *header = take(4);
+    if (memcmp(header, magic, 2) != 0)
+        throw StreamError_t("Bad magic !!!");
+    version.versionMajor = static_cast<unsigned char>(header[2]);
+    version.versionMinor = static_cast<unsigned char>(header[3]);
+    if (version.versionMajor > 3 || version.versionMajor < 1)
+        throw StreamError_t("Unsupported protocol version !!!");
+
+    try {
+        switch (static_cast<unsigned char>(*take(1)) >> 3) {
+        case METHOD_RESPONSE: {
+            // following values are ignored as by Builder_t
+            PyObjectWrapper_t result(Py_None, true);
+            for (bool first = true; this->data != end; first = false) {
+                PyObjectWrapper_t value(decodeValue());
+                if (first) std::swap(result.object, value.object);
+            }
+
+            methodName = Py_None;
+            Py_INCREF(methodName);
+            return result.inc();
+        }
+
+        case METHOD_CALL: {
+            std::size_t nameSize = static_cast<unsigned char>(*take(1));
+            if (!nameSize)
+                throw StreamError_t("Bad call name");
+            const char *name = take(nameSize);
+
+            PyObjectWrapper_t params(PyList_New(0));
+            if (!params) throw PyError_t();
+            while (this->data != end) {
+                PyObjectWrapper_t value(decodeValue());
+                if (PyList_Append(params, value) < 0) throw PyError_t();
+            }
+
+            PyObjectWrapper_t result(PyList_AsTuple(params));
+            if (!result) throw PyError_t();
+            methodName = PyUnicode_FromStringAndSize(name, nameSize);
+            if (!methodName) throw PyError_t();
+            return result.inc();
+        }
+
+        case FAULT:
+            return 0;
+
+        default:
+            throw StreamError_t("Invalid stream message type");
+        }
+
+    } catch (const Fallback_t &) {
+        return 0;
+    }
+}
+
+PyObject* BinaryDecoder_t::decodeValue() {
+    unsigned char tag = static_cast<unsigned char>(*take(1));
+    PyObject *value = 0;
+
+    switch (tag >> 3) {
+    case BOOL:
+        if (tag & 0x6)
+            throw StreamError_t("Invalid bool value");
+        value = makeBool(tag & 0x01, nativeBoolean);
+        break;
+
+    case NULLTYPE:
+        if (version.versionMajor == 1)
+            throw StreamError_t("Unknown value type");
+        Py_INCREF(Py_None);
+        return Py_None;
+
+    case INT: {
+        std::size_t size = getVersionedLengthSize(version.versionMajor > 2,
+                                                  tag);
+        int64_t number = getInt64(take(size), size);
+        if (version.versionMajor > 2)
+            number = zigzagDecode(number);
+        value = makeInt(number);
+        break;
+    }
+
+    case INTP8: {
+        std::size_t size = (tag & 0x07) + 1;
+        value = makeInt(getInt64(take(size), size));
+        break;
+    }
+
+    case INTN8: {
+        std::size_t size = (tag & 0x07) + 1;
+        value = makeInt(safeNegate(getInt64(take(size), size)));
+        break;
+    }
+
+    case DOUBLE:
+        value = PyFloat_FromDouble(getDouble(take(8)));
+        break;
+
+    case DATETIME:
+        value = decodeDateTime();
+        break;
+
+    case STRING:
+    case BINARY: {
+        std::size_t lengthSize = getVersionedLengthSize(
+                version.versionMajor >= 2, tag);
+        auto size = static_cast<uint64_t>(
+                getInt64(take(lengthSize), lengthSize));
+        if (size >= ELEMENT_SIZE_LIMIT) {
+            throw StreamError_t(((tag >> 3) == STRING)
+                                ? "String entity too large"
+                                : "Binary entity too large");
+        }
+        const char *bytes = take(size);
+        value = ((tag >> 3) == STRING)
+            ? makeString(bytes, size, stringMode)
+            : makeBinary(bytes, size);
+        break;
+    }
+
+    case STRUCT:
+        return decodeStruct(tag);
+
+    case ARRAY:
+        return decodeArray(tag);
+
+    case INT_ARRAY:
+    case DOUBLE_ARRAY:
+        if (!hasPackedArrays(version))
+            throw StreamError_t("Unknown value type");
+        return ((tag >> 3) == INT_ARRAY) ? decodeIntArray(tag)
+                                         : decodeDoubleArray(tag);
+
+    default:
+        throw StreamError_t("Unknown value type");
+    }
+
+    if (!value) throw PyError_t();
+    return value;
+}
+
+PyObject* BinaryDecoder_t::decodeStruct(unsigned char tag) {
+    std::size_t lengthSize = getVersionedLengthSize(version.versionMajor >= 2,
+                                                    tag);
+    std::size_t count = checkCount(getInt64(take(lengthSize), lengthSize),
+                                   "Struct", "Struct too large !!!");
+    Depth_t guard(depth);
+
+#if PY_VERSION_HEX >= 0x030B0000
+    // presized dict has general keys table, the one filled by string keys
+    // is smaller and faster
+    PyObjectWrapper_t dict(PyDict_New());
+#else
+    // member takes two bytes at least, don't trust the count blindly
+    PyObjectWrapper_t dict(_PyDict_NewPresized(static_cast<Py_ssize_t>(
+            std::min(count, static_cast<std::size_t>(end - data) / 2))));
+#endif
+    if (!dict) throw PyError_t();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        PyObjectWrapper_t key(decodeMemberName());
+        PyObjectWrapper_t value(decodeValue());
+        if (PyDict_SetItem(dict, key, value) < 0) throw PyError_t();
+    }
+    return dict.inc();
+}
+
+PyObject* BinaryDecoder_t::decodeMemberName() {
+    std::size_t size = static_cast<unsigned char>(*take(1));
+
+    if (!size) {
+        if (!hasKeyDictionary(version))
+            throw StreamError_t("Struct member name length is zero");
+
+        // reference to the key dictionary
+        if (keys.empty())
+            throw StreamError_t("Invalid struct member index");
+        std::size_t indexSize = keyIndexSize(keys.size());
+        auto index = static_cast<uint64_t>(getInt64(take(indexSize),
+                                                    indexSize));
+        if (index >= keys.size())
+            throw StreamError_t("Invalid struct member index");
+
+        Py_INCREF(keys[index]);
+        return keys[index];
+    }
+
+    const char *name = take(size);
+    PyObject *key = callKeys.get(name, size);
+    if (!key) throw PyError_t();
+
+    if (hasKeyDictionary(version) && (keys.size() < KEY_DICTIONARY_LIMIT)) {
+        Py_INCREF(key);
+        keys.push_back(key);
+    }
+    return key;
+}
+
+PyObject* BinaryDecoder_t::decodeArray(unsigned char tag) {
+    std::size_t lengthSize = getVersionedLengthSize(version.versionMajor >= 2,
+                                                    tag);
+    std::size_t count = checkCount(getInt64(take(lengthSize), lengthSize),
+                                   "Array", "Array too long !!!");
+    Depth_t guard(depth);
+
+    // item takes one byte at least, the stream turns out incomplete
+    // before the list would overflow
+    std::size_t size = std::min(count, static_cast<std::size_t>(end - data));
+    PyObjectWrapper_t list(PyList_New(static_cast<Py_ssize_t>(size)));
+    if (!list) throw PyError_t();
+
+    for (std::size_t i = 0; i < count; ++i)
+        PyList_SET_ITEM(list.object, i, decodeValue());
+    return list.inc();
+}
+
+PyObject* BinaryDecoder_t::decodeIntArray(unsigned char tag) {
+    std::size_t lengthSize = (tag & 0x07) + 1;
+    auto count = static_cast<uint64_t>(getInt64(take(lengthSize),
+                                                lengthSize));
+    if (count >= ELEMENT_SIZE_LIMIT)
+        throw StreamError_t("Array entity too large");
+
+    std::size_t width = static_cast<unsigned char>(*take(1));
+    if ((width != 1) && (width != 2) && (width != 4) && (width != 8))
+        throw StreamError_t("Invalid packed array item width");
+    if (count * width >= ELEMENT_SIZE_LIMIT)
+        throw StreamError_t("Array entity too large");
+    const char *items = take(count * width);
+
+    PyObjectWrapper_t list(PyList_New(static_cast<Py_ssize_t>(count)));
+    if (!list) throw PyError_t();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        PyObject *value = makeInt(zigzagDecode(
+                getInt64(items + i * width, width)));
+        if (!value) throw PyError_t();
+        PyList_SET_ITEM(list.object, i, value);
+    }
+    return list.inc();
+}
+
+PyObject* BinaryDecoder_t::decodeDoubleArray(unsigned char tag) {
+    std::size_t lengthSize = (tag & 0x07) + 1;
+    auto count = static_cast<uint64_t>(getInt64(take(lengthSize),
+                                                lengthSize));
+    if ((count >= ELEMENT_SIZE_LIMIT)
+        || (count * sizeof(double) >= ELEMENT_SIZE_LIMIT))
+    {
+        throw StreamError_t("Array entity too large");
+    }
+    const char *items = take(count * sizeof(double));
+
+    PyObjectWrapper_t list(PyList_New(static_cast<Py_ssize_t>(count)));
+    if (!list) throw PyError_t();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        PyObject *value = PyFloat_FromDouble(
+                getDouble(items + i * sizeof(double)));
+        if (!value) throw PyError_t();
+        PyList_SET_ITEM(list.object, i, value);
+    }
+    return list.inc();
+}
+
+PyObject* BinaryDecoder_t::decodeDateTime() {
+    DateTimeInternal_t dateTime = (version.versionMajor > 2)
+        ? getDateTimeV3(take(14))
+        : getDateTime(take(10));
+
+    if (dateTime.year || dateTime.month || dateTime.day
+            || dateTime.hour || dateTime.minute || dateTime.sec)
+    {
+        dateTime.year += 1600;
+    }
+
+    return makeDateTime(datetimeBuilder,
+                        dateTime.year, dateTime.month, dateTime.day,
+                        dateTime.hour, dateTime.minute, dateTime.sec,
+                        dateTime.weekDay, dateTime.unixTime,
+                        dateTime.timeZone * 15 * 60);
+}
+
+} } // namespace FRPC::Python
@@ -0,0 +1,112 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Decoder of complete binary FastRPC messages
+ * into Python objects.
+ *
+ */
+
+#ifndef BINARYDECODER_H_
+#define BINARYDECODER_H_
+
+// Included first to get rid of the _POSIX_C_SOURCE warning
+#include <Python.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <frpc.h>
+
+#include "frpcpythonhelper.h"
+#include "pythonbuilder.h"
+
+namespace FRPC { namespace Python {
+
+/**
+ * @short Decodes whole binary message held in memory.
+ *
+ * Unlike the resumable BinUnMarshaller_t feeding Builder_t the data are
+ * decoded by single recursive pass, lists and dicts are created with the
+ * sizes given by the message. The built objects are the same as the ones
+ * of Builder_t, invalid data raise the same StreamError_t. It has to be
+ * used with the GIL held.
+ */
+class BinaryDecoder_t
+{
+public:
+    BinaryDecoder_t(StringMode_t stringMode, bool nativeBoolean = true,
+                    PyObject *datetimeBuilder = 0)
+        : stringMode(stringMode), nativeBoolean(nativeBoolean),
+          datetimeBuilder(datetimeBuilder), data(0), end(0), depth(0)
+    {}
+
+    ~BinaryDecoder_t();
+
+    BinaryDecoder_t(const BinaryDecoder_t &) = delete;
+    BinaryDecoder_t& operator=(const BinaryDecoder_t &) = delete;
+
+    /**
+     * @short Decodes the message
+     *
+     * The result is a new reference to the response value or to the tuple
+     * of call parameters, methodName is set to new reference to the name
+     * of the called method (None for response). Faults and very deeply
+     * nested data are left to the BinUnMarshaller_t, 0 is returned without
+     * Python error then.
+     *
+     * Throws StreamError_t for invalid data and PyError_t when Python
+     * fails.
+     */
+    PyObject* decode(const char *data, std::size_t size,
+                     PyObject *&methodName);
+
+private:
+    PyObject* decodeValue();
+    PyObject* decodeStruct(unsigned char tag);
+    PyObject* decodeArray(unsigned char tag);
+    PyObject* decodeIntArray(unsigned char tag);
+    PyObject* decodeDoubleArray(unsigned char tag);
+    PyObject* decodeDateTime();
+    PyObject* decodeMemberName();
+
+    /** Returns pointer to next size bytes of the message. */
+    const char* take(std::size_t size);
+
+    StringMode_t stringMode;
+    bool nativeBoolean;
+    //NOTE: Either null or ref managed by owner
+    PyObject *datetimeBuilder;
+
+    const char *data;
+    const char *end;
+    ProtocolVersion_t version;
+    std::size_t depth;
+    std::vector<PyObject*> keys; //!< key dictionary of the message
+    KeyCache_t callKeys;
+};
+
+} } // namespace FRPC::Python
+
+#endif // BINARYDECODER_H_
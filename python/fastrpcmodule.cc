@@ -35,9 +35,13 @@
 #include <Python.h>
 
 #include <new>
+#include <algorithm>
+#include <exception>
+#include <list>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 #include <unistd.h>
@@ -64,6 +68,9 @@
 #include "fastrpcmodule.h"
 #include "pythonbuilder.h"
 #include "pythonfeeder.h"
+#include "recordingbuilder.h"
+#include "iothreads.h"
+#include "binarydecoder.h"
 
 #if PY_VERSION_HEX < 0x02050000 && !defined(PY_SSIZE_T_MIN)
 typedef int Py_ssize_t;
@@ -1217,6 +1224,12 @@ BooleanObject* newBoolean(bool value)
 /**************************************************************************/
 namespace
 {
+/**
+ * @short Request marshalled with the GIL held and sent without it later
+ *
+ * The data is kept in chunks released as soon as they are sent, so the
+ * request is never held twice in memory.
+ */
 class OutBuffer_t:public Writer_t
 {
 public:
@@ -1227,25 +1240,17 @@ public:
     virtual void write(const char *data, unsigned int size );
     virtual void flush();
 
-    inline const char* data()
-    {
-        return localBuffer.data();
-    }
-
-    inline unsigned int size()
-    {
-        return localBuffer.size();
-    }
-
-    inline const char* c_str()
-    {
-        return localBuffer.c_str();
-    }
+    /**
+     * @short Writes the data into the writer and releases it
+     */
+    void sendTo(Writer_t &writer);
 
 private:
+    //! size of one chunk, larger than the HTTP client buffer so that the
+    //! client keeps the chunks as they are
+    static const std::size_t CHUNK_SIZE = 1 << 16;
 
-    std::string localBuffer;
-
+    std::list<std::string> chunks;
 };
 
 
@@ -1253,12 +1258,65 @@ private:
 
 void OutBuffer_t::write(const char *data, unsigned int size )
 {
-    localBuffer.append(data, size);
+    while (size) {
+        if (chunks.empty() || (chunks.back().size() == CHUNK_SIZE)) {
+            chunks.emplace_back();
+        }
+        std::string &chunk = chunks.back();
+        unsigned int part = static_cast<unsigned int>(
+            std::min<std::size_t>(size, CHUNK_SIZE - chunk.size()));
+        chunk.append(data, part);
+        data += part;
+        size -= part;
+    }
 }
 
 void OutBuffer_t::flush()
 {}
 
+void OutBuffer_t::sendTo(Writer_t &writer)
+{
+    while (!chunks.empty()) {
+        writer.write(chunks.front().data(),
+                     static_cast<unsigned int>(chunks.front().size()));
+        chunks.pop_front();
+    }
+}
+
+
+/**************************************************************************/
+/*** Remote call                                                        ***/
+/**************************************************************************/
+namespace
+{
+/**
+ * @short State of one remote call.
+ *
+ * The call is marshalled and its result is built with the GIL held, the
+ * network I/O in between runs without the GIL.
+ */
+struct Call_t
+{
+    Call_t()
+        : protocol(HTTPClient_t::XML_RPC),
+          supportedProtocols(HTTPClient_t::XML_RPC), callbackData(0)
+    {}
+
+    ~Call_t() {
+        Py_XDECREF(callbackData);
+    }
+
+    OutBuffer_t request;
+    unsigned int protocol;
+    HTTPClient_t::HeaderVector_t headers;
+    RecordingBuilder_t response;
+    unsigned int supportedProtocols;
+    ProtocolVersion_t protocolVersion;
+    std::exception_ptr error;
+    PyObject *callbackData;   //!< result of the pre-call hook
+};
+}
+
 
 /**************************************************************************/
 /*** Server proxy object declaration                                    ***/
@@ -1267,6 +1325,7 @@ namespace
 {
 // forward
 struct MethodObject;
+struct AsyncCall_t;
 
 class Proxy_t
 {
@@ -1280,6 +1339,7 @@ public:
             PyObject *datetimeBuilder, PyObject *preCall, PyObject *postCall)
         : url(serverUrl, proxyVia),
           io(-1, readTimeout, writeTimeout, -1, -1),
+          readTimeout(readTimeout), writeTimeout(writeTimeout),
           rpcTransferMode(rpcTransferMode), encoding(encoding),
           serverSupportedProtocols(HTTPClient_t::XML_RPC),
           useHTTP10(useHTTP10), useChunks(useChunks),
@@ -1291,6 +1351,11 @@ public:
     {}
 
     ~Proxy_t() {
+        // no call is running, the threads are idle
+        ioThreads.reset();
+        for (int fd: idleSockets)
+            TEMP_FAILURE_RETRY(::close(fd));
+
         Py_XDECREF(datetimeBuilder);
         Py_XDECREF(preCall);
         Py_XDECREF(postCall);
@@ -1305,6 +1370,29 @@ public:
 
     PyObject* operator()(MethodObject *methodObject, PyObject *args);
 
+    /**
+     * @short Calls the method from native I/O thread
+     *
+     * @return asyncio future of the result
+     */
+    PyObject* callAsync(MethodObject *methodObject, PyObject *args);
+
+    /**
+     * @short Builds result of the asynchronous call, with the GIL held
+     */
+    void completeAsync(AsyncCall_t &call);
+
+    /**
+     * @short Enables asynchronous calls
+     *
+     * @param maxConnections maximum of concurrent calls (I/O threads and
+     *                       kept alive connections)
+     */
+    void enableAsync(std::size_t maxConnections) {
+        ioThreads.reset(new IOThreads_t(maxConnections));
+        this->maxConnections = maxConnections;
+    }
+
     const URL_t& getURL() const {
         return url;
     }
@@ -1317,11 +1405,17 @@ public:
      * @short Closes (keep alive) connection to server
      */
     void closeConnection() {
+        std::unique_lock<std::recursive_mutex> guard(lock());
         int &fd = io.socket();
         if (fd > -1) {
             TEMP_FAILURE_RETRY(::close(fd));
             fd = -1;
         }
+
+        std::lock_guard<std::mutex> socketGuard(socketMutex);
+        for (int fd: idleSockets)
+            TEMP_FAILURE_RETRY(::close(fd));
+        idleSockets.clear();
     }
 
     typedef std::pair<std::string, std::string> Header_t;
@@ -1336,7 +1430,60 @@ public:
 
     void enableSurrogatePass() { allowSurrogates = true; }
 
+    /**
+     * @short Keeps struct member names among calls
+     *
+     * @param size maximum of cached names
+     */
+    void enableKeyCache(std::size_t size) {
+        keyCache.reset(new KeyCache_t(size));
+    }
+
 private:
+    /**
+     * @short Locks the proxy, the connection is used by one call at a time
+     *
+     * The GIL is released while waiting for a call made by other thread,
+     * that call needs the GIL to finish.
+     */
+    std::unique_lock<std::recursive_mutex> lock() {
+        std::unique_lock<std::recursive_mutex> guard(mutex, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            AllowThreads_t allowThreads;
+            guard.lock();
+        }
+        return guard;
+    }
+
+    unsigned int chooseProtocol(bool connected) const;
+
+    /**
+     * @short Marshalls the call into the request, with the GIL held
+     */
+    void marshall(MethodObject *methodObject, PyObject *args, Call_t &call,
+                  bool connected);
+
+    /**
+     * @short Sends the request and reads the response, without the GIL
+     */
+    void send(Call_t &call, HTTPIO_t &io);
+
+    /**
+     * @short Builds the result of the call, with the GIL held
+     *
+     * @return result or 0 when Python exception was raised
+     */
+    PyObject* finish(MethodObject *methodObject, PyObject *args,
+                     Call_t &call);
+
+    /**
+     * @short Runs the asynchronous call in I/O thread
+     */
+    void sendAsync(AsyncCall_t *call);
+
+    int takeSocket();
+    void keepSocket(HTTPIO_t &io);
+
     URL_t url;
     HTTPIO_t io;
     int readTimeout;
@@ -1364,6 +1511,15 @@ private:
     Headers_t headers;
 
     bool allowSurrogates;
+
+    std::recursive_mutex mutex;
+    std::unique_ptr<KeyCache_t> keyCache;
+
+    // asynchronous calls
+    std::size_t maxConnections;
+    std::mutex socketMutex;
+    std::vector<int> idleSockets;   //!< kept alive connections
+    std::unique_ptr<IOThreads_t> ioThreads;
 };
 
 struct ServerProxyObject
@@ -1382,6 +1538,9 @@ extern "C"
     static PyObject* ServerProxy_ServerProxy(ServerProxyObject *self,
             PyObject *args, PyObject *keywds);
 
+    static PyObject* AsyncServerProxy_AsyncServerProxy(
+            ServerProxyObject *self, PyObject *args, PyObject *keywds);
+
     static void ServerProxy_dealloc(ServerProxyObject *self);
     static PyObject* ServerProxy_getattr(ServerProxyObject *self, char *name);
     static PyObject* ServerProxy_call(ServerProxyObject *self, PyObject *args, PyObject *kw);
@@ -1414,6 +1573,32 @@ static PyTypeObject ServerProxy_Type =
         0,                                 /* tp_doc */
     };
 
+static PyTypeObject AsyncServerProxy_Type =
+    {
+        PyVarObject_HEAD_INIT(&PyType_Type, 0)
+        "AsyncServerProxy",                /*tp_name*/
+        sizeof (ServerProxyObject),        /*tp_basicsize*/
+        0,                                 /*tp_itemsize*/
+        /* methods */
+        (destructor) ServerProxy_dealloc,  /*tp_dealloc*/
+        0,                                 /*tp_print*/
+        (getattrfunc) ServerProxy_getattr, /*tp_getattr*/
+        0,                                 /*tp_setattr*/
+        0,                                 /*tp_compare*/
+        0,                                 /*tp_repr*/
+        0,                                 /*tp_as_number*/
+        0,                                 /*tp_as_sequence*/
+        0,                                 /*tp_as_mapping*/
+        0,                                 /*tp_hash*/
+        (ternaryfunc) ServerProxy_call,   /* tp_call */
+        0,                                 /* tp_str */
+        0,                                 /* tp_getattro */
+        0,                                 /* tp_setattro */
+        0,                                 /* tp_as_buffer */
+        0,                                 /* tp_flags */
+        0,                                 /* tp_doc */
+    };
+
 /**************************************************************************/
 /*** Method object declaration                                          ***/
 /**************************************************************************/
@@ -1430,6 +1615,48 @@ struct MethodObject
     /** Name of method */
     std::string name;
 };
+
+/**
+ * @short Asynchronous call, its result is set to asyncio future
+ */
+struct AsyncCall_t : public Call_t
+{
+    AsyncCall_t(MethodObject *methodObject, PyObject *args, PyObject *loop,
+                PyObject *future)
+        : methodObject(methodObject), args(args), loop(loop), future(future)
+    {
+        Py_INCREF(reinterpret_cast<PyObject*>(methodObject));
+        Py_INCREF(args);
+        Py_INCREF(loop);
+        Py_INCREF(future);
+    }
+
+    ~AsyncCall_t() {
+        Py_DECREF(future);
+        Py_DECREF(loop);
+        Py_DECREF(args);
+        Py_DECREF(reinterpret_cast<PyObject*>(methodObject));
+    }
+
+    MethodObject *methodObject;
+    PyObject *args;
+    PyObject *loop;
+    PyObject *future;
+};
+
+const char ASYNC_CALL[] = "fastrpc.AsyncCall";
+};
+
+extern "C"
+{
+    static PyObject* AsyncCall_complete(PyObject *self, PyObject *);
+
+    static void AsyncCall_destroy(PyObject *capsule);
+};
+
+// completes the call passed as capsule in the event loop
+static PyMethodDef AsyncCall_complete_def = {
+    "complete", (PyCFunction) AsyncCall_complete, METH_NOARGS, 0
 };
 
 extern "C"
@@ -1655,9 +1882,26 @@ PyObject* Method_call(MethodObject *self, PyObject *args, PyObject *keys)
     }
 
     // make remote call
+    if (Py_TYPE(self->proxy) == &AsyncServerProxy_Type)
+        return self->proxy->proxy.callAsync(self, args);
     return self->proxy->proxy(self, args);
 }
 
+PyObject* AsyncCall_complete(PyObject *self, PyObject *)
+{
+    AsyncCall_t *call = static_cast<AsyncCall_t*>(
+        PyCapsule_GetPointer(self, ASYNC_CALL));
+    if (!call) return 0;
+
+    call->methodObject->proxy->proxy.completeAsync(*call);
+    Py_RETURN_NONE;
+}
+
+void AsyncCall_destroy(PyObject *capsule)
+{
+    delete static_cast<AsyncCall_t*>(PyCapsule_GetPointer(capsule, ASYNC_CALL));
+}
+
 /**************************************************************************/
 /*** Server proxy object implementation                                 ***/
 /**************************************************************************/
@@ -1665,8 +1909,17 @@ PyObject* Method_call(MethodObject *self, PyObject *args, PyObject *keys)
 static char ServerProxy_ServerProxy__doc__[] =
     "Create new ServerProxy\n";
 
-PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
-                                  PyObject *keywds)
+static char AsyncServerProxy_AsyncServerProxy__doc__[] =
+    "Create new AsyncServerProxy, its methods return asyncio futures\n"
+    "\n"
+    "Takes the same arguments as ServerProxy and maxConnections, the\n"
+    "maximum of concurrent calls. Calls run in native I/O threads and\n"
+    "kept alive connections are reused by following calls.\n";
+
+namespace
+{
+PyObject* newServerProxy(PyTypeObject *type, PyObject *args,
+                         PyObject *keywds, std::size_t maxConnections)
 {
     static const char *kwlist[] = {"serverUrl", "readTimeout", "writeTimeout",
                                    "connectTimeout",
@@ -1678,6 +1931,7 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
                                    "nativeBoolean", "datetimeBuilder",
                                    "preCall", "postCall", "hideAttributes",
                                    "headers", "allowSurrogates",
+                                   "keyCacheSize",
                                    0};
 
     // parse arguments
@@ -1686,7 +1940,8 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
     int readTimeout = -1;
     int writeTimeout = -1;
     int connectTimeout = -1;
-    int keepAlive = 0;
+    // connections of asynchronous proxy are pooled by default
+    int keepAlive = (maxConnections > 0);
     int mode = Proxy_t::BINARY_ON_SUPPORT_ON_KEEP_ALIVE;
     char *stringMode_ = 0;
     char *encoding = "utf-8";
@@ -1702,6 +1957,7 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
     int hideAttributes = true;
     PyObject *headers = 0;
     PyObject *allowSurrogates = 0;
+    int keyCacheSize = 0;
 
     static const char *kwtypes = "siiiiisiissiiOOO";
     const void *kwvars[] = { serverUrl, &readTimeout,
@@ -1715,7 +1971,7 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
 
     // Normal initialization
     if (!PyArg_ParseTupleAndKeywords(args, keywds,
-                                     "s#|iiiiisiissiiOOOOiOO:ServerProxy.__init__",
+                                     "s#|iiiiisiissiiOOOOiOOi:ServerProxy.__init__",
                                      (char **)kwlist,
                                      &serverUrl, &serverUrlLen, &readTimeout,
                                      &writeTimeout, &connectTimeout,
@@ -1725,7 +1981,7 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
                                      &protocolVersionMinor, &nativeBoolean,
                                      &datetimeBuilder, &preCall, &postCall,
                                      &hideAttributes, &headers,
-                                     &allowSurrogates))
+                                     &allowSurrogates, &keyCacheSize))
     {
         if (PyErr_Occurred()) {
             PyErr_Clear();
@@ -1828,8 +2084,7 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
     }
 
     // create server proxy object
-    ServerProxyObject *proxy = PyObject_New(ServerProxyObject,
-                                            &ServerProxy_Type);
+    ServerProxyObject *proxy = PyObject_New(ServerProxyObject, type);
     if (!proxy) return 0;
 
     proxy->proxyOk = false;
@@ -1857,11 +2112,17 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
                                     datetimeBuilder, preCall, postCall);
         proxy->proxyOk = true;
 
+        if (maxConnections)
+            proxy->proxy.enableAsync(maxConnections);
+
         if (allowSurrogates) {
             if (PyObject_IsTrue(allowSurrogates))
                 proxy->proxy.enableSurrogatePass();
         }
 
+        if (keyCacheSize > 0)
+            proxy->proxy.enableKeyCache(keyCacheSize);
+
         if (headers)
             feed_headers(headers, proxy->proxy, /*callscope*/ false);
     }
@@ -1891,6 +2152,39 @@ PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
     // OK
     return reinterpret_cast<PyObject*>(proxy);
 }
+}
+
+PyObject* ServerProxy_ServerProxy(ServerProxyObject *, PyObject *args,
+                                  PyObject *keywds)
+{
+    return newServerProxy(&ServerProxy_Type, args, keywds, 0);
+}
+
+PyObject* AsyncServerProxy_AsyncServerProxy(ServerProxyObject *,
+                                            PyObject *args, PyObject *keywds)
+{
+    // maxConnections is not known to the ServerProxy arguments parser
+    long maxConnections = 10;
+    PyObjectWrapper_t kwargs(keywds ? PyDict_Copy(keywds) : 0);
+    if (keywds && !kwargs) return 0;
+
+    if (PyObject *value = (kwargs ? PyDict_GetItemString(kwargs,
+                                                         "maxConnections")
+                                  : 0))
+    {
+        maxConnections = PyLong_AsLong(value);
+        if (PyErr_Occurred()) return 0;
+        if (maxConnections < 1) {
+            PyErr_SetString(PyExc_ValueError,
+                            "maxConnections must be positive");
+            return 0;
+        }
+        if (PyDict_DelItemString(kwargs, "maxConnections")) return 0;
+    }
+
+    return newServerProxy(&AsyncServerProxy_Type, args, kwargs,
+                          maxConnections);
+}
 
 void ServerProxy_dealloc(ServerProxyObject *self)
 {
@@ -2010,100 +2304,90 @@ PyObject* ServerProxy_getattr(ServerProxyObject *self, char *name)
     return newMethod(self, name);
 }
 
-PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
-    // remember last method
-    lastCall = methodObject->name;
-
-    HTTPClient_t client(io, url, connector.get(), useHTTP10, useChunks);
-    Builder_t builder(reinterpret_cast<PyObject*>(methodObject),
-                      stringMode, nativeBoolean, datetimeBuilder);
-
-    if (allowSurrogates) builder.enableSurrogatePass();
-
-    Marshaller_t *marshaller;
-
-    {
-        client.addCustomRequestHeader(headers);
-        client.addCustomRequestHeader(headersForCall);
-        headersForCall.clear();
-    }
-
+unsigned int Proxy_t::chooseProtocol(bool connected) const {
     switch(rpcTransferMode) {
     case BINARY_NEVER:
-        //using XML_RPC
-        marshaller= Marshaller_t::create(Marshaller_t::XML_RPC,client,
-                                         protocolVersion);
-        client.prepare(HTTPClient_t::XML_RPC);
-        break;
+        return HTTPClient_t::XML_RPC;
 
     case BINARY_ON_SUPPORT:
-        if(serverSupportedProtocols & HTTPClient_t::BINARY_RPC) {
-            //using BINARY_RPC
-            marshaller=
-                Marshaller_t::create(Marshaller_t::BINARY_RPC,client,
-                                     protocolVersion);
-            client.prepare(HTTPClient_t::BINARY_RPC);
-        } else {
-            //using XML_RPC
-            marshaller= Marshaller_t::create(Marshaller_t::XML_RPC,client,
-                                             protocolVersion);
-            client.prepare(HTTPClient_t::XML_RPC);
-        }
-        break;
+        if(serverSupportedProtocols & HTTPClient_t::BINARY_RPC)
+            return HTTPClient_t::BINARY_RPC;
+        return HTTPClient_t::XML_RPC;
 
     case BINARY_ALWAYS:
-        //using BINARY_RPC  always
-        marshaller= Marshaller_t::create(Marshaller_t::BINARY_RPC,client,
-                                         protocolVersion);
-        client.prepare(HTTPClient_t::BINARY_RPC);
-        break;
+        return HTTPClient_t::BINARY_RPC;
 
     case BINARY_ON_SUPPORT_ON_KEEP_ALIVE:
     default:
         if(serverSupportedProtocols & HTTPClient_t::XML_RPC
-           || connector->getKeepAlive() == false || io.socket() != -1) {
-            //using XML_RPC
-            marshaller= Marshaller_t::create(Marshaller_t::XML_RPC,client,
-                                             protocolVersion);
-            client.prepare(HTTPClient_t::XML_RPC);
-        } else {
-            //using BINARY_RPC
-            marshaller=
-                Marshaller_t::create(Marshaller_t::BINARY_RPC,client,
-                                     protocolVersion);
-            client.prepare(HTTPClient_t::BINARY_RPC);
+           || connector->getKeepAlive() == false || connected)
+            return HTTPClient_t::XML_RPC;
+        return HTTPClient_t::BINARY_RPC;
+    }
+}
+
+void Proxy_t::marshall(MethodObject *methodObject, PyObject *args,
+                       Call_t &call, bool connected)
+{
+    call.headers = headers;
+    call.headers.insert(call.headers.end(), headersForCall.begin(),
+                        headersForCall.end());
+    headersForCall.clear();
+
+    call.protocol = chooseProtocol(connected);
+    std::unique_ptr<Marshaller_t> marshaller(
+        Marshaller_t::create((call.protocol == HTTPClient_t::BINARY_RPC)
+                             ? Marshaller_t::BINARY_RPC
+                             : Marshaller_t::XML_RPC,
+                             call.request, protocolVersion));
+
+    // Pre-call hook
+    if (preCall) {
+        call.callbackData = PyObject_CallFunction(preCall, "sO",
+            methodObject->name.c_str(), args, 0);
+        if (PyErr_Occurred()) {
+            // Ignore error
+            PyErr_Clear();
         }
-        break;
     }
 
-    PyObject *callbackData = NULL;
-    PyObject *errEx = NULL;
-    PyObject *errArgs = NULL;
+    Feeder_t feeder(marshaller.get(), encoding);
+    marshaller->packMethodCall(methodObject->name.c_str());
+    feeder.feed(args);
+    marshaller->flush();
+}
+
+void Proxy_t::send(Call_t &call, HTTPIO_t &io) {
+    HTTPClient_t client(io, url, connector.get(), useHTTP10, useChunks);
+    client.addCustomRequestHeader(call.headers);
+    client.prepare(call.protocol);
+
     try {
+        call.request.sendTo(client);
+        client.flush();
+    } catch(const ResponseError_t &e) {
+        // premature response occured => just ignore here
+    }
 
-        // Pre-call hook
-        if (preCall) {
-            callbackData = PyObject_CallFunction(preCall, "sO",
-                methodObject->name.c_str(), args, 0);
-            if (PyErr_Occurred()) {
-                // Ignore error
-                PyErr_Clear();
-            }
-        }
+    client.readResponse(call.response);
+    call.supportedProtocols = client.getSupportedProtocols();
+    call.protocolVersion = client.getProtocolVersion();
+}
 
-        Feeder_t feeder(marshaller,encoding);
-        try {
-            marshaller->packMethodCall(methodObject->name.c_str());
-            feeder.feed(args);
-            marshaller->flush();
-        } catch(const ResponseError_t &e) {
-            // premature response occured => just ignore here
-        }
+PyObject* Proxy_t::finish(MethodObject *methodObject, PyObject *args,
+                          Call_t &call)
+{
+    Builder_t builder(reinterpret_cast<PyObject*>(methodObject),
+                      stringMode, nativeBoolean, datetimeBuilder);
 
-        client.readResponse(builder);
-        serverSupportedProtocols = client.getSupportedProtocols();
-        protocolVersion = client.getProtocolVersion();
+    if (allowSurrogates) builder.enableSurrogatePass();
+    if (keyCache) builder.setKeyCache(keyCache.get());
 
+    PyObject *errEx = NULL;
+    PyObject *errArgs = NULL;
+    try {
+        if (call.error) std::rethrow_exception(call.error);
+        call.response.replay(builder);
     }
 
     catch (const LenError_t &lenError) {
@@ -2154,8 +2438,6 @@ PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
 
     }
 
-    delete marshaller;
-
     PyObject *umdata = NULL;
     if (errEx == NULL) {
         // check for error (exception already raised)
@@ -2196,7 +2478,7 @@ PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
         PyObjectWrapper_t result(
             PyObject_CallFunction(postCall, "sOOOO",
                 methodObject->name.c_str(), args,
-                (callbackData == NULL ? Py_None : callbackData),
+                (call.callbackData == NULL ? Py_None : call.callbackData),
                 (errEx == NULL ? Py_None : errEx),
                 (errArgs == NULL ? Py_None : errArgs)
                 ));
@@ -2205,9 +2487,6 @@ PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
             PyErr_Clear();
         }
     }
-    if (callbackData != NULL) {
-        Py_DECREF(callbackData);
-    }
 
     if (errEx != NULL) {
         if (errArgs) {
@@ -2222,6 +2501,177 @@ PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
     return umdata;
 }
 
+PyObject* Proxy_t::operator()(MethodObject *methodObject, PyObject *args) {
+    std::unique_lock<std::recursive_mutex> guard(lock());
+
+    // remember last method
+    lastCall = methodObject->name;
+
+    Call_t call;
+    try {
+        marshall(methodObject, args, call, io.socket() != -1);
+
+        {
+            // no Python object is touched until the response is read
+            AllowThreads_t allowThreads;
+            send(call, io);
+        }
+        serverSupportedProtocols = call.supportedProtocols;
+        protocolVersion = call.protocolVersion;
+    } catch (...) {
+        call.error = std::current_exception();
+    }
+
+    return finish(methodObject, args, call);
+}
+
+PyObject* Proxy_t::callAsync(MethodObject *methodObject, PyObject *args) {
+    static PyObject *getEventLoop = 0;
+    if (!getEventLoop) {
+        PyObjectWrapper_t asyncio(PyImport_ImportModule("asyncio"));
+        if (!asyncio) return 0;
+        getEventLoop = PyObject_GetAttrString(asyncio, "get_event_loop");
+        if (!getEventLoop) return 0;
+    }
+
+    PyObjectWrapper_t loop(PyObject_CallObject(getEventLoop, 0));
+    if (!loop) return 0;
+    PyObjectWrapper_t future(PyObject_CallMethod(loop, "create_future", 0));
+    if (!future) return 0;
+
+    std::unique_ptr<AsyncCall_t> call(
+        new AsyncCall_t(methodObject, args, loop, future));
+    {
+        std::unique_lock<std::recursive_mutex> guard(lock());
+
+        // remember last method
+        lastCall = methodObject->name;
+
+        bool connected;
+        {
+            std::lock_guard<std::mutex> socketGuard(socketMutex);
+            connected = !idleSockets.empty();
+        }
+
+        try {
+            marshall(methodObject, args, *call, connected);
+        } catch (...) {
+            call->error = std::current_exception();
+        }
+    }
+
+    if (call->error) {
+        // nothing to send, the future fails right away
+        completeAsync(*call);
+        return future.inc();
+    }
+
+    try {
+        AsyncCall_t *running = call.get();
+        ioThreads->run([this, running] { sendAsync(running); });
+        call.release();
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return 0;
+    }
+    return future.inc();
+}
+
+void Proxy_t::sendAsync(AsyncCall_t *call) {
+    {
+        HTTPIO_t io(takeSocket(), readTimeout, writeTimeout, -1, -1);
+        try {
+            send(*call, io);
+            keepSocket(io);
+        } catch (...) {
+            call->error = std::current_exception();
+        }
+    }
+
+    // the result is built in the event loop; the proxy can be destroyed
+    // together with the call, it is not touched below
+    PyGILState_STATE state = PyGILState_Ensure();
+    {
+        PyObjectWrapper_t loop(call->loop, true);
+        PyObjectWrapper_t capsule(
+            PyCapsule_New(call, ASYNC_CALL, AsyncCall_destroy));
+        if (!capsule) delete call;
+
+        PyObjectWrapper_t complete(
+            capsule ? PyCFunction_New(&AsyncCall_complete_def, capsule) : 0);
+        PyObjectWrapper_t scheduled(
+            complete ? PyObject_CallMethod(loop, "call_soon_threadsafe", "O",
+                                           complete.get())
+                     : 0);
+        // closed loop, nobody waits for the result
+        if (!scheduled) PyErr_Clear();
+    }
+    PyGILState_Release(state);
+}
+
+void Proxy_t::completeAsync(AsyncCall_t &call) {
+    // keep error raised by marshalling aside
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+
+    // the future could have been cancelled meanwhile
+    PyObjectWrapper_t done(PyObject_CallMethod(call.future, "done", 0));
+    if (!done || PyObject_IsTrue(done)) {
+        PyErr_Clear();
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        return;
+    }
+    PyErr_Restore(type, value, traceback);
+
+    if (!call.error) {
+        std::unique_lock<std::recursive_mutex> guard(lock());
+        serverSupportedProtocols = call.supportedProtocols;
+        protocolVersion = call.protocolVersion;
+    }
+
+    PyObject *result = 0;
+    try {
+        result = finish(call.methodObject, call.args, call);
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "FRPC Runtime Error");
+    }
+
+    PyObjectWrapper_t outcome;
+    if (result) {
+        outcome = PyObject_CallMethod(call.future, "set_result", "N", result);
+    } else {
+        PyErr_Fetch(&type, &value, &traceback);
+        PyErr_NormalizeException(&type, &value, &traceback);
+        outcome = PyObject_CallMethod(call.future, "set_exception", "O",
+                                      value ? value : Py_None);
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+    }
+    if (!outcome) PyErr_Clear();
+}
+
+int Proxy_t::takeSocket() {
+    std::lock_guard<std::mutex> guard(socketMutex);
+    if (idleSockets.empty()) return -1;
+    int fd = idleSockets.back();
+    idleSockets.pop_back();
+    return fd;
+}
+
+void Proxy_t::keepSocket(HTTPIO_t &io) {
+    int &fd = io.socket();
+    if ((fd < 0) || !connector->getKeepAlive()) return;
+
+    std::lock_guard<std::mutex> guard(socketMutex);
+    if (idleSockets.size() < maxConnections) {
+        idleSockets.push_back(fd);
+        fd = -1;
+    }
+}
+
 /**************************************************************************/
 /*** Other methods                                                      ***/
 /**************************************************************************/
@@ -2234,6 +2684,9 @@ extern "C"
     static PyObject* fastrpc_dumps(PyObject *self, PyObject *args,
                                    PyObject *keywds);
 
+    static PyObject* fastrpc_dumps_into(PyObject *self, PyObject *args,
+                                        PyObject *keywds);
+
     static PyObject* fastrpc_loads(PyObject *self, PyObject *args,
                                    PyObject *keywds);
 
@@ -2295,35 +2748,255 @@ PyObject* fastrpc_cleanup(PyObject *, PyObject *args, PyObject *keywds) {
 }
 
 namespace {
-    class StringWriter_t : public FRPC::Writer_t {
+    /**
+     * @short Writer straight into memory of a Python object
+     */
+    class MemoryWriter_t : public FRPC::Writer_t {
     public:
-        StringWriter_t()
-            : Writer_t()
+        virtual void write(const char *data, unsigned int size) {
+            if (size > capacity - used) reserve(used + size);
+            memcpy(buffer + used, data, size);
+            used += size;
+        }
+
+        virtual void flush() { /* noop */ }
+
+        std::size_t size() const { return used; }
+
+    protected:
+        MemoryWriter_t()
+            : Writer_t(), buffer(0), used(0), capacity(0)
         {}
 
-        virtual ~StringWriter_t() {}
+        /**
+         * @short Makes room for size bytes at least
+         *
+         * Throws PyError_t when there is no room.
+         */
+        virtual void reserve(std::size_t size) = 0;
 
-        virtual void write(const char *data, unsigned  int size) {
-            this->data.append(data, size);
-        }
+        char *buffer;
+        std::size_t used;
+        std::size_t capacity;
+    };
 
-        virtual void flush() { /* noop */ }
+    /**
+     * @short Writes into bytes object which is grown as needed
+     *
+     * The object is shrunk to the written size and returned at the end,
+     * the data are not copied again.
+     */
+    class BytesWriter_t : public MemoryWriter_t {
+    public:
+        explicit BytesWriter_t(std::size_t initialSize)
+            : MemoryWriter_t(), initialSize(initialSize), bytes(0)
+        {}
+
+        virtual ~BytesWriter_t() {
+            Py_XDECREF(bytes);
+        }
 
         PyObject* getData(bool binary) {
 #if PY_MAJOR_VERSION >= 3
-            if (binary) {
-                return PyBytes_FromStringAndSize(data.data(), data.size());
-            } else {
-                return PyUnicode_FromStringAndSize(data.data(), data.size());
+            if (!binary) {
+                return PyUnicode_FromStringAndSize(buffer, used);
             }
-#else
-            return PyString_FromStringAndSize(data.data(), data.size());
 #endif
+            if (!bytes) return PyBytes_FromStringAndSize(0, 0);
+            if (_PyBytes_Resize(&bytes, used) < 0) {
+                bytes = 0;
+                return 0;
+            }
+            PyObject *result = bytes;
+            bytes = 0;
+            return result;
+        }
+
+    protected:
+        virtual void reserve(std::size_t size) {
+            size = std::max(size, std::max(initialSize, 2 * capacity));
+            if (!bytes) {
+                bytes = PyBytes_FromStringAndSize(0, size);
+                if (!bytes) throw PyError_t();
+            } else if (_PyBytes_Resize(&bytes, size) < 0) {
+                bytes = 0;
+                throw PyError_t();
+            }
+            buffer = PyBytes_AS_STRING(bytes);
+            capacity = size;
         }
 
     private:
-        std::string data;
+        std::size_t initialSize;
+        PyObject *bytes;
     };
+
+    /**
+     * @short Writes into bytearray which is resized as needed
+     */
+    class ByteArrayWriter_t : public MemoryWriter_t {
+    public:
+        explicit ByteArrayWriter_t(PyObject *array)
+            : MemoryWriter_t(), array(array)
+        {
+            buffer = PyByteArray_AS_STRING(array);
+            capacity = PyByteArray_GET_SIZE(array);
+        }
+
+        /** Shrinks the array to the written size. */
+        bool finish() {
+            return PyByteArray_Resize(array, used) == 0;
+        }
+
+    protected:
+        virtual void reserve(std::size_t size) {
+            size = std::max(size, 2 * capacity);
+            if (PyByteArray_Resize(array, size) < 0) throw PyError_t();
+            buffer = PyByteArray_AS_STRING(array);
+            capacity = size;
+        }
+
+    private:
+        PyObject *array;
+    };
+
+    /**
+     * @short Writes into writable buffer of fixed size
+     */
+    class BufferWriter_t : public MemoryWriter_t {
+    public:
+        BufferWriter_t()
+            : MemoryWriter_t(), view()
+        {}
+
+        virtual ~BufferWriter_t() {
+            if (view.obj) PyBuffer_Release(&view);
+        }
+
+        bool open(PyObject *object) {
+            if (PyObject_GetBuffer(object, &view, PyBUF_WRITABLE) < 0)
+                return false;
+            buffer = static_cast<char*>(view.buf);
+            capacity = view.len;
+            return true;
+        }
+
+    protected:
+        virtual void reserve(std::size_t) {
+            PyErr_SetString(PyExc_ValueError, "Buffer too small");
+            throw PyError_t();
+        }
+
+    private:
+        Py_buffer view;
+    };
+
+    // dumps() starts with the size of the previous data
+    const std::size_t MIN_DUMPS_SIZE = 256;
+    const std::size_t MAX_DUMPS_SIZE_HINT = 1 << 20;
+    std::size_t dumpsSizeHint = MIN_DUMPS_SIZE;
+
+    /**
+     * @short Marshalls params (tuple, list or Fault) by the marshaller
+     *
+     * Returns false with Python exception set on error.
+     */
+    bool marshallParams(Marshaller_t *marshaller, PyObject *params,
+                        const char *methodname, const char *encoding)
+    {
+        try {
+            // normal data
+            if (PyTuple_Check(params) || PyList_Check(params)) {
+                Feeder_t feeder(marshaller, encoding);
+                if (methodname) {
+                    marshaller->packMethodCall(methodname);
+                    feeder.feed(params);
+                } else  {// now is default method response  if (methodresponse) {
+                    marshaller->packMethodResponse();
+                    PyObject *firstParam = 0;
+                    if (PyTuple_Check(params)) {
+                        firstParam = (PyTuple_GET_SIZE(params)
+                                      ? PyTuple_GET_ITEM(params, 0)
+                                      : 0);
+                    } else {
+                        firstParam = (PyList_GET_SIZE(params)
+                                      ? PyList_GET_ITEM(params, 0)
+                                      : 0);
+                    }
+                    if (firstParam) feeder.feedValue(firstParam);
+                } //else {
+                    // raw data
+                    //feeder.feedValue(params);
+               // }
+            } else if (PyObject_IsInstance(params, Fault) > 0) {
+                PyObjectWrapper_t faultCode
+                    (PyObject_GetAttrString(params, "faultCode"));
+                if (!faultCode) return false;
+                PyObjectWrapper_t faultString
+                    (PyObject_GetAttrString(params, "faultString"));
+                if (!faultString) return false;
+
+                if (!PyInt_Check(faultCode.get())) {
+                    PyErr_SetString(PyExc_TypeError,
+                                    "Fault.faultCode is not an int");
+                    return false;
+                }
+
+                PyStrDataType_t str;
+                Py_ssize_t strSize;
+                STR_ASSTRANDSIZE(faultString.get(), str, strSize) {
+                    return false;
+                }
+
+                marshaller->packFault(PyInt_AsLong(faultCode.get()), str, strSize);
+            } else {
+                PyErr_SetString(PyExc_TypeError,
+                                "Parameter params must be tuple or fastrpc.Fault "
+                                "instance.");
+                return false;
+            }
+
+            marshaller->flush();
+
+        } catch (const TypeError_t &typeError) {
+            PyErr_SetString(PyExc_TypeError, typeError.message().c_str());
+            return false;
+
+        } catch (const LenError_t &lenError) {
+            PyErr_SetString(PyExc_TypeError, lenError.message().c_str());
+            return false;
+
+        } catch (const Error_t &error) {
+            PyErr_SetString(PyExc_RuntimeError, error.message().c_str());
+            return false;
+
+        } catch (std::bad_alloc &badAlloc) {
+            PyErr_SetString(PyExc_MemoryError, "Out of memory");
+            return false;
+
+        } catch (PyError_t &pyErr) {
+            return false;
+        }
+        return true;
+    }
+
+    /** Creates marshaller of the given type and version. */
+    Marshaller_t* createMarshaller(FRPC::Writer_t &writer, int useBinary,
+                                   int protocolVersionMajor,
+                                   int protocolVersionMinor)
+    {
+        if ((protocolVersionMajor < 0) || (protocolVersionMinor < 0)) {
+            PyErr_SetString(PyExc_RuntimeError, "Protocol version must not be negative");
+            return 0;
+        }
+
+        return Marshaller_t::create((useBinary
+                                     ? Marshaller_t::BINARY_RPC
+                                     : Marshaller_t::XML_RPC),
+                                    writer,
+                                    ProtocolVersion_t(protocolVersionMajor,
+                                                      protocolVersionMinor));
+    }
 }
 
 static char fastrpc_dumps__doc__[] =
@@ -2353,98 +3026,84 @@ PyObject* fastrpc_dumps(PyObject *, PyObject *args, PyObject *keywds) {
                                      &protocolVersionMinor))
         return 0;
 
-    if ((protocolVersionMajor < 0) || (protocolVersionMinor < 0)) {
-        PyErr_SetString(PyExc_RuntimeError, "Protocol version must not be negative");
-        return 0;
-    }
-
     // create writer
-    StringWriter_t writer;
+    BytesWriter_t writer(dumpsSizeHint);
 
     // create marshaller
     std::auto_ptr<Marshaller_t> marshaller
-        (Marshaller_t::create((useBinary
-                               ? Marshaller_t::BINARY_RPC
-                               : Marshaller_t::XML_RPC),
-                               writer,ProtocolVersion_t(protocolVersionMajor,
-                                                      protocolVersionMinor)));
+        (createMarshaller(writer, useBinary, protocolVersionMajor,
+                          protocolVersionMinor));
+    if (!marshaller.get()) return 0;
 
-    try {
-        // normal data
-        if (PyTuple_Check(params) || PyList_Check(params)) {
-            Feeder_t feeder(marshaller.get(), encoding);
-            if (methodname) {
-                marshaller->packMethodCall(methodname);
-                feeder.feed(params);
-            } else  {// now is default method response  if (methodresponse) {
-                marshaller->packMethodResponse();
-                PyObject *firstParam = 0;
-                if (PyTuple_Check(params)) {
-                    firstParam = (PyTuple_GET_SIZE(params)
-                                  ? PyTuple_GET_ITEM(params, 0)
-                                  : 0);
-                } else {
-                    firstParam = (PyList_GET_SIZE(params)
-                                  ? PyList_GET_ITEM(params, 0)
-                                  : 0);
-                }
-                if (firstParam) feeder.feedValue(firstParam);
-            } //else {
-                // raw data
-                //feeder.feedValue(params);
-           // }
-        } else if (PyObject_IsInstance(params, Fault) > 0) {
-            PyObjectWrapper_t faultCode
-                (PyObject_GetAttrString(params, "faultCode"));
-            if (!faultCode) return 0;
-            PyObjectWrapper_t faultString
-                (PyObject_GetAttrString(params, "faultString"));
-            if (!faultString) return 0;
-
-            if (!PyInt_Check(faultCode.get())) {
-                PyErr_SetString(PyExc_TypeError,
-                                "Fault.faultCode is not an int");
-                return 0;
-            }
+    if (!marshallParams(marshaller.get(), params, methodname, encoding))
+        return 0;
 
-            PyStrDataType_t str;
-            Py_ssize_t strSize;
-            STR_ASSTRANDSIZE(faultString.get(), str, strSize) {
-                return 0;
-            }
+    // similar data are expected next time
+    dumpsSizeHint = std::max(MIN_DUMPS_SIZE,
+                             std::min(MAX_DUMPS_SIZE_HINT,
+                                      writer.size() + writer.size() / 8));
 
-            marshaller->packFault(PyInt_AsLong(faultCode.get()), str, strSize);
-        } else {
-            PyErr_SetString(PyExc_TypeError,
-                            "Parameter params must be tuple or fastrpc.Fault "
-                            "instance.");
-            return 0;
-        }
-
-        marshaller->flush();
+    // return mashalled string
+    return writer.getData(useBinary);
+}
 
-    } catch (const TypeError_t &typeError) {
-        PyErr_SetString(PyExc_TypeError, typeError.message().c_str());
-        return 0;
+static char fastrpc_dumps_into__doc__[] =
+    "Convert an argument tuple or a Fault instance to an XML-RPC\n"
+    "request (or response) written to the given writable buffer.\n"
+    "Bytearray is resized to the size of the data, other buffers have to\n"
+    "be large enough. Takes the same optional parameters as dumps.\n"
+    "Returns the number of written bytes.\n";
+
+PyObject* fastrpc_dumps_into(PyObject *, PyObject *args, PyObject *keywds) {
+    static const char *kwlist[] = {"buffer", "params", "methodname",
+                                   "methodresponse", "encoding", "useBinary",
+                                   "protocolVersionMajor",
+                                   "protocolVersionMinor",0};
 
-    } catch (const LenError_t &lenError) {
-        PyErr_SetString(PyExc_TypeError, lenError.message().c_str());
-        return 0;
+    // parse arguments
+    PyObject *buffer;
+    PyObject *params;
+    char *methodname = 0;
+    int methodresponse = false;
+    const char *encoding = "utf-8";
+    int useBinary = false;
+    int protocolVersionMajor = 2;
+    int protocolVersionMinor = 1;
 
-    } catch (const Error_t &error) {
-        PyErr_SetString(PyExc_RuntimeError, error.message().c_str());
+    if (!PyArg_ParseTupleAndKeywords(args, keywds,
+                                     "OO|zisiii:fastrpc.dumps_into",
+                                     (char **)kwlist,
+                                     &buffer, &params, &methodname,
+                                     &methodresponse, &encoding, &useBinary,
+                                     &protocolVersionMajor,
+                                     &protocolVersionMinor))
         return 0;
 
-    } catch (std::bad_alloc &badAlloc) {
-        PyErr_SetString(PyExc_MemoryError, "Out of memory");
-        return 0;
+    if (PyByteArray_CheckExact(buffer)) {
+        ByteArrayWriter_t writer(buffer);
+        std::auto_ptr<Marshaller_t> marshaller
+            (createMarshaller(writer, useBinary, protocolVersionMajor,
+                              protocolVersionMinor));
+        if (!marshaller.get()) return 0;
 
-    } catch (PyError_t &pyErr) {
-        return 0;
+        if (!marshallParams(marshaller.get(), params, methodname, encoding)
+            || !writer.finish())
+        {
+            return 0;
+        }
+        return PyInt_FromLong(writer.size());
     }
 
-    // return mashalled string
-    return writer.getData(useBinary);
+    BufferWriter_t writer;
+    if (!writer.open(buffer)) return 0;
+    std::auto_ptr<Marshaller_t> marshaller
+        (createMarshaller(writer, useBinary, protocolVersionMajor,
+                          protocolVersionMinor));
+    if (!marshaller.get()) return 0;
+
+    if (!marshallParams(marshaller.get(), params, methodname, encoding))
+        return 0;
+    return PyInt_FromLong(writer.size());
 }
 
 static char fastrpc_loads__doc__[] =
@@ -2454,7 +3113,41 @@ static char fastrpc_loads__doc__[] =
     " * stringMode ('string', 'unicode', 'mixed')\n"
     " * nativeBoolean (True/False, defaults to True)\n"
     " * datetimeBuilder (callable that converts datetime components to python object)\n"
-    " * useBinary (True/False/None - Defaults to None, which means 'detect')\n";
+    " * useBinary (True/False/None - Defaults to None, which means 'detect')\n"
+    "Data may be given by any object supporting the buffer protocol\n"
+    "(e.g. memoryview), it is not copied.\n";
+
+namespace {
+
+/**
+ * @short Buffer of the data to be loaded, released on destruction
+ */
+class DataBuffer_t {
+public:
+    DataBuffer_t()
+        : view()
+    {}
+
+    ~DataBuffer_t() {
+        if (view.obj) PyBuffer_Release(&view);
+    }
+
+    DataBuffer_t(const DataBuffer_t &) = delete;
+    DataBuffer_t& operator=(const DataBuffer_t &) = delete;
+
+    bool get(PyObject *object, PyStrDataType_t &data, Py_ssize_t &size) {
+        if (PyObject_GetBuffer(object, &view, PyBUF_SIMPLE) < 0)
+            return false;
+        data = static_cast<char*>(view.buf);
+        size = view.len;
+        return true;
+    }
+
+private:
+    Py_buffer view;
+};
+
+} // namespace
 
 PyObject* fastrpc_loads(PyObject *, PyObject *args, PyObject *keywds) {
     static const char *kwlist[] = {"data",
@@ -2484,6 +3177,7 @@ PyObject* fastrpc_loads(PyObject *, PyObject *args, PyObject *keywds) {
 
     PyStrDataType_t dataStr;
     Py_ssize_t dataSize;
+    DataBuffer_t buffer;
 #if PY_MAJOR_VERSION >= 3
     if (PyBytes_Check(data)) {
         char *ncDataStr;
@@ -2491,16 +3185,41 @@ PyObject* fastrpc_loads(PyObject *, PyObject *args, PyObject *keywds) {
             return 0;
         }
         dataStr = ncDataStr;
+    } else if (PyObject_CheckBuffer(data)) {
+        if (!buffer.get(data, dataStr, dataSize)) return 0;
     } else STR_ASSTRANDSIZE(data, dataStr, dataSize) {
         return 0;
     }
 #else
-    STR_ASSTRANDSIZE(data, dataStr, dataSize) {
+    if (!PyString_Check(data) && !PyUnicode_Check(data)
+        && PyObject_CheckBuffer(data))
+    {
+        if (!buffer.get(data, dataStr, dataSize)) return 0;
+    } else STR_ASSTRANDSIZE(data, dataStr, dataSize) {
         return 0;
     }
 #endif
 
+    unsigned char magic[] = {0xCA, 0x11};
+    bool binary = (!useBinary || useBinary == Py_None)
+        ? ((dataSize >= 4) && !memcmp(dataStr, magic, 2))
+        : PyObject_IsTrue(useBinary);
+
     try {
+        // complete binary messages are decoded directly, faults and too
+        // deeply nested data go through the unmarshaller
+        if (binary) {
+            BinaryDecoder_t decoder(stringMode,
+                    nativeBoolean != 0 ? PyObject_IsTrue(nativeBoolean) : true,
+                    datetimeBuilder);
+            PyObject *methodName = 0;
+            if (PyObject *umdata = decoder.decode(dataStr, dataSize,
+                                                  methodName))
+            {
+                return Py_BuildValue("(NN)", umdata, methodName);
+            }
+        }
+
         Builder_t builder(0, stringMode,
                 nativeBoolean != 0 ? PyObject_IsTrue(nativeBoolean) : true,
                 datetimeBuilder);
@@ -2522,6 +3241,9 @@ PyObject* fastrpc_loads(PyObject *, PyObject *args, PyObject *keywds) {
                                      FRPC::UnMarshaller_t::TYPE_ANY);
         }
 
+        // incomplete binary data are refused as by the decoder above
+        if (binary) unmarshaller->finish();
+
         // check for error (exception already raised)
         PyObject *umdata = builder.getUnMarshaledData();
         if (!umdata) return 0;
@@ -2799,6 +3521,11 @@ static PyMethodDef frpc_methods[] =
             (PyCFunction) ServerProxy_ServerProxy,
             METH_VARARGS | METH_KEYWORDS,
             ServerProxy_ServerProxy__doc__
+        }, {
+            "AsyncServerProxy",
+            (PyCFunction) AsyncServerProxy_AsyncServerProxy,
+            METH_VARARGS | METH_KEYWORDS,
+            AsyncServerProxy_AsyncServerProxy__doc__
         }, {
             "boolean",
             (PyCFunction) fastrpc_boolean,
@@ -2814,6 +3541,11 @@ static PyMethodDef frpc_methods[] =
             (PyCFunction) fastrpc_dumps,
             METH_VARARGS | METH_KEYWORDS,
             fastrpc_dumps__doc__
+        }, {
+            "dumps_into",
+            (PyCFunction) fastrpc_dumps_into,
+            METH_VARARGS | METH_KEYWORDS,
+            fastrpc_dumps_into__doc__
         }, {
             "loads",
             (PyCFunction) fastrpc_loads,
@@ -2948,7 +3680,8 @@ PyMODINIT_FUNC init_fastrpc(void)
         (PyType_Ready(&BinaryObject_Type) < 0) ||
 #endif
         (PyType_Ready(&BooleanObject_Type) < 0) ||
-        (PyType_Ready(&ServerProxy_Type) < 0))
+        (PyType_Ready(&ServerProxy_Type) < 0) ||
+        (PyType_Ready(&AsyncServerProxy_Type) < 0))
         INITERROR;
 
     Py_INCREF(&DateTimeObject_Type);
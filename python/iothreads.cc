@@ -0,0 +1,97 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Native threads doing blocking I/O.
+ *
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "iothreads.h"
+
+namespace FRPC { namespace Python {
+
+struct IOThreads_t::State_t {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Job_t> jobs;
+    std::size_t idle = 0;
+    bool stopping = false;
+};
+
+IOThreads_t::IOThreads_t(std::size_t maxThreads)
+    : maxThreads(maxThreads ? maxThreads : 1), state(new State_t())
+{}
+
+IOThreads_t::~IOThreads_t() {
+    {
+        std::lock_guard<std::mutex> guard(state->mutex);
+        state->stopping = true;
+    }
+    state->ready.notify_all();
+
+    for (std::thread &thread: threads) {
+        if (thread.get_id() == std::this_thread::get_id()) {
+            // the state is kept alive by the thread itself
+            thread.detach();
+        } else {
+            thread.join();
+        }
+    }
+}
+
+void IOThreads_t::run(Job_t job) {
+    std::unique_lock<std::mutex> guard(state->mutex);
+    state->jobs.push_back(std::move(job));
+    if ((state->jobs.size() > state->idle) && (threads.size() < maxThreads)) {
+        threads.emplace_back(&IOThreads_t::work, state);
+        return;
+    }
+    guard.unlock();
+    state->ready.notify_one();
+}
+
+void IOThreads_t::work(std::shared_ptr<State_t> state) {
+    std::unique_lock<std::mutex> guard(state->mutex);
+    for (;;) {
+        while (state->jobs.empty() && !state->stopping) {
+            ++state->idle;
+            state->ready.wait(guard);
+            --state->idle;
+        }
+        if (state->jobs.empty()) return;
+
+        Job_t job(std::move(state->jobs.front()));
+        state->jobs.pop_front();
+        guard.unlock();
+        job();
+        job = nullptr;
+        guard.lock();
+    }
+}
+
+} } // namespace FRPC::Python
@@ -0,0 +1,81 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Native threads doing blocking I/O.
+ *
+ */
+
+#ifndef IOTHREADS_H_
+#define IOTHREADS_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace FRPC { namespace Python {
+
+/**
+ * @short Pool of native threads running blocking jobs.
+ *
+ * Threads are started on demand, up to the given limit; jobs wait in
+ * a queue when all threads are busy. The jobs run without the GIL, a job
+ * has to acquire it before touching any Python object.
+ */
+class IOThreads_t {
+public:
+    typedef std::function<void()> Job_t;
+
+    explicit IOThreads_t(std::size_t maxThreads);
+
+    /**
+     * @short Stops the threads once they finish the queued jobs.
+     *
+     * It may be called from a job, that thread is detached then.
+     */
+    ~IOThreads_t();
+
+    IOThreads_t(const IOThreads_t &) = delete;
+    IOThreads_t& operator=(const IOThreads_t &) = delete;
+
+    /**
+     * @short Runs the job in some of the threads, the job must not throw.
+     */
+    void run(Job_t job);
+
+private:
+    struct State_t;
+
+    static void work(std::shared_ptr<State_t> state);
+
+    std::size_t maxThreads;
+    std::shared_ptr<State_t> state; //!< shared with the running threads
+    std::vector<std::thread> threads;
+};
+
+} } // namespace FRPC::Python
+
+#endif // IOTHREADS_H_
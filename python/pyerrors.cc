@@ -157,6 +157,7 @@ ProtocolError_clear(ProtocolErrorObject *self)
 static void
 ProtocolError_dealloc(ProtocolErrorObject *self)
 {
+    PyObject_GC_UnTrack(self);
     ProtocolError_clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
@@ -262,6 +263,7 @@ Fault_clear(FaultObject *self)
 static void
 Fault_dealloc(FaultObject *self)
 {
+    PyObject_GC_UnTrack(self);
     Fault_clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
@@ -354,6 +356,7 @@ ResponseError_clear(ResponseErrorObject *self)
 static void
 ResponseError_dealloc(ResponseErrorObject *self)
 {
+    PyObject_GC_UnTrack(self);
     ResponseError_clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
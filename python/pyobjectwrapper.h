@@ -111,6 +111,28 @@ public:
     PyObject *object;
 };
 
+/**
+ * @short Releases the GIL for the lifetime of the object.
+ *
+ * No Python object may be touched until the GIL is reacquired.
+ */
+class AllowThreads_t {
+public:
+    AllowThreads_t()
+        : state(PyEval_SaveThread())
+    {}
+
+    ~AllowThreads_t() {
+        PyEval_RestoreThread(state);
+    }
+
+    AllowThreads_t(const AllowThreads_t &) = delete;
+    AllowThreads_t& operator=(const AllowThreads_t &) = delete;
+
+private:
+    PyThreadState *state;
+};
+
 } } // namespace FRPC::Python
 
 #endif // PYOBJECTWRAPPER_H_
@@ -41,6 +41,51 @@ using namespace FRPC::Python;
 
 namespace FRPC {
 namespace Python {
+PyObject* KeyCache_t::get(const char *data, std::size_t size) {
+    lookup.assign(data, size);
+    auto ikey = keys.find(lookup);
+    if (ikey != keys.end()) {
+        Py_INCREF(ikey->second);
+        return ikey->second;
+    }
+
+    // ASCII names are native strings, the others are unicode
+    bool utf8 = false;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (data[i] & 0x80) {
+            utf8 = true;
+            break;
+        }
+    }
+
+    PyObject *key;
+    if (utf8) {
+        key = PyUnicode_DecodeUTF8(data, size, "strict");
+    } else {
+#if PY_MAJOR_VERSION >= 3
+        key = PyUnicode_FromStringAndSize(data, size);
+#else
+        key = PyString_FromStringAndSize(data, size);
+#endif
+    }
+    if (!key || (keys.size() >= limit)) return key;
+
+#if PY_MAJOR_VERSION >= 3
+    PyUnicode_InternInPlace(&key);
+#else
+    if (!utf8) PyString_InternInPlace(&key);
+#endif
+    keys.emplace(lookup, key);
+    Py_INCREF(key);
+    return key;
+}
+
+void KeyCache_t::clear() {
+    for (auto &key: keys)
+        Py_DECREF(key.second);
+    keys.clear();
+}
+
 StringMode_t parseStringMode(const char *stringMode) {
     if (stringMode) {
         if (!strcmp(stringMode, "string")) {
@@ -58,6 +103,88 @@ StringMode_t parseStringMode(const char *stringMode) {
     return STRING_MODE_MIXED;
 }
 
+PyObject* makeInt(Int_t::value_type value) {
+#if PY_MAJOR_VERSION >= 3
+    return PyLong_FromLongLong(value);
+#else
+    Int_t::value_type absValue = value < 0 ? -value :value;
+
+    if ((absValue & INT31_MASK)) {
+
+        return PyLong_FromLongLong(value);
+    }
+    return PyInt_FromLong(int32_t(value));
+#endif
+}
+
+PyObject* makeString(const char *data, std::size_t size,
+                     StringMode_t stringMode, bool allowSurrogates)
+{
+#if PY_MAJOR_VERSION >= 3
+# ifdef HAVE_BINARY
+    static_cast<void>(allowSurrogates);
+    if (stringMode == STRING_MODE_STRING) {
+        return PyBytes_FromStringAndSize(data, size);
+    }
+    return PyUnicode_DecodeUTF8(data, size, "strict");
+# else
+    static_cast<void>(stringMode);
+    if (allowSurrogates)
+        return PyUnicode_DecodeUTF8(data, size, "surrogatepass");
+    return PyUnicode_DecodeUTF8(data, size, "strict");
+# endif
+#else
+    static_cast<void>(allowSurrogates);
+    bool utf8 = (stringMode == STRING_MODE_UNICODE);
+
+    // check 8-bit string only iff mixed
+    if (stringMode == STRING_MODE_MIXED) {
+        for (std::size_t i = 0; i < size; i++) {
+            if (data[i] & 0x80) {
+                utf8 = true;
+                break;
+            }
+        }
+    }
+
+    if (utf8) {
+        return PyUnicode_DecodeUTF8(data, size, "strict");
+    }
+    return PyString_FromStringAndSize(const_cast<char*>(data), size);
+#endif
+}
+
+PyObject* makeBinary(const char *data, std::size_t size) {
+#ifdef HAVE_BINARY
+    return reinterpret_cast<PyObject*>(newBinary(data, size));
+#else
+    return PyBytes_FromStringAndSize(data, size);
+#endif
+}
+
+PyObject* makeBool(bool value, bool nativeBoolean) {
+    if (nativeBoolean) {
+        PyObject *boolean = value ? Py_True : Py_False;
+        Py_INCREF(boolean);
+        return boolean;
+    }
+    return reinterpret_cast<PyObject*>(newBoolean(value));
+}
+
+PyObject* makeDateTime(PyObject *datetimeBuilder, short year, char month,
+                       char day, char hour, char min, char sec, char weekDay,
+                       time_t unixTime, int timeZone)
+{
+    if ( datetimeBuilder != 0 && PyCallable_Check(datetimeBuilder) ) {
+        return PyObject_CallFunction(datetimeBuilder,"(hbbbbbbii)", year,
+                                     month, day, hour, min, sec, weekDay,
+                                     unixTime, timeZone);
+    }
+    return reinterpret_cast<PyObject*>(newDateTime(year, month,
+                     day, hour, min,
+                     sec, weekDay, unixTime, timeZone) );
+}
+
 }
 } // namespace FRPC::Python
 
@@ -66,11 +193,7 @@ void Builder_t::buildMethodResponse() {}
 void Builder_t::buildBinary(const char* data, unsigned int size) {
     if (isError())
         return;
-#ifdef HAVE_BINARY
-    PyObject *binary = reinterpret_cast<PyObject*>(newBinary(data, size));
-#else
-    PyObject *binary = PyBytes_FromStringAndSize(data, size);
-#endif
+    PyObject *binary = makeBinary(data, size);
 
     if (!binary)
         setError();
@@ -82,12 +205,7 @@ void Builder_t::buildBinary(const char* data, unsigned int size) {
 void Builder_t::buildBinary(const std::string &data) {
     if (isError())
         return;
-#ifdef HAVE_BINARY
-    PyObject *binary = reinterpret_cast<PyObject*>(newBinary(data.data(),
-                       data.size()));
-#else
-    PyObject *binary = PyBytes_FromStringAndSize(data.data(), data.size());
-#endif
+    PyObject *binary = makeBinary(data.data(), data.size());
     if (!binary)
         setError();
 
@@ -98,13 +216,7 @@ void Builder_t::buildBool(bool value) {
     if (isError())
         return;
 
-    PyObject *boolean = 0;
-    if ( nativeBoolean ) {
-        boolean = value ? Py_True : Py_False;
-        Py_INCREF(boolean);
-    } else {
-        boolean = reinterpret_cast<PyObject*>(newBoolean(value));
-    }
+    PyObject *boolean = makeBool(value, nativeBoolean);
 
     if (!boolean)
         setError();
@@ -124,17 +236,9 @@ void Builder_t::buildDateTime(short year, char month, char day, char hour, char
     if (isError())
         return;
 
-    PyObject *dateTime = 0;
-
-    if ( datetimeBuilder != 0 && PyCallable_Check(datetimeBuilder) ) {
-        dateTime = PyObject_CallFunction(datetimeBuilder,"(hbbbbbbii)", year,
-                                         month, day, hour, min, sec, weekDay,
-                                         unixTime, timeZone);
-    } else {
-        dateTime = reinterpret_cast<PyObject*>(newDateTime(year, month,
-                         day, hour, min,
-                         sec, weekDay, unixTime, timeZone) );
-    }
+    PyObject *dateTime = makeDateTime(datetimeBuilder, year, month, day,
+                                      hour, min, sec, weekDay, unixTime,
+                                      timeZone);
 
     if (!dateTime)
         setError();
@@ -188,21 +292,7 @@ void Builder_t::buildFault(int errNumber, const std::string &errMsg) {
 void Builder_t::buildInt(Int_t::value_type value) {
     if (isError())
         return;
-    PyObject *integer = 0;
-
-#if PY_MAJOR_VERSION >= 3
-    integer = PyLong_FromLongLong(value);
-#else
-    Int_t::value_type absValue = value < 0 ? -value :value;
-
-    if ((absValue & INT31_MASK)) {
-
-        integer = PyLong_FromLongLong(value);
-    }
-    else {
-        integer = PyInt_FromLong(int32_t(value));
-    }
-#endif
+    PyObject *integer = makeInt(value);
     if (!integer)
         setError();
 
@@ -236,40 +326,8 @@ void Builder_t::buildString(const char* data, unsigned int size) {
     if (isError())
         return;
 
-    PyObject *stringVal;
-
-#if PY_MAJOR_VERSION >= 3
-# ifdef HAVE_BINARY
-    if (stringMode == STRING_MODE_STRING) {
-        stringVal = PyBytes_FromStringAndSize(data, size);
-    } else {
-        stringVal = PyUnicode_DecodeUTF8(data, size, "strict");
-    }
-# else
-    if (allowSurrogates)
-        stringVal = PyUnicode_DecodeUTF8(data, size, "surrogatepass");
-    else
-        stringVal = PyUnicode_DecodeUTF8(data, size, "strict");
-# endif
-#else
-    bool utf8 = (stringMode == STRING_MODE_UNICODE);
-
-    // check 8-bit string only iff mixed
-    if (stringMode == STRING_MODE_MIXED) {
-        for (long i = 0; i < size; i++) {
-            if (data[i] & 0x80) {
-                utf8 = true;
-                break;
-            }
-        }
-    }
-
-    if (utf8) {
-        stringVal = PyUnicode_DecodeUTF8(data, size, "strict");
-    } else {
-        stringVal = PyString_FromStringAndSize(const_cast<char*>(data), size);
-    }
-#endif
+    PyObject *stringVal = makeString(data, size, stringMode,
+                                     allowSurrogates);
 
     if (!stringVal)
         setError();
@@ -281,14 +339,14 @@ void Builder_t::buildString(const char* data, unsigned int size) {
 void Builder_t::buildStructMember(const char *memberName, unsigned int size ) {
     if (isError())
         return;
-    std::string buf(memberName,size);
-    this->memberName =  buf;
-
+    Py_XDECREF(memberKey);
+    memberKey = keyCache->get(memberName, size);
+    if (!memberKey)
+        setError();
 }
 void Builder_t::buildStructMember(const std::string &memberName) {
-    if (isError())
-        return;
-    this->memberName = memberName;
+    buildStructMember(memberName.data(),
+                      static_cast<unsigned int>(memberName.size()));
 }
 void Builder_t::closeArray() {
     if (isError())
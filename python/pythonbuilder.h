@@ -40,6 +40,7 @@
 #include <Python.h>
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <frpcdatabuilder.h>
@@ -59,6 +60,60 @@ const Int_t::value_type INT31_MASK = ALLONES << 31;
 
 StringMode_t parseStringMode(const char *stringMode);
 
+/**
+ * @short Python objects of the FastRPC values
+ *
+ * Shared by the builder and the binary decoder, all of them return new
+ * reference or 0 on error.
+ */
+PyObject* makeInt(Int_t::value_type value);
+PyObject* makeString(const char *data, std::size_t size,
+                     StringMode_t stringMode, bool allowSurrogates = false);
+PyObject* makeBinary(const char *data, std::size_t size);
+PyObject* makeBool(bool value, bool nativeBoolean);
+PyObject* makeDateTime(PyObject *datetimeBuilder, short year, char month,
+                       char day, char hour, char min, char sec, char weekDay,
+                       time_t unixTime, int timeZone);
+
+/**
+ * @short Cache of struct member names as Python objects
+ *
+ * Records of a response usually share their member names, the names are
+ * created (and interned) just once then. It has to be used with the GIL
+ * held.
+ */
+class KeyCache_t
+{
+public:
+    //! default maximum of cached names
+    static const std::size_t DEFAULT_LIMIT = 4096;
+
+    explicit KeyCache_t(std::size_t limit = DEFAULT_LIMIT)
+        : limit(limit)
+    {}
+
+    ~KeyCache_t() {
+        clear();
+    }
+
+    KeyCache_t(const KeyCache_t &) = delete;
+    KeyCache_t& operator=(const KeyCache_t &) = delete;
+
+    /**
+     * @short Returns new reference to the member name, 0 on error
+     *
+     * Names beyond the limit are created without caching.
+     */
+    PyObject* get(const char *data, std::size_t size);
+
+    void clear();
+
+private:
+    std::size_t limit;
+    std::unordered_map<std::string, PyObject*> keys;
+    std::string lookup; //!< buffer for looking up without allocation
+};
+
 struct TypeStorage_t
 {
 
@@ -79,7 +134,8 @@ public:
     Builder_t(PyObject *methodObject, StringMode_t stringMode, bool nativeBoolean = true, PyObject *datetimeBuilder = 0)
         : FRPC::DataBuilderWithNull_t(), first(true), error(false), retValue(Py_None),
           methodObject(methodObject), methodName(0), stringMode(stringMode), nativeBoolean(nativeBoolean),
-        datetimeBuilder(datetimeBuilder), allowSurrogates(false)
+        datetimeBuilder(datetimeBuilder), allowSurrogates(false),
+          memberKey(0), keyCache(&callKeys)
     {
         Py_INCREF(retValue);
     }
@@ -87,6 +143,7 @@ public:
     ~Builder_t() {
         delete methodName;
         Py_XDECREF(retValue);
+        Py_XDECREF(memberKey);
     }
 
     virtual void buildMethodResponse();
@@ -163,51 +220,15 @@ public:
             break;
         case STRUCT:
             {
-
-                bool utf8 = false;
-                for(size_t i = 0; i < memberName.size(); i++)
+                if(!memberKey
+                   || PyDict_SetItem(entityStorage.back().container,
+                                     memberKey, value) !=0 )
                 {
-                    if(memberName[i] & 0x80)
-                    {
-                        utf8 = true;
-                        break;
-                    }
-                }
-
-                if(utf8)
-                {
-                    PyObject *pyMemberName =
-                        PyUnicode_DecodeUTF8(memberName.data(),
-                                             memberName.size(), "strict");
-                    if(pyMemberName == 0x00)
-                    {
-                        setError();
-                        Py_DECREF(value);
-                        return false;
-                    }
-
-                    if(PyDict_SetItem(entityStorage.back().container,
-                                      pyMemberName, value) !=0 )
-
-                    {
-                        setError();
-                        Py_DECREF(value);
-                        return false;
-                    }
-                    Py_DECREF(value);
-                }
-                else
-                {
-                    if(PyDict_SetItemString(entityStorage.back().container,
-                                            const_cast<char*>(memberName.c_str()),
-                                            value) !=0 )
-                    {
-                        setError();
-                        Py_DECREF(value);
-                        return false;
-                    }
+                    setError();
                     Py_DECREF(value);
+                    return false;
                 }
+                Py_DECREF(value);
                 //entityStorage.back().numOfItems--;
             }
             break;
@@ -246,11 +267,15 @@ public:
     PyObject * getRetValue() { return retValue; }
 
     void enableSurrogatePass() { allowSurrogates = true; }
+
+    /**
+     * @short Uses given cache of member names instead of per call one
+     */
+    void setKeyCache(KeyCache_t *cache) { keyCache = cache; }
 private :
     bool first;
     bool error;
     PyObject *retValue;
-    std::string memberName;
     std::vector<TypeStorage_t> entityStorage;
     PyObject *methodObject;
     std::string *methodName;
@@ -259,6 +284,9 @@ private :
     //NOTE: Either null or ref managed by owner
     PyObject *datetimeBuilder;
     bool allowSurrogates;
+    PyObject *memberKey;  //!< name of the member being built
+    KeyCache_t callKeys;
+    KeyCache_t *keyCache;
 };
 
 
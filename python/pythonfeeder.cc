@@ -125,6 +125,48 @@ void Feeder_t::feed(PyObject *args)
 
 void Feeder_t::feedValue(PyObject *value)
 {
+    // the most common types are recognized by the exact type first,
+    // subclasses and the other types go through the checks below
+    PyTypeObject *type = Py_TYPE(value);
+#if PY_MAJOR_VERSION >= 3
+    if (type == &PyUnicode_Type) {
+        // the UTF-8 representation is cached by the string
+        Py_ssize_t strLen;
+        const char *str = PyUnicode_AsUTF8AndSize(value, &strLen);
+        if (!str) throw PyError_t();
+
+        marshaller->packString(str, strLen);
+        return;
+    }
+#else
+    if (type == &PyInt_Type) {
+        marshaller->packInt(PyInt_AS_LONG(value));
+        return;
+    }
+#endif
+    if (type == &PyLong_Type) {
+        int overflow;
+        PY_LONG_LONG number = PyLong_AsLongLongAndOverflow(value, &overflow);
+        if (!overflow) {
+            if ((number == -1) && PyErr_Occurred()) throw PyError_t();
+            marshaller->packInt(number);
+            return;
+        }
+        // unsigned 64 bit values are handled below
+    } else if (type == &PyDict_Type) {
+        feedStruct(value);
+        return;
+    } else if (type == &PyList_Type) {
+        feedArray(value);
+        return;
+    } else if (type == &PyFloat_Type) {
+        marshaller->packDouble(PyFloat_AS_DOUBLE(value));
+        return;
+    } else if (value == Py_None) {
+        feedNull();
+        return;
+    }
+
 #if PYTHON_API_VERSION >= 1012
     if (PyBool_Check(value)) {
         marshaller->packBool(PyObject_IsTrue(value));
@@ -234,59 +276,10 @@ void Feeder_t::feedValue(PyObject *value)
 
         marshaller->packString(str, strLen);
 #endif
-    } else if (PyList_Check(value)) {
-        int argc = PyList_GET_SIZE(value);
-
-        marshaller->packArray(argc);
-
-        for (int pos = 0; pos < argc; ++pos)
-            feedValue(PyList_GET_ITEM(value, pos));
-    } else if (PyTuple_Check(value)) {
-        int argc = PyTuple_GET_SIZE(value);
-
-        marshaller->packArray(argc);
-
-        for (int pos = 0; pos < argc; ++pos)
-            feedValue(PyTuple_GET_ITEM(value, pos));
+    } else if (PyList_Check(value) || PyTuple_Check(value)) {
+        feedArray(value);
     } else if (PyDict_Check(value)) {
-        Py_ssize_t argc = PyDict_Size(value);
-        Py_ssize_t pos = 0;
-        PyObject *key, *member;
-
-        marshaller->packStruct(argc);
-
-        while (PyDict_Next(value, &pos, &key, &member)) {
-#if PY_MAJOR_VERSION >= 3
-            if(!PyUnicode_Check(key)) {
-                PyErr_SetString(PyExc_TypeError,
-                                "Key in Dictionary must be a string.");
-                throw PyError_t();
-            }
-            PyObjectWrapper_t skey(key, true);
-#else
-            if(!PyString_Check(key) && !PyUnicode_Check(key)) {
-                PyErr_SetString(PyExc_TypeError,
-                                "Key in Dictionary must be either string or unicode.");
-                throw PyError_t();
-            }
-
-            PyObjectWrapper_t skey(key, true);
-            if (PyUnicode_Check(key)) {
-                skey = PyObjectWrapper_t(PyUnicode_AsUTF8String(key));
-                if (!skey)
-                    throw PyError_t();
-            }
-#endif
-
-            PyStrDataType_t str;
-            Py_ssize_t strLen;
-            STR_ASSTRANDSIZE(key, str, strLen) {
-                throw PyError_t();
-            }
-
-            marshaller->packStructMember(str, strLen);
-            feedValue(member);
-        }
+        feedStruct(value);
     } else if ((dateTimeDateTime
             && (PyObject_IsInstance(value, dateTimeDateTime) == 1))
             || (mxDateTime && (PyObject_IsInstance(value, mxDateTime) == 1))) {
@@ -304,16 +297,6 @@ void Feeder_t::feedValue(PyObject *value)
                                  timestamp,
                                  -1);
 
-    } else if (value == Py_None) {
-        //NOTE: Base64Marshaller is inherited from BinMarshaller_t
-        FRPC::BinMarshaller_t *binMarshaller(dynamic_cast<FRPC::BinMarshaller_t*>(marshaller));
-        if (binMarshaller) {
-            binMarshaller->packNull();
-        } else if ( dynamic_cast<FRPC::JSONMarshaller_t*>(marshaller) ) {
-            dynamic_cast<FRPC::JSONMarshaller_t*>(marshaller)->packNull();
-        } else {
-            dynamic_cast<FRPC::XmlMarshaller_t&>(*marshaller).packNull();
-        }
     } else {
 
         std::string objectRepr = "unknown";
@@ -332,6 +315,80 @@ void Feeder_t::feedValue(PyObject *value)
     }
 }
 
+void Feeder_t::feedArray(PyObject *value)
+{
+    if (PyList_Check(value)) {
+        int argc = PyList_GET_SIZE(value);
+
+        marshaller->packArray(argc);
+
+        for (int pos = 0; pos < argc; ++pos)
+            feedValue(PyList_GET_ITEM(value, pos));
+    } else {
+        int argc = PyTuple_GET_SIZE(value);
+
+        marshaller->packArray(argc);
+
+        for (int pos = 0; pos < argc; ++pos)
+            feedValue(PyTuple_GET_ITEM(value, pos));
+    }
+}
+
+void Feeder_t::feedStruct(PyObject *value)
+{
+    Py_ssize_t argc = PyDict_Size(value);
+    Py_ssize_t pos = 0;
+    PyObject *key, *member;
+
+    marshaller->packStruct(argc);
+
+    while (PyDict_Next(value, &pos, &key, &member)) {
+#if PY_MAJOR_VERSION >= 3
+        if(!PyUnicode_Check(key)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "Key in Dictionary must be a string.");
+            throw PyError_t();
+        }
+        PyObjectWrapper_t skey(key, true);
+#else
+        if(!PyString_Check(key) && !PyUnicode_Check(key)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "Key in Dictionary must be either string or unicode.");
+            throw PyError_t();
+        }
+
+        PyObjectWrapper_t skey(key, true);
+        if (PyUnicode_Check(key)) {
+            skey = PyObjectWrapper_t(PyUnicode_AsUTF8String(key));
+            if (!skey)
+                throw PyError_t();
+        }
+#endif
+
+        PyStrDataType_t str;
+        Py_ssize_t strLen;
+        STR_ASSTRANDSIZE(key, str, strLen) {
+            throw PyError_t();
+        }
+
+        marshaller->packStructMember(str, strLen);
+        feedValue(member);
+    }
+}
+
+void Feeder_t::feedNull()
+{
+    //NOTE: Base64Marshaller is inherited from BinMarshaller_t
+    FRPC::BinMarshaller_t *binMarshaller(dynamic_cast<FRPC::BinMarshaller_t*>(marshaller));
+    if (binMarshaller) {
+        binMarshaller->packNull();
+    } else if ( dynamic_cast<FRPC::JSONMarshaller_t*>(marshaller) ) {
+        dynamic_cast<FRPC::JSONMarshaller_t*>(marshaller)->packNull();
+    } else {
+        dynamic_cast<FRPC::XmlMarshaller_t&>(*marshaller).packNull();
+    }
+}
+
 extern "C"  {
 
 FRPC::Python::FeederInterface_t * create_frpc_python_feeder(FRPC::Marshaller_t *marshaller,const std::string *encoding) {
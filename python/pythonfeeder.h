@@ -59,6 +59,10 @@ public:
 
 private:
     Feeder_t();
+    void feedArray(PyObject *value);
+    void feedStruct(PyObject *value);
+    void feedNull();
+
     FRPC::Marshaller_t *marshaller;
     const std::string encoding;
 };
@@ -67,6 +67,7 @@
 #include "fastrpcmodule.h"
 #include "pythonbuilder.h"
 #include "pythonfeeder.h"
+#include "recordingbuilder.h"
 
 #if PY_VERSION_HEX < 0x02050000 && !defined(PY_SSIZE_T_MIN)
 typedef int Py_ssize_t;
@@ -80,6 +81,8 @@ using FRPC::Python::PyObjectWrapper_t;
 using FRPC::Python::Fault;
 using FRPC::Python::Builder_t;
 using FRPC::Python::Feeder_t;
+using FRPC::Python::RecordingBuilder_t;
+using FRPC::Python::AllowThreads_t;
 
 inline unsigned int chooseType(unsigned int type) {
     switch(type) {
@@ -464,7 +467,7 @@ namespace {
               outType(FRPC::Server_t::XML_RPC), closeConnection(true),
               contentLength(0), useChunks(false), headersSent(false),
             head(false), useBinary(serverObject->useBinary),
-            allowSurrogates(false)
+            allowSurrogates(false), serving(false)
         {}
 
         ~Server_t() {}
@@ -483,7 +486,15 @@ namespace {
 
         void enableSurrogatePass() { allowSurrogates = true; }
 
+        ServerObject* getServerObject() const { return serverObject; }
+
+        /** Tells whether a connection is being served by this engine. */
+        bool isServing() const { return serving; }
+
     private:
+        /**
+         * @short Reads and parses the request, runs without the GIL
+         */
         void readRequest(FRPC::DataBuilder_t &builder);
 
         PyObject* headersToPyList(const FRPC::HTTPHeader_t &headers,
@@ -497,6 +508,9 @@ namespace {
 
         /**
          * @brief write data to server
+         *
+         * The data are only buffered, they are sent by flush().
+         *
          * @param data pointer to data
          * @param size size of data
          */
@@ -532,6 +546,7 @@ namespace {
         ProtocolVersion_t protocolVersion;
         bool useBinary;
         bool allowSurrogates;
+        bool serving;
 
         /** HTTP headers received in client's request. */
         FRPC::HTTPHeader_t headersIn;
@@ -757,6 +772,18 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
 
     io.setSocket(fd);
 
+    // the socket is owned by the caller
+    struct ServingGuard_t {
+        ServingGuard_t(Server_t &server) : server(server) {
+            server.serving = true;
+        }
+        ~ServingGuard_t() {
+            server.io.setSocket(-1);
+            server.serving = false;
+        }
+        Server_t &server;
+    } servingGuard(*this);
+
     if (addr == Py_None) {
         struct sockaddr_in clientaddr;
         socklen_t sinSize = sizeof (clientaddr);
@@ -778,6 +805,9 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
         // fix for utf-8 surrogates, if requested by the caller
         if (allowSurrogates) builder.enableSurrogatePass();
 
+        // request parsed without the GIL
+        RecordingBuilder_t request;
+
         try {
             // call preprocessor
             if (serverObject->registry->preRead != Py_None) {
@@ -791,8 +821,13 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
                      }
             }
 
-            readRequest(builder);
+            {
+                AllowThreads_t allowThreads;
+                readRequest(request);
+            }
+            request.replay(builder);
         } catch (const FRPC::StreamError_t &streamError) {
+            AllowThreads_t allowThreads;
             std::auto_ptr<FRPC::Marshaller_t> marshaller
                 (FRPC::Marshaller_t::create
                  (chooseType(outType), *this,protocolVersion));
@@ -802,6 +837,7 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
             marshaller->flush();
             continue;
         } catch (const FRPC::HTTPError_t &httpError) {
+            AllowThreads_t allowThreads;
             sendHttpError(httpError);
             break;
         } catch (const FRPC::ProtocolError_t &pe) {
@@ -837,6 +873,7 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
                     if (r)
                         throw FRPC::HTTPError_t(FRPC::HTTP_SERVICE_UNAVAILABLE,
                                                 "Service Unavailable");
+                    AllowThreads_t allowThreads;
                     flush();
                 } else {
                     throw FRPC::HTTPError_t(FRPC::HTTP_METHOD_NOT_ALLOWED,
@@ -885,6 +922,9 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
                         marshaller->packMethodResponse();
                         feeder.feedValue(result);
                     }
+
+                    // the response is buffered, send it without the GIL
+                    AllowThreads_t allowThreads;
                     marshaller->flush();
                 } catch (const PyError_t &) {
                     // oops error during processing result
@@ -907,6 +947,7 @@ PyObject* Server_t::serve(int fd, PyObjectWrapper_t addr) {
                 }
             }
         } catch (const FRPC::HTTPError_t &httpError) {
+            AllowThreads_t allowThreads;
             sendHttpError(httpError);
             break;
         } catch (const PyError_t &) {
@@ -1102,17 +1143,8 @@ void Server_t::flush() {
 void Server_t::write(const char* data, unsigned int size) {
     contentLength += size;
 
-    if (size > BUFFER_SIZE - queryStorage.back().size()) {
-        if(useChunks)  {
-            sendResponse();
-            queryStorage.back().append(data, size);
-        } else  {
-            if (size > BUFFER_SIZE) {
-                queryStorage.push_back(std::string(data, size));
-            } else {
-                queryStorage.back().append(data, size);
-            }
-        }
+    if (size > BUFFER_SIZE) {
+        queryStorage.push_back(std::string(data, size));
     } else {
         queryStorage.back().append(data, size);
     }
@@ -1182,25 +1214,29 @@ void Server_t::sendResponse() {
         if (head) return;
     }
 
-    if (useChunks) {
-        // write chunk size
-        std::ostringstream os;
-        os << std::hex << queryStorage.back().size() << "\r\n";
-        io.sendData(os.str());
-        // write chunk
-        io.sendData(queryStorage.back().data(),queryStorage.back().size());
-        // write chunk terminator
-        io.sendData("\r\n", 2);
-        queryStorage.back().erase();
-    } else {
-        while (queryStorage.size() != 1) {
-            io.sendData(queryStorage.front().data(),queryStorage.front().size());
-            queryStorage.pop_front();
-        }
+    for (std::list<std::string>::const_iterator
+             iqueryStorage = queryStorage.begin();
+         iqueryStorage != queryStorage.end(); ++iqueryStorage)
+    {
+        if (useChunks) {
+            // empty chunk would terminate the body
+            if (iqueryStorage->empty()) continue;
 
-        io.sendData(queryStorage.back().data(),queryStorage.back().size());
-        queryStorage.back().erase();
+            // write chunk size
+            std::ostringstream os;
+            os << std::hex << iqueryStorage->size() << "\r\n";
+            io.sendData(os.str());
+            // write chunk
+            io.sendData(iqueryStorage->data(), iqueryStorage->size());
+            // write chunk terminator
+            io.sendData("\r\n", 2);
+        } else {
+            io.sendData(iqueryStorage->data(), iqueryStorage->size());
+        }
     }
+
+    queryStorage.erase(queryStorage.begin(), --queryStorage.end());
+    queryStorage.back().erase();
 }
 
 void Server_t::sendHttpError(const FRPC::HTTPError_t &httpError) {
@@ -2127,6 +2163,20 @@ PyObject* ServerObject_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return selfHolder.inc();
 }
 
+namespace {
+    /** Engine serving the connection in this thread. */
+    thread_local Server_t *activeServer = 0;
+
+    /**
+     * @short Returns the engine serving the current request of the server
+     */
+    Server_t* getServer(ServerObject *self) {
+        if (activeServer && (activeServer->getServerObject() == self))
+            return activeServer;
+        return self->server;
+    }
+}
+
 static DECL_METHOD(ServerObject, serve) {
     // parse arguments
     PyObject *file;
@@ -2140,18 +2190,36 @@ static DECL_METHOD(ServerObject, serve) {
     if (fd == -1)
         return 0;
 
+    // connections served concurrently (the GIL is released during I/O)
+    // need their own engine
+    std::unique_ptr<Server_t> ownServer;
+    Server_t *server = self->server;
+    if (server->isServing()) {
+        ownServer.reset(new Server_t(self));
+        if (self->allowSurrogates) ownServer->enableSurrogatePass();
+        server = ownServer.get();
+    }
+
+    struct ActiveServer_t {
+        ActiveServer_t(Server_t *server) : previous(activeServer) {
+            activeServer = server;
+        }
+        ~ActiveServer_t() { activeServer = previous; }
+        Server_t *previous;
+    } active(server);
+
     // handle the connection
-    return self->server->serve(fd, PyObjectWrapper_t(clientIP, true));
+    return server->serve(fd, PyObjectWrapper_t(clientIP, true));
 }
 
 
 static DECL_METHOD(ServerObject, getInHeaders) {
-    return self->server->getInHeaders();
+    return getServer(self)->getInHeaders();
 }
 
 
 static DECL_METHOD(ServerObject, getOutHeaders) {
-    return self->server->getOutHeaders();
+    return getServer(self)->getOutHeaders();
 }
 
 
@@ -2162,7 +2230,7 @@ static DECL_METHOD(ServerObject, getInHeadersFor) {
         PyErr_SetString(PyExc_ValueError, "No header name specified");
         return 0;
     }
-    return self->server->getInHeadersFor(name);
+    return getServer(self)->getInHeadersFor(name);
 }
 
 
@@ -2173,7 +2241,7 @@ static DECL_METHOD(ServerObject, getOutHeadersFor) {
         PyErr_SetString(PyExc_ValueError, "No header name specified");
         return 0;
     }
-    return self->server->getOutHeadersFor(name);
+    return getServer(self)->getOutHeadersFor(name);
 }
 
 
@@ -2185,7 +2253,7 @@ static DECL_METHOD(ServerObject, addOutHeader) {
         PyErr_SetString(PyExc_ValueError, "Invalid header name/value specified");
         return 0;
     }
-    self->server->addOutHeader(key, value);
+    getServer(self)->addOutHeader(key, value);
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -0,0 +1,258 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Builder recording the unmarshalled data into
+ * a native buffer, they are built as Python objects later.
+ *
+ */
+
+#include <cstring>
+
+#include "recordingbuilder.h"
+
+namespace FRPC { namespace Python {
+
+void RecordingBuilder_t::buildMethodResponse() {
+    put(METHOD_RESPONSE);
+}
+
+void RecordingBuilder_t::buildBinary(const char* data, unsigned int size) {
+    put(BINARY, data, size);
+}
+
+void RecordingBuilder_t::buildBinary(const std::string &data) {
+    buildBinary(data.data(), static_cast<unsigned int>(data.size()));
+}
+
+void RecordingBuilder_t::buildBool(bool value) {
+    put(BOOL);
+    put(value);
+}
+
+void RecordingBuilder_t::buildDateTime(short year, char month, char day,
+                                       char hour, char min, char sec,
+                                       char weekDay, time_t unixTime,
+                                       int timeZone)
+{
+    put(DATETIME);
+    put(year);
+    const char fields[] = {month, day, hour, min, sec, weekDay};
+    record.append(fields, sizeof(fields));
+    put(unixTime);
+    put(timeZone);
+}
+
+void RecordingBuilder_t::buildDouble(double value) {
+    put(DOUBLE);
+    put(value);
+}
+
+void RecordingBuilder_t::buildFault(int errNumber, const char* errMsg,
+                                    unsigned int size)
+{
+    put(FAULT, errMsg, size);
+    put(errNumber);
+}
+
+void RecordingBuilder_t::buildFault(int errNumber, const std::string &errMsg) {
+    buildFault(errNumber, errMsg.data(),
+               static_cast<unsigned int>(errMsg.size()));
+}
+
+void RecordingBuilder_t::buildInt(Int_t::value_type value) {
+    put(INT);
+    put(value);
+}
+
+void RecordingBuilder_t::buildMethodCall(const char* methodName,
+                                         unsigned int size)
+{
+    put(METHOD_CALL, methodName, size);
+}
+
+void RecordingBuilder_t::buildMethodCall(const std::string &methodName) {
+    buildMethodCall(methodName.data(),
+                    static_cast<unsigned int>(methodName.size()));
+}
+
+void RecordingBuilder_t::buildString(const char* data, unsigned int size) {
+    put(STRING, data, size);
+}
+
+void RecordingBuilder_t::buildString(const std::string &data) {
+    buildString(data.data(), static_cast<unsigned int>(data.size()));
+}
+
+void RecordingBuilder_t::buildStructMember(const char *memberName,
+                                           unsigned int size)
+{
+    put(STRUCT_MEMBER, memberName, size);
+}
+
+void RecordingBuilder_t::buildStructMember(const std::string &memberName) {
+    buildStructMember(memberName.data(),
+                      static_cast<unsigned int>(memberName.size()));
+}
+
+void RecordingBuilder_t::closeArray() {
+    put(CLOSE_ARRAY);
+}
+
+void RecordingBuilder_t::closeStruct() {
+    put(CLOSE_STRUCT);
+}
+
+void RecordingBuilder_t::openArray(unsigned int numOfItems) {
+    put(OPEN_ARRAY);
+    put(numOfItems);
+}
+
+void RecordingBuilder_t::openStruct(unsigned int numOfMembers) {
+    put(OPEN_STRUCT);
+    put(numOfMembers);
+}
+
+void RecordingBuilder_t::buildNull() {
+    put(NULL_VALUE);
+}
+
+namespace {
+
+/** Reads values back from the record. */
+class Reader_t {
+public:
+    Reader_t(const std::string &record)
+        : pos(record.data()), end(record.data() + record.size())
+    {}
+
+    bool eof() const { return pos == end; }
+
+    template <typename Value_t>
+    Value_t get() {
+        Value_t value;
+        memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    const char *data(unsigned int size) {
+        const char *result = pos;
+        pos += size;
+        return result;
+    }
+
+private:
+    const char *pos;
+    const char *end;
+};
+
+} // namespace
+
+void RecordingBuilder_t::replay(FRPC::DataBuilderWithNull_t &builder) const {
+    Reader_t reader(record);
+    while (!reader.eof()) {
+        switch (reader.get<Event_t>()) {
+        case METHOD_RESPONSE:
+            builder.buildMethodResponse();
+            break;
+
+        case BINARY: {
+                unsigned int size = reader.get<unsigned int>();
+                builder.buildBinary(reader.data(size), size);
+            }
+            break;
+
+        case BOOL:
+            builder.buildBool(reader.get<bool>());
+            break;
+
+        case DATETIME: {
+                short year = reader.get<short>();
+                const char *fields = reader.data(6);
+                time_t unixTime = reader.get<time_t>();
+                int timeZone = reader.get<int>();
+                builder.buildDateTime(year, fields[0], fields[1], fields[2],
+                                      fields[3], fields[4], fields[5],
+                                      unixTime, timeZone);
+            }
+            break;
+
+        case DOUBLE:
+            builder.buildDouble(reader.get<double>());
+            break;
+
+        case FAULT: {
+                unsigned int size = reader.get<unsigned int>();
+                const char *message = reader.data(size);
+                builder.buildFault(reader.get<int>(), message, size);
+            }
+            break;
+
+        case INT:
+            builder.buildInt(reader.get<Int_t::value_type>());
+            break;
+
+        case METHOD_CALL: {
+                unsigned int size = reader.get<unsigned int>();
+                builder.buildMethodCall(reader.data(size), size);
+            }
+            break;
+
+        case STRING: {
+                unsigned int size = reader.get<unsigned int>();
+                builder.buildString(reader.data(size), size);
+            }
+            break;
+
+        case STRUCT_MEMBER: {
+                unsigned int size = reader.get<unsigned int>();
+                builder.buildStructMember(reader.data(size), size);
+            }
+            break;
+
+        case CLOSE_ARRAY:
+            builder.closeArray();
+            break;
+
+        case CLOSE_STRUCT:
+            builder.closeStruct();
+            break;
+
+        case OPEN_ARRAY:
+            builder.openArray(reader.get<unsigned int>());
+            break;
+
+        case OPEN_STRUCT:
+            builder.openStruct(reader.get<unsigned int>());
+            break;
+
+        case NULL_VALUE:
+            builder.buildNull();
+            break;
+        }
+    }
+}
+
+} } // namespace FRPC::Python
@@ -0,0 +1,110 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * $Id: $
+ *
+ * DESCRIPTION
+ * Python FastRPC support. Builder recording the unmarshalled data into
+ * a native buffer, they are built as Python objects later.
+ *
+ */
+
+#ifndef RECORDINGBUILDER_H_
+#define RECORDINGBUILDER_H_
+
+#include <string>
+
+#include <frpcdatabuilder.h>
+
+namespace FRPC { namespace Python {
+
+/**
+ * @short Records data built by an unmarshaller and replays them later.
+ *
+ * No Python object is touched while recording, so the unmarshaller can run
+ * without the GIL. The recorded data are then replayed into the Python
+ * Builder_t with the GIL held. Strings and binaries are passed to the
+ * target builder directly from the record.
+ */
+class RecordingBuilder_t : public FRPC::DataBuilderWithNull_t
+{
+public:
+    RecordingBuilder_t() = default;
+
+    virtual void buildMethodResponse();
+    virtual void buildBinary(const char* data, unsigned int size);
+    virtual void buildBinary(const std::string &data);
+    virtual void buildBool(bool value);
+    virtual void buildDateTime(short year, char month, char day, char hour,
+                               char min, char sec, char weekDay,
+                               time_t unixTime, int timeZone);
+    virtual void buildDouble(double value);
+    virtual void buildFault(int errNumber, const char* errMsg,
+                            unsigned int size);
+    virtual void buildFault(int errNumber, const std::string &errMsg);
+    virtual void buildInt(Int_t::value_type value);
+    virtual void buildMethodCall(const char* methodName, unsigned int size);
+    virtual void buildMethodCall(const std::string &methodName);
+    virtual void buildString(const char* data, unsigned int size);
+    virtual void buildString(const std::string &data);
+    virtual void buildStructMember(const char *memberName, unsigned int size);
+    virtual void buildStructMember(const std::string &memberName);
+    virtual void closeArray();
+    virtual void closeStruct();
+    virtual void openArray(unsigned int numOfItems);
+    virtual void openStruct(unsigned int numOfMembers);
+    virtual void buildNull();
+
+    /**
+     * @short Builds the recorded data by given builder.
+     */
+    void replay(FRPC::DataBuilderWithNull_t &builder) const;
+
+    /**
+     * @short Forgets the recorded data.
+     */
+    void clear() { record.clear(); }
+
+private:
+    enum Event_t : char {
+        METHOD_RESPONSE, BINARY, BOOL, DATETIME, DOUBLE, FAULT, INT,
+        METHOD_CALL, STRING, STRUCT_MEMBER, CLOSE_ARRAY, CLOSE_STRUCT,
+        OPEN_ARRAY, OPEN_STRUCT, NULL_VALUE
+    };
+
+    template <typename Value_t>
+    void put(const Value_t &value) {
+        record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void put(Event_t event, const char *data, unsigned int size) {
+        put(event);
+        put(size);
+        record.append(data, size);
+    }
+
+    std::string record; //!< events with their arguments
+};
+
+} } // namespace FRPC::Python
+
+#endif // RECORDINGBUILDER_H_
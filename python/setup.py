@@ -108,6 +108,9 @@ setup(
             "pyerrors.cc",
             "pythonbuilder.cc",
             "pythonfeeder.cc",
+            "recordingbuilder.cc",
+            "iothreads.cc",
+            "binarydecoder.cc",
         ], libraries=["fastrpc"]),
     ], headers=[
         "frpcpythonhelper.h",
@@ -115,6 +118,9 @@ setup(
         "pythonbuilder.h",
         "pythoncompat.h",
         "pythonfeeder.h",
+        "recordingbuilder.h",
+        "iothreads.h",
+        "binarydecoder.h",
         "fastrpcmodule.h",
     ], install_requires=[
         "pkginfo",
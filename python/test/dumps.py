@@ -0,0 +1,66 @@
+import fastrpc
+import unittest
+
+
+class DumpsTest(unittest.TestCase):
+
+    def roundtrip(self, value):
+        data = fastrpc.dumps((value,), useBinary=True, methodresponse=True,
+                             protocolVersionMajor=3, protocolVersionMinor=0)
+        return fastrpc.loads(data)[0]
+
+    def test_types(self):
+        class Int(int):
+            pass
+
+        class Dict(dict):
+            pass
+
+        class List(list):
+            pass
+
+        value = {"int": Int(7), "big": 2 ** 62, "neg": -2 ** 63,
+                 "dict": Dict(a=1), "list": List([1, None]),
+                 "tuple": (1.5, u"x"), "none": None}
+        self.assertEqual(self.roundtrip(value),
+                         {"int": 7, "big": 2 ** 62, "neg": -2 ** 63,
+                          "dict": {"a": 1}, "list": [1, None],
+                          "tuple": [1.5, u"x"], "none": None})
+        self.assertRaises(OverflowError, fastrpc.dumps, (2 ** 64,),
+                          useBinary=True)
+
+    def test_large(self):
+        value = [u"x" * 1000] * 1000
+        self.assertEqual(self.roundtrip(value), value)
+        self.assertEqual(self.roundtrip([]), [])
+
+    def test_dumps_into(self):
+        params = ({"a": [1, 2]},)
+        for useBinary in (True, False):
+            expected = fastrpc.dumps(params, methodname="test",
+                                     useBinary=useBinary)
+            if not isinstance(expected, bytes):
+                expected = expected.encode("utf-8")
+
+            buf = bytearray(b"garbage")
+            size = fastrpc.dumps_into(buf, params, methodname="test",
+                                      useBinary=useBinary)
+            self.assertEqual(size, len(expected))
+            self.assertEqual(bytes(buf), expected)
+
+            buf = bytearray(len(expected) + 10)
+            size = fastrpc.dumps_into(memoryview(buf), params,
+                                      methodname="test", useBinary=useBinary)
+            self.assertEqual(size, len(expected))
+            self.assertEqual(bytes(buf[:size]), expected)
+
+    def test_dumps_into_small(self):
+        buf = bytearray(8)
+        self.assertRaises(ValueError, fastrpc.dumps_into, memoryview(buf),
+                          ([1, 2, 3],), useBinary=True)
+        self.assertRaises(BufferError, fastrpc.dumps_into, b"readonly",
+                          ([1],), useBinary=True)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,81 @@
+import fastrpc
+import unittest
+
+
+VERSIONS = [(2, 1), (3, 0), (3, 2)]
+
+
+class LoadsTest(unittest.TestCase):
+
+    def dumps(self, params, version, **kwargs):
+        return fastrpc.dumps(params, useBinary=True,
+                             protocolVersionMajor=version[0],
+                             protocolVersionMinor=version[1], **kwargs)
+
+    def test_response(self):
+        record = {"id": 2 ** 40, "neg": -5, "price": 1.5,
+                  "name": u"žluťoučký", "ok": True,
+                  "tags": ["a", [], {}]}
+        for version in VERSIONS:
+            data = self.dumps(([record] * 3,), version, methodresponse=True)
+            result, method = fastrpc.loads(data)
+            self.assertEqual(result, [record] * 3)
+            self.assertEqual(method, None)
+
+    def test_call(self):
+        for version in VERSIONS:
+            data = self.dumps((1, "x", [2]), version, methodname="test.call")
+            self.assertEqual(fastrpc.loads(data), ((1, "x", [2]), "test.call"))
+
+    def test_buffer(self):
+        data = self.dumps(({"a": [1, 2]},), (3, 2), methodresponse=True)
+        expected = fastrpc.loads(data)
+        self.assertEqual(fastrpc.loads(memoryview(data)), expected)
+        self.assertEqual(fastrpc.loads(bytearray(data)), expected)
+        self.assertEqual(fastrpc.loads(memoryview(data + b"xx")[:-2]),
+                         expected)
+
+    def test_fault(self):
+        data = fastrpc.dumps(fastrpc.Fault(500, "error"), useBinary=True,
+                             methodresponse=True)
+        self.assertRaises(fastrpc.Fault, fastrpc.loads, data)
+
+    def test_nested(self):
+        value = []
+        for i in range(300):
+            value = [value]
+        data = self.dumps((value,), (2, 1), methodresponse=True)
+        result = fastrpc.loads(data)[0]
+        for i in range(300):
+            result = result[0]
+        self.assertEqual(result, [])
+
+    def test_incomplete(self):
+        data = self.dumps(({"a": [1, 2]},), (3, 2), methodresponse=True)
+        for size in (3, 6, len(data) - 1):
+            self.assertRaises(RuntimeError, fastrpc.loads, data[:size])
+        self.assertRaises(RuntimeError, fastrpc.loads, b"\xca\x11\x04\x00")
+
+    def test_member_names(self):
+        record = {"name": 1, "a\0b": 2, "a": 3, "\0": 4, u"žluť": 5}
+        for version in VERSIONS:
+            data = self.dumps(([record] * 2,), version, methodresponse=True)
+            result = fastrpc.loads(data)[0]
+            self.assertEqual(result, [record] * 2)
+            # records of a call share their member names
+            for first, second in zip(result[0], result[1]):
+                self.assertIs(first, second)
+
+    def test_member_names_limit(self):
+        record = dict(("key%d" % i, i) for i in range(5000))
+        data = self.dumps(([record] * 2,), (3, 0), methodresponse=True)
+        result = fastrpc.loads(data)[0]
+        self.assertEqual(result, [record] * 2)
+        shared = [first is second
+                  for first, second in zip(result[0], result[1])]
+        # names beyond the limit are not cached
+        self.assertEqual(shared, [True] * 4096 + [False] * 904)
+
+
+if __name__ == '__main__':
+    unittest.main()
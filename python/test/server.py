@@ -1,6 +1,9 @@
 #!/usr/bin/python
 
 import sys
+import socket
+import threading
+import time
 import fastrpc
 import unittest
 
@@ -41,6 +44,73 @@ class ServerTest(unittest.TestCase):
             self.assertEqual(exc.faultString, fault_string)
             pass
 
+    def test_concurrent(self):
+        server = fastrpc.Server(readTimeout=5000, useBinary=True)
+
+        def slow(value):
+            time.sleep(0.3)
+            return {"value": value,
+                    "header": server.getInHeadersFor("X-Value")}
+
+        server.registry.register("slow", slow)
+
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        sock.bind(("127.0.0.1", 0))
+        sock.listen(10)
+        url = "http://127.0.0.1:%d/RPC2" % sock.getsockname()[1]
+
+        def handle(conn, addr):
+            try:
+                server.serve(conn, addr)
+            except fastrpc.ProtocolError:
+                # the idle connection
+                pass
+            conn.close()
+
+        handlers = []
+
+        def accept():
+            for i in range(4):
+                conn, addr = sock.accept()
+                handler = threading.Thread(target=handle, args=(conn, addr))
+                handler.start()
+                handlers.append(handler)
+
+        acceptor = threading.Thread(target=accept)
+        acceptor.start()
+
+        # idle connection must not block the others
+        idle = socket.create_connection(sock.getsockname())
+
+        results = {}
+
+        def call(value):
+            proxy = fastrpc.ServerProxy(url, keepAlive=False,
+                                        readTimeout=5000,
+                                        useBinary=fastrpc.ALWAYS)
+            results[value] = proxy.slow(value, headers=[("X-Value", value)])
+
+        start = time.time()
+        callers = [threading.Thread(target=call, args=(str(i),))
+                   for i in range(3)]
+        for caller in callers:
+            caller.start()
+        for caller in callers:
+            caller.join()
+        elapsed = time.time() - start
+
+        idle.close()
+        acceptor.join()
+        for handler in handlers:
+            handler.join()
+        sock.close()
+
+        self.assertEqual(results,
+                         dict((str(i), {"value": str(i),
+                                        "header": [["X-Value", str(i)]]})
+                              for i in range(3)))
+        self.assertTrue(elapsed < 0.8, elapsed)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -1,9 +1,15 @@
 #!/usr/bin/python
 import fastrpc
 import unittest
+import socket
 import sys
+import threading
+import time
 if sys.version_info.major >= 3:
+    import asyncio
     import configparser
+    from socketserver import ThreadingMixIn
+    from xmlrpc.server import SimpleXMLRPCServer
 else:
     import ConfigParser as configparser
 from fastrpc import ProtocolError
@@ -155,5 +161,138 @@ class ServerProxyTest(unittest.TestCase):
         self.assertTrue(str(type(client.foo)).endswith(" 'Method'>"))
 
 
+class LocalServerProxyTest(unittest.TestCase):
+    def setUp(self):
+        self.server = fastrpc.Server(readTimeout=5000, useBinary=True)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.bind(("127.0.0.1", 0))
+        self.sock.listen(16)
+        self.url = "http://127.0.0.1:%d/RPC2" % self.sock.getsockname()[1]
+        self.stopped = False
+        self.handlers = []
+        self.acceptor = threading.Thread(target=self.accept)
+        self.acceptor.start()
+
+    def tearDown(self):
+        self.stopped = True
+        socket.create_connection(self.sock.getsockname()).close()
+        self.acceptor.join()
+        for handler in self.handlers:
+            handler.join()
+        self.sock.close()
+
+    def accept(self):
+        while True:
+            conn, addr = self.sock.accept()
+            if self.stopped:
+                conn.close()
+                return
+            handler = threading.Thread(target=self.handle, args=(conn, addr))
+            handler.start()
+            self.handlers.append(handler)
+
+    def handle(self, conn, addr):
+        try:
+            self.server.serve(conn, addr)
+        except fastrpc.ProtocolError:
+            pass
+        conn.close()
+
+    def test_concurrent(self):
+        self.server.registry.register(
+            "slow", lambda value: time.sleep(0.3) or value)
+        results = {}
+
+        def call(value):
+            client = fastrpc.ServerProxy(self.url, keepAlive=False,
+                                         readTimeout=5000)
+            results[value] = client.slow(value)
+
+        start = time.time()
+        callers = [threading.Thread(target=call, args=(i,))
+                   for i in range(2)]
+        for caller in callers:
+            caller.start()
+        for caller in callers:
+            caller.join()
+
+        # the calls overlap, the GIL is released while waiting
+        self.assertEqual(results, {0: 0, 1: 1})
+        self.assertLess(time.time() - start, 0.55)
+
+    def test_large_request(self):
+        self.server.registry.register("echo", lambda value: value)
+        value = {"text": "x" * (1 << 20), "numbers": list(range(100000))}
+        for useBinary in (fastrpc.NEVER, fastrpc.ALWAYS):
+            for useChunks in (False, True):
+                client = fastrpc.ServerProxy(self.url, keepAlive=False,
+                                             readTimeout=5000,
+                                             useBinary=useBinary,
+                                             useChunks=useChunks)
+                self.assertEqual(client.echo(value), value)
+
+    @unittest.skipIf(sys.version_info < (3, 7), "ordered dict is required")
+    def test_key_cache(self):
+        names = ["first", "second", "nul\0name", "nul", "third"]
+        record = dict((name, i) for i, name in enumerate(names))
+        self.server.registry.register("record", lambda: record)
+
+        def shared(**kwargs):
+            client = fastrpc.ServerProxy(self.url, keepAlive=False,
+                                         readTimeout=5000,
+                                         useBinary=fastrpc.ALWAYS, **kwargs)
+            first, second = client.record(), client.record()
+            self.assertEqual(first, record)
+            self.assertEqual(second, record)
+            return [a is b for a, b in zip(first, second)]
+
+        # names beyond keyCacheSize are created anew for every call
+        self.assertEqual(shared(keyCacheSize=3),
+                         [True, True, True, False, False])
+        self.assertEqual(shared(keyCacheSize=100), [True] * 5)
+
+
+@unittest.skipIf(sys.version_info < (3, 7), "asyncio is required")
+class AsyncServerProxyTest(unittest.TestCase):
+    def setUp(self):
+        class Server(ThreadingMixIn, SimpleXMLRPCServer):
+            daemon_threads = True
+            request_queue_size = 16
+
+        self.server = Server(("127.0.0.1", 0), logRequests=False)
+        self.server.register_function(
+            lambda seconds: time.sleep(seconds) or seconds, "sleep")
+        threading.Thread(target=self.server.serve_forever).start()
+        self.url = "http://127.0.0.1:%d/RPC2" % self.server.server_address[1]
+
+    def tearDown(self):
+        self.server.shutdown()
+        self.server.server_close()
+
+    def run_loop(self, calls):
+        loop = asyncio.new_event_loop()
+        asyncio.set_event_loop(loop)
+        try:
+            return loop.run_until_complete(asyncio.gather(*calls()))
+        finally:
+            asyncio.set_event_loop(None)
+            loop.close()
+
+    def test_concurrent(self):
+        client = fastrpc.AsyncServerProxy(
+            self.url, readTimeout=5000, maxConnections=4)
+
+        start = time.time()
+        result = self.run_loop(lambda: [client.sleep(0.2) for _ in range(4)])
+        self.assertEqual(result, [0.2] * 4)
+        self.assertLess(time.time() - start, 0.6)
+
+    def test_raise(self):
+        client = fastrpc.AsyncServerProxy(
+            "http://127.0.0.1:1/RPC2", connectTimeout=1000)
+
+        self.assertRaises(fastrpc.ProtocolError, self.run_loop,
+                          lambda: [client.system.listMethods()])
+
 if __name__ == '__main__':
     unittest.main()
@@ -34,6 +34,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <algorithm>
 #include <unordered_set>
@@ -80,6 +81,72 @@ struct HexWriter_t {
 } // namespace
 
 
+namespace {
+
+/** Two digit decimal numbers "00" - "99".
+ */
+class TwoDigits_t {
+public:
+    constexpr TwoDigits_t(): digits() {
+        for (unsigned int i = 0; i < 100; ++i) {
+            digits[2 * i] = static_cast<char>('0' + i / 10);
+            digits[2 * i + 1] = static_cast<char>('0' + i % 10);
+        }
+    }
+
+    /** Writes number 0 - 99 as two digits. */
+    char *write(char *pos, int value) const {
+        memcpy(pos, &digits[2 * value], 2);
+        return pos + 2;
+    }
+
+private:
+    char digits[200];
+};
+
+constexpr TwoDigits_t TWO_DIGITS;
+
+bool isTwoDigits(int value) {
+    return (value >= 0) && (value < 100);
+}
+
+} // namespace
+
+unsigned int formatISODateTime(char *buffer, short year, char month,
+                               char day, char hour, char minute, char sec,
+                               int timeZone)
+{
+    int tzHour = abs(timeZone / 60 / 60);
+    int tzMinute = abs(timeZone / 60 % 60);
+
+    if ((year < 0) || (year > 9999) || !isTwoDigits(month)
+        || !isTwoDigits(day) || !isTwoDigits(hour) || !isTwoDigits(minute)
+        || !isTwoDigits(sec) || !isTwoDigits(tzHour))
+    {
+        // values out of the fixed layout
+        return static_cast<unsigned int>(snprintf(
+                buffer, ISO_DATETIME_BUFFER_SIZE,
+                "%04d%02d%02dT%02d:%02d:%02d%c%02d%02d",
+                year, month, day, hour, minute, sec,
+                ((timeZone <= 0)? '+': '-'), tzHour, tzMinute));
+    }
+
+    char *pos = TWO_DIGITS.write(buffer, year / 100);
+    pos = TWO_DIGITS.write(pos, year % 100);
+    pos = TWO_DIGITS.write(pos, month);
+    pos = TWO_DIGITS.write(pos, day);
+    *pos++ = 'T';
+    pos = TWO_DIGITS.write(pos, hour);
+    *pos++ = ':';
+    pos = TWO_DIGITS.write(pos, minute);
+    *pos++ = ':';
+    pos = TWO_DIGITS.write(pos, sec);
+    *pos++ = (timeZone <= 0)? '+': '-';
+    pos = TWO_DIGITS.write(pos, tzHour);
+    pos = TWO_DIGITS.write(pos, tzMinute);
+    return static_cast<unsigned int>(pos - buffer);
+}
+
 /**
 *@brief method render iso date time forma from parameters
 
@@ -87,192 +154,176 @@ struct HexWriter_t {
 std::string getISODateTime(short year, char month,
                            char day, char hour,
                            char minute, char sec, int timeZone) {
-    char dateTime[50];
-    sprintf(dateTime, "%04d%02d%02dT%02d:%02d:%02d%c%02d%02d",
-            year, month, day, hour, minute, sec,
-            ((timeZone <= 0)? '+': '-'),
-            abs(timeZone / 60 / 60), abs(timeZone / 60 % 60));
+    char dateTime[ISO_DATETIME_BUFFER_SIZE];
+    return std::string(dateTime, formatISODateTime(dateTime, year, month, day,
+                                                   hour, minute, sec,
+                                                   timeZone));
+}
+
+namespace {
+
+bool isSpace(char ch) {
+    return (ch == ' ') || ((ch >= '\t') && (ch <= '\r'));
+}
+
+/** Reads up to given count of digits, returns the count of digits read. */
+int readNumber(const char *&pos, const char *end, int count, int &value) {
+    value = 0;
+    int i = 0;
+    for (; (i < count) && (pos != end); ++i, ++pos) {
+        unsigned int digit = static_cast<unsigned char>(*pos) - '0';
+        if (digit > 9) break;
+        value = value * 10 + static_cast<int>(digit);
+    }
+    return i;
+}
 
-    return std::string(dateTime);
+void checkRange(int value, int max) {
+    if (value > max) throw StreamError_t("Bad DATE format");
 }
 
+/** Parses the layout written by formatISODateTime(), YYYYMMDDThh:mm:ss+hhmm.
+ */
+bool parseFixedISODateTime(const char *data, short &year, char &month,
+                           char &day, char &hour, char &minute, char &sec,
+                           int &timeZone)
+{
+    unsigned int invalid = 0;
+    auto number = [&](int pos) {
+        unsigned int high = static_cast<unsigned char>(data[pos]) - '0';
+        unsigned int low = static_cast<unsigned char>(data[pos + 1]) - '0';
+        invalid |= (high > 9) | (low > 9);
+        return static_cast<int>(high * 10 + low);
+    };
+    int century = number(0), years = number(2), months = number(4);
+    int days = number(6), hours = number(9), minutes = number(12);
+    int secs = number(15), tzHour = number(18), tzMinute = number(20);
+    if (invalid || (data[8] != 'T') || (data[11] != ':') || (data[14] != ':')
+        || ((data[17] != '+') && (data[17] != '-')))
+    {
+        return false;
+    }
+
+    checkRange(months, 12);
+    checkRange(days, 31);
+    checkRange(hours, 23);
+    checkRange(minutes, 59);
+    checkRange(secs, 60);
+    checkRange(tzHour, 23);
+    checkRange(tzMinute, 59);
+    year = static_cast<short>(century * 100 + years);
+    month = static_cast<char>(months);
+    day = static_cast<char>(days);
+    hour = static_cast<char>(hours);
+    minute = static_cast<char>(minutes);
+    sec = static_cast<char>(secs);
+    timeZone = (tzHour * 60 + tzMinute) * ((data[17] == '+')? -60: 60);
+    return true;
+}
+
+} // namespace
+
 /**
 @brief method parse date time iso format from string data and his length
 and fill parameters
-*/
 
+Delimiters of the date and time parts are optional, missing time or time zone
+are zeros. Values out of range (month 13, minute 60...) are rejected; zero
+month and day are allowed, they make the null datetime.
+*/
 void parseISODateTime(const char *data, long len, short &year, char &month,
                       char &day, char &hour, char &minute, char &sec,
                       int &timeZone) {
 
+    // the layout used by FastRPC itself
+    if ((len == 22) && parseFixedISODateTime(data, year, month, day, hour,
+                                             minute, sec, timeZone))
+    {
+        return;
+    }
+
     year = 0;
     month = day = hour = minute = sec = 0;
     timeZone = 0;
-    // iterators
-    char *sit = const_cast<char*>(data);
-    char *end = const_cast<char*>(data)+len;
-
+    const char *pos = data;
+    const char *end = data + len;
+    int value;
 
     // skip leading spaces
-    while (sit != end && isspace(*sit))
-        ++sit;
-    // get year
-    std::string tmp;
-    int i = 0;
-    while (sit != end && i < 4 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+    while ((pos != end) && isSpace(*pos))
+        ++pos;
+
+    // date, the delimiters are optional
+    if (!readNumber(pos, end, 4, value))
         throw StreamError_t("Bad DATE format");
-    year = static_cast<short>(atoi(tmp.c_str()));
-
-    // skip optional delimiter
-    if (sit != end && *sit == '-')
-        ++sit;
-    // get month
-    tmp.erase();
-    i = 0;
-    while (sit != end && i < 2 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+    year = static_cast<short>(value);
+    if ((pos != end) && (*pos == '-'))
+        ++pos;
+    if (!readNumber(pos, end, 2, value))
         throw StreamError_t("Bad DATE format");
-    month = static_cast<char>(atoi(tmp.c_str()));
-
-    // skip optional delimiter
-    if (sit != end && *sit == '-')
-        ++sit;
-    // get day
-    tmp.erase();
-    i = 0;
-    while (sit != end && i < 2 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+    checkRange(value, 12);
+    month = static_cast<char>(value);
+    if ((pos != end) && (*pos == '-'))
+        ++pos;
+    if (!readNumber(pos, end, 2, value))
         throw StreamError_t("Bad DATE format");
-    day = static_cast<char>(atoi(tmp.c_str()));
+    checkRange(value, 31);
+    day = static_cast<char>(value);
 
-    // skip time delimiter
-    if (sit != end && (*sit == 'T' || *sit == 't' || *sit == ' ' ))
-        ++sit;
+    // time delimiter, the time is optional
+    if ((pos != end) && ((*pos == 'T') || (*pos == 't') || (*pos == ' ')))
+        ++pos;
     else
         return;
-    //throw StreamError_t("Bad DATE format no time");
-
-    // get hour
-    tmp.erase();
-    i = 0;
-    while (sit != end && i < 2 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+
+    if (!readNumber(pos, end, 2, value))
         return;
-    //throw StreamError_t("Bad DATE format");
-    hour = static_cast<char>(atoi(tmp.c_str()));
-
-    // skip optional delimiter
-    if (sit != end && *sit == ':')
-        ++sit;
-    // get min
-    tmp.erase();
-    i = 0;
-    while (sit != end && i < 2 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+    checkRange(value, 23);
+    hour = static_cast<char>(value);
+    if ((pos != end) && (*pos == ':'))
+        ++pos;
+    if (!readNumber(pos, end, 2, value))
         return;
-    //throw StreamError_t("Bad DATE format");
-    minute = static_cast<char>(atoi(tmp.c_str()));
-
-    // skip optional delimiter
-    if (sit != end && *sit == ':')
-        ++sit;
-    // get sec
-    tmp.erase();
-    i = 0;
-    while (sit != end && i < 2 && isdigit(*sit)) {
-        tmp += *sit;
-        ++sit;
-        ++i;
-    }
-    if (tmp.length() == 0)
+    checkRange(value, 59);
+    minute = static_cast<char>(value);
+    if ((pos != end) && (*pos == ':'))
+        ++pos;
+    if (!readNumber(pos, end, 2, value))
         return;
-    //throw StreamError_t("Bad DATE format");
-    sec = static_cast<char>(atoi(tmp.c_str()));
-
-    // if sec fraction
-    if (sit != end && *sit == '.') {
-        ++sit; //skip delimiter
-        while (sit != end && isdigit(*sit))
-            ++sit; //sec fraction is ignored
+    checkRange(value, 60);
+    sec = static_cast<char>(value);
+
+    // sec fraction is ignored
+    if ((pos != end) && (*pos == '.')) {
+        ++pos;
+        while ((pos != end) && (static_cast<unsigned char>(*pos - '0') < 10))
+            ++pos;
     }
 
-    // timezone vars
-    int tzsign, tzhour, tzmin;
-    tzsign = 0;
-    tzhour = 0;
-    tzmin = 0;
-
     // timezone sign +/- or 'Z' for UTC
-    if (sit != end) {
-        tzsign = *sit;
-        ++sit;
-    }
-    // if timezone specified
-    if (tzsign == 'Z' || tzsign == 'z') {
-        // Z means zero meridian GMT+0
-        tzhour = 0;
-        tzmin = 0;
-    } else if (tzsign == '+' || tzsign == '-') {
-        // get TZ hour
-        tmp.erase();
-        i = 0;
-        while (sit != end && i < 2 && isdigit(*sit)) {
-            tmp += *sit;
-            ++sit;
-            ++i;
-        }
-        if (tmp.length() == 0)
+    char tzSign = 0;
+    int tzHour = 0;
+    int tzMinute = 0;
+    if (pos != end)
+        tzSign = *pos++;
+    if ((tzSign == '+') || (tzSign == '-')) {
+        if (!readNumber(pos, end, 2, tzHour))
             return;
-        //throw StreamError_t("Bad DATE format");
-        tzhour = atoi(tmp.c_str());
-
-        // skip optional delimiter
-        if (sit != end && *sit == ':')
-            ++sit;
-        // get TZ min
-        tmp.erase();
-        i = 0;
-        while (sit != end && i < 2 && isdigit(*sit)) {
-            tmp += *sit;
-            ++sit;
-            ++i;
-        }
-        if (tmp.length() == 0)
+        checkRange(tzHour, 23);
+        if ((pos != end) && (*pos == ':'))
+            ++pos;
+        if (!readNumber(pos, end, 2, tzMinute))
             return;
-        //throw StreamError_t("Bad DATE format");
-        tzmin = atoi(tmp.c_str());
+        checkRange(tzMinute, 59);
     }
 
-    // skip trailing spaces
-    while (sit != end && isspace(*sit))
-        ++sit;
-    if (sit != end)
+    // skip trailing spaces, extra characters leave the time zone unset
+    while ((pos != end) && isSpace(*pos))
+        ++pos;
+    if (pos != end)
         return;
-    //throw StreamError_t("Bad DATE format"); //error, extra characters on line
-
-    timeZone = (tzhour * 60 + tzmin) * ((tzsign == '+')? -60: 60);
 
+    timeZone = (tzHour * 60 + tzMinute) * ((tzSign == '+')? -60: 60);
 }
 
 int FRPC_DLLEXPORT dumpFastrpcTree(
@@ -40,6 +40,7 @@
 
 #include <frpcvalue.h>
 #include <frpcarray.h>
+#include <frpcpackedarray.h>
 
 #include <frpcbinary.h>
 #include <frpcbinaryref.h>
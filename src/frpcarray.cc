@@ -34,6 +34,8 @@
  *
  */
 
+#include <mutex>
+
 #include "frpcarray.h"
 
 #include "frpcpool.h"
@@ -49,6 +51,7 @@ namespace FRPC {
 Array_t::~Array_t() = default;
 
 Value_t &Array_t::clone(Pool_t& newPool) const {
+    access();
     Array_t &newArray = newPool.Array();
     newArray.reserve(size());
 
@@ -59,74 +62,102 @@ Value_t &Array_t::clone(Pool_t& newPool) const {
 }
 
 Array_t::Array_t()
+    : lazy(false), packed(false)
 {
     arrayData.reserve(LibConfig_t::getInstance()->getDefaultArraySize());
 }
 
 Array_t::Array_t(Array_t::size_type size)
+    : lazy(false), packed(false)
 {
     arrayData.reserve(size);
 }
 
 Array_t::Array_t(const Value_t &item)
+    : lazy(false), packed(false)
 {
     arrayData.reserve(LibConfig_t::getInstance()->getDefaultArraySize());
     arrayData.push_back(const_cast<Value_t*>(&item));
 }
 
+void Array_t::materialize() const
+{}
+
+void Array_t::materializeOnce() const
+{
+    // items are allocated from the pool which is not thread safe itself,
+    // hence single lock for all arrays
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!lazy.load(std::memory_order_relaxed)) return;
+    materialize();
+    lazy.store(false, std::memory_order_release);
+}
+
 Array_t::const_iterator Array_t::begin() const
 {
+    access();
     return arrayData.begin();
 }
 
 Array_t::const_iterator Array_t::end() const
 {
+    access();
     return arrayData.end();
 }
 
 Array_t::iterator Array_t::begin()
 {
+    modify();
     return arrayData.begin();
 }
 
 Array_t::iterator Array_t::end()
 {
+    modify();
     return  arrayData.end();
 }
 
 Array_t::size_type Array_t::size() const
 {
+    access();
     return arrayData.size();
 }
 
 void Array_t::clear()
 {
+    modify();
     arrayData.clear();
 }
 
 void Array_t::reserve(Array_t::size_type size)
 {
+   modify();
    arrayData.reserve(size);
 }
 
 Array_t::size_type Array_t::capacity()
 {
+   access();
    return arrayData.capacity();
 }
 
 void Array_t::push_back(const Value_t &value)
 {
+    modify();
     arrayData.push_back(const_cast<Value_t *>(&value));
 }
 
 Array_t& Array_t::append(const Value_t &value)
 {
+    modify();
 
     arrayData.push_back(const_cast<Value_t *>(&value));
     return *this;
 }
 
 Array_t &Array_t::replace(size_type index, const Value_t &value) {
+    modify();
     if (index >= arrayData.size())
         throw IndexError_t::format("index %zd is out of range 0 - %zd.", index,
                                    arrayData.size());
@@ -137,11 +168,13 @@ Array_t &Array_t::replace(size_type index, const Value_t &value) {
 
 bool Array_t::empty() const
 {
+    access();
     return arrayData.empty();
 }
 
 Value_t& Array_t::operator[] (Array_t::size_type index)
 {
+    modify();
     if (index >= arrayData.size())
         throw(IndexError_t::format("index %zd is out of range 0 - %zd.", index,
                                    arrayData.size()));
@@ -151,6 +184,7 @@ Value_t& Array_t::operator[] (Array_t::size_type index)
 
 const Value_t& Array_t::operator[] (Array_t::size_type index) const
 {
+    access();
     if (index >= arrayData.size())
         throw(IndexError_t::format("index %zd is out of range 0 - %zd.", index,
                                    arrayData.size()));
@@ -159,6 +193,7 @@ const Value_t& Array_t::operator[] (Array_t::size_type index) const
 }
 
 void Array_t::checkItems(const std::string &items) const {
+    access();
     size_t itemsSize(0);
     for (size_t i(0) ; i < items.size() ; ++i) {
         if (items[i] != '?') {
@@ -38,6 +38,7 @@
 
 #include <frpcvalue.h>
 #include <frpctypeerror.h>
+#include <atomic>
 #include <vector>
 
 namespace FRPC {
@@ -220,7 +221,37 @@ protected:
     */
     explicit Array_t(const Value_t &item);
 
-    std::vector<Value_t*> arrayData;///Internal array data
+    /**
+        @brief Fills arrayData of array which items are created lazily
+        (see PackedArray_t), called once by materializeOnce()
+    */
+    virtual void materialize() const;
+
+    /**
+        @brief Calls materialize() unless another thread did it already,
+        const readers of one tree may run in more threads at once
+    */
+    void materializeOnce() const;
+
+    /**
+        @brief Prepares items for reading
+    */
+    void access() const {
+        if (lazy.load(std::memory_order_acquire)) materializeOnce();
+    }
+
+    /**
+        @brief Prepares items for modification, packed copy of items held
+        by derived class is no longer valid
+    */
+    void modify() {
+        access();
+        packed = false;
+    }
+
+    mutable std::vector<Value_t*> arrayData;///Internal array data
+    mutable std::atomic<bool> lazy;///arrayData are not created yet
+    bool packed;///derived class holds packed copy of all items
 
 };
 /**
@@ -42,16 +42,18 @@
 namespace FRPC {
 
 Base64UnMarshaller_t::Base64UnMarshaller_t(DataBuilder_t &dataBuilder)
-    : BinUnMarshaller_t(dataBuilder), decoder()
+    : BinUnMarshaller_t(dataBuilder), decoder(), buffer()
 {}
 
 void Base64UnMarshaller_t::unMarshall(const char *data,
                                       unsigned int size,
                                       char type)
 {
-    std::string decoded = decoder.process(data, size);
-    if (!decoded.empty())
-        BinUnMarshaller_t::unMarshall(decoded.data(), static_cast<uint32_t>(decoded.size()), type);
+    if (buffer.size() < Base64::decodedSize(size))
+        buffer.resize(Base64::decodedSize(size));
+    std::size_t decoded = decoder.process(data, size, buffer.data());
+    if (decoded)
+        BinUnMarshaller_t::unMarshall(buffer.data(), static_cast<uint32_t>(decoded), type);
 }
 
 } // namespace FRPC
@@ -69,6 +69,8 @@ public:
 
 private:
     Base64 decoder;
+    /// decoded data, reused between calls
+    std::vector<char> buffer;
 };
 
 } // namespace FRPC
@@ -31,28 +31,17 @@
  *
  */
 
+#include <algorithm>
+
 #include <frpcb64writer.h>
+#include <frpcbase64.h>
 
 namespace FRPC {
 namespace {
-const char B64_ALPHABET[] = {
-    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
-    'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-    'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
-    'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-    'w', 'x', 'y', 'z', '0', '1', '2', '3',
-    '4', '5', '6', '7', '8', '9', '+', '/',
-};
+// number of encoded bytes per write to the underlying writer
+const unsigned int BLOCK_SIZE = 3072;
 } // namespace
 
-const Base64Writer_t::States_t Base64Writer_t::State_t::STATE_NEXT[3] = {
-    Base64Writer_t::STATE_SECOND,
-    Base64Writer_t::STATE_THIRD,
-    Base64Writer_t::STATE_FIRST
-};
-
 Base64Writer_t::~Base64Writer_t() {
     //try to flush, ignore exceptions
     try {
@@ -64,57 +53,43 @@ Base64Writer_t::~Base64Writer_t() {
 void Base64Writer_t::write(const char *data, unsigned int size) {
     const unsigned char *ud = reinterpret_cast<const unsigned char *>(data);
 
-    while (size) {
-        switch (state.state) {
-        case STATE_FIRST:
-            // fresh byte start
-            writer.write(&B64_ALPHABET[*ud >> 2], 1);
-            state.next((*ud & 0x03) << 4, 1);
-
-            ++ud;
-            if (!--size)
-                return;
-
-            // FALL THROUGH
-        case STATE_SECOND:
-            writer.write(&B64_ALPHABET[state.prev | ((*ud & 0x0f0) >> 4)], 1);
-            state.next((*ud & 0x0f) << 2, 1);
-
-            ++ud;
-            if (!--size)
-                return;
+    // complete the triplet from the last write
+    if (pendingSize) {
+        while ((pendingSize < 3) && size) {
+            pending[pendingSize++] = *ud++;
+            --size;
+        }
+        if (pendingSize < 3)
+            return;
 
-            // FALL THROUGH
-        case STATE_THIRD:
-            writer.write(&B64_ALPHABET[state.prev | ((*ud & 0x0c0) >> 6)], 1);
-            writer.write(&B64_ALPHABET[*ud & 0x03f], 1);
-            state.next(0, 2);
+        char encoded[4];
+        Base64::encode(pending, 3, encoded);
+        writer.write(encoded, 4);
+        pendingSize = 0;
+    }
 
-            ++ud;
-            if (!--size)
-                return;
-        }
+    char encoded[BLOCK_SIZE / 3 * 4];
+    while (size >= 3) {
+        unsigned int block = std::min(size / 3 * 3, BLOCK_SIZE);
+        Base64::encode(ud, block, encoded);
+        writer.write(encoded, block / 3 * 4);
+        ud += block;
+        size -= block;
     }
+
+    while (size--)
+        pending[pendingSize++] = *ud++;
 }
 
 void Base64Writer_t::flush() {
     // encode the data tail
-    switch (state.state) {
-    case STATE_SECOND:
-        writer.write(&B64_ALPHABET[state.prev], 1);
-        writer.write("==", 2);
-        break;
-
-    case STATE_THIRD:
-        writer.write(&B64_ALPHABET[state.prev], 1);
-        writer.write("=", 1);
-        break;
-
-    default:
-            break;
+    if (pendingSize) {
+        char encoded[4];
+        Base64::encode(pending, pendingSize, encoded);
+        writer.write(encoded, 4);
+        pendingSize = 0;
     }
 
-    state.reset();
     writer.flush();
 }
 
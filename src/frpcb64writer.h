@@ -40,40 +40,18 @@ namespace FRPC {
 
 class Base64Writer_t: public Writer_t {
 public:
-    Base64Writer_t(Writer_t &writer): writer(writer), state() {}
+    Base64Writer_t(Writer_t &writer): writer(writer), pendingSize(0) {}
 
     ~Base64Writer_t() override;
 
-    /// Encoder's state (current byte position in tripplet)
-    enum States_t { STATE_FIRST = 0x0, STATE_SECOND = 0x1, STATE_THIRD = 0x2 };
-
-    /// Complex encoder's state
-    struct State_t {
-        State_t() : state(STATE_FIRST), lineLen(0), prev(0x0) {}
-
-        void next(unsigned char pr, size_t) {
-            prev = pr;
-            state = STATE_NEXT[state];
-        }
-
-        void reset() {
-            state = STATE_FIRST;
-            prev = 0;
-        }
-
-        States_t state;
-        size_t lineLen;
-        unsigned char prev;
-
-        static const States_t STATE_NEXT[3];
-    };
-
     void write(const char *data, unsigned int size) override;
     void flush() override;
 
 private:
     Writer_t &writer;
-    State_t state;
+    /// bytes of incomplete triplet left from the last write
+    unsigned char pending[3];
+    unsigned int pendingSize;
 };
 
 } // namespace FRPC
@@ -1,5 +1,12 @@
+#include <cstring>
+
 #include "frpcbase64.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FRPC_BASE64_X86 1
+#include <immintrin.h>
+#endif
+
 namespace FRPC {
 namespace {
 const unsigned char base64Table[256] = {
@@ -77,6 +84,243 @@ const unsigned char base64Table[256] = {
            // 248 - 255
            0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
        };
+
+const char base64Alphabet[]
+    = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Block codecs process the longest prefix of the input they can handle and
+// return its length, the caller finishes the rest with the portable code.
+// Decoders stop at the first block containing anything but the base64
+// alphabet (whitespace, padding, garbage) and write exactly 3 bytes for each
+// 4 characters consumed, only after reading them, so they can decode in place.
+typedef std::size_t (*DecodeBlocks_t)(const char *src, std::size_t len,
+                                      char *out);
+typedef std::size_t (*EncodeBlocks_t)(const unsigned char *src,
+                                      std::size_t size, char *out);
+
+std::size_t decodeNone(const char *, std::size_t, char *) {
+    return 0;
+}
+
+std::size_t encodeNone(const unsigned char *, std::size_t, char *) {
+    return 0;
+}
+
+#ifdef FRPC_BASE64_X86
+
+// The SIMD algorithms are the ones described by Wojciech Muła and Daniel
+// Lemire in "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+
+// The 128-bit loops are inlined to the AVX2 variants as well, calling legacy
+// SSE code with dirty upper halves of the AVX registers would be slow.
+__attribute__((target("ssse3"), always_inline))
+inline std::size_t decode16(const char *src, std::size_t len, char *out) {
+    const __m128i lutLo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+
+    std::size_t done = 0;
+    for (; len - done >= 16; done += 16, out += 12) {
+        __m128i str = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + done));
+
+        // validate: every character must be in the alphabet
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+        __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(str, mask2F));
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                                             _mm_setzero_si128())))
+            break;
+
+        // translate characters to sextets and pack them to bytes
+        __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+        str = _mm_add_epi8(str, _mm_shuffle_epi8(
+            lutRoll, _mm_add_epi8(eq2F, hiNibbles)));
+        str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+        str = _mm_shuffle_epi8(str, pack);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out), str);
+        int tail = _mm_cvtsi128_si32(_mm_srli_si128(str, 8));
+        std::memcpy(out + 8, &tail, 4);
+    }
+    return done;
+}
+
+__attribute__((target("ssse3")))
+std::size_t decodeSsse3(const char *src, std::size_t len, char *out) {
+    return decode16(src, len, out);
+}
+
+__attribute__((target("avx2")))
+std::size_t decodeAvx2(const char *src, std::size_t len, char *out) {
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask2F = _mm256_set1_epi8(0x2f);
+
+    std::size_t done = 0;
+    for (; len - done >= 32; done += 32, out += 24) {
+        __m256i str = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(src + done));
+
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4),
+                                             mask2F);
+        __m256i lo = _mm256_shuffle_epi8(lutLo,
+                                         _mm256_and_si256(str, mask2F));
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+
+        __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+        str = _mm256_add_epi8(str, _mm256_shuffle_epi8(
+            lutRoll, _mm256_add_epi8(eq2F, hiNibbles)));
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack);
+        // move the 12 bytes of the upper lane next to the lower ones
+        str = _mm256_permutevar8x32_epi32(
+            str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm256_castsi256_si128(str));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16),
+                         _mm256_extracti128_si256(str, 1));
+    }
+
+    // lines of XML base64 are not multiples of 32 characters
+    return done + decode16(src + done, len - done, out);
+}
+
+__attribute__((target("ssse3"), always_inline))
+inline std::size_t encode12(const unsigned char *src, std::size_t size,
+                            char *out)
+{
+    const __m128i shuffle = _mm_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i lut = _mm_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+    // 12 bytes are encoded but 16 are read
+    std::size_t done = 0;
+    for (; size - done >= 16; done += 12, out += 16) {
+        __m128i in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + done));
+
+        // split 3 bytes to 4 sextets
+        in = _mm_shuffle_epi8(in, shuffle);
+        __m128i t0 = _mm_mulhi_epu16(
+            _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+            _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(
+            _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+            _mm_set1_epi32(0x01000010));
+        __m128i sextets = _mm_or_si128(t0, t1);
+
+        // translate sextets to the alphabet
+        __m128i index = _mm_sub_epi8(
+            _mm_subs_epu8(sextets, _mm_set1_epi8(51)),
+            _mm_cmpgt_epi8(sextets, _mm_set1_epi8(25)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                         _mm_add_epi8(sextets,
+                                      _mm_shuffle_epi8(lut, index)));
+    }
+    return done;
+}
+
+__attribute__((target("ssse3")))
+std::size_t encodeSsse3(const unsigned char *src, std::size_t size,
+                        char *out)
+{
+    return encode12(src, size, out);
+}
+
+__attribute__((target("avx2")))
+std::size_t encodeAvx2(const unsigned char *src, std::size_t size,
+                       char *out)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i lut = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+    // 24 bytes are encoded but 28 are read
+    std::size_t done = 0;
+    for (; size - done >= 28; done += 24, out += 32) {
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(src + done))),
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(src + done + 12)), 1);
+
+        in = _mm256_shuffle_epi8(in, shuffle);
+        __m256i t0 = _mm256_mulhi_epu16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+            _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(
+            _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+            _mm256_set1_epi32(0x01000010));
+        __m256i sextets = _mm256_or_si256(t0, t1);
+
+        __m256i index = _mm256_sub_epi8(
+            _mm256_subs_epu8(sextets, _mm256_set1_epi8(51)),
+            _mm256_cmpgt_epi8(sextets, _mm256_set1_epi8(25)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                            _mm256_add_epi8(sextets,
+                                            _mm256_shuffle_epi8(lut, index)));
+    }
+
+    return done + encode12(src + done, size - done, out);
+}
+
+#endif // FRPC_BASE64_X86
+
+struct BlockCodec_t {
+    BlockCodec_t(): decode(decodeNone), encode(encodeNone) {
+#ifdef FRPC_BASE64_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            decode = decodeAvx2;
+            encode = encodeAvx2;
+        } else if (__builtin_cpu_supports("ssse3")) {
+            decode = decodeSsse3;
+            encode = encodeSsse3;
+        }
+#endif
+    }
+
+    DecodeBlocks_t decode;
+    EncodeBlocks_t encode;
+};
+
+const BlockCodec_t &blockCodec() {
+    static const BlockCodec_t codec;
+    return codec;
+}
+
 } // namespace
 
 const std::string Base64::decode(const char *data, long len) {
@@ -84,6 +328,39 @@ const std::string Base64::decode(const char *data, long len) {
     return decoder.process(data, len);
 }
 
+char *Base64::encode(const unsigned char *data, std::size_t size, char *out)
+{
+    std::size_t done = blockCodec().encode(data, size, out);
+    out += done / 3 * 4;
+
+    for (; size - done >= 3; done += 3) {
+        const unsigned char *in = data + done;
+        *out++ = base64Alphabet[in[0] >> 2];
+        *out++ = base64Alphabet[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+        *out++ = base64Alphabet[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
+        *out++ = base64Alphabet[in[2] & 0x3f];
+    }
+
+    switch (size - done) {
+    case 1:
+        *out++ = base64Alphabet[data[done] >> 2];
+        *out++ = base64Alphabet[(data[done] & 0x03) << 4];
+        *out++ = '=';
+        *out++ = '=';
+        break;
+    case 2:
+        *out++ = base64Alphabet[data[done] >> 2];
+        *out++ = base64Alphabet[((data[done] & 0x03) << 4)
+                                | (data[done + 1] >> 4)];
+        *out++ = base64Alphabet[(data[done + 1] & 0x0f) << 2];
+        *out++ = '=';
+        break;
+    default:
+        break;
+    }
+    return out;
+}
+
 Base64::Base64() {
     reset();
 }
@@ -98,14 +375,29 @@ void Base64::reset() {
 
 std::string Base64::process(const char *data, long len)
 {
-    std::string result;
-    result.reserve((len * 3) / 4);
+    if (len <= 0) return std::string();
+    std::string result(decodedSize(len), '\0');
+    result.resize(process(data, static_cast<std::size_t>(len), &result[0]));
+    return result;
+}
 
+std::size_t Base64::process(const char *data, std::size_t len, char *out)
+{
+    char *opos = out;
     for (const char
              *isrc = data,
              *end = data + len;
             isrc != end; )
     {
+        // whole blocks of the alphabet are decoded at once
+        if (!i) {
+            std::size_t done = blockCodec().decode(isrc, end - isrc, opos);
+            isrc += done;
+            opos += done / 4 * 3;
+            if (isrc == end)
+                break;
+        }
+
         for (; (isrc != end) && (i < 4); isrc++) {
             // a hack. should be based on the table values
             if (isspace(*isrc))
@@ -119,25 +411,22 @@ std::string Base64::process(const char *data, long len)
         if (i < 4)
             break;
 
-        // when nothing read terminate this loop (invalid b64 chars)
-        if (!i)
-            break;
-
-        unsigned char o[4];
+        unsigned char o[3];
         o[0] = static_cast<unsigned char>((b[0] << 2) | (b[1] >> 4));
         o[1] = static_cast<unsigned char>((b[1] << 4) | (b[2] >> 2));
         o[2] = static_cast<unsigned char>((b[2] << 6) | b[3]);
 
-        int len = (a[2] == '=') ? 1 : ((a[3] == '=') ? 2 : 3);
-        result.append((char *)o, len);
+        int size = (a[2] == '=') ? 1 : ((a[3] == '=') ? 2 : 3);
+        std::memcpy(opos, o, size);
+        opos += size;
 
         reset();
 
-        if (len < 3)
+        if (size < 3)
             break;
     }
 
-    return  result;
+    return opos - out;
 }
 
 } // namespace FRPC
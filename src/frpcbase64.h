@@ -34,21 +34,46 @@
 #define FRPCBASE64_H
 
 #include <frpcplatform.h>
+#include <cstddef>
 #include <string>
 
 namespace FRPC {
 
+/// Base64 codec. Long runs of data are processed in blocks with SSSE3 or
+/// AVX2 instructions when the CPU supports them (detected at runtime), the
+/// rest with portable code.
 class Base64 {
 public:
     /// Decodes a complete Base64 sequence. Any trailing bytes (0-3)
     /// that are not a part of a quad get thrown out
     static const std::string decode(const char *data, long len);
 
+    /// Size of the buffer needed by process() for len input characters
+    static std::size_t decodedSize(std::size_t len) {
+        return (len + 3) / 4 * 3;
+    }
+
+    /// Number of characters encode() writes for size bytes of data
+    static std::size_t encodedSize(std::size_t size) {
+        return (size + 2) / 3 * 4;
+    }
+
+    /// Encodes data to out, the last incomplete triplet gets padded with
+    /// '='. The out buffer must have at least encodedSize(size) characters.
+    /// Returns the end of the written data.
+    static char *encode(const unsigned char *data, std::size_t size,
+                        char *out);
+
     Base64();
 
     /// Stateful decoder variant. Remembers the residue from last decode
     std::string process(const char *data, long len);
 
+    /// Stateful decoder writing to caller provided buffer of at least
+    /// decodedSize(len) bytes. The buffer may be the input itself (decoding
+    /// in place) when remains() is zero. Returns number of bytes written.
+    std::size_t process(const char *data, std::size_t len, char *out);
+
     /// complete == 0, otherwise there are some leftovers from last buffer.
     int remains() const { return i; }
 
@@ -30,6 +30,7 @@
  * HISTORY
  *
  */
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
@@ -125,6 +126,24 @@ uint64_t zigzagEncode(int64_t n) {
     return (static_cast<uint64_t>(n) << 1u) ^ static_cast<uint64_t>(n >> 63u);
 }
 
+/** Size of the buffer for items of packed arrays. */
+const std::size_t PACKED_BUFFER_SIZE = 1 << 12;
+
+/** Smallest width (in bytes) that can hold all zigzag encoded values.
+ */
+unsigned int packedIntWidth(const Int_t::value_type *values,
+                            std::size_t count)
+{
+    uint64_t bits = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        bits |= zigzagEncode(values[i]);
+
+    if (!(bits >> 8u)) return 1;
+    if (!(bits >> 16u)) return 2;
+    if (!(bits >> 32u)) return 4;
+    return 8;
+}
+
 } // namespace
 
 BinMarshaller_t::BinMarshaller_t(Writer_t &writer,
@@ -406,6 +425,23 @@ void BinMarshaller_t::packStructMember(const char* memberName,
         throw LenError_t::format(
             "Lenght of member name is %d not in interval (1-255)", size);
 
+    if (hasKeyDictionary(protocolVersion)) {
+        key.assign(memberName, size);
+        auto ikey = keys.find(key);
+        if (ikey != keys.end()) {
+            // write reference to the name already sent
+            char reference = 0;
+            Number_t index(ikey->second);
+            writer.write(&reference, 1);
+            writer.write(index.data,
+                         static_cast<unsigned int>(keyIndexSize(keys.size())));
+            return;
+        }
+
+        if (keys.size() < KEY_DICTIONARY_LIMIT)
+            keys.emplace(key, static_cast<uint32_t>(keys.size()));
+    }
+
     //write member name
     int8_t realSize = int8_t(size);
     writer.write(reinterpret_cast<char *>(&realSize), 1);
@@ -426,6 +462,8 @@ void BinMarshaller_t::packMethodResponse() {
 }
 
 void BinMarshaller_t::packMagic() {
+    // each message has its own key dictionary
+    keys.clear();
 
     unsigned char magic[]={0xCA,0x11,0x00,0x00};
     magic[2] = protocolVersion.versionMajor;
@@ -451,6 +489,80 @@ void BinMarshaller_t::packNull() {
 
 }
 
+void BinMarshaller_t::packArrayHeader(char type, std::size_t numOfItems) {
+    unsigned int numType = getNumberType(
+            protocolVersion, static_cast<Int_t::value_type>(numOfItems));
+    Number_t number(static_cast<Int_t::value_type>(numOfItems));
+    type = data_type(type, numType);
+
+    writer.write(&type, 1);
+    writer.write(number.data, getNumberSize(protocolVersion, numType));
+}
+
+void BinMarshaller_t::packIntArray(const Int_t::value_type *values,
+                                   std::size_t count)
+{
+    if (!hasPackedArrays(protocolVersion)) {
+        packArray(static_cast<unsigned int>(count));
+        for (std::size_t i = 0; i < count; ++i)
+            packInt(values[i]);
+        return;
+    }
+
+    packArrayHeader(INT_ARRAY, count);
+
+    unsigned int width = packedIntWidth(values, count);
+    char widthByte = static_cast<char>(width);
+    writer.write(&widthByte, 1);
+
+    // items are converted into the buffer and written in chunks
+    char buffer[PACKED_BUFFER_SIZE];
+    std::size_t chunk = PACKED_BUFFER_SIZE / width;
+    for (std::size_t pos = 0; pos < count; pos += chunk) {
+        std::size_t items = std::min(chunk, count - pos);
+        char *out = buffer;
+        for (std::size_t i = 0; i < items; ++i, out += width) {
+            Number_t number(static_cast<Int_t::value_type>(
+                        zigzagEncode(values[pos + i])));
+            memcpy(out, number.data, width);
+        }
+        writer.write(buffer, static_cast<unsigned int>(items * width));
+    }
+}
+
+void BinMarshaller_t::packDoubleArray(const double *values, std::size_t count)
+{
+    if (!hasPackedArrays(protocolVersion)) {
+        packArray(static_cast<unsigned int>(count));
+        for (std::size_t i = 0; i < count; ++i)
+            packDouble(values[i]);
+        return;
+    }
+
+    packArrayHeader(DOUBLE_ARRAY, count);
+
+    std::size_t chunk = PACKED_BUFFER_SIZE / sizeof(double);
+    for (std::size_t pos = 0; pos < count; pos += chunk) {
+        std::size_t items = std::min(chunk, count - pos);
+#ifdef FRPC_BIG_ENDIAN
+        char buffer[PACKED_BUFFER_SIZE];
+        for (std::size_t i = 0; i < items; ++i) {
+            char *out = buffer + i * sizeof(double);
+            memcpy(out, &values[pos + i], sizeof(double));
+            SWAP_BYTE(out[7], out[0]);
+            SWAP_BYTE(out[6], out[1]);
+            SWAP_BYTE(out[5], out[2]);
+            SWAP_BYTE(out[4], out[3]);
+        }
+        writer.write(buffer, static_cast<unsigned int>(items * sizeof(double)));
+#else
+        // doubles are sent in native little endian layout
+        writer.write(reinterpret_cast<const char *>(values + pos),
+                     static_cast<unsigned int>(items * sizeof(double)));
+#endif
+    }
+}
+
 void BinMarshaller_t::packBinaryRef(BinaryRefFeeder_t feeder) {
     auto size = feeder.size();
     unsigned int numType = getNumberType(protocolVersion, size);
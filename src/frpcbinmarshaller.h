@@ -41,6 +41,9 @@
 #include <frpcnull.h>
 #include <frpcstreamerror.h>
 
+#include <string>
+#include <unordered_map>
+
 namespace FRPC {
 
 /**
@@ -75,14 +78,37 @@ public:
 
     void packBinaryRef(BinaryRefFeeder_t feeder);
 
+    /**
+        @brief Packs array of ints, it is sent as one block since protocol
+        version 3.3 and as regular array otherwise
+        @param values is a pointer to items
+        @param count is a number of items
+    */
+    void packIntArray(const Int_t::value_type *values, std::size_t count);
+
+    /**
+        @brief Packs array of doubles, it is sent as one block since protocol
+        version 3.3 and as regular array otherwise
+        @param values is a pointer to items
+        @param count is a number of items
+    */
+    void packDoubleArray(const double *values, std::size_t count);
+
 private:
 
     BinMarshaller_t();
 
     void packMagic();
 
+    void packArrayHeader(char type, std::size_t numOfItems);
+
     Writer_t  &writer;
     ProtocolVersion_t protocolVersion;
+
+    /** Member names already sent in current message (protocol >= 3.2).
+     */
+    std::unordered_map<std::string, uint32_t> keys;
+    std::string key;
 };
 
 } // namespace FRPC
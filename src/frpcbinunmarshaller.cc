@@ -88,7 +88,13 @@ enum {
     S_VALUE_TYPE,
     S_REAL_VALUE_TYPE,
     S_STRING_LEN,
-    S_BINARY_LEN
+    S_BINARY_LEN,
+    S_MEMBER_INDEX,
+    S_INT_ARRAY,
+    S_INT_ARRAY_WIDTH,
+    S_INT_ARRAY_ITEMS,
+    S_DOUBLE_ARRAY,
+    S_DOUBLE_ARRAY_ITEMS
 };
 
 /** Decodes zigzag encoded integer back into native integer.
@@ -164,6 +170,57 @@ double getDouble(const char *data) {
 #endif
 }
 
+inline uint8_t swapBytes(uint8_t value) { return value;}
+inline uint16_t swapBytes(uint16_t value) { return __builtin_bswap16(value);}
+inline uint32_t swapBytes(uint32_t value) { return __builtin_bswap32(value);}
+inline uint64_t swapBytes(uint64_t value) { return __builtin_bswap64(value);}
+
+/** Decodes block of zigzag encoded ints of packed array. The loop has no
+ * dependencies between items so the compiler vectorizes it.
+ */
+template <typename Word_t>
+void getInts(const char *data, std::size_t count, Int_t::value_type *out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        Word_t word;
+        memcpy(&word, data + i * sizeof(Word_t), sizeof(Word_t));
+#ifdef FRPC_BIG_ENDIAN
+        word = swapBytes(word);
+#endif
+        out[i] = zigzagDecode(static_cast<int64_t>(word));
+    }
+}
+
+std::vector<Int_t::value_type>
+getIntArray(const char *data, std::size_t count, std::size_t width) {
+    std::vector<Int_t::value_type> values(count);
+    switch (width) {
+    case 1:
+        getInts<uint8_t>(data, count, values.data());
+        break;
+    case 2:
+        getInts<uint16_t>(data, count, values.data());
+        break;
+    case 4:
+        getInts<uint32_t>(data, count, values.data());
+        break;
+    default:
+        getInts<uint64_t>(data, count, values.data());
+        break;
+    }
+    return values;
+}
+
+std::vector<double> getDoubleArray(const char *data, std::size_t count) {
+    std::vector<double> values(count);
+#ifdef FRPC_BIG_ENDIAN
+    for (std::size_t i = 0; i < count; ++i)
+        values[i] = getDouble(data + i * sizeof(double));
+#else
+    if (count) memcpy(values.data(), data, count * sizeof(double));
+#endif
+    return values;
+}
+
 // needs 10 bytes of data
 DateTimeInternal_t getDateTime(const char *data) {
     DateTimeInternal_t dateTime;
@@ -308,6 +365,8 @@ public:
 
     // accessors
     ProtocolVersion_t& version() { return self.protocolVersion; }
+    std::vector<std::string>& keys() { return self.keys; }
+    uint64_t& packedItems() { return self.packedItems; }
     DataBuilder_t* dataBuilder() const { return &self.dataBuilder; }
     uint8_t& faultState() const { return  self.faultState; }
     int64_t& errNo() const { return self.errNo; }
@@ -447,6 +506,7 @@ static void unMarshallInternal(BinUnMarshaller_t::Driver_t &d, char reqType) {
             if (d.version().versionMajor > 3 || d.version().versionMajor < 1) {
                 throw StreamError_t("Unsupported protocol version !!!");
             }
+            d.keys().clear();
 
             d.newDataWanted = 1;
             d.state = S_BODY;
@@ -505,6 +565,25 @@ static void unMarshallInternal(BinUnMarshaller_t::Driver_t &d, char reqType) {
             debugf("struct member: %s \n",
                     std::string(d.data(), d.wanted()).c_str());
 
+            if (hasKeyDictionary(d.version())
+                && (d.keys().size() < KEY_DICTIONARY_LIMIT))
+            {
+                d.keys().emplace_back(d.data(), d.wanted());
+            }
+
+            d.newDataWanted = 1;
+            d.state = S_REAL_VALUE_TYPE;
+        }
+        break;
+        case S_MEMBER_INDEX: {
+            uint64_t index = static_cast<uint64_t>(
+                    getInt64(d.data(), d.wanted()));
+            if (index >= d.keys().size())
+                throw StreamError_t("Invalid struct member index");
+
+            dataBuilder->buildStructMember(d.keys()[index]);
+            debugf("struct member ref: %s \n", d.keys()[index].c_str());
+
             d.newDataWanted = 1;
             d.state = S_REAL_VALUE_TYPE;
         }
@@ -513,8 +592,17 @@ static void unMarshallInternal(BinUnMarshaller_t::Driver_t &d, char reqType) {
             if (d.isInsideStruct()) {
                 d.newDataWanted = static_cast<uint8_t>(d[0]);
 
-                if (d.newDataWanted == 0)
-                    throw StreamError_t("Struct member name length is zero");
+                if (d.newDataWanted == 0) {
+                    if (!hasKeyDictionary(d.version()))
+                        throw StreamError_t("Struct member name length is zero");
+
+                    // reference to the key dictionary
+                    if (d.keys().empty())
+                        throw StreamError_t("Invalid struct member index");
+                    d.newDataWanted = keyIndexSize(d.keys().size());
+                    d.state = S_MEMBER_INDEX;
+                    break;
+                }
 
                 d.state = S_MEMBER_NAME;
                 break;
@@ -615,6 +703,18 @@ static void unMarshallInternal(BinUnMarshaller_t::Driver_t &d, char reqType) {
                 d.state = S_STRUCT;
             }
             break;
+            case INT_ARRAY:
+            case DOUBLE_ARRAY: {
+                if (!hasPackedArrays(d.version())) {
+                    throw StreamError_t("Unknown value type");
+                }
+                d.newDataWanted = getVersionedLengthSize(true, d[0]);
+
+                debugf("packed array size size: %lu\n", d.newDataWanted);
+                d.state = (getValueType(d[0]) == INT_ARRAY) ? S_INT_ARRAY
+                                                            : S_DOUBLE_ARRAY;
+            }
+            break;
             default:
                 if (d.stopOnUnknown) {
                     return;
@@ -754,6 +854,74 @@ static void unMarshallInternal(BinUnMarshaller_t::Driver_t &d, char reqType) {
         }
         break;
 
+        case S_INT_ARRAY:
+        case S_DOUBLE_ARRAY: {
+            int64_t acc = getInt64(d.data(), d.wanted());
+
+            if ((acc < 0) || (static_cast<uint64_t>(acc) >= ELEMENT_SIZE_LIMIT))
+                throw StreamError_t("Array entity too large");
+
+            d.packedItems() = static_cast<uint64_t>(acc);
+            debugf("packed array size: %li\n", acc);
+
+            if (d.state == S_INT_ARRAY) {
+                d.newDataWanted = 1;
+                d.state = S_INT_ARRAY_WIDTH;
+
+            } else if (acc == 0) {
+                dataBuilder->buildDoubleArray(std::vector<double>());
+                d.finalizeValue = true;
+                d.newDataWanted = 1;
+                d.state = S_VALUE_TYPE;
+
+            } else {
+                d.newDataWanted = d.packedItems() * sizeof(double);
+                if (d.newDataWanted >= ELEMENT_SIZE_LIMIT)
+                    throw StreamError_t("Array entity too large");
+                d.state = S_DOUBLE_ARRAY_ITEMS;
+            }
+        }
+        break;
+
+        case S_INT_ARRAY_WIDTH: {
+            auto width = static_cast<uint8_t>(d[0]);
+            if ((width != 1) && (width != 2) && (width != 4) && (width != 8))
+                throw StreamError_t("Invalid packed array item width");
+
+            if (d.packedItems() == 0) {
+                dataBuilder->buildIntArray(std::vector<Int_t::value_type>());
+                d.finalizeValue = true;
+                d.newDataWanted = 1;
+                d.state = S_VALUE_TYPE;
+                break;
+            }
+
+            d.newDataWanted = d.packedItems() * width;
+            if (d.newDataWanted >= ELEMENT_SIZE_LIMIT)
+                throw StreamError_t("Array entity too large");
+            d.state = S_INT_ARRAY_ITEMS;
+        }
+        break;
+
+        case S_INT_ARRAY_ITEMS: {
+            dataBuilder->buildIntArray(getIntArray(
+                        d.data(), d.packedItems(),
+                        d.wanted() / d.packedItems()));
+            d.finalizeValue = true;
+            d.newDataWanted = 1;
+            d.state = S_VALUE_TYPE;
+        }
+        break;
+
+        case S_DOUBLE_ARRAY_ITEMS: {
+            dataBuilder->buildDoubleArray(
+                    getDoubleArray(d.data(), d.packedItems()));
+            d.finalizeValue = true;
+            d.newDataWanted = 1;
+            d.state = S_VALUE_TYPE;
+        }
+        break;
+
         case S_ARRAY: {
             //unpack number
             int64_t acc = getInt64(d.data(), d.wanted());
@@ -85,7 +85,8 @@ protected:
     uint8_t state;
     uint8_t faultState;
     ProtocolVersion_t protocolVersion;
-    uint64_t _reserved1;
+    std::vector<std::string> keys; //!< key dictionary (protocol >= 3.2)
+    uint64_t packedItems; //!< items of packed array being read (protocol >= 3.3)
     uint64_t _reserved2;
 };
 
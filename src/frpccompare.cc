@@ -35,8 +35,12 @@
  *                  First draft.
  */
 
+#include <cmath>
 #include <stdexcept>
+#include <string_view>
 #include "frpccompare.h"
+#include "frpcstring_view.h"
+#include "frpcbinaryref.h"
 
 namespace FRPC {
 
@@ -118,6 +122,55 @@ int compareValue<FRPC::DateTime_t>(const FRPC::Value_t &lhs,
         : ((rhsc.getUnixTime() < lhsc.getUnixTime())? 1: 0);
 }
 
+/** NaNs are equal to each other and greater than any number, so that
+ *  compare() is a total order consistent with hash().
+ */
+static int compareDouble(const Value_t &lhs, const Value_t &rhs) {
+    double l = static_cast<const Double_t&>(lhs).getValue();
+    double r = static_cast<const Double_t&>(rhs).getValue();
+    if (std::isnan(l) || std::isnan(r))
+        return compareValue(std::isnan(l), std::isnan(r));
+    return compareValue(l, r);
+}
+
+/** String and binary views compare equal to their owning counterparts.
+ */
+static TypeTag_t canonicalType(const Value_t &value) {
+    switch (value.getType()) {
+    case StringView_t::TYPE:
+        return String_t::TYPE;
+    case BinaryRef_t::TYPE:
+        return Binary_t::TYPE;
+    default:
+        return value.getType();
+    }
+}
+
+static std::string_view stringValue(const Value_t &value) {
+    if (value.getType() == StringView_t::TYPE)
+        return static_cast<const StringView_t &>(value).getValue();
+    return static_cast<const String_t &>(value).getValue();
+}
+
+static std::string binaryValue(const Value_t &value) {
+    if (value.getType() == BinaryRef_t::TYPE) {
+        const BinaryRef_t &ref = static_cast<const BinaryRef_t &>(value);
+        std::string result;
+        result.reserve(ref.size());
+        for (auto chunk: ref.chunks())
+            result.append(reinterpret_cast<const char *>(chunk.data),
+                          chunk.size);
+        return result;
+    }
+    return static_cast<const Binary_t &>(value).getValue();
+}
+
+static int compareBinary(const Value_t &lhs, const Value_t &rhs) {
+    if ((lhs.getType() == Binary_t::TYPE) && (rhs.getType() == Binary_t::TYPE))
+        return compareValue<FRPC::Binary_t>(lhs, rhs);
+    return compareValue(binaryValue(lhs), binaryValue(rhs));
+}
+
 static int compare(const FRPC::Struct_t &lhs, const FRPC::Struct_t &rhs) {
     FRPC::Struct_t::const_iterator ilhs = lhs.begin();
     FRPC::Struct_t::const_iterator irhs = rhs.begin();
@@ -155,20 +208,21 @@ static int compare(const FRPC::Array_t &lhs, const FRPC::Array_t &rhs) {
 
 int compare(const FRPC::Value_t &lhs, const FRPC::Value_t &rhs) {
     // compare the type
-    if (int res = compareValue(lhs.getType(), rhs.getType())) return res;
+    if (int res = compareValue(canonicalType(lhs), canonicalType(rhs)))
+        return res;
 
     // compare the value
-    switch (lhs.getType()) {
+    switch (canonicalType(lhs)) {
     case FRPC::Bool_t::TYPE:
         return compareValue<FRPC::Bool_t>(lhs, rhs);
     case FRPC::Int_t::TYPE:
         return compareValue<FRPC::Int_t>(lhs, rhs);
     case FRPC::Double_t::TYPE:
-        return compareValue<FRPC::Double_t>(lhs, rhs);
+        return compareDouble(lhs, rhs);
     case FRPC::String_t::TYPE:
-        return compareValue<FRPC::String_t>(lhs, rhs);
+        return compareValue(stringValue(lhs), stringValue(rhs));
     case FRPC::Binary_t::TYPE:
-        return compareValue<FRPC::Binary_t>(lhs, rhs);
+        return compareBinary(lhs, rhs);
     case FRPC::DateTime_t::TYPE:
         return compareValue<FRPC::DateTime_t>(lhs, rhs);
     case FRPC::Struct_t::TYPE:
@@ -52,7 +52,9 @@ namespace FRPC {
 
 /**
  * @short Compares two FastRPC values and returns zero if it is equals. 1 if
- * lhs is greater and -1 if lhs is less.
+ * lhs is greater and -1 if lhs is less. StringView_t compares as String_t
+ * and BinaryRef_t as Binary_t. NaN doubles are equal to each other and
+ * greater than any other double.
  * @param lhs left operand.
  * @param rhs right operand.
  * @return 0, -1, 1 if equals, is lhs is greater or lhs is less.
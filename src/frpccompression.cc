@@ -0,0 +1,282 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   HTTP content coding (gzip, deflate) of message bodies.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include "frpccompression.h"
+#include "frpcunmarshaller.h"
+#include "frpcstreamerror.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace FRPC {
+namespace {
+
+const std::size_t CHUNK_SIZE = 1 << 14;
+
+// zlib window bits: +16 selects gzip wrapper, +32 detects gzip or zlib
+// wrapper automatically when decompressing
+const int WINDOW_BITS = 15;
+
+std::string lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), tolower);
+    return value;
+}
+
+std::string trim(const std::string &value) {
+    const char *ws = " \t";
+    std::string::size_type begin = value.find_first_not_of(ws);
+    if (begin == std::string::npos) return std::string();
+    return value.substr(begin, value.find_last_not_of(ws) - begin + 1);
+}
+
+int encodingByName(const std::string &name) {
+    if (name.empty() || (name == "identity")) return ENCODING_IDENTITY;
+    if ((name == "gzip") || (name == "x-gzip")) return ENCODING_GZIP;
+    if (name == "deflate") return ENCODING_DEFLATE;
+    return -1;
+}
+
+} // namespace
+
+const std::string ACCEPT_ENCODINGS = "gzip, deflate";
+
+const char *contentEncodingName(unsigned int encoding) {
+    switch (encoding) {
+    case ENCODING_GZIP:
+        return "gzip";
+    case ENCODING_DEFLATE:
+        return "deflate";
+    default:
+        return "";
+    }
+}
+
+int parseContentEncoding(const std::string &value) {
+    // only single coding is supported
+    return encodingByName(lower(trim(value)));
+}
+
+unsigned int parseAcceptEncoding(const std::string &value) {
+    unsigned int encodings = ENCODING_IDENTITY;
+    // codings explicitly refused by zero quality (they override "*")
+    unsigned int refused = ENCODING_IDENTITY;
+    std::string::size_type pos = 0;
+    while (pos <= value.size()) {
+        std::string::size_type end = value.find(',', pos);
+        if (end == std::string::npos) end = value.size();
+        std::string item(lower(value.substr(pos, end - pos)));
+        pos = end + 1;
+
+        // split coding and its parameters (quality)
+        std::string::size_type semicolon = item.find(';');
+        std::string name(trim(item.substr(0, semicolon)));
+        bool accepted = true;
+        if (semicolon != std::string::npos) {
+            std::string param(trim(item.substr(semicolon + 1)));
+            if ((param.size() > 2) && (param.compare(0, 2, "q=") == 0)
+                && (std::strtod(param.c_str() + 2, nullptr) <= 0.0))
+                accepted = false;
+        }
+
+        unsigned int flags = ENCODING_IDENTITY;
+        if (name == "*") {
+            flags = ENCODING_GZIP | ENCODING_DEFLATE;
+        } else {
+            int encoding = encodingByName(name);
+            if (encoding > 0) flags = static_cast<unsigned int>(encoding);
+        }
+
+        if (accepted) {
+            encodings |= flags;
+        } else if (name != "*") {
+            refused |= flags;
+        }
+    }
+    return encodings & ~refused;
+}
+
+std::size_t decompressedSizeLimit(int bodySizeLimit) {
+    if (bodySizeLimit < 0) return DECOMPRESSED_SIZE_LIMIT;
+    return std::size_t(bodySizeLimit) * 32;
+}
+
+unsigned int chooseContentEncoding(unsigned int encodings) {
+    if (encodings & ENCODING_GZIP) return ENCODING_GZIP;
+    if (encodings & ENCODING_DEFLATE) return ENCODING_DEFLATE;
+    return ENCODING_IDENTITY;
+}
+
+struct Compressor_t::Stream_t {
+    z_stream zs;
+};
+
+Compressor_t::Compressor_t(unsigned int encoding, int level)
+    : stream(new Stream_t()), coding(encoding)
+{
+    int windowBits = WINDOW_BITS;
+    switch (encoding) {
+    case ENCODING_GZIP:
+        windowBits += 16;
+        break;
+    case ENCODING_DEFLATE:
+        break;
+    default:
+        throw std::invalid_argument("Unsupported content encoding");
+    }
+
+    if (deflateInit2(&stream->zs, level, Z_DEFLATED, windowBits, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::bad_alloc();
+}
+
+Compressor_t::~Compressor_t() {
+    deflateEnd(&stream->zs);
+}
+
+void Compressor_t::deflate(const char *data, std::size_t size,
+                           std::string &out, int flush)
+{
+    z_stream &zs = stream->zs;
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs.avail_in = static_cast<uInt>(size);
+
+    for (;;) {
+        std::string::size_type offset = out.size();
+        out.resize(offset + CHUNK_SIZE);
+        zs.next_out = reinterpret_cast<Bytef *>(&out[offset]);
+        zs.avail_out = static_cast<uInt>(CHUNK_SIZE);
+
+        int ret = ::deflate(&zs, flush);
+        out.resize(out.size() - zs.avail_out);
+
+        if (ret == Z_STREAM_END) break;
+        if ((ret != Z_OK) && (ret != Z_BUF_ERROR))
+            throw StreamError_t("Compression failed");
+        // output space left means that all input has been consumed
+        if (zs.avail_out && !zs.avail_in && (flush == Z_NO_FLUSH)) break;
+    }
+}
+
+void Compressor_t::compress(const char *data, std::size_t size,
+                            std::string &out)
+{
+    deflate(data, size, out, Z_NO_FLUSH);
+}
+
+void Compressor_t::finish(std::string &out) {
+    deflate(nullptr, 0, out, Z_FINISH);
+}
+
+std::size_t Compressor_t::compress(std::list<std::string> &storage,
+                                   bool last)
+{
+    std::string out;
+    for (const std::string &part: storage)
+        compress(part.data(), part.size(), out);
+    if (last) finish(out);
+
+    storage.clear();
+    storage.push_back(std::move(out));
+    return storage.back().size();
+}
+
+struct Decompressor_t::Stream_t {
+    z_stream zs;
+};
+
+Decompressor_t::Decompressor_t(unsigned int encoding, std::size_t sizeLimit)
+    : stream(new Stream_t()), sizeLimit(sizeLimit), decompressed(0),
+      finished(false)
+{
+    if ((encoding != ENCODING_GZIP) && (encoding != ENCODING_DEFLATE))
+        throw std::invalid_argument("Unsupported content encoding");
+
+    // be liberal in what we accept, both wrappers are detected
+    if (inflateInit2(&stream->zs, WINDOW_BITS + 32) != Z_OK)
+        throw std::bad_alloc();
+}
+
+Decompressor_t::~Decompressor_t() {
+    inflateEnd(&stream->zs);
+}
+
+void Decompressor_t::decompress(const char *data, std::size_t size,
+                                UnMarshaller_t &um, char type)
+{
+    if (!size) return;
+    if (finished)
+        throw StreamError_t("Data after the end of compressed content");
+
+    char buffer[CHUNK_SIZE];
+    z_stream &zs = stream->zs;
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs.avail_in = static_cast<uInt>(size);
+
+    do {
+        zs.next_out = reinterpret_cast<Bytef *>(buffer);
+        zs.avail_out = static_cast<uInt>(CHUNK_SIZE);
+
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        switch (ret) {
+        case Z_OK:
+        case Z_BUF_ERROR:
+        case Z_STREAM_END:
+            break;
+        default:
+            throw StreamError_t("Corrupted compressed content");
+        }
+
+        if (std::size_t produced = CHUNK_SIZE - zs.avail_out) {
+            decompressed += produced;
+            if (decompressed > sizeLimit)
+                throw StreamError_t("Decompressed content is too large");
+            um.unMarshall(buffer, static_cast<unsigned int>(produced), type);
+        }
+
+        if (ret == Z_STREAM_END) {
+            finished = true;
+            if (zs.avail_in)
+                throw StreamError_t("Data after the end of compressed content");
+            break;
+        }
+    } while (zs.avail_in || !zs.avail_out);
+}
+
+void Decompressor_t::finish() {
+    if (!finished) throw StreamError_t("Truncated compressed content");
+}
+
+} // namespace FRPC
@@ -0,0 +1,205 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   HTTP content coding (gzip, deflate) of message bodies.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPCFRPCCOMPRESSION_H
+#define FRPCFRPCCOMPRESSION_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+
+#include <frpcplatform.h>
+
+namespace FRPC {
+
+class UnMarshaller_t;
+
+/**
+@brief Content codings supported by the library
+
+The values are bit flags so that set of codings accepted by the peer can be
+stored in one integer (like supported protocols of HTTPClient_t).
+*/
+enum {
+    ENCODING_IDENTITY = 0x00,
+    ENCODING_GZIP = 0x01,
+    ENCODING_DEFLATE = 0x02
+};
+
+/**
+@brief Value of Accept-Encoding header listing all supported codings
+*/
+FRPC_DLLEXPORT extern const std::string ACCEPT_ENCODINGS;
+
+/**
+@brief Name of the coding as used in HTTP headers
+@param encoding one of ENCODING_* values
+@return coding name (empty for identity)
+*/
+FRPC_DLLEXPORT const char *contentEncodingName(unsigned int encoding);
+
+/**
+@brief Parses value of Content-Encoding header
+@param value header value
+@return one of ENCODING_* values or -1 when the coding is not supported
+*/
+FRPC_DLLEXPORT int parseContentEncoding(const std::string &value);
+
+/**
+@brief Parses value of Accept-Encoding header
+@param value header value
+@return set of supported codings accepted by the peer (codings with zero
+        quality are excluded)
+*/
+FRPC_DLLEXPORT unsigned int parseAcceptEncoding(const std::string &value);
+
+/**
+@brief Limit of decompressed body size when the body size is not limited
+*/
+const std::size_t DECOMPRESSED_SIZE_LIMIT = 256 << 20;
+
+/**
+@brief Limit of decompressed body size derived from the limit of (compressed)
+       body size
+@param bodySizeLimit body size limit of HTTPIO_t (-1 = unlimited)
+@return 32 times bodySizeLimit or DECOMPRESSED_SIZE_LIMIT when unlimited
+*/
+FRPC_DLLEXPORT std::size_t decompressedSizeLimit(int bodySizeLimit);
+
+/**
+@brief Chooses the preferred coding from the set of accepted ones
+@param encodings set of ENCODING_* flags
+@return ENCODING_GZIP, ENCODING_DEFLATE or ENCODING_IDENTITY
+*/
+FRPC_DLLEXPORT unsigned int chooseContentEncoding(unsigned int encodings);
+
+/**
+@brief Streaming compressor of message body
+
+It compresses the body buffered in the same storage used by HTTPClient_t and
+Server_t so the compressed data can be sent in place of the plain ones.
+*/
+class FRPC_DLLEXPORT Compressor_t {
+public:
+    /**
+    @brief Constructor
+    @param encoding ENCODING_GZIP or ENCODING_DEFLATE
+    @param level zlib compression level (fast compression by default since
+                 the body is compressed on the request path)
+    */
+    explicit Compressor_t(unsigned int encoding, int level = 1);
+
+    ~Compressor_t();
+
+    /**
+    @brief Compresses data and appends the output to out
+    @param data plain data
+    @param size size of data
+    @param out compressed output (may stay empty, data are buffered inside)
+    */
+    void compress(const char *data, std::size_t size, std::string &out);
+
+    /**
+    @brief Flushes remaining output and terminates the stream
+    @param out compressed output
+    */
+    void finish(std::string &out);
+
+    /**
+    @brief Replaces the buffered body by the compressed one
+    @param storage body buffers, it contains one buffer on return
+    @param last true if it is the last part of the body
+    @return size of compressed data in the storage
+    */
+    std::size_t compress(std::list<std::string> &storage, bool last);
+
+    unsigned int encoding() const { return coding;}
+
+private:
+    Compressor_t(const Compressor_t &);
+    Compressor_t &operator=(const Compressor_t &);
+
+    void deflate(const char *data, std::size_t size, std::string &out,
+                 int flush);
+
+    struct Stream_t;
+    std::unique_ptr<Stream_t> stream;
+    unsigned int coding;
+};
+
+/**
+@brief Streaming decompressor of message body feeding the unmarshaller
+*/
+class FRPC_DLLEXPORT Decompressor_t {
+public:
+    /**
+    @brief Constructor
+    @param encoding ENCODING_GZIP or ENCODING_DEFLATE
+    @param sizeLimit maximal size of decompressed data, it protects the
+                     unmarshaller from bodies that expand enormously
+    */
+    explicit Decompressor_t(unsigned int encoding,
+                            std::size_t sizeLimit = DECOMPRESSED_SIZE_LIMIT);
+
+    ~Decompressor_t();
+
+    /**
+    @brief Decompresses the data and passes them to the unmarshaller
+    @param data compressed data
+    @param size size of data
+    @param um target unmarshaller
+    @param type type of unmarshalled message
+    @throw StreamError_t if data are corrupted or too large
+    */
+    void decompress(const char *data, std::size_t size, UnMarshaller_t &um,
+                    char type);
+
+    /**
+    @brief Checks that the whole compressed stream has been received
+    @throw StreamError_t if the stream is truncated
+    */
+    void finish();
+
+private:
+    Decompressor_t(const Decompressor_t &);
+    Decompressor_t &operator=(const Decompressor_t &);
+
+    struct Stream_t;
+    std::unique_ptr<Stream_t> stream;
+    std::size_t sizeLimit;
+    std::size_t decompressed;
+    bool finished;
+};
+
+} // namespace FRPC
+
+#endif
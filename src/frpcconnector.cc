@@ -38,6 +38,8 @@
 #include <cstring>
 #include <cerrno>
 #include <fcntl.h>
+#include <chrono>
+#include <vector>
 
 #ifndef UNIX_PATH_MAX
 # define UNIX_PATH_MAX   108
@@ -45,6 +47,7 @@
 
 #include "frpcplatform.h"
 #include "frpcconnector.h"
+#include "frpcresolver.h"
 #include "frpchttperror.h"
 #include "frpcsocket.h"
 
@@ -78,28 +81,7 @@ namespace {
         bool doClose;
     };
 
-    const char *host_strerror(int num) {
-        switch (num) {
-        case HOST_NOT_FOUND:
-            return "The specified host is unknown";
-
-        case NO_ADDRESS:
-            return "The requested name is valid but does "
-                "not have an IP address.";
-
-        case NO_RECOVERY:
-            return "A non-recoverable name server error occurred.";
-
-        case TRY_AGAIN:
-            return "A temporary error occurred on an authoritative "
-                "name server.  Try again later.";
-
-        default:
-            return "Unknown DNS related error.";
-        }
-    }
-
-    void checkSocket(int &fd)
+    int getSocketError(int &fd)
     {
         // check for connect status
         socklen_t len = sizeof(int);
@@ -116,8 +98,13 @@ namespace {
                     ERRNO, STRERROR(ERRNO));
         }
 
+        return status;
+    }
+
+    void checkSocket(int &fd)
+    {
         // check for error
-        if (status) {
+        if (int status = getSocketError(fd)) {
             STRERROR_PRE();
             throw HTTPError_t::format(
                     HTTP_SYSCALL, "Cannot connect socket: <%d, %s>.",
@@ -218,58 +205,18 @@ namespace {
         }
     }
 
-} // namespace
-
-SimpleConnector_t::SimpleConnector_t(const URL_t &url, int connectTimeout,
-                                     bool keepAlive)
-    : Connector_t(url, connectTimeout, keepAlive)
-{
-    struct hostent h, *he;
-    char tmpbuf[1024];
-    int errcode;
-
-
-#if (defined(sun) || defined(__sun)) && (defined(__SVR4) || defined(__svr4__))
-    he = gethostbyname_r(url.host.c_str(), &h, tmpbuf, 1024, &errcode);
-#else
-    gethostbyname_r(url.host.c_str(), &h, tmpbuf, 1024, &he, &errcode);
-#endif
-
-    if (!he) {
-        // oops
-        throw HTTPError_t::format(HTTP_DNS,
-                                  "Cannot resolve host '%s': <%d, %s>.",
-                                  url.host.c_str(), errcode,
-                                  host_strerror(errcode));
-    }
-
-    // remember IP address
-    ipaddr = *reinterpret_cast<in_addr*>(he->h_addr_list[0]);
-}
-
-SimpleConnector_t::~SimpleConnector_t() {}
-
-void SimpleConnector_t::connectSocket(int &fd) {
-    // check socket
-    if (!keepAlive && (fd > -1)) {
-        TEMP_FAILURE_RETRY(::close(fd));
-        fd = -1;
-    }
-
-    // initialize closer (initially closes socket when valid)
-    SocketCloser_t closer(fd);
-
-    // check open socket whether the peer had not closed it
-    if (fd > -1) {
-        closer.release();
-
-        closeSocketIfPeerClosed(fd);
-    }
+    /** Opens new non-blocking socket and starts connect to the address.
+     *
+     * @return 0 when connected, EINPROGRESS when connect runs on the
+     *         background or error of refused connect (socket is closed)
+     */
+    int startConnect(int &fd, const Resolver_t::Address_t &address)
+    {
+        // initialize closer (closes socket unless connecting)
+        SocketCloser_t closer(fd);
 
-    // if open socket is not availabe open new one
-    if (fd < 0) {
         // otevøeme socket
-        if ((fd = ::socket(PF_INET, SOCK_STREAM, 0)) < 0) {
+        if ((fd = ::socket(address.family, SOCK_STREAM, 0)) < 0) {
             // oops! error
             STRERROR_PRE();
             throw HTTPError_t::format(
@@ -282,18 +229,10 @@ void SimpleConnector_t::connectSocket(int &fd) {
 
         setNonDelayedSocket(fd);
 
-        // peer address
-        struct sockaddr_in addr;
-
-        // initialize it
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(url.port);
-        addr.sin_addr = ipaddr;
-        memset(addr.sin_zero, 0x0, 8);
-
         // connect the socket
-        if (TEMP_FAILURE_RETRY(::connect(fd, (struct sockaddr *)&addr,
-                               sizeof(struct sockaddr))) < 0)
+        int result = 0;
+        if (TEMP_FAILURE_RETRY(::connect(fd, address.get(),
+                                         address.length)) < 0)
         {
             switch (ERRNO) {
             case EINPROGRESS:
@@ -302,126 +241,293 @@ void SimpleConnector_t::connectSocket(int &fd) {
                 // connection already in progress
             case EWOULDBLOCK:
                 // connection launched on the background
+                result = EINPROGRESS;
                 break;
 
             default:
-                STRERROR_PRE();
-                throw HTTPError_t::format(
-                        HTTP_SYSCALL,
-                        "Cannot connect socket: <%d, %s>.",
-                        ERRNO, STRERROR(ERRNO));
+                return ERRNO;
             }
+        }
 
-            waitConnectSocket(fd, url, connectTimeout);
+        // connect OK or in progress => do not close the socket!
+        closer.release();
+        return result;
+    }
 
-            checkSocket(fd);
+    /** Opens new socket and connects it to the address of the host.
+     *
+     * @return 0 on success or error of refused connect
+     */
+    int connectAddress(int &fd, const Resolver_t::Host_t &host,
+                       std::size_t index, const URL_t &url,
+                       int connectTimeout)
+    {
+        int result = startConnect(fd, host[index]);
+        if (result != EINPROGRESS) return result;
+
+        // initialize closer (closes socket unless connected)
+        SocketCloser_t closer(fd);
+
+        try {
+            waitConnectSocket(fd, url, connectTimeout);
+        } catch (const HTTPError_t &) {
+            // do not try this address first again
+            host.failed(index);
+            throw;
         }
 
+        if (int status = getSocketError(fd)) return status;
+
         // connect OK => do not close the socket!
         closer.release();
+        return 0;
     }
-}
 
+    /** Connects new socket to the first address of the host accepting the
+     *  connection.
+     */
+    void connectHost(int &fd, const Resolver_t::Host_t &host,
+                     const URL_t &url, int connectTimeout)
+    {
+        int error = 0;
+        for (std::size_t index: host.order()) {
+            error = connectAddress(fd, host, index, url, connectTimeout);
+            if (!error) {
+                host.succeeded(index);
+                return;
+            }
+            host.failed(index);
+        }
 
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot connect socket: <%d, %s>.",
+                error, STRERROR(error));
+    }
 
-SimpleConnectorIPv6_t::SimpleConnectorIPv6_t(const URL_t &url, int connectTimeout,
-                                     bool keepAlive)
-    : Connector_t(url, connectTimeout, keepAlive), addrInfo(nullptr)
-{
-    int errcode;
-    struct addrinfo hints;
-    char port[8] = {0};
-
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_flags = 0;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
-
-    std::string host = url.host;
-    if ( *host.begin() == '[' && *host.rbegin() == ']' ) {
-        host = host.substr(1, host.size() - 2);
-        hints.ai_family = AF_INET6;
+    /** Closes sockets of unfinished connects.
+     */
+    struct PendingCloser_t {
+        ~PendingCloser_t() {
+            for (const pollfd &pfd: fds) TEMP_FAILURE_RETRY(::close(pfd.fd));
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<std::size_t> indices;
+    };
+
+    /** Connects new socket to the host addresses in staggered parallel:
+     *  next address is tried when previous connect does not finish within
+     *  attemptDelay or immediately when it fails. The first connected
+     *  socket is kept and the others are closed.
+     */
+    void connectHostParallel(int &fd, const Resolver_t::Host_t &host,
+                             const URL_t &url, int connectTimeout,
+                             int attemptDelay)
+    {
+        using Clock_t = std::chrono::steady_clock;
+        auto remaining = [](Clock_t::time_point until, Clock_t::time_point now)
+        {
+            auto ms = std::chrono::ceil<std::chrono::milliseconds>(
+                    until - now).count();
+            return (ms > 0) ? int(ms) : 0;
+        };
+
+        std::vector<std::size_t> order = host.order();
+        std::size_t next = 0;
+        int error = 0;
+        PendingCloser_t pending;
+
+        auto now = Clock_t::now();
+        auto deadline = now + std::chrono::milliseconds(connectTimeout);
+        auto nextAttempt = now;
+
+        for (;;) {
+            // start next connect when it is time or nothing is pending
+            if ((next < order.size())
+                && (pending.fds.empty() || (now >= nextAttempt)))
+            {
+                std::size_t index = order[next++];
+                int result = startConnect(fd, host[index]);
+                if (!result) {
+                    host.succeeded(index);
+                    return;
+                }
+                if (result != EINPROGRESS) {
+                    host.failed(index);
+                    error = result;
+                    continue;
+                }
+
+                pollfd pfd;
+                pfd.fd = fd;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                pending.fds.push_back(pfd);
+                pending.indices.push_back(index);
+                fd = -1;
+                nextAttempt = now + std::chrono::milliseconds(attemptDelay);
+                continue;
+            }
+
+            if (pending.fds.empty()) {
+                STRERROR_PRE();
+                throw HTTPError_t::format(
+                        HTTP_SYSCALL, "Cannot connect socket: <%d, %s>.",
+                        error, STRERROR(error));
+            }
+
+            int timeout = -1;
+            if (connectTimeout >= 0) {
+                if (now >= deadline) {
+                    // do not try these addresses first again
+                    for (std::size_t index: pending.indices) {
+                        host.failed(index);
+                    }
+                    throw HTTPError_t::format(
+                            HTTP_SYSCALL, "Timeout while connecting to %s.",
+                            url.getUrl().c_str());
+                }
+                timeout = remaining(deadline, now);
+            }
+            if (next < order.size()) {
+                int wait = remaining(nextAttempt, now);
+                if ((timeout < 0) || (wait < timeout)) timeout = wait;
+            }
+
+            // wait for connect completion of any socket
+            if (TEMP_FAILURE_RETRY(::poll(pending.fds.data(),
+                                          pending.fds.size(), timeout)) < 0)
+            {
+                STRERROR_PRE();
+                throw HTTPError_t::format(
+                        HTTP_SYSCALL, "Cannot select on socket: <%d, %s>.",
+                        ERRNO, STRERROR(ERRNO));
+            }
+
+            for (std::size_t i = 0; i < pending.fds.size();) {
+                if (!pending.fds[i].revents) {
+                    ++i;
+                    continue;
+                }
+
+                int status = getSocketError(pending.fds[i].fd);
+                std::size_t index = pending.indices[i];
+                if (!status) {
+                    // connect OK => keep the socket, close the others
+                    host.succeeded(index);
+                    fd = pending.fds[i].fd;
+                    pending.fds.erase(pending.fds.begin() + long(i));
+                    return;
+                }
+
+                host.failed(index);
+                error = status;
+                TEMP_FAILURE_RETRY(::close(pending.fds[i].fd));
+                pending.fds.erase(pending.fds.begin() + long(i));
+                pending.indices.erase(pending.indices.begin() + long(i));
+            }
+
+            now = Clock_t::now();
+        }
     }
 
-    snprintf(port, sizeof(port), "%u", url.port);
-    errcode = getaddrinfo(host.c_str(), port, &hints, &addrInfo);
-    if ( errcode != 0 ) {
-        // oops
-        throw HTTPError_t::format(
-                HTTP_DNS, "Cannot resolve host '%s'('%s'): <%d, %s>.",
-                url.host.c_str(), host.c_str(), errcode,
-                gai_strerror(errcode));
+    /** Splits host of the URL to host name and address family: host in
+     *  brackets is IPv6 address.
+     */
+    void parseHost(const URL_t &url, std::string &host, int &family) {
+        host = url.host;
+        family = AF_INET;
+        if (!host.empty() && *host.begin() == '[' && *host.rbegin() == ']') {
+            host = host.substr(1, host.size() - 2);
+            family = AF_INET6;
+        }
     }
 
-}
+    /** Closes the socket that should not be reused.
+     *
+     * @return true if there is no usable socket
+     */
+    bool needsConnect(int &fd, bool keepAlive)
+    {
+        // check socket
+        if (!keepAlive && (fd > -1)) {
+            TEMP_FAILURE_RETRY(::close(fd));
+            fd = -1;
+        }
 
-SimpleConnectorIPv6_t::~SimpleConnectorIPv6_t() {
-    if ( addrInfo )
-        freeaddrinfo(addrInfo);
-}
+        // check open socket whether the peer had not closed it
+        if (fd > -1) closeSocketIfPeerClosed(fd);
 
-void SimpleConnectorIPv6_t::connectSocket(int &fd) {
-    // check socket
-    if (!keepAlive && (fd > -1)) {
-        TEMP_FAILURE_RETRY(::close(fd));
-        fd = -1;
+        return fd < 0;
     }
 
-    // initialize closer (initially closes socket when valid)
-    SocketCloser_t closer(fd);
+} // namespace
 
-    // check open socket whether the peer had not closed it
-    if (fd > -1) {
-        closer.release();
+SimpleConnector_t::SimpleConnector_t(const URL_t &url, int connectTimeout,
+                                     bool keepAlive)
+    : Connector_t(url, connectTimeout, keepAlive)
+{
+    // fail early when host cannot be resolved
+    Resolver_t::instance().resolve(url.host, url.port, AF_INET);
+}
 
-        closeSocketIfPeerClosed(fd);
-    }
+SimpleConnector_t::~SimpleConnector_t() {}
 
+void SimpleConnector_t::connectSocket(int &fd) {
     // if open socket is not availabe open new one
-    if (fd < 0) {
-        // otevøeme socket
-        if ((fd = ::socket(addrInfo->ai_family, SOCK_STREAM, 0)) < 0) {
-            // oops! error
-            STRERROR_PRE();
-            throw HTTPError_t::format(
-                    HTTP_SYSCALL,
-                    "Cannot select on socket: <%d, %s>.",
-                    ERRNO, STRERROR(ERRNO));
-        }
+    if (needsConnect(fd, keepAlive)) {
+        auto host = Resolver_t::instance().resolve(url.host, url.port,
+                                                   AF_INET);
+        connectHost(fd, *host, url, connectTimeout);
+    }
+}
 
-        setNonBlockingSocket(fd);
 
-        setNonDelayedSocket(fd);
 
-        // connect the socket
-        if (TEMP_FAILURE_RETRY(::connect(fd, addrInfo->ai_addr,
-                               addrInfo->ai_addrlen)) < 0)
-        {
-            switch (ERRNO) {
-            case EINPROGRESS:
-                // connection already in progress
-            case EALREADY:
-                // connection already in progress
-            case EWOULDBLOCK:
-                // connection launched on the background
-                break;
+SimpleConnectorIPv6_t::SimpleConnectorIPv6_t(const URL_t &url, int connectTimeout,
+                                     bool keepAlive)
+    : Connector_t(url, connectTimeout, keepAlive), family(AF_INET)
+{
+    parseHost(url, host, family);
 
-            default:
-                STRERROR_PRE();
-                throw HTTPError_t::format(
-                        HTTP_SYSCALL,
-                        "Cannot connect socket: <%d, %s>.",
-                        ERRNO, STRERROR(ERRNO));
-            }
+    // fail early when host cannot be resolved
+    Resolver_t::instance().resolve(host, url.port, family);
+}
 
-            waitConnectSocket(fd, url, connectTimeout);
+SimpleConnectorIPv6_t::~SimpleConnectorIPv6_t() {}
 
-            checkSocket(fd);
-        }
+void SimpleConnectorIPv6_t::connectSocket(int &fd) {
+    // if open socket is not availabe open new one
+    if (needsConnect(fd, keepAlive)) {
+        auto resolved = Resolver_t::instance().resolve(host, url.port,
+                                                       family);
+        connectHost(fd, *resolved, url, connectTimeout);
+    }
+}
 
-        // connect OK => do not close the socket!
-        closer.release();
+ParallelConnector_t::ParallelConnector_t(const URL_t &url,
+                                         int connectTimeout, bool keepAlive,
+                                         int attemptDelay,
+                                         Resolver_t *resolver)
+    : Connector_t(url, connectTimeout, keepAlive), family(AF_INET),
+      attemptDelay(attemptDelay),
+      resolver(resolver ? *resolver : Resolver_t::instance())
+{
+    parseHost(url, host, family);
+
+    // fail early when host cannot be resolved
+    this->resolver.resolve(host, url.port, family);
+}
+
+ParallelConnector_t::~ParallelConnector_t() {}
+
+void ParallelConnector_t::connectSocket(int &fd) {
+    // if open socket is not availabe open new one
+    if (needsConnect(fd, keepAlive)) {
+        auto resolved = resolver.resolve(host, url.port, family);
+        connectHostParallel(fd, *resolved, url, connectTimeout,
+                            attemptDelay);
     }
 }
 
@@ -33,12 +33,16 @@
 #ifndef FRPCCONNECTOR_H
 #define FRPCCONNECTOR_H
 
+#include <string>
+
 #include <frpcplatform.h>
 #include <frpchttp.h>
 
 
 namespace FRPC {
 
+class Resolver_t;
+
 /** Socket connector. Base class.
  */
 class FRPC_DLLEXPORT Connector_t {
@@ -72,8 +76,9 @@ private:
     Connector_t& operator=(const Connector_t&);
 };
 
-/** Simple socket connector: connects to the first IP returned by host
- *  resolution.
+/** Simple IPv4 socket connector: connects to the addresses returned by
+ *  the shared Resolver_t in round-robin order, addresses refusing
+ *  connection are skipped.
  */
 class FRPC_DLLEXPORT SimpleConnector_t : public Connector_t {
 public:
@@ -82,17 +87,12 @@ public:
     virtual ~SimpleConnector_t();
 
     virtual void connectSocket(int &fd);
-
-private:
-
-    /** Resolved IP address.
-     */
-    in_addr ipaddr;
 };
 
 
-/** Simple socket connector: connects to the first IP returned by host
- *  resolution.
+/** Simple socket connector: connects to the addresses returned by the
+ *  shared Resolver_t in round-robin order, addresses refusing connection
+ *  are skipped. Host in brackets is resolved as IPv6 address.
  */
 class FRPC_DLLEXPORT SimpleConnectorIPv6_t : public Connector_t {
 public:
@@ -104,9 +104,60 @@ public:
 
 private:
 
-    /** Resolved IP address.
+    /** Host name without brackets.
+     */
+    std::string host;
+
+    /** Address family to resolve.
+     */
+    int family;
+};
+
+/** Socket connector connecting to the addresses returned by the shared
+ *  (or given) Resolver_t in staggered parallel: connect to the next address starts
+ *  when the previous one does not finish within attemptDelay (or fails),
+ *  the first connected socket is kept and the other connects are
+ *  cancelled. One blackholed address thus delays the connect by
+ *  attemptDelay instead of whole connectTimeout. Host in brackets is
+ *  resolved as IPv6 address.
+ */
+class FRPC_DLLEXPORT ParallelConnector_t : public Connector_t {
+public:
+    /** Constructor.
+     *
+     * @param attemptDelay delay between connect attempts in milliseconds
+     * @param resolver resolver used instead of the shared one (it must
+     *                 outlive the connector)
+     */
+    ParallelConnector_t(const URL_t &url, int connectTimeout, bool keepAlive,
+                        int attemptDelay = 250,
+                        Resolver_t *resolver = nullptr);
+
+    virtual ~ParallelConnector_t();
+
+    virtual void connectSocket(int &fd);
+
+    void setAttemptDelay(int delay) {
+        attemptDelay = delay;
+    }
+
+private:
+
+    /** Host name without brackets.
+     */
+    std::string host;
+
+    /** Address family to resolve.
+     */
+    int family;
+
+    /** Delay between connect attempts.
+     */
+    int attemptDelay;
+
+    /** Resolver of the host.
      */
-    struct addrinfo *addrInfo;
+    Resolver_t &resolver;
 };
 
 #ifndef WIN32
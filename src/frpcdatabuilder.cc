@@ -59,6 +59,20 @@ void DataBuilder_t::buildStructMember(const char *memberName) {
     buildStructMember(memberName,size);
 }
 
+void DataBuilder_t::buildIntArray(std::vector<Int_t::value_type> values) {
+    openArray(static_cast<uint32_t>(values.size()));
+    for (Int_t::value_type value: values)
+        buildInt(value);
+    closeArray();
+}
+
+void DataBuilder_t::buildDoubleArray(std::vector<double> values) {
+    openArray(static_cast<uint32_t>(values.size()));
+    for (double value: values)
+        buildDouble(value);
+    closeArray();
+}
+
 DataBuilderWithNull_t::DataBuilderWithNull_t() = default;
 
 DataBuilderWithNull_t::~DataBuilderWithNull_t() = default;
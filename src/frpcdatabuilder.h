@@ -38,6 +38,7 @@
 #include <frpcint.h>
 #include <time.h>
 #include <string>
+#include <vector>
 
 namespace FRPC {
 
@@ -78,6 +79,23 @@ public:
     virtual void openArray(unsigned int numOfItems) = 0;
     virtual void openStruct(unsigned int numOfMembers) = 0;
 
+    /**
+        @brief Builds array of ints received as one packed block
+        @param values is a items of the array
+
+        Default implementation builds regular array (openArray(), buildInt()
+        for each item and closeArray()).
+    */
+    virtual void buildIntArray(std::vector<Int_t::value_type> values);
+
+    /**
+        @brief Builds array of doubles received as one packed block
+        @param values is a items of the array
+
+        Default implementation builds regular array (openArray(),
+        buildDouble() for each item and closeArray()).
+    */
+    virtual void buildDoubleArray(std::vector<double> values);
 };
 
 class FRPC_DLLEXPORT DataBuilderWithNull_t : public DataBuilder_t
@@ -37,6 +37,7 @@
 #include "frpcdatetime.h"
 #include "frpcpool.h"
 #include "frpcconfig.h"
+#include "frpclocaltime.h"
 
 namespace FRPC {
 
@@ -57,12 +58,8 @@ DateTime_t::DateTime_t(int16_t year, char month, char day,
         time_tm.tm_min = minute;
         time_tm.tm_sec = sec;
         time_tm.tm_isdst = -1; // we know nothing about daylight savings time
-        time_t time_l = mktime(&time_tm);
-        struct tm timeValid = {};
-        localtime_r(&time_l, &timeValid);
-
-        this->unixTime = time_l;
-        this->weekDay = static_cast<char>(timeValid.tm_wday);
+        this->unixTime = makeTime(time_tm);
+        this->weekDay = static_cast<char>(time_tm.tm_wday);
     }
 }
 
@@ -78,12 +75,8 @@ DateTime_t::DateTime_t(short year, char month, char day,
     time_tm.tm_min = minute;
     time_tm.tm_sec = sec;
     time_tm.tm_isdst = -1; // we know nothing about daylight savings time
-    time_t time_l = mktime(&time_tm);
-    struct tm timeValid = {};
-    localtime_r(&time_l, &timeValid);
-
-    unixTime = time_l;
-    weekDay = static_cast<char>(timeValid.tm_wday);
+    unixTime = makeTime(time_tm);
+    weekDay = static_cast<char>(time_tm.tm_wday);
 #ifdef HAVE_ALTZONE
     timeZone = (time_tm.tm_isdst > 0)? ::altzone: ::timezone;
 #else
@@ -94,7 +87,7 @@ DateTime_t::DateTime_t(short year, char month, char day,
 DateTime_t::DateTime_t(const time_t &unixTime)
 {
     struct tm time_tm = {};
-    localtime_r(&unixTime, &time_tm);
+    localTime(unixTime, time_tm);
     year = static_cast<int16_t>(time_tm.tm_year + 1900);
     month = static_cast<char>(time_tm.tm_mon + 1);
     day = static_cast<char>(time_tm.tm_mday);
@@ -115,7 +108,7 @@ DateTime_t::DateTime_t(time_t unixTime, int timeZone)
     : unixTime(unixTime), timeZone(timeZone)
 {
     struct tm time_tm = {};
-    localtime_r(&unixTime, &time_tm);
+    localTime(unixTime, time_tm);
     year = static_cast<int16_t>(time_tm.tm_year + 1900);
     month = static_cast<char>(time_tm.tm_mon + 1);
     day = static_cast<char>(time_tm.tm_mday);
@@ -133,14 +126,14 @@ DateTime_t::DateTime_t(const struct tm &tm)
       minute(static_cast<char>(tm.tm_min)),
       sec(static_cast<char>(tm.tm_sec)),
       weekDay(static_cast<char>(tm.tm_wday)),
-      unixTime(mktime(const_cast<struct tm *>(&tm))),
+      unixTime(makeTime(const_cast<struct tm &>(tm))),
       timeZone(0)
 {}
 
 DateTime_t::DateTime_t() {
     time_t unix_time =  time(nullptr);
     struct tm time_tm = {};
-    localtime_r(&unix_time, &time_tm);
+    localTime(unix_time, time_tm);
     year = static_cast<int16_t>(time_tm.tm_year + 1900);
     month = static_cast<char>(time_tm.tm_mon + 1);
     day = static_cast<char>(time_tm.tm_mday);
@@ -148,7 +141,7 @@ DateTime_t::DateTime_t() {
     minute =  static_cast<char>(time_tm.tm_min);
     sec =  static_cast<char>(time_tm.tm_sec);
     weekDay =  static_cast<char>(time_tm.tm_wday);
-    this->unixTime = mktime(&time_tm);;
+    this->unixTime = unix_time;
 
 #ifdef HAVE_ALTZONE
     timeZone = (time_tm.tm_isdst > 0)? ::altzone: ::timezone;
@@ -170,12 +163,8 @@ DateTime_t::DateTime_t(const std::string &isoFormat)
     time_tm.tm_min = minute;
     time_tm.tm_sec = sec;
     time_tm.tm_isdst = -1; // we know nothing about daylight savings time
-    time_t time_l = mktime(&time_tm);
-    struct tm timeValid = {};
-    localtime_r(&time_l, &timeValid);
-
-    this->unixTime =  time_l;
-    this->weekDay = static_cast<char>(timeValid.tm_wday);
+    this->unixTime = makeTime(time_tm);
+    this->weekDay = static_cast<char>(time_tm.tm_wday);
 }
 
 DateTime_t::DateTime_t(short year, char month, char day,
@@ -243,7 +232,7 @@ Value_t& FRPC::DateTime_t::clone(Pool_t &newPool) const
 
 bool FRPC::DateTime_t::isSaveLightDay() const {
     struct tm timeValid;
-    localtime_r(&unixTime, &timeValid);
+    localTime(unixTime, timeValid);
     return timeValid.tm_isdst;
 }
 
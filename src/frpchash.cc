@@ -0,0 +1,627 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Structural hash of FastRPC values.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "frpchash.h"
+#include "frpc.h"
+#include "frpcstring_view.h"
+#include "frpcbinaryref.h"
+#include "frpcconfig.h"
+#include "frpcinternals.h"
+#include "frpclocaltime.h"
+
+namespace FRPC {
+namespace {
+
+/* The hash is the XXH64 function applied on canonical serialization of the
+ * value:
+ *
+ *  scalar:  type tag, payload (ints, datetimes and doubles as 8 bytes
+ *           little endian, bool as single byte, string/binary bytes)
+ *  array:   type tag, hash of each item, number of items
+ *  struct:  type tag, wrapping sum of member hashes, number of members
+ *  member:  name, hash of the value
+ *
+ * The type tags are the binary protocol ones so both hash() and
+ * hashBinary() share them.
+ */
+
+const uint64_t PRIME1 = 11400714785074694791ULL;
+const uint64_t PRIME2 = 14029467366897019727ULL;
+const uint64_t PRIME3 =  1609587929392839161ULL;
+const uint64_t PRIME4 =  9650029242287828579ULL;
+const uint64_t PRIME5 =  2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, unsigned r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#ifdef FRPC_BIG_ENDIAN
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline uint64_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#ifdef FRPC_BIG_ENDIAN
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+/** Streaming XXH64. Bulk data are consumed in 32 bytes stripes by four
+ * independent lanes which compilers map to vector registers.
+ */
+class Hasher_t {
+public:
+    Hasher_t(): total(0), used(0) {
+        lanes[0] = PRIME1 + PRIME2;
+        lanes[1] = PRIME2;
+        lanes[2] = 0;
+        lanes[3] = -PRIME1;
+    }
+
+    void update(const void *data, std::size_t size) {
+        auto *p = static_cast<const unsigned char *>(data);
+        total += size;
+
+        if (used + size < STRIPE) {
+            if (size) memcpy(buffer + used, p, size);
+            used += size;
+            return;
+        }
+
+        if (used) {
+            std::size_t fill = STRIPE - used;
+            memcpy(buffer + used, p, fill);
+            consume(buffer);
+            p += fill;
+            size -= fill;
+            used = 0;
+        }
+
+        for (; size >= STRIPE; p += STRIPE, size -= STRIPE)
+            consume(p);
+
+        if (size) memcpy(buffer, p, size);
+        used = size;
+    }
+
+    void update(uint8_t byte) { update(&byte, 1);}
+
+    void update(uint64_t number) {
+        unsigned char data[8];
+        for (unsigned i = 0; i < 8; ++i, number >>= 8)
+            data[i] = static_cast<unsigned char>(number);
+        update(data, sizeof(data));
+    }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (total >= STRIPE) {
+            h = rotl(lanes[0], 1) + rotl(lanes[1], 7)
+                + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (uint64_t lane: lanes) {
+                h ^= round(0, lane);
+                h = h * PRIME1 + PRIME4;
+            }
+        } else {
+            h = PRIME5;
+        }
+        h += total;
+
+        const unsigned char *p = buffer;
+        const unsigned char *end = buffer + used;
+        for (; p + 8 <= end; p += 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * PRIME1 + PRIME4;
+        }
+        if (p + 4 <= end) {
+            h ^= read32(p) * PRIME1;
+            h = rotl(h, 23) * PRIME2 + PRIME3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= (*p) * PRIME5;
+            h = rotl(h, 11) * PRIME1;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static const std::size_t STRIPE = 32;
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    void consume(const unsigned char *p) {
+        for (unsigned i = 0; i < 4; ++i)
+            lanes[i] = round(lanes[i], read64(p + 8 * i));
+    }
+
+    uint64_t lanes[4];
+    uint64_t total;
+    unsigned char buffer[STRIPE];
+    std::size_t used;
+};
+
+uint64_t hashNull() {
+    Hasher_t hasher;
+    hasher.update(uint8_t(NULLTYPE));
+    return hasher.digest();
+}
+
+uint64_t hashBool(bool value) {
+    Hasher_t hasher;
+    hasher.update(uint8_t(BOOL));
+    hasher.update(uint8_t(value));
+    return hasher.digest();
+}
+
+uint64_t hashNumber(uint8_t type, int64_t value) {
+    Hasher_t hasher;
+    hasher.update(type);
+    hasher.update(static_cast<uint64_t>(value));
+    return hasher.digest();
+}
+
+uint64_t hashDouble(double value) {
+    // values equal by operator< must have the same hash
+    if (value == 0) value = 0;
+    if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Hasher_t hasher;
+    hasher.update(uint8_t(DOUBLE));
+    hasher.update(bits);
+    return hasher.digest();
+}
+
+uint64_t hashBytes(uint8_t type, const char *data, std::size_t size) {
+    Hasher_t hasher;
+    hasher.update(type);
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+uint64_t hashMember(const char *name, std::size_t size, uint64_t value) {
+    Hasher_t hasher;
+    hasher.update(name, size);
+    hasher.update(value);
+    return hasher.digest();
+}
+
+/** Hash of array or struct fed item by item.
+ */
+class CompoundHasher_t {
+public:
+    explicit CompoundHasher_t(uint8_t type): type(type), count(0), sum(0) {
+        hasher.update(type);
+    }
+
+    void add(uint64_t value) {
+        ++count;
+        hasher.update(value);
+    }
+
+    void add(const char *name, std::size_t size, uint64_t value) {
+        ++count;
+        // struct member order does not matter
+        sum += hashMember(name, size, value);
+    }
+
+    uint64_t digest() {
+        if (type == STRUCT) hasher.update(sum);
+        hasher.update(count);
+        return hasher.digest();
+    }
+
+    uint8_t getType() const { return type;}
+
+private:
+    uint8_t type;
+    uint64_t count;
+    uint64_t sum;
+    Hasher_t hasher;
+};
+
+uint64_t hashCall(const char *name, std::size_t size, uint64_t params) {
+    uint64_t length = size;
+    Hasher_t hasher;
+    hasher.update(uint8_t(METHOD_CALL));
+    hasher.update(length);
+    hasher.update(name, size);
+    hasher.update(params);
+    return hasher.digest();
+}
+
+uint64_t hashValue(const Value_t &value) {
+    switch (value.getType()) {
+    case Bool_t::TYPE:
+        return hashBool(static_cast<const Bool_t &>(value).getValue());
+    case Int_t::TYPE:
+        return hashNumber(INT, static_cast<const Int_t &>(value).getValue());
+    case Double_t::TYPE:
+        return hashDouble(static_cast<const Double_t &>(value).getValue());
+    case String_t::TYPE: {
+        auto &str = static_cast<const String_t &>(value);
+        return hashBytes(STRING, str.data(), str.size());
+    }
+    case StringView_t::TYPE: {
+        auto &str = static_cast<const StringView_t &>(value);
+        return hashBytes(STRING, str.data(), str.size());
+    }
+    case Binary_t::TYPE: {
+        auto &bin = static_cast<const Binary_t &>(value);
+        return hashBytes(BINARY, bin.data(), bin.size());
+    }
+    case BinaryRef_t::TYPE: {
+        Hasher_t hasher;
+        hasher.update(uint8_t(BINARY));
+        for (auto chunk: static_cast<const BinaryRef_t &>(value).chunks())
+            hasher.update(chunk.data, chunk.size);
+        return hasher.digest();
+    }
+    case DateTime_t::TYPE:
+        return hashNumber(DATETIME, static_cast<const DateTime_t &>(value)
+                                        .getUnixTime());
+    case Null_t::TYPE:
+        return hashNull();
+    case Struct_t::TYPE: {
+        CompoundHasher_t hasher(STRUCT);
+        for (auto &member: static_cast<const Struct_t &>(value))
+            hasher.add(member.first.data(), member.first.size(),
+                       hashValue(*member.second));
+        return hasher.digest();
+    }
+    case Array_t::TYPE: {
+        CompoundHasher_t hasher(ARRAY);
+        // packed arrays are hashed without creating the items
+        if (auto *ints = dynamic_cast<const IntArray_t *>(&value)) {
+            if (ints->isPacked()) {
+                for (auto item: ints->values())
+                    hasher.add(hashNumber(INT, item));
+                return hasher.digest();
+            }
+        } else if (auto *doubles = dynamic_cast<const DoubleArray_t *>(&value)) {
+            if (doubles->isPacked()) {
+                for (auto item: doubles->values())
+                    hasher.add(hashDouble(item));
+                return hasher.digest();
+            }
+        }
+        for (auto *item: static_cast<const Array_t &>(value))
+            hasher.add(hashValue(*item));
+        return hasher.digest();
+    }
+    default:
+        break;
+    }
+    throw std::runtime_error("FRPC::hash(value)");
+}
+
+/** Bounds checked cursor over binary message.
+ */
+class Reader_t {
+public:
+    Reader_t(const char *data, std::size_t size)
+        : pos(data), end(data + size)
+    {}
+
+    const char *take(std::size_t size) {
+        if (static_cast<std::size_t>(end - pos) < size)
+            throw StreamError_t("Stream not complete");
+        const char *result = pos;
+        pos += size;
+        return result;
+    }
+
+    uint8_t byte() { return static_cast<uint8_t>(*take(1));}
+
+    /** Little endian number of given size, zero extended. */
+    uint64_t number(std::size_t size) {
+        const char *data = take(size);
+        uint64_t result = 0;
+        for (std::size_t i = 0; i < size; ++i)
+            result |= uint64_t(static_cast<uint8_t>(data[i])) << (8 * i);
+        return result;
+    }
+
+    bool eof() const { return pos == end;}
+
+private:
+    const char *pos;
+    const char *end;
+};
+
+uint8_t lengthSize(bool longer, uint8_t tag) {
+    if (longer) return (tag & 0x7u) + 1;
+    uint8_t size = (tag & 0x7u);
+    if (size == 0 || size > 4)
+        throw StreamError_t("Illegal element length");
+    return size;
+}
+
+int64_t negate(uint64_t value) {
+    auto number = static_cast<int64_t>(value);
+    if (number == std::numeric_limits<int64_t>::min()) return number;
+    return -number;
+}
+
+/** Mirrors BinUnMarshaller_t and DateTime_t in obtaining the unix time.
+ */
+int64_t unixTime(Reader_t &reader, const ProtocolVersion_t &version) {
+    bool v3 = version.versionMajor > 2;
+    const auto *data = reinterpret_cast<const uint8_t *>(
+            reader.take(v3 ? 14 : 10));
+
+    uint64_t number = 0;
+    for (unsigned i = 0, size = (v3 ? 8 : 4); i < size; ++i)
+        number |= uint64_t(data[1 + i]) << (8 * i);
+    int64_t time = v3
+        ? static_cast<int64_t>(number)
+        : static_cast<int32_t>(static_cast<uint32_t>(number));
+
+    if (!LibConfig_t::getInstance()->getDatetimeValidationPolicy())
+        return time;
+
+    const uint8_t *d = data + (v3 ? 4 : 0);
+    int year = (d[9] << 3) | ((d[8] & 0xe0) >> 5);
+    int month = (d[8] & 0x1e) >> 1;
+    int day = ((d[8] & 0x01) << 4) | ((d[7] & 0xf0) >> 4);
+    int hour = ((d[7] & 0x0f) << 1) | ((d[6] & 0x80) >> 7);
+    int minute = (d[6] & 0x7e) >> 1;
+    int sec = ((d[6] & 0x01) << 5) | ((d[5] & 0xf8) >> 3);
+    if (year || month || day || hour || minute || sec) year += 1600;
+
+    struct tm time_tm = {};
+    time_tm.tm_year = static_cast<int16_t>(year) - 1900;
+    time_tm.tm_mon = static_cast<char>(month) - 1;
+    time_tm.tm_mday = static_cast<char>(day);
+    time_tm.tm_hour = static_cast<char>(hour);
+    time_tm.tm_min = static_cast<char>(minute);
+    time_tm.tm_sec = static_cast<char>(sec);
+    time_tm.tm_isdst = -1;
+    return makeTime(time_tm);
+}
+
+struct Frame_t {
+    explicit Frame_t(uint8_t type, uint64_t remaining = 0)
+        : hasher(type), remaining(remaining), name(nullptr), nameSize(0)
+    {}
+
+    CompoundHasher_t hasher;
+    uint64_t remaining;
+    const char *name;
+    std::size_t nameSize;
+};
+
+} // namespace
+
+uint64_t hash(const Value_t &value) {
+    return hashValue(value);
+}
+
+uint64_t hash(const std::string &methodName, const Array_t &params) {
+    return hashCall(methodName.data(), methodName.size(), hashValue(params));
+}
+
+uint64_t hashBinary(const char *data, std::size_t size) {
+    Reader_t reader(data, size);
+
+    const char *magic = reader.take(4);
+    if ((uint8_t(magic[0]) != 0xCA) || (uint8_t(magic[1]) != 0x11))
+        throw StreamError_t("Bad magic !!!");
+    ProtocolVersion_t version(magic[2], magic[3]);
+    if (version.versionMajor > 3 || version.versionMajor < 1)
+        throw StreamError_t("Unsupported protocol version !!!");
+
+    const char *name = nullptr;
+    std::size_t nameSize = 0;
+    switch (reader.byte() >> 3) {
+    case METHOD_CALL:
+        nameSize = reader.byte();
+        if (!nameSize) throw StreamError_t("Bad call name");
+        name = reader.take(nameSize);
+        break;
+    case METHOD_RESPONSE:
+        break;
+    case FAULT:
+        throw StreamError_t("Can't hash fault");
+    default:
+        throw StreamError_t("Invalid stream message type");
+    }
+
+    // names of struct members sent by the protocol 3.2 key dictionary
+    bool dictionary = hasKeyDictionary(version);
+    std::vector<std::pair<const char *, std::size_t>> keys;
+
+    // the bottom frame collects call params or the response value
+    std::vector<Frame_t> stack;
+    stack.emplace_back(ARRAY, name ? std::numeric_limits<uint64_t>::max(): 1);
+    uint64_t last = 0;
+
+    while (!((stack.size() == 1)
+             && (!stack.back().remaining || (name && reader.eof()))))
+    {
+        if (stack.back().hasher.getType() == STRUCT) {
+            Frame_t &frame = stack.back();
+            frame.nameSize = reader.byte();
+            if (frame.nameSize) {
+                frame.name = reader.take(frame.nameSize);
+                if (dictionary && (keys.size() < KEY_DICTIONARY_LIMIT))
+                    keys.emplace_back(frame.name, frame.nameSize);
+
+            } else if (dictionary && !keys.empty()) {
+                uint64_t index = reader.number(keyIndexSize(keys.size()));
+                if (index >= keys.size())
+                    throw StreamError_t("Invalid struct member index");
+                frame.name = keys[index].first;
+                frame.nameSize = keys[index].second;
+
+            } else if (dictionary) {
+                throw StreamError_t("Invalid struct member index");
+
+            } else {
+                throw StreamError_t("Struct member name length is zero");
+            }
+        }
+
+        uint8_t tag = reader.byte();
+        uint8_t type = tag >> 3;
+        uint64_t h = 0;
+        switch (type) {
+        case BOOL:
+            if (tag & 0x6) throw StreamError_t("Invalid bool value");
+            h = hashBool(tag & 0x1);
+            break;
+        case NULLTYPE:
+            if (version.versionMajor == 1)
+                throw StreamError_t("Unknown value type");
+            h = hashNull();
+            break;
+        case INT: {
+            uint64_t n = reader.number(
+                    lengthSize(version.versionMajor > 2, tag));
+            h = hashNumber(INT, (version.versionMajor > 2)
+                           ? static_cast<int64_t>((n >> 1) ^ (0 - (n & 1)))
+                           : static_cast<int64_t>(n));
+            break;
+        }
+        case INTP8:
+            h = hashNumber(INT, static_cast<int64_t>(
+                        reader.number((tag & 0x7u) + 1)));
+            break;
+        case INTN8:
+            h = hashNumber(INT, negate(reader.number((tag & 0x7u) + 1)));
+            break;
+        case DOUBLE: {
+            uint64_t bits = reader.number(8);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            h = hashDouble(value);
+            break;
+        }
+        case DATETIME:
+            h = hashNumber(DATETIME, unixTime(reader, version));
+            break;
+        case STRING:
+        case BINARY: {
+            uint64_t length = reader.number(
+                    lengthSize(version.versionMajor >= 2, tag));
+            h = hashBytes(type, reader.take(length), length);
+            break;
+        }
+        case STRUCT:
+        case ARRAY: {
+            uint64_t count = reader.number(
+                    lengthSize(version.versionMajor >= 2, tag));
+            if (count >> 32) throw StreamError_t("Compound value too large");
+            if (count) {
+                stack.emplace_back(type, count);
+                continue;
+            }
+            h = Frame_t(type).hasher.digest();
+            break;
+        }
+        case INT_ARRAY:
+        case DOUBLE_ARRAY: {
+            if (!hasPackedArrays(version))
+                throw StreamError_t("Unknown value type");
+            uint64_t count = reader.number(lengthSize(true, tag));
+            std::size_t width = (type == INT_ARRAY) ? reader.byte() : 8;
+            if ((width != 1) && (width != 2) && (width != 4) && (width != 8))
+                throw StreamError_t("Invalid packed array item width");
+            if (count > (std::numeric_limits<uint64_t>::max() / width))
+                throw StreamError_t("Compound value too large");
+
+            const char *items = reader.take(count * width);
+            CompoundHasher_t hasher(ARRAY);
+            Reader_t itemReader(items, count * width);
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t n = itemReader.number(width);
+                if (type == INT_ARRAY) {
+                    hasher.add(hashNumber(INT, static_cast<int64_t>(
+                                (n >> 1) ^ (0 - (n & 1)))));
+                } else {
+                    double value;
+                    memcpy(&value, &n, sizeof(value));
+                    hasher.add(hashDouble(value));
+                }
+            }
+            h = hasher.digest();
+            break;
+        }
+        default:
+            throw StreamError_t("Unknown value type");
+        }
+
+        // pass the hash to the parents and close finished ones
+        for (;;) {
+            Frame_t &frame = stack.back();
+            if (frame.hasher.getType() == STRUCT)
+                frame.hasher.add(frame.name, frame.nameSize, h);
+            else
+                frame.hasher.add(h);
+            last = h;
+            if (--frame.remaining || (stack.size() == 1)) break;
+
+            h = frame.hasher.digest();
+            stack.pop_back();
+        }
+    }
+
+    if (!name) return last;
+    return hashCall(name, nameSize, stack.back().hasher.digest());
+}
+
+} // namespace FRPC
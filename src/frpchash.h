@@ -0,0 +1,114 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Structural hash of FastRPC values.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPC_FRPCHASH_H
+#define FRPC_FRPCHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <frpcplatform.h>
+#include <frpccompare.h>
+
+namespace FRPC {
+
+/**
+ * @short Computes stable structural hash of FastRPC value.
+ *
+ * The hash is consistent with compare(): values that compare equal have the
+ * same hash. Especially String_t and StringView_t (and Binary_t and
+ * BinaryRef_t) with the same content have the same hash. Struct member hashes
+ * are combined independently of member order. The hash does not depend on
+ * the platform nor the process.
+ *
+ * @param value hashed value.
+ * @return 64bit hash.
+ * @throw std::runtime_error for values that cannot be compared (secrets).
+ */
+FRPC_DLLEXPORT uint64_t hash(const Value_t &value);
+
+/**
+ * @short Computes stable hash of the method call.
+ * @param methodName name of called method.
+ * @param params method parameters.
+ * @return 64bit hash.
+ */
+FRPC_DLLEXPORT uint64_t hash(const std::string &methodName,
+                             const Array_t &params);
+
+/**
+ * @short Computes the hash directly from binary FastRPC message without
+ * building the value tree.
+ *
+ * For method response it equals hash() of the returned value and for method
+ * call it equals hash(methodName, params) of the call. The datetime values
+ * are hashed the same way as values built by TreeBuilder_t under the current
+ * LibConfig_t datetime validation policy.
+ *
+ * @param data binary message (starting with magic).
+ * @param size size of data.
+ * @return 64bit hash.
+ * @throw StreamError_t if message is malformed or it is fault.
+ */
+FRPC_DLLEXPORT uint64_t hashBinary(const char *data, std::size_t size);
+
+/**
+ * @short Hash functor usable with unordered containers of values (or
+ * pointers to values).
+ */
+struct ValueHash_t {
+    std::size_t operator()(const Value_t &value) const {
+        return hash(value);
+    }
+
+    std::size_t operator()(const Value_t *value) const {
+        return hash(*value);
+    }
+};
+
+/**
+ * @short Equality functor usable with unordered containers of values (or
+ * pointers to values).
+ */
+struct ValueEqual_t {
+    bool operator()(const Value_t &lhs, const Value_t &rhs) const {
+        return compare(lhs, rhs) == 0;
+    }
+
+    bool operator()(const Value_t *lhs, const Value_t *rhs) const {
+        return compare(*lhs, *rhs) == 0;
+    }
+};
+
+} // namespace FRPC
+
+#endif /* FRPC_FRPCHASH_H */
@@ -109,7 +109,9 @@ HTTPClient_t::HTTPClient_t(HTTPIO_t &httpIO, URL_t &url,
     : httpIO(httpIO), url(url), connector(connector),
       headersSent(false), useChunks(false), supportedProtocols(XML_RPC),
       useProtocol(XML_RPC), contentLenght(0), connectionMustClose(false),
-      unmarshaller(nullptr), useHTTP10(useHTTP10)
+      unmarshaller(nullptr), useHTTP10(useHTTP10), serverProtocolVersion(0, 0),
+      supportedEncodings(ENCODING_IDENTITY), requestEncoding(ENCODING_IDENTITY),
+      compressionThreshold(0)
 {
     queryStorage.emplace_back();
     queryStorage.back().reserve(BUFFER_SIZE + HTTP_BALLAST);
@@ -120,7 +122,9 @@ HTTPClient_t::HTTPClient_t(HTTPIO_t &httpIO, URL_t &url,
     : httpIO(httpIO), url(url), connector(connector),
       headersSent(false), useChunks(useChunks), supportedProtocols(XML_RPC),
       useProtocol(XML_RPC), contentLenght(0), connectionMustClose(false),
-      unmarshaller(nullptr), useHTTP10(useHTTP10)
+      unmarshaller(nullptr), useHTTP10(useHTTP10), serverProtocolVersion(0, 0),
+      supportedEncodings(ENCODING_IDENTITY), requestEncoding(ENCODING_IDENTITY),
+      compressionThreshold(0)
 {
     queryStorage.emplace_back();
     queryStorage.back().reserve(BUFFER_SIZE + HTTP_BALLAST);
@@ -146,7 +150,8 @@ void HTTPClient_t::write(const char* data, unsigned int size) {
 
     if (size > (BUFFER_SIZE - queryStorage.back().size())) {
         if (useChunks) {
-            sendRequest();
+            // empty chunk would end the body
+            if (!queryStorage.back().empty()) sendRequest();
             queryStorage.back().append(data, size);
         } else {
             if (size > BUFFER_SIZE) {
@@ -235,6 +240,43 @@ void HTTPClient_t::readResponse(DataBuilder_t &builder, HTTPHeader_t &httpHead)
             }
         }
 
+        // what binary protocol version is supported by server?
+        std::string serverProtocol;
+        serverProtocolVersion = ProtocolVersion_t(0, 0);
+        if (httpHead.get(HTTP_HEADER_X_FASTRPC_PROTOCOL, serverProtocol) == 0) {
+            std::istringstream is(serverProtocol);
+            unsigned int major = 0, minor = 0;
+            char dot = 0;
+            if ((is >> major >> dot >> minor) && (dot == '.')
+                && (major < 256) && (minor < 256))
+            {
+                serverProtocolVersion = ProtocolVersion_t(
+                        static_cast<unsigned char>(major),
+                        static_cast<unsigned char>(minor));
+            }
+        }
+
+        // what content-codings are supported by server?
+        std::string acceptEncoding;
+        supportedEncodings = ENCODING_IDENTITY;
+        if (httpHead.get(HTTP_HEADER_ACCEPT_ENCODING, acceptEncoding) == 0) {
+            supportedEncodings = parseAcceptEncoding(acceptEncoding);
+        }
+
+        std::unique_ptr<Decompressor_t> decompressor;
+        std::string contentEncoding;
+        if (httpHead.get(HTTP_HEADER_CONTENT_ENCODING, contentEncoding) == 0) {
+            int encoding = parseContentEncoding(contentEncoding);
+            if (encoding < 0) {
+                throw StreamError_t("Unknown ContentEncoding");
+            }
+            if (encoding != ENCODING_IDENTITY) {
+                decompressor.reset(new Decompressor_t(
+                        static_cast<unsigned int>(encoding),
+                        decompressedSizeLimit(httpIO.getBodySizeLimit())));
+            }
+        }
+
         delete unmarshaller;
 
         if (contentType.find(TYPE_XML) != std::string::npos) {
@@ -245,10 +287,12 @@ void HTTPClient_t::readResponse(DataBuilder_t &builder, HTTPHeader_t &httpHead)
             throw StreamError_t("Unknown ContentType");
         }
 
-        DataSink_t data(*unmarshaller);
+        DataSink_t data(*unmarshaller, UnMarshaller_t::TYPE_METHOD_RESPONSE,
+                        decompressor.get());
 
         // read body of response
         httpIO.readContent(httpHead, data, false);
+        if (decompressor) decompressor->finish();
 
         unmarshaller->finish();
         protocolVersion = unmarshaller->getProtocolVersion();
@@ -277,6 +321,24 @@ void HTTPClient_t::readResponse(DataBuilder_t &builder, HTTPHeader_t &httpHead)
 
 
 void HTTPClient_t::sendRequest(bool last) {
+    // compress body when it is big enough or when it is sent in chunks
+    // (then it is bigger than the chunk); small bodies are sent as is
+    if (!headersSent && !compressor && requestEncoding
+        && ((contentLenght >= compressionThreshold) || (useChunks && !last)))
+    {
+        compressor.reset(new Compressor_t(requestEncoding));
+    }
+
+    if (compressor) {
+        std::size_t size = compressor->compress(queryStorage, last || !useChunks);
+        if (!useChunks) {
+            contentLenght = static_cast<unsigned int>(size);
+        } else if (!size && !last) {
+            // compressor buffered the data, empty chunk would end the body
+            return;
+        }
+    }
+
     SocketCloser_t closer(httpIO.socket());
 
     std::string headerData;
@@ -312,6 +374,11 @@ void HTTPClient_t::sendRequest(bool last) {
         }
 
         addHeader(os, HTTP_HEADER_ACCEPT, ACCEPTED);
+        addHeader(os, HTTP_HEADER_ACCEPT_ENCODING, ACCEPT_ENCODINGS);
+        if (compressor) {
+            addHeader(os, HTTP_HEADER_CONTENT_ENCODING,
+                      contentEncodingName(compressor->encoding()));
+        }
 
         //append connection header
         addHeader(os, HTTP_HEADER_CONNECTION, (connector->getKeepAlive() ? KEEPALIVE : CLOSE));
@@ -40,7 +40,9 @@
 #include <frpctypeerror.h>
 #include <frpcunmarshaller.h>
 #include <frpcconnector.h>
+#include <frpccompression.h>
 #include <list>
+#include <memory>
 #include <frpc.h>
 #include <sstream>
 
@@ -58,14 +60,19 @@ class UnMarshaller_t;
 class FRPC_DLLEXPORT DataSink_t {
 public:
     inline DataSink_t(UnMarshaller_t& um,
-                      unsigned int type = UnMarshaller_t::TYPE_METHOD_RESPONSE)
-        : um(um),dataWritten(0), type(type)
+                      unsigned int type = UnMarshaller_t::TYPE_METHOD_RESPONSE,
+                      Decompressor_t *decompressor = nullptr)
+        : um(um),dataWritten(0), type(type), decompressor(decompressor)
     {}
 
     inline ~DataSink_t() {}
 
     inline void write(const char *data, unsigned int size) {
-        um.unMarshall(data, size, static_cast<char>(type));
+        if (decompressor) {
+            decompressor->decompress(data, size, um, static_cast<char>(type));
+        } else {
+            um.unMarshall(data, size, static_cast<char>(type));
+        }
         dataWritten += size;
     }
 
@@ -77,6 +84,7 @@ private:
     UnMarshaller_t &um;
     unsigned int dataWritten;
     unsigned int type;
+    Decompressor_t *decompressor;
 };
 
 
@@ -131,6 +139,39 @@ public:
         return protocolVersion;
     }
 
+    /**
+    * @brief getting the highest protocol version supported by server
+    *        (X-Fastrpc-Protocol header of last response)
+    * @return ProtocolVersion_t, 0.0 when server has not sent it
+    */
+    inline ProtocolVersion_t getServerProtocolVersion() {
+        return serverProtocolVersion;
+    }
+
+    /**
+    * @brief getting content codings accepted by server from last response
+    * @return set of ENCODING_* flags (see frpccompression.h)
+    */
+    inline unsigned int getSupportedEncodings() {
+        return supportedEncodings;
+    }
+
+    /**
+    * @brief enables compression of the request body
+    *
+    * The body is compressed only when the server is known to accept some
+    * supported coding and the body is not smaller than the threshold.
+    *
+    * @param encodings codings accepted by server (ENCODING_* flags)
+    * @param threshold minimal size of body to be compressed
+    */
+    inline void prepareCompression(unsigned int encodings,
+                                   unsigned int threshold)
+    {
+        requestEncoding = chooseContentEncoding(encodings);
+        compressionThreshold = threshold;
+    }
+
     /**
     * @brief says to HTTP client that all data was writed
     *
@@ -197,6 +238,11 @@ private:
     UnMarshaller_t *unmarshaller;
     bool useHTTP10;
     ProtocolVersion_t protocolVersion;
+    ProtocolVersion_t serverProtocolVersion;
+    unsigned int supportedEncodings;
+    unsigned int requestEncoding;
+    unsigned int compressionThreshold;
+    std::unique_ptr<Compressor_t> compressor;
 
     std::ostringstream m_customRequestHeaders;
 };
@@ -57,6 +57,11 @@
 #    define MSG_NOSIGNAL 0
 #endif
 
+// check for MSG_MORE
+#ifndef MSG_MORE
+#    define MSG_MORE 0
+#endif
+
 namespace FRPC {
 namespace {
 const unsigned int HTTP_BUFF_LENGTH = 1u << 16u;
@@ -313,7 +318,8 @@ std::string HTTPIO_t::readLineOpt(bool checkLimit, bool optional)
     }
 }
 
-void HTTPIO_t::sendData(const char *data, size_t length, bool watchForResponse)
+void HTTPIO_t::sendData(const char *data, size_t length, bool watchForResponse,
+                         bool more)
 {
     // zjistíme, kolik máme poslat
     if (!length)
@@ -350,7 +356,10 @@ void HTTPIO_t::sendData(const char *data, size_t length, bool watchForResponse)
 
         auto toWrite = (length > HTTP_BUFF_LENGTH)
                       ? HTTP_BUFF_LENGTH : length;
-        auto bytes = TEMP_FAILURE_RETRY(send(fd, data, toWrite, MSG_NOSIGNAL));
+        // partial packet is held while the rest of data follows
+        int flags = MSG_NOSIGNAL;
+        if (more || (toWrite < length)) flags |= MSG_MORE;
+        auto bytes = TEMP_FAILURE_RETRY(send(fd, data, toWrite, flags));
         switch (bytes)
         {
         case 0:
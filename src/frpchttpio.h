@@ -131,12 +131,13 @@ public:
      *
      * @param data pointer to data
      * @param watchForResponse says that sender receive too
+     * @param more more data follow immediately (MSG_MORE)
      */
     inline void sendData(const std::string &data,
-                         bool watchForResponse = false)
+                         bool watchForResponse = false, bool more = false)
     {
         // send string's content
-        return sendData(data.data(), data.length(), watchForResponse);
+        return sendData(data.data(), data.length(), watchForResponse, more);
     }
 
     /** @short Send data to socket.
@@ -144,9 +145,11 @@ public:
      * @param data pointer to data
      * @param length  data length 
      * @param watchForResponse says that sender receive too
+     * @param more more data follow immediately, kernel holds the partial
+     *             packet until they come (MSG_MORE where available)
      */
     void sendData(const char *data, size_t length,
-                  bool watchForResponse = false);
+                  bool watchForResponse = false, bool more = false);
     /**
     *    @brief return reference to socket
     */
@@ -172,6 +175,13 @@ public:
     {
         writeTimeout = timeout;
     }
+    /**
+     *    @brief limit of body size (-1 = unlimited)
+     */
+    inline int getBodySizeLimit() const
+    {
+        return bodySizeLimit;
+    }
 
 private:
     int fd;
@@ -33,10 +33,13 @@
 #ifndef FRPCINTERNALS_H
 #define FRPCINTERNALS_H
 #include <memory.h>
+#include <charconv>
+#include <cstdio>
 #include <sstream>
 #include <frpcint.h>
 #include <frpcstreamerror.h>
 #include <frpclogging.h>
+#include <frpc.h>
 
 #include <sys/param.h>
 
@@ -56,7 +59,7 @@
 
 
 #define FRPC_MAJOR_VERSION 3
-#define FRPC_MINOR_VERSION 1
+#define FRPC_MINOR_VERSION 3
 
 // We use this to intentionally downgrade the emitted frpc stream
 // so that we can have a comfortable 2 phase transition to new protocol version.
@@ -86,6 +89,8 @@ enum {
     METHOD_CALL     = 13,
     METHOD_RESPONSE = 14,
     FAULT           = 15,
+    INT_ARRAY       = 16,
+    DOUBLE_ARRAY    = 17,
     METHOD_NAME     = 100,
     MEMBER_NAME     = 101
 };
@@ -101,6 +106,49 @@ enum {
     LONG64  = 7
 };
 
+/**
+@brief Since protocol version 3.2 the struct member names are sent only once
+per message
+
+The first occurrence of the name is sent as usual (length and name) and
+the name is appended to the message key dictionary. The following
+occurrences are sent as zero length followed by the index of the name in the
+dictionary. The index is little endian number of size given by
+keyIndexSize() of the current dictionary size.
+*/
+inline bool hasKeyDictionary(const ProtocolVersion_t &protocolVersion) {
+    return (protocolVersion.versionMajor > 3)
+        || ((protocolVersion.versionMajor == 3)
+            && (protocolVersion.versionMinor >= 2));
+}
+
+/** Maximal number of names in the key dictionary, following new names are
+ * always sent inline.
+ */
+const size_t KEY_DICTIONARY_LIMIT = 1u << 16u;
+
+/** Size of the key dictionary index in bytes. */
+inline size_t keyIndexSize(size_t dictionarySize) {
+    return (dictionarySize > 256) ? 2 : 1;
+}
+
+/**
+@brief Since protocol version 3.3 arrays of ints and doubles stored in
+PackedArray_t are sent as one block
+
+INT_ARRAY: type tag with length size of item count in info bits (as for
+ARRAY), item count, one byte item width (1, 2, 4 or 8) and count items of
+zigzag encoded little endian ints of that width.
+
+DOUBLE_ARRAY: type tag with length size of item count in info bits, item
+count and count items of 8 byte little endian doubles.
+*/
+inline bool hasPackedArrays(const ProtocolVersion_t &protocolVersion) {
+    return (protocolVersion.versionMajor > 3)
+        || ((protocolVersion.versionMajor == 3)
+            && (protocolVersion.versionMinor >= 3));
+}
+
 const Int_t::value_type ZERO = 0;
 const Int_t::value_type ALLONES = ~ZERO; // NOLINT
 const Int_t::value_type INT8_MASK =  (int64_t)((uint64_t)ALLONES <<  8u);
@@ -290,6 +338,71 @@ struct DateTimeDataV3_t {
     char data[14];
 };
 
+/** Size of buffer large enough for any number formatted by formatNumber().
+ */
+const size_t NUMBER_BUFFER_SIZE = 32;
+
+/**
+@brief Formats the integer into the buffer without allocation
+@param buffer buffer of NUMBER_BUFFER_SIZE bytes
+@param value formatted value
+@return length of the text (not terminated by zero)
+*/
+inline unsigned int formatNumber(char *buffer, Int_t::value_type value) {
+    std::to_chars_result res
+        = std::to_chars(buffer, buffer + NUMBER_BUFFER_SIZE, value);
+    return static_cast<unsigned int>(res.ptr - buffer);
+}
+
+/**
+@brief Formats the double into the buffer without allocation using the
+shortest text that parses back to the same value
+@param buffer buffer of NUMBER_BUFFER_SIZE bytes
+@param value formatted value
+@return length of the text (not terminated by zero)
+
+Like %.17g the exponent notation is used only for decimal exponents below -4
+or above 16, other values are written in plain notation since XML-RPC double
+does not allow exponent.
+*/
+inline unsigned int formatNumber(char *buffer, double value) {
+#if defined(__cpp_lib_to_chars)
+    char *end = buffer + NUMBER_BUFFER_SIZE;
+    std::to_chars_result res
+        = std::to_chars(buffer, end, value, std::chars_format::scientific);
+
+    // read decimal exponent after 'e' (nan and inf have none)
+    const char *e = buffer;
+    while ((e != res.ptr) && (*e != 'e')) ++e;
+    if (e != res.ptr) {
+        bool negative = (*++e == '-');
+        int exponent = 0;
+        while (++e != res.ptr) exponent = exponent * 10 + (*e - '0');
+        if (negative) exponent = -exponent;
+        if ((exponent >= -4) && (exponent < 17))
+            res = std::to_chars(buffer, end, value, std::chars_format::fixed);
+    }
+    return static_cast<unsigned int>(res.ptr - buffer);
+#else
+    // no floating point to_chars in this standard library
+    return static_cast<unsigned int>(
+            snprintf(buffer, NUMBER_BUFFER_SIZE, "%.17g", value));
+#endif
+}
+
+/** Size of buffer large enough for formatISODateTime(). */
+const size_t ISO_DATETIME_BUFFER_SIZE = 50;
+
+/**
+@brief Formats the datetime in ISO 8601 format (as getISODateTime()) into
+the buffer without allocation
+@param buffer buffer of ISO_DATETIME_BUFFER_SIZE bytes
+@return length of the text (not terminated by zero)
+*/
+unsigned int formatISODateTime(char *buffer, short year, char month,
+                               char day, char hour, char minute, char sec,
+                               int timeZone);
+
 const unsigned int HTTP_BALLAST = 1 << 10;
 const unsigned int  BUFFER_SIZE = (1 << 16) - HTTP_BALLAST;
 const size_t MAX_LEN = 20;
@@ -36,9 +36,9 @@
  *                  First draft.
  */
 
-#include <limits>
-#include <sstream>
-#include <iomanip>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "frpc.h"
 #include "frpcwriter.h"
@@ -55,11 +55,6 @@
 namespace FRPC {
 namespace {
 
-void write(Writer_t &writer, const std::string &value) {
-    if (!value.empty())
-        writer.write(value.data(), static_cast<uint32_t>(value.size()));
-}
-
 template <typename Context_t>
 bool dec(Context_t &ctx, Writer_t &writer) {
     if (ctx.empty()) return true;
@@ -79,42 +74,97 @@ bool dec(Context_t &ctx, Writer_t &writer) {
     return ctx.empty();
 }
 
-std::string escape(unsigned int ch) {
-    std::ostringstream os;
-    os << "\\u"
-       << std::hex
-       << std::setfill('0')
-       << std::setw(4)
-       << ch;
-    return os.str();
+/** Escape sequence of one byte.
+ */
+struct Escape_t {
+    char data[6] = {};
+    uint8_t size = 0; //!< zero for bytes written as they are
+};
+
+/** Escape sequences of all bytes; control characters, quote and backslash
+ * have to be escaped in JSON strings.
+ */
+class EscapeTable_t {
+public:
+    constexpr EscapeTable_t(): table() {
+        for (unsigned int ch = 0; ch < 0x20; ++ch) unicode(ch);
+        unicode(0x7f);
+        simple('"', '"');
+        simple('\\', '\\');
+        simple('\r', 'r');
+        simple('\n', 'n');
+        simple('\t', 't');
+    }
+
+    constexpr const Escape_t &operator[](unsigned char ch) const {
+        return table[ch];
+    }
+
+private:
+    constexpr void simple(unsigned char ch, char escaped) {
+        table[ch].data[0] = '\\';
+        table[ch].data[1] = escaped;
+        table[ch].size = 2;
+    }
+
+    constexpr void unicode(unsigned int ch) {
+        const char hex[] = "0123456789abcdef";
+        Escape_t &escape = table[ch];
+        escape.data[0] = '\\';
+        escape.data[1] = 'u';
+        escape.data[2] = '0';
+        escape.data[3] = '0';
+        escape.data[4] = hex[(ch >> 4) & 0xf];
+        escape.data[5] = hex[ch & 0xf];
+        escape.size = 6;
+    }
+
+    Escape_t table[256];
+};
+
+constexpr EscapeTable_t ESCAPES;
+
+/** Returns position of the first byte that has to be escaped or end. The
+ * string is scanned by 16 bytes long blocks where SSE2 is available.
+ */
+const char *findEscape(const char *pos, const char *end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; end - pos >= 16; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        // unsigned byte <= 0x1f iff min(byte, 0x1f) == byte
+        __m128i mask = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                         _mm_cmpeq_epi8(block, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, del),
+                         _mm_cmpeq_epi8(_mm_min_epu8(block, control), block)));
+        if (int bits = _mm_movemask_epi8(mask))
+            return pos + __builtin_ctz(static_cast<unsigned int>(bits));
+    }
+#endif
+    for (; pos != end; ++pos) {
+        if (ESCAPES[static_cast<unsigned char>(*pos)].size) break;
+    }
+    return pos;
 }
 
-void quote(Writer_t &writer, const char *ipos, unsigned int size) {
+/** Writes quoted string, runs of bytes that need no escaping are written by
+ * single write.
+ */
+void quote(Writer_t &writer, const char *pos, unsigned int size) {
     writer.write("\"", 1);
-    for (const char *epos = ipos + size; ipos != epos; ++ipos) {
-        switch (*ipos) {
-        case '"':
-            writer.write("\\\"", 2);
-            break;
-        case '\\':
-            writer.write("\\\\", 2);
-            break;
-        case '\r':
-            writer.write("\\r", 2);
-            break;
-        case '\n':
-            writer.write("\\n", 2);
-            break;
-        case '\t':
-            writer.write("\\t", 2);
-            break;
-        default:
-            if (::iscntrl(*ipos)) {
-                writer.write(escape(*ipos).c_str(), 6);
-            } else {
-                writer.write(ipos, 1);
-            }
-        }
+    for (const char *end = pos + size; pos != end; ) {
+        const char *escape = findEscape(pos, end);
+        if (escape != pos)
+            writer.write(pos, static_cast<unsigned int>(escape - pos));
+        if (escape == end) break;
+
+        const Escape_t &sequence = ESCAPES[static_cast<unsigned char>(*escape)];
+        writer.write(sequence.data, sequence.size);
+        pos = escape + 1;
     }
     writer.write("\"", 1);
 }
@@ -143,10 +193,10 @@ void JSONMarshaller_t::packMethodResponse() {}
 void JSONMarshaller_t::packFault(int errNumber, const char *errMsg,
                                  unsigned int size)
 {
-    std::ostringstream os;
-    os << "{ \"failure\": " << errNumber
-       << ", \"failureMessage\": ";
-    write(writer, os.str());
+    char buffer[NUMBER_BUFFER_SIZE];
+    writer.write("{ \"failure\": ", 13);
+    writer.write(buffer, formatNumber(buffer, Int_t::value_type(errNumber)));
+    writer.write(", \"failureMessage\": ", 20);
     quote(writer, errMsg, size);
     writer.write(" }", 2);
 }
@@ -193,23 +243,22 @@ void JSONMarshaller_t::packBinary(const char *value, unsigned int size) {
 
 void JSONMarshaller_t::packBool(bool value) {
     DBG("bool: %d\n", value);
-    write(writer, value? "true": "false");
+    if (value) writer.write("true", 4);
+    else writer.write("false", 5);
     dec(ctx, writer);
 }
 
 void JSONMarshaller_t::packDouble(double value) {
     DBG("double: %f\n", value);
-    std::ostringstream os;
-    os << std::setprecision(std::numeric_limits<double>::digits10 + 2) << value;
-    write(writer, os.str());
+    char buffer[NUMBER_BUFFER_SIZE];
+    writer.write(buffer, formatNumber(buffer, value));
     dec(ctx, writer);
 }
 
 void JSONMarshaller_t::packInt(Int_t::value_type value) {
     DBG("int: %li\n", value);
-    std::ostringstream os;
-    os << value;
-    write(writer, os.str());
+    char buffer[NUMBER_BUFFER_SIZE];
+    writer.write(buffer, formatNumber(buffer, value));
     dec(ctx, writer);
 }
 
@@ -223,9 +272,9 @@ void JSONMarshaller_t::packDateTime(short, char, char, char, char, char, char,
                                     time_t unixTime, int)
 {
     DBG("datetime: %lu\n", unixTime);
-    std::ostringstream os;
-    os << unixTime;
-    write(writer, os.str());
+    char buffer[NUMBER_BUFFER_SIZE];
+    Int_t::value_type time = unixTime;
+    writer.write(buffer, formatNumber(buffer, time));
     dec(ctx, writer);
 }
 
@@ -0,0 +1,495 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   JSON unmarshaller of method calls.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "frpcstreamerror.h"
+#include "frpctreebuilder.h"
+#include "frpcjsonunmarshaller.h"
+
+namespace FRPC {
+namespace {
+
+bool isSpace(char ch) {
+    return (ch == ' ') || (ch == '\n') || (ch == '\r') || (ch == '\t');
+}
+
+bool isDigit(char ch) {
+    return (ch >= '0') && (ch <= '9');
+}
+
+bool isNumberChar(char ch) {
+    return isDigit(ch) || (ch == '-') || (ch == '+') || (ch == '.')
+        || (ch == 'e') || (ch == 'E');
+}
+
+/** Returns position of the first quote, backslash or control character in
+ * the string or end.
+ */
+const char *findSpecial(const char *pos, const char *end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; end - pos >= 16; pos += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        // unsigned byte <= 0x1f iff min(byte, 0x1f) == byte
+        __m128i mask = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                         _mm_cmpeq_epi8(block, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(block, control), block));
+        if (int bits = _mm_movemask_epi8(mask))
+            return pos + __builtin_ctz(static_cast<unsigned int>(bits));
+    }
+#endif
+    for (; pos != end; ++pos) {
+        unsigned char ch = static_cast<unsigned char>(*pos);
+        if ((ch == '"') || (ch == '\\') || (ch < 0x20)) break;
+    }
+    return pos;
+}
+
+/** Returns value of four hex digits or -1.
+ */
+long hex4(const char *pos) {
+    long value = 0;
+    for (const char *end = pos + 4; pos != end; ++pos) {
+        value <<= 4;
+        if (isDigit(*pos)) value |= *pos - '0';
+        else if ((*pos >= 'a') && (*pos <= 'f')) value |= *pos - 'a' + 10;
+        else if ((*pos >= 'A') && (*pos <= 'F')) value |= *pos - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+void appendUtf8(std::string &str, unsigned long ch) {
+    if (ch < 0x80) {
+        str += static_cast<char>(ch);
+    } else if (ch < 0x800) {
+        str += static_cast<char>(0xc0 | (ch >> 6));
+        str += static_cast<char>(0x80 | (ch & 0x3f));
+    } else if (ch < 0x10000) {
+        str += static_cast<char>(0xe0 | (ch >> 12));
+        str += static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+        str += static_cast<char>(0x80 | (ch & 0x3f));
+    } else {
+        str += static_cast<char>(0xf0 | (ch >> 18));
+        str += static_cast<char>(0x80 | ((ch >> 12) & 0x3f));
+        str += static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+        str += static_cast<char>(0x80 | (ch & 0x3f));
+    }
+}
+
+void buildNull(DataBuilder_t &builder) {
+    // only some builders know null
+    if (auto *tbuilder = dynamic_cast<ExtTreeBuilder_t*>(&builder)) {
+        tbuilder->buildNull();
+    } else if (auto *tbuilder = dynamic_cast<TreeBuilder_t*>(&builder)) {
+        tbuilder->buildNull();
+    } else if (auto *tbuilder = dynamic_cast<DataBuilderWithNull_t*>(&builder)) {
+        tbuilder->buildNull();
+    } else {
+        throw StreamError_t("Unknown builder type for null value");
+    }
+}
+
+} // namespace
+
+JSONUnMarshaller_t::JSONUnMarshaller_t(DataBuilder_t &dataBuilder,
+                                       const std::string &path)
+    : dataBuilder(dataBuilder), method(path.empty()? "RPC2": path.data() + 1),
+      called(false), expect(BODY), containers(), pending(), decoded(),
+      base(nullptr), offset(0)
+{
+    std::replace(method.begin(), method.end(), '/', '.');
+}
+
+void JSONUnMarshaller_t::unMarshall(const char *data,
+                                    unsigned int size,
+                                    char type)
+{
+    if (type != TYPE_METHOD_CALL)
+        throw StreamError_t("Unsupported stream type");
+
+    if (!called) {
+        dataBuilder.buildMethodCall(method);
+        called = true;
+    }
+
+    const char *pos = data;
+    const char *end = data + size;
+
+    // complete the token split between chunks, let it grow geometrically
+    while (!pending.empty() && (pos != end)) {
+        std::size_t old = pending.size();
+        std::size_t take = std::min(static_cast<std::size_t>(end - pos),
+                                    std::max(old, std::size_t(64)));
+        pending.append(pos, take);
+        std::size_t used = parse(pending.data(),
+                                 pending.data() + pending.size(), false);
+        if (used >= old) {
+            pos += used - old;
+            pending.clear();
+        } else {
+            pos += take;
+            pending.erase(0, used);
+        }
+    }
+
+    if (pending.empty() && (pos != end)) {
+        std::size_t used = parse(pos, end, false);
+        pending.assign(pos + used, end);
+    }
+}
+
+void JSONUnMarshaller_t::finish() {
+    if (!called) {
+        dataBuilder.buildMethodCall(method);
+        called = true;
+    }
+
+    if (!pending.empty()) {
+        parse(pending.data(), pending.data() + pending.size(), true);
+        pending.clear();
+    }
+
+    if ((expect != END) && (expect != BODY)) {
+        base = nullptr;
+        error("Unexpected end of data", base);
+    }
+}
+
+std::size_t JSONUnMarshaller_t::parse(const char *begin, const char *end,
+                                      bool last)
+{
+    base = begin;
+    const char *pos = begin;
+    for (;;) {
+        while ((pos != end) && isSpace(*pos)) ++pos;
+        if (pos == end) break;
+
+        const char *next = pos + 1;
+        switch (expect) {
+        case BODY:
+            if (*pos == '[') {
+                containers.push_back(PARAMS);
+                expect = FIRST_VALUE;
+            } else {
+                expect = VALUE;
+                next = pos;
+            }
+            break;
+
+        case FIRST_VALUE:
+            if (*pos == ']') {
+                close();
+                break;
+            }
+            // FALL THROUGH
+        case VALUE:
+            next = value(pos, end, last);
+            break;
+
+        case FIRST_MEMBER:
+            if (*pos == '}') {
+                close();
+                break;
+            }
+            // FALL THROUGH
+        case MEMBER:
+            if (*pos != '"')
+                error("Member name expected", pos);
+            next = string(pos, end, last, true);
+            break;
+
+        case COLON:
+            if (*pos != ':')
+                error("Colon expected", pos);
+            expect = VALUE;
+            break;
+
+        case SEPARATOR:
+            if (*pos == ',') {
+                expect = (containers.back() == STRUCT)? MEMBER: VALUE;
+            } else if (*pos == ((containers.back() == STRUCT)? '}': ']')) {
+                close();
+            } else {
+                error("Comma or end of container expected", pos);
+            }
+            break;
+
+        case END:
+            error("Unexpected data after the end", pos);
+        }
+
+        // incomplete token, wait for more data
+        if (!next) break;
+        pos = next;
+    }
+
+    std::size_t used = pos - begin;
+    offset += used;
+    return used;
+}
+
+const char *JSONUnMarshaller_t::value(const char *pos, const char *end,
+                                      bool last)
+{
+    const char *next;
+    switch (*pos) {
+    case '{':
+        dataBuilder.openStruct(0);
+        containers.push_back(STRUCT);
+        expect = FIRST_MEMBER;
+        return pos + 1;
+
+    case '[':
+        dataBuilder.openArray(0);
+        containers.push_back(ARRAY);
+        expect = FIRST_VALUE;
+        return pos + 1;
+
+    case '"':
+        return string(pos, end, last, false);
+
+    case 't':
+        if (!(next = literal(pos, end, last, "true", 4))) return nullptr;
+        dataBuilder.buildBool(true);
+        break;
+
+    case 'f':
+        if (!(next = literal(pos, end, last, "false", 5))) return nullptr;
+        dataBuilder.buildBool(false);
+        break;
+
+    case 'n':
+        if (!(next = literal(pos, end, last, "null", 4))) return nullptr;
+        buildNull(dataBuilder);
+        break;
+
+    case '-':
+    case '0' ... '9':
+        return number(pos, end, last);
+
+    default:
+        error("Unexpected character", pos);
+    }
+
+    valueDone();
+    return next;
+}
+
+const char *JSONUnMarshaller_t::string(const char *pos, const char *end,
+                                       bool last, bool member)
+{
+    const char *start = pos + 1;
+    const char *special = findSpecial(start, end);
+    const char *data = start;
+    std::size_t size = special - start;
+
+    if ((special != end) && (*special == '\\')) {
+        // the string has to be decoded
+        decoded.assign(start, special);
+        while ((special != end) && (*special == '\\')) {
+            const char *next = unescape(special, end, last);
+            if (!next) return nullptr;
+            special = findSpecial(next, end);
+            decoded.append(next, special);
+        }
+        data = decoded.data();
+        size = decoded.size();
+    }
+
+    if (special == end) {
+        if (last) error("Unterminated string", pos);
+        return nullptr;
+    }
+
+    if (*special != '"')
+        error("Control character in string", special);
+
+    if (member) {
+        dataBuilder.buildStructMember(data, static_cast<unsigned int>(size));
+        expect = COLON;
+    } else {
+        dataBuilder.buildString(data, static_cast<unsigned int>(size));
+        valueDone();
+    }
+    return special + 1;
+}
+
+const char *JSONUnMarshaller_t::unescape(const char *pos, const char *end,
+                                         bool last)
+{
+    // incomplete sequence at the end of data is checked on the next call
+    auto incomplete = [&] () -> const char * {
+        if (last) error("Unterminated string", pos);
+        return nullptr;
+    };
+
+    if (end - pos < 2) return incomplete();
+    switch (pos[1]) {
+    case '"': decoded += '"'; break;
+    case '\\': decoded += '\\'; break;
+    case '/': decoded += '/'; break;
+    case 'b': decoded += '\b'; break;
+    case 'f': decoded += '\f'; break;
+    case 'n': decoded += '\n'; break;
+    case 'r': decoded += '\r'; break;
+    case 't': decoded += '\t'; break;
+    case 'u': {
+        if (end - pos < 6) return incomplete();
+        long ch = hex4(pos + 2);
+        if (ch < 0)
+            error("Invalid unicode escape", pos);
+        if ((ch >= 0xdc00) && (ch <= 0xdfff))
+            error("Invalid unicode escape", pos);
+        if ((ch < 0xd800) || (ch > 0xdbff)) {
+            appendUtf8(decoded, ch);
+            return pos + 6;
+        }
+
+        // surrogate pair
+        if (end - pos < 12) return incomplete();
+        long low = ((pos[6] == '\\') && (pos[7] == 'u'))? hex4(pos + 8): -1;
+        if ((low < 0xdc00) || (low > 0xdfff))
+            error("Invalid unicode escape", pos);
+        appendUtf8(decoded, 0x10000 + ((ch - 0xd800) << 10) + (low - 0xdc00));
+        return pos + 12;
+    }
+    default:
+        error("Invalid escape sequence", pos);
+    }
+    return pos + 2;
+}
+
+const char *JSONUnMarshaller_t::number(const char *pos, const char *end,
+                                       bool last)
+{
+    const char *stop = pos;
+    while ((stop != end) && isNumberChar(*stop)) ++stop;
+    if ((stop == end) && !last) return nullptr;
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const char *p = pos;
+    bool integral = true;
+    if (*p == '-') ++p;
+    if ((p != stop) && (*p == '0')) {
+        ++p;
+    } else {
+        if ((p == stop) || !isDigit(*p)) error("Invalid number", pos);
+        while ((p != stop) && isDigit(*p)) ++p;
+    }
+    if ((p != stop) && (*p == '.')) {
+        integral = false;
+        if ((++p == stop) || !isDigit(*p)) error("Invalid number", pos);
+        while ((p != stop) && isDigit(*p)) ++p;
+    }
+    if ((p != stop) && ((*p == 'e') || (*p == 'E'))) {
+        integral = false;
+        if ((++p != stop) && ((*p == '+') || (*p == '-'))) ++p;
+        if ((p == stop) || !isDigit(*p)) error("Invalid number", pos);
+        while ((p != stop) && isDigit(*p)) ++p;
+    }
+    if (p != stop) error("Invalid number", pos);
+
+    if (integral) {
+        Int_t::value_type value;
+        if (std::from_chars(pos, stop, value).ec != std::errc())
+            error("Unsupported size of int (too small/big)", pos);
+        dataBuilder.buildInt(value);
+    } else {
+        double value;
+#if defined(__cpp_lib_to_chars)
+        if (std::from_chars(pos, stop, value).ec != std::errc())
+            error("Unsupported size of double (too small/big)", pos);
+#else
+        // no floating point from_chars in this standard library
+        std::string str(pos, stop);
+        errno = 0;
+        value = std::strtod(str.c_str(), nullptr);
+        if (errno == ERANGE)
+            error("Unsupported size of double (too small/big)", pos);
+#endif
+        dataBuilder.buildDouble(value);
+    }
+
+    valueDone();
+    return stop;
+}
+
+const char *JSONUnMarshaller_t::literal(const char *pos, const char *end,
+                                        bool last, const char *name,
+                                        std::size_t size)
+{
+    std::size_t available = std::min(size, static_cast<std::size_t>(end - pos));
+    if (!std::equal(pos, pos + available, name))
+        error("Unexpected character", pos);
+    if (available < size) {
+        if (last) error("Unexpected end of data", pos);
+        return nullptr;
+    }
+    return pos + size;
+}
+
+void JSONUnMarshaller_t::close() {
+    switch (containers.back()) {
+    case ARRAY:
+        dataBuilder.closeArray();
+        break;
+    case STRUCT:
+        dataBuilder.closeStruct();
+        break;
+    case PARAMS:
+        break;
+    }
+    containers.pop_back();
+    valueDone();
+}
+
+void JSONUnMarshaller_t::valueDone() {
+    expect = containers.empty()? END: SEPARATOR;
+}
+
+void JSONUnMarshaller_t::error(const char *what, const char *pos) const {
+    throw StreamError_t::format("JSON parse error: %s at offset %zu",
+                                what, offset + (pos - base));
+}
+
+} // namespace FRPC
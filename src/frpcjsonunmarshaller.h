@@ -0,0 +1,122 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   JSON unmarshaller of method calls.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPC_FRPCJSONUNMARSHALLER_H
+#define FRPC_FRPCJSONUNMARSHALLER_H
+
+#include <frpcunmarshaller.h>
+#include <frpcdatabuilder.h>
+#include <frpc.h>
+#include <vector>
+#include <string>
+
+namespace FRPC {
+
+/**
+ * @short Unmarshaller of method calls sent as JSON (application/json).
+ *
+ * The called method is taken from the uri path as for url encoded calls
+ * ("/math/add" calls "math.add"). When the body is JSON array its items are
+ * the method parameters, any other JSON value is the only parameter. Empty
+ * body means no parameters.
+ *
+ * Types map to the FastRPC ones: integral numbers are ints, numbers with
+ * fraction or exponent are doubles; strings, booleans, null, arrays and
+ * objects (structs) are what they are. JSON has no binary or datetime
+ * values, they are sent as strings or ints by JSONMarshaller_t.
+ *
+ * Data are parsed as they come and the values are passed to the builder
+ * directly; only a token split between two chunks is copied.
+ */
+class JSONUnMarshaller_t : public UnMarshaller_t {
+public:
+    /**
+     * @short C'tor.
+     * @param dataBuilder builder of the unmarshalled data.
+     * @param path uri path, the called method.
+     */
+    JSONUnMarshaller_t(DataBuilder_t &dataBuilder,
+                       const std::string &path = std::string("RPC2"));
+
+    /** Unmarshalls serialized data.
+     * @param data buffer with marshalled data.
+     * @param size size of buffer.
+     * @param type type of data to unmarshall, only method call is supported.
+     */
+    void unMarshall(const char *data, unsigned int size, char type) override;
+
+    /**
+     * @short Checks that the whole call has been read.
+     */
+    void finish() override;
+
+private:
+    /// what is expected as the next token
+    enum Expect_t : char {
+        BODY,         //!< parameters or the only parameter
+        VALUE,
+        FIRST_VALUE,  //!< value or end of empty array
+        MEMBER,
+        FIRST_MEMBER, //!< member or end of empty object
+        COLON,
+        SEPARATOR,    //!< comma or end of array/object
+        END
+    };
+
+    /// open containers
+    enum Container_t : char { PARAMS, ARRAY, STRUCT };
+
+    std::size_t parse(const char *begin, const char *end, bool last);
+    const char *value(const char *pos, const char *end, bool last);
+    const char *string(const char *pos, const char *end, bool last,
+                       bool member);
+    const char *number(const char *pos, const char *end, bool last);
+    const char *literal(const char *pos, const char *end, bool last,
+                        const char *name, std::size_t size);
+    const char *unescape(const char *pos, const char *end, bool last);
+    void close();
+    void valueDone();
+    [[noreturn]] void error(const char *what, const char *pos) const;
+
+    DataBuilder_t &dataBuilder; //!< data builder
+    std::string method;         //!< called method
+    bool called;                //!< method call has been built
+    Expect_t expect;
+    std::vector<Container_t> containers;
+    std::string pending;        //!< incomplete token from previous chunk
+    std::string decoded;        //!< string with escape sequences
+    const char *base;           //!< start of data being parsed
+    std::size_t offset;         //!< offset of base in the stream
+};
+
+} // namespace FRPC
+
+#endif /* FRPC_FRPCJSONUNMARSHALLER_H */
@@ -0,0 +1,368 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   TCP and unix-domain listening sockets for Server_t.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+
+#include "nonglibc.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/un.h>
+#include <fcntl.h>
+#endif // !WIN32
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#include "frpclistener.h"
+#include "frpchttp.h"
+#include "frpchttperror.h"
+#include "frpcsocket.h"
+
+namespace FRPC {
+
+namespace {
+
+const std::string UNIX_LISTENER_SCHEMA("unix://");
+
+bool hasPrefix(const std::string &s, const std::string &prefix) {
+    return (s.size() >= prefix.size())
+        && std::equal(prefix.begin(), prefix.end(), s.begin(),
+                      [] (char l, char r) {
+                          return ::tolower(l) == ::tolower(r);
+                      });
+}
+
+void closeSocket(int fd) {
+    TEMP_FAILURE_RETRY(::close(fd));
+}
+
+void setOption(int fd, int level, int name, int value, const char *what) {
+    if (::setsockopt(fd, level, name, (char*) &value, sizeof(value)) < 0) {
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot set %s on listening socket: <%d, %s>.",
+                what, ERRNO, STRERROR(ERRNO));
+    }
+}
+
+void setBuffers(int fd, const Listener_t::Config_t &config) {
+    if (config.receiveBuffer > 0) {
+        setOption(fd, SOL_SOCKET, SO_RCVBUF, config.receiveBuffer,
+                  "SO_RCVBUF");
+    }
+    if (config.sendBuffer > 0) {
+        setOption(fd, SOL_SOCKET, SO_SNDBUF, config.sendBuffer, "SO_SNDBUF");
+    }
+}
+
+void listenSocket(int fd, const Listener_t::Config_t &config,
+                  const std::string &url)
+{
+    if (::listen(fd, config.backlog) < 0) {
+        STRERROR_PRE();
+        int error = ERRNO;
+        closeSocket(fd);
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot listen on %s: <%d, %s>.",
+                url.c_str(), error, STRERROR(error));
+    }
+}
+
+#ifndef WIN32
+/** Removes socket file left behind by a process which is gone; throws when
+ * the socket still accepts connections (or cannot be probed).
+ */
+void removeStaleSocket(const struct sockaddr_un &local,
+                       const std::string &url)
+{
+    struct stat st;
+    if (::stat(local.sun_path, &st) || !S_ISSOCK(st.st_mode)) return;
+
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot create socket: <%d, %s>.",
+                ERRNO, STRERROR(ERRNO));
+    }
+
+    // non-blocking so that a full backlog does not stall us
+    int error = EADDRINUSE;
+    if ((::fcntl(probe, F_SETFL, O_NONBLOCK) == 0)
+        && (::connect(probe,
+                      reinterpret_cast<const struct sockaddr*>(&local),
+                      sizeof(local)) < 0))
+    {
+        error = ERRNO;
+    }
+    closeSocket(probe);
+
+    // nobody listens there any more
+    if (error == ECONNREFUSED) {
+        ::unlink(local.sun_path);
+        return;
+    }
+
+    STRERROR_PRE();
+    throw HTTPError_t::format(
+            HTTP_SYSCALL, "Cannot bind to %s: <%d, %s>.",
+            url.c_str(), EADDRINUSE, STRERROR(EADDRINUSE));
+}
+#endif // !WIN32
+
+} // namespace
+
+Listener_t::Listener_t(const std::string &url, const Config_t &config)
+    : config(config), fd(-1), isUnix(hasPrefix(url, UNIX_LISTENER_SCHEMA))
+{
+    if (isUnix) {
+#ifndef WIN32
+        URL_t parsed(url);
+        unixPath = parsed.path;
+
+        struct sockaddr_un local;
+        if (unixPath.size() >= sizeof(local.sun_path)) {
+            throw HTTPError_t::format(
+                    HTTP_SYSCALL, "Unix socket path '%s' is too long.",
+                    unixPath.c_str());
+        }
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        memcpy(local.sun_path, unixPath.data(), unixPath.size());
+
+        // replace socket left behind by previous process
+        removeStaleSocket(local, url);
+
+        if ((fd = ::socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+            STRERROR_PRE();
+            throw HTTPError_t::format(
+                    HTTP_SYSCALL, "Cannot create socket: <%d, %s>.",
+                    ERRNO, STRERROR(ERRNO));
+        }
+
+        try {
+            setBuffers(fd, config);
+        } catch (...) {
+            closeSocket(fd);
+            throw;
+        }
+
+        if (::bind(fd, reinterpret_cast<struct sockaddr*>(&local),
+                   sizeof(local)) < 0)
+        {
+            STRERROR_PRE();
+            int error = ERRNO;
+            closeSocket(fd);
+            throw HTTPError_t::format(
+                    HTTP_SYSCALL, "Cannot bind to %s: <%d, %s>.",
+                    url.c_str(), error, STRERROR(error));
+        }
+
+        try {
+            listenSocket(fd, config, url);
+        } catch (...) {
+            ::unlink(unixPath.c_str());
+            throw;
+        }
+        return;
+#else // !WIN32
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Unix sockets are not supported: %s.",
+                url.c_str());
+#endif // !WIN32
+    }
+
+    URL_t parsed(url);
+    std::string host = parsed.host;
+    int family = AF_UNSPEC;
+    if (!host.empty() && *host.begin() == '[' && *host.rbegin() == ']') {
+        host = host.substr(1, host.size() - 2);
+        family = AF_INET6;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    char service[8] = {0};
+    snprintf(service, sizeof(service), "%u", parsed.port);
+
+    struct addrinfo *addrInfo = nullptr;
+    bool anyHost = host.empty() || (host == "*");
+    int errcode = getaddrinfo(anyHost ? nullptr : host.c_str(), service,
+                              &hints, &addrInfo);
+    if (errcode != 0) {
+        throw HTTPError_t::format(
+                HTTP_DNS, "Cannot resolve host '%s': <%d, %s>.",
+                host.c_str(), errcode, gai_strerror(errcode));
+    }
+
+    // bind to the first address that works
+    int error = 0;
+    for (struct addrinfo *ai = addrInfo; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            error = ERRNO;
+            continue;
+        }
+
+        try {
+            setOption(fd, SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR");
+#ifdef SO_REUSEPORT
+            if (config.reusePort) {
+                setOption(fd, SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT");
+            }
+#endif // SO_REUSEPORT
+            setBuffers(fd, config);
+#ifdef TCP_DEFER_ACCEPT
+            if (config.deferAccept) {
+                setOption(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                          int(config.deferAccept), "TCP_DEFER_ACCEPT");
+            }
+#endif // TCP_DEFER_ACCEPT
+            // accepted sockets inherit it on most systems
+            if (config.noDelay) {
+                setOption(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+            }
+        } catch (...) {
+            freeaddrinfo(addrInfo);
+            closeSocket(fd);
+            throw;
+        }
+
+        if (!::bind(fd, ai->ai_addr, ai->ai_addrlen)) break;
+
+        error = ERRNO;
+        closeSocket(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrInfo);
+
+    if (fd < 0) {
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot bind to %s: <%d, %s>.",
+                url.c_str(), error, STRERROR(error));
+    }
+
+    listenSocket(fd, config, url);
+}
+
+Listener_t::~Listener_t() {
+    closeSocket(fd);
+    if (!unixPath.empty()) ::unlink(unixPath.c_str());
+}
+
+int Listener_t::accept(std::string *clientAddress) {
+    struct sockaddr_storage address;
+    socklen_t length;
+    int client;
+    for (;;) {
+        length = sizeof(address);
+        auto accepted = TEMP_FAILURE_RETRY(
+                ::accept(fd, reinterpret_cast<struct sockaddr*>(&address),
+                         &length));
+        if (accepted >= 0) {
+            client = static_cast<int>(accepted);
+            break;
+        }
+        // connection reset before we accepted it => wait for another one
+        if (ERRNO == ECONNABORTED) continue;
+
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot accept connection: <%d, %s>.",
+                ERRNO, STRERROR(ERRNO));
+    }
+
+    if (isUnix) {
+        if (clientAddress) clientAddress->clear();
+        return client;
+    }
+
+    try {
+        configureSocket(client, config);
+    } catch (...) {
+        closeSocket(client);
+        throw;
+    }
+
+    if (clientAddress) {
+        char buffer[INET6_ADDRSTRLEN] = {0};
+        const void *ip = (address.ss_family == AF_INET6)
+            ? static_cast<const void*>(
+                    &reinterpret_cast<sockaddr_in6*>(&address)->sin6_addr)
+            : static_cast<const void*>(
+                    &reinterpret_cast<sockaddr_in*>(&address)->sin_addr);
+        const char *s = inet_ntop(address.ss_family, ip, buffer,
+                                  sizeof(buffer));
+        *clientAddress = s ? s : "";
+    }
+    return client;
+}
+
+void Listener_t::configureSocket(int fd, const Config_t &config) {
+    if (!config.noDelay) return;
+
+    int just_say_no = 1;
+    if (::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY,
+                     (char*) &just_say_no, sizeof(int)) < 0)
+    {
+        // not a TCP socket => nothing to tune
+        if ((ERRNO == EOPNOTSUPP) || (ERRNO == ENOPROTOOPT)) return;
+
+        STRERROR_PRE();
+        throw HTTPError_t::format(
+                HTTP_SYSCALL, "Cannot set socket non-delaying: <%d, %s>.",
+                ERRNO, STRERROR(ERRNO));
+    }
+}
+
+unsigned short Listener_t::port() const {
+    struct sockaddr_storage address;
+    socklen_t length = sizeof(address);
+    if (isUnix || ::getsockname(fd, reinterpret_cast<struct sockaddr*>(
+                                        &address), &length) < 0)
+    {
+        return 0;
+    }
+    return ntohs((address.ss_family == AF_INET6)
+                 ? reinterpret_cast<sockaddr_in6*>(&address)->sin6_port
+                 : reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+}
+
+} // namespace FRPC
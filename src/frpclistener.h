@@ -0,0 +1,150 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   TCP and unix-domain listening sockets for Server_t.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+
+#ifndef FRPCFRPCLISTENER_H
+#define FRPCFRPCLISTENER_H
+
+#include <string>
+
+#include <frpcplatform.h>
+
+namespace FRPC {
+
+/**
+@brief Listening socket accepting connections for Server_t.
+
+The listener is created from URL: http://host:port listens on TCP (host in
+brackets is IPv6 address, empty host or * listens on all addresses) and
+unix:///path listens on unix-domain socket (stale socket file nobody listens
+on is replaced, a socket still accepting connections is left alone and the
+address is reported as in use; the file is removed by destructor).
+
+Socket buffer sizes are set on the listening socket so that the accepted
+connections inherit them before the TCP window is negotiated. Accepted TCP
+connections have Nagle's algorithm disabled; Server_t sends the header in
+the same packet as the body and multi-buffer bodies with MSG_MORE, so the
+responses still leave in full packets.
+*/
+class FRPC_DLLEXPORT Listener_t {
+public:
+    /**
+    @brief Listener configuration
+    */
+    struct Config_t {
+        /**
+        @brief Default constructor
+
+        Setting default values:
+
+        @n @b backlog = 128
+        @n @b noDelay = true
+        @n @b deferAccept = 0 s
+        @n @b receiveBuffer = 0 (system default)
+        @n @b sendBuffer = 0 (system default)
+        @n @b reusePort = false
+        */
+        Config_t()
+            : backlog(128), noDelay(true), deferAccept(0),
+              receiveBuffer(0), sendBuffer(0), reusePort(false)
+        {}
+
+        ///@brief length of queue of not yet accepted connections
+        int backlog;
+        ///@brief set TCP_NODELAY on accepted TCP connections
+        bool noDelay;
+        ///@brief accept TCP connection only when request data arrive
+        ///       or after given number of seconds (TCP_DEFER_ACCEPT,
+        ///       0 = disabled, Linux only)
+        unsigned int deferAccept;
+        ///@brief SO_RCVBUF of the sockets in bytes (0 = system default)
+        int receiveBuffer;
+        ///@brief SO_SNDBUF of the sockets in bytes (0 = system default)
+        int sendBuffer;
+        ///@brief allow more processes to listen on the same TCP port
+        ///       (SO_REUSEPORT)
+        bool reusePort;
+    };
+
+    /**
+    @brief Constructor, creates bound listening socket
+    @param url address to listen on (http://host:port or unix:///path)
+    @param config listener configuration
+
+    Throws HTTPError_t when the socket cannot be created or bound.
+    */
+    explicit Listener_t(const std::string &url,
+                        const Config_t &config = Config_t());
+
+    ~Listener_t();
+
+    Listener_t(const Listener_t&) = delete;
+    Listener_t& operator=(const Listener_t&) = delete;
+
+    /**
+    @brief Accept new connection
+    @param clientAddress when not null, filled with address of the client
+                         (empty for unix-domain socket)
+    @return connected socket owned by caller, suitable for Server_t::serve()
+
+    Throws HTTPError_t on failure.
+    */
+    int accept(std::string *clientAddress = nullptr);
+
+    /**
+    @brief Apply per-connection options of config to connected socket
+    @param fd connected socket (e.g. accepted by caller's own loop)
+    @param config listener configuration
+    */
+    static void configureSocket(int fd, const Config_t &config);
+
+    /**
+    @brief Listening socket, e.g. for polling
+    */
+    int socket() const {
+        return fd;
+    }
+
+    /**
+    @brief Port the TCP listener is bound to (useful for port 0)
+    */
+    unsigned short port() const;
+
+private:
+    Config_t config;
+    int fd;
+    bool isUnix;
+    std::string unixPath;
+};
+
+} // namespace FRPC
+
+#endif // FRPCFRPCLISTENER_H
@@ -0,0 +1,298 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Local time conversions without the libc timezone lock.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+#include "frpclocaltime.h"
+
+namespace FRPC {
+namespace {
+
+const int64_t DAY = 86400;
+
+// years covered by the table of UTC offsets
+const int FIRST_YEAR = 1900;
+const int YEAR_COUNT = 300;
+const int64_t FIRST_START = -2208988800; // 1900-01-01
+const int64_t AVERAGE_YEAR = 31556952;   // 365.2425 days
+
+// more changes in one year are not expected, such year goes to libc
+const int MAX_CHANGES = 8;
+
+/** UTC offset of local time valid since given unix time. */
+struct Period_t {
+    int64_t since;
+    long gmtoff;
+    int isdst;
+    const char *zone;
+};
+
+/** UTC offsets of local time during one year (of UTC). */
+struct Year_t {
+    int64_t start;
+    int64_t end;
+    int size; //!< zero when libc can't convert the times of the year
+    Period_t periods[MAX_CHANGES + 1];
+};
+
+/** Tables of one time zone, as set by tzset(). */
+struct Zone_t {
+    bool active() const {
+        return (names[0] == tzname[0]) && (names[1] == tzname[1])
+            && (offset == ::timezone) && (dst == ::daylight);
+    }
+
+    const char *names[2];
+    long offset;
+    int dst;
+    mutable std::atomic<const Year_t *> years[YEAR_COUNT];
+    const Zone_t *replaced; //!< zone used before
+};
+
+// replaced zones are never freed, other threads may still use them; time
+// zone of a process is not expected to change often
+std::atomic<const Zone_t *> zone;
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t result = value / divisor;
+    return ((value % divisor) < 0)? result - 1: result;
+}
+/** Converts seconds to time_t, casts only where time_t is another type. */
+/** Converts seconds to time_t, casts only where time_t is not 64-bit. */
+template <typename Seconds_t>
+time_t toTime(Seconds_t seconds) {
+    if constexpr (std::is_same_v<time_t, Seconds_t>) return seconds;
+    else return static_cast<time_t>(seconds);
+}
+
+bool probe(int64_t unixTime, Period_t &period) {
+    time_t time = toTime(unixTime);
+    struct tm result;
+    if ((time != unixTime) || !localtime_r(&time, &result))
+        return false;
+    period.since = unixTime;
+    period.gmtoff = result.tm_gmtoff;
+    period.isdst = result.tm_isdst;
+    period.zone = result.tm_zone;
+    return true;
+}
+
+bool sameOffset(const Period_t &first, const Period_t &second) {
+    return (first.gmtoff == second.gmtoff) && (first.isdst == second.isdst)
+        && ((first.zone == second.zone)
+            || (first.zone && second.zone && !strcmp(first.zone, second.zone)));
+}
+
+const Year_t *buildYear(int year) {
+    std::unique_ptr<Year_t> result(new Year_t());
+    const int64_t start = result->start = daysFromCivil(year, 1, 1) * DAY;
+    const int64_t end = result->end = daysFromCivil(year + 1, 1, 1) * DAY;
+
+    Period_t current;
+    if (!probe(start, current)) return result.release();
+    result->periods[0] = current;
+    result->size = 1;
+
+    // offsets are probed daily, a change is then searched to the second
+    for (int64_t time = start; time != end - 1; ) {
+        int64_t next = std::min(time + DAY, end - 1);
+        Period_t period;
+        if (!probe(next, period)) {
+            result->size = 0;
+            break;
+        }
+        if (sameOffset(period, current)) {
+            time = next;
+            continue;
+        }
+
+        int64_t low = time;
+        while (next - low > 1) {
+            int64_t middle = low + (next - low) / 2;
+            Period_t probed;
+            if (!probe(middle, probed)) {
+                result->size = 0;
+                return result.release();
+            }
+            if (sameOffset(probed, current)) {
+                low = middle;
+            } else {
+                next = middle;
+                period = probed;
+            }
+        }
+
+        if (result->size > MAX_CHANGES) {
+            result->size = 0;
+            break;
+        }
+        result->periods[result->size++] = period;
+        current = period;
+        time = next;
+    }
+    return result.release();
+}
+
+const Zone_t &getZone() {
+    const Zone_t *current = zone.load(std::memory_order_acquire);
+    if (current && current->active()) return *current;
+
+    // TZ could have changed, mktime() would see it as well
+    tzset();
+    std::unique_ptr<Zone_t> created(new Zone_t());
+    created->names[0] = tzname[0];
+    created->names[1] = tzname[1];
+    created->offset = ::timezone;
+    created->dst = ::daylight;
+    created->replaced = current;
+    if (!zone.compare_exchange_strong(current, created.get(),
+                                      std::memory_order_acq_rel))
+    {
+        return *current;
+    }
+    return *created.release();
+}
+
+const Year_t &getYear(int index) {
+    std::atomic<const Year_t *> &slot = getZone().years[index];
+    const Year_t *year = slot.load(std::memory_order_acquire);
+    if (year) return *year;
+
+    // the first of concurrently built tables wins
+    const Year_t *built = buildYear(FIRST_YEAR + index);
+    if (!slot.compare_exchange_strong(year, built, std::memory_order_acq_rel))
+    {
+        delete built;
+        return *year;
+    }
+    return *built;
+}
+
+const Period_t *findPeriod(int64_t unixTime) {
+    // the guess is one year off at most, around new year
+    int64_t index = floorDiv(unixTime - FIRST_START, AVERAGE_YEAR);
+    if ((index < 0) || (index >= YEAR_COUNT)) return nullptr;
+
+    const Year_t *year = &getYear(static_cast<int>(index));
+    if (unixTime < year->start) {
+        if (!index) return nullptr;
+        year = &getYear(static_cast<int>(index - 1));
+    } else if (unixTime >= year->end) {
+        if (index + 1 == YEAR_COUNT) return nullptr;
+        year = &getYear(static_cast<int>(index + 1));
+    }
+    if (!year->size) return nullptr;
+
+    int i = year->size - 1;
+    while ((i > 0) && (year->periods[i].since > unixTime)) --i;
+    return &year->periods[i];
+}
+
+/** Broken down local time (seconds since 1970-01-01 of local time). */
+void breakDown(int64_t local, const Period_t &period, struct tm &result) {
+    int64_t days = floorDiv(local, DAY);
+    int64_t secs = local - days * DAY;
+    int64_t year;
+    unsigned int month, day;
+    civilFromDays(days, year, month, day);
+
+    result = tm();
+    result.tm_year = static_cast<int>(year - 1900);
+    result.tm_mon = static_cast<int>(month - 1);
+    result.tm_mday = static_cast<int>(day);
+    result.tm_hour = static_cast<int>(secs / 3600);
+    result.tm_min = static_cast<int>(secs / 60 % 60);
+    result.tm_sec = static_cast<int>(secs % 60);
+    // 1970-01-01 was thursday
+    result.tm_wday = static_cast<int>(days - floorDiv(days + 4, 7) * 7 + 4);
+    result.tm_yday = static_cast<int>(days - daysFromCivil(year, 1, 1));
+    result.tm_isdst = period.isdst;
+    result.tm_gmtoff = period.gmtoff;
+    result.tm_zone = period.zone;
+}
+
+} // namespace
+
+bool localTime(time_t unixTime, struct tm &result) {
+    const Period_t *period = findPeriod(unixTime);
+    if (!period) return localtime_r(&unixTime, &result) != nullptr;
+
+    breakDown(unixTime + period->gmtoff, *period, result);
+    return true;
+}
+
+time_t makeTime(struct tm &time) {
+    // mktime() adds seconds out of range to the result, after resolving
+    // the rest of the time
+    if ((time.tm_isdst >= 0) || (time.tm_sec < 0) || (time.tm_sec > 59))
+        return mktime(&time);
+
+    int64_t months = int64_t(time.tm_year) * 12 + time.tm_mon;
+    int64_t years = floorDiv(months, 12);
+    int64_t year = 1900 + years;
+    unsigned int month = static_cast<unsigned int>(months - years * 12 + 1);
+    int64_t local = (daysFromCivil(year, month, 1) + time.tm_mday - 1) * DAY
+                    + int64_t(time.tm_hour) * 3600 + int64_t(time.tm_min) * 60
+                    + time.tm_sec;
+
+    // the UTC time is within a day from the local one
+    const Period_t *before = findPeriod(local - DAY);
+    const Period_t *after = findPeriod(local + DAY);
+    if (!before || !after) return mktime(&time);
+
+    const Period_t *found = before;
+    if (before != after) {
+        // the offset changes, valid are the offsets which are in effect
+        // at the resulting UTC time
+        found = nullptr;
+        for (const Period_t *candidate: {before, after}) {
+            const Period_t *actual = findPeriod(local - candidate->gmtoff);
+            if (!actual) return mktime(&time);
+            if (actual->gmtoff != candidate->gmtoff) continue;
+            // two solutions, let libc decide
+            if (found && (found->gmtoff != actual->gmtoff))
+                return mktime(&time);
+            found = actual;
+        }
+        // no solution, let libc decide
+        if (!found) return mktime(&time);
+    }
+
+    breakDown(local, *found, time);
+    return toTime(local - found->gmtoff);
+}
+
+} // namespace FRPC
@@ -0,0 +1,97 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Local time conversions without the libc timezone lock.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPCFRPCLOCALTIME_H
+#define FRPCFRPCLOCALTIME_H
+
+#include <cstdint>
+#include <ctime>
+
+namespace FRPC {
+
+/**
+    @brief Days since 1970-01-01 of the date in proleptic Gregorian calendar
+*/
+inline int64_t daysFromCivil(int64_t year, unsigned int month,
+                             unsigned int day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5
+                        + day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/**
+    @brief Date of the given number of days since 1970-01-01
+*/
+inline void civilFromDays(int64_t days, int64_t &year, unsigned int &month,
+                          unsigned int &day)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    day = static_cast<unsigned int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<unsigned int>(mp < 10 ? mp + 3 : mp - 9);
+    year = yoe + era * 400 + (month <= 2);
+}
+
+/**
+    @brief Converts unix time to local time, the same as localtime_r()
+
+    The UTC offsets of the local timezone are computed by libc once per
+    year and kept in a table; the conversion itself is arithmetic then and
+    it does not take the libc timezone lock. The tables are built again
+    when tzset() changes the timezone. Times the tables do not cover are
+    passed to libc.
+
+    @return false when the time can't be converted
+*/
+bool localTime(time_t unixTime, struct tm &result);
+
+/**
+    @brief Converts local time to unix time, the same as mktime()
+
+    Fields of the time get normalized as mktime() does. Local times that
+    do not exist or are ambiguous (around daylight saving time changes),
+    times with tm_isdst set and seconds out of range are passed to
+    mktime().
+*/
+time_t makeTime(struct tm &time);
+
+} // namespace FRPC
+
+#endif
@@ -39,6 +39,9 @@ enum class LogEvent_t {
     CALL_SUCCESS,
     CALL_FAULT,
     CALL_ERROR,
+    CALL_HEDGE,
+    CALL_RETRY,
+    CALL_RETRY_THROTTLED,
 };
 
 union LogEventData_t {
@@ -69,10 +72,25 @@ union LogEventData_t {
         const HTTPHeader_t *responseHeaders;
     };
 
+    // duplicate of slow call sent to another server (url is the slow one)
+    struct CallHedge_t: CallBasics_t {
+        const URL_t *hedgeUrl;
+        unsigned int delay;     // miliseconds waited for the response
+    };
+
+    // failed call is retried (url is the server of the next attempt) or
+    // the retry is not allowed by the retry budget (url is the failed one)
+    struct CallRetry_t: CallBasics_t {
+        const char *what;
+        unsigned int attempt;   // number of the failed attempt (from 1)
+    };
+
     CallStart_t callStart;
     CallSuccess_t callSuccess;
     CallFault_t callFault;
     CallError_t callError;
+    CallHedge_t callHedge;
+    CallRetry_t callRetry;
 };
 
 using LoggerFn_t = void (*)(LogEvent_t event, LogEventData_t &eventData, void *loggerData);
@@ -59,6 +59,10 @@ Marshaller_t* Marshaller_t::create(unsigned int contentType, Writer_t& writer,
         marshaller = new XmlMarshaller_t(writer,protocolVersion);
         break;
 
+    case XML_RPC_COMPACT:
+        marshaller = new XmlMarshaller_t(writer, protocolVersion, true);
+        break;
+
     case JSON:
         marshaller = new JSONMarshaller_t(writer,protocolVersion);
         break;
@@ -47,7 +47,7 @@ class Writer_t;
 struct  ProtocolVersion_t;
 class FRPC_DLLEXPORT Marshaller_t {
 public:
-    enum{ BINARY_RPC, XML_RPC, JSON, BASE64_RPC};
+    enum{ BINARY_RPC, XML_RPC, JSON, BASE64_RPC, XML_RPC_COMPACT};
 
     /**
         @brief Default constructor
@@ -188,6 +188,8 @@ public:
         @brief create marshaller object with contentType
         @param contentType is an content type
             @li @b XML - create xml marshaller
+            @li @b XML_RPC_COMPACT - create xml marshaller without whitespace
+                                     between tags
             @li @b BINARY create binary marshaler
         @param writer is a object which write output data
         @return reference to new marshaller
@@ -130,6 +130,47 @@ void MethodRegistry_t::registerMethod(const std::string &methodName, Method_t *m
     }
 }
 
+void MethodRegistry_t::enableResponseCache(const std::string &methodName,
+                                           const ResponseCache_t::Config_t &config)
+{
+    std::map<std::string, RegistryEntry_t>::iterator
+        pos = methodMap.find(methodName);
+    if (pos == methodMap.end())
+        throw std::invalid_argument("Method " + methodName + " not registered");
+
+    pos->second.cache = std::make_shared<ResponseCache_t>(config);
+}
+
+void MethodRegistry_t::disableResponseCache(const std::string &methodName) {
+    std::map<std::string, RegistryEntry_t>::iterator
+        pos = methodMap.find(methodName);
+    if (pos != methodMap.end())
+        pos->second.cache.reset();
+}
+
+ResponseCache_t *
+MethodRegistry_t::responseCache(const std::string &methodName) const {
+    std::map<std::string, RegistryEntry_t>::const_iterator
+        pos = methodMap.find(methodName);
+    if (pos == methodMap.end())
+        return nullptr;
+
+    return pos->second.cache.get();
+}
+
+void MethodRegistry_t::cacheHit(const std::string &clientIP,
+                                const std::string &methodName,
+                                Array_t &params,
+                                const ResponseCache_t::Entry_t &entry,
+                                TimeDiff_t &timeD)
+{
+    if (callbacks) {
+        callbacks->preProcess(methodName, clientIP, params);
+        callbacks->postProcess(methodName, clientIP, params, entry.result(),
+                               timeD.diff());
+    }
+}
+
 void MethodRegistry_t::registerDefaultMethod(DefaultMethod_t *defaultMethod) {
     delete this->defaultMethod;
     this->defaultMethod = defaultMethod;
@@ -156,17 +197,29 @@ int MethodRegistry_t::processCall(const std::string &clientIP, const std::string
     TimeDiff_t timeD;
 
     TreeFeeder_t feeder(*marshaller);
+    ResponseCache_t *cache = responseCache(methodName);
 
     try
     {
+        ResponseCache_t::EntryPtr_t entry;
+        Value_t *retValue = nullptr;
 
-        Value_t &retValue = processCall(clientIP, methodName, params, pool);
-
-
-        marshaller->packMethodResponse();
-        feeder.feedValue(retValue);
-        marshaller->flush();
+        if (cache && (entry = cache->find(params))) {
+            cacheHit(clientIP, methodName, params, *entry, timeD);
+        } else {
+            retValue = &callMethod(clientIP, methodName, params, pool);
+            if (cache)
+                entry = cache->insert(params, *retValue);
+        }
 
+        if (entry) {
+            // the response is marshalled once per output type
+            cache->write(*entry, writer, typeOut, protocolVersion);
+        } else {
+            marshaller->packMethodResponse();
+            feeder.feedValue(*retValue);
+            marshaller->flush();
+        }
     }
 
     catch(const StreamError_t &streamError)
@@ -218,6 +271,26 @@ Value_t& MethodRegistry_t::processCall(const std::string &clientIP,
                                        const std::string &methodName,
                                        Array_t &params,
                                        Pool_t &pool)
+{
+    ResponseCache_t *cache = responseCache(methodName);
+    if (!cache)
+        return callMethod(clientIP, methodName, params, pool);
+
+    TimeDiff_t timeD;
+    if (ResponseCache_t::EntryPtr_t entry = cache->find(params)) {
+        cacheHit(clientIP, methodName, params, *entry, timeD);
+        return entry->result().clone(pool);
+    }
+
+    Value_t &result = callMethod(clientIP, methodName, params, pool);
+    cache->insert(params, result);
+    return result;
+}
+
+Value_t& MethodRegistry_t::callMethod(const std::string &clientIP,
+                                      const std::string &methodName,
+                                      Array_t &params,
+                                      Pool_t &pool)
 {
     TimeDiff_t timeD;
     Value_t *result = nullptr;
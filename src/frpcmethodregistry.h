@@ -34,8 +34,10 @@
 #define FRPCFRPCMETHODREGISTRY_H
 
 #include <map>
+#include <memory>
 #include <string>
 #include <frpcmethod.h>
+#include <frpcresponsecache.h>
 
 namespace FRPC {
 
@@ -75,6 +77,7 @@ public:
         Method_t *method;
         std::string signature;
         std::string help;
+        std::shared_ptr<ResponseCache_t> cache;
     };
 
 
@@ -156,6 +159,32 @@ public:
     void registerMethod(const std::string &methodName, Method_t *method,
                         const std::string signature = "",
                         const std::string help = "No help" );
+    /**
+    @brief enable caching of results of already registered method
+    @param methodName it is the method name in string
+    @param config cache ttl and size limits
+
+    The method must be idempotent: cached result is returned for any call
+    with parameters equal (by FRPC::compare) to the cached one and neither
+    the method handler nor the response marshaller are called. Faults are
+    never cached. The cache is dropped when the method is registered again.
+    */
+    void enableResponseCache(const std::string &methodName,
+                             const ResponseCache_t::Config_t &config
+                             = ResponseCache_t::Config_t());
+
+    /**
+    @brief disable caching of results of registered method
+    @param methodName it is the method name in string
+    */
+    void disableResponseCache(const std::string &methodName);
+
+    /**
+    @brief returns the result cache of the method or nullptr if disabled
+    @param methodName it is the method name in string
+    */
+    ResponseCache_t *responseCache(const std::string &methodName) const;
+
     /**
     @brief call head method on HTTP HEAD
     @return long
@@ -202,6 +231,14 @@ public:
 
 
 private:
+    Value_t& callMethod(const std::string &clientIP,
+                        const std::string &methodName,
+                        Array_t &params, Pool_t &pool);
+
+    void cacheHit(const std::string &clientIP, const std::string &methodName,
+                  Array_t &params, const ResponseCache_t::Entry_t &entry,
+                  TimeDiff_t &timeD);
+
     //system methods
     Value_t& listMethods(Pool_t &pool, Array_t &params);
     Value_t& methodHelp(Pool_t &pool, Array_t &params);
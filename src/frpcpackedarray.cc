@@ -0,0 +1,87 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Arrays of ints and doubles stored in contiguous memory.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include <utility>
+
+#include "frpcpackedarray.h"
+#include "frpcpool.h"
+
+namespace FRPC {
+namespace {
+
+Value_t &makeItem(Pool_t &pool, Int_t::value_type value) {
+    return pool.Int(value);
+}
+
+Value_t &makeItem(Pool_t &pool, double value) {
+    return pool.Double(value);
+}
+
+IntArray_t &makeArray(Pool_t &pool, const IntArray_t::storage_type &values) {
+    return pool.IntArray(values);
+}
+
+DoubleArray_t &makeArray(Pool_t &pool,
+                         const DoubleArray_t::storage_type &values)
+{
+    return pool.DoubleArray(values);
+}
+
+} // namespace
+
+template <typename Item_t>
+PackedArray_t<Item_t>::PackedArray_t(Pool_t &pool, storage_type values)
+    : Array_t(size_type(0)), pool(pool), items(std::move(values))
+{
+    lazy = true;
+    packed = true;
+}
+
+template <typename Item_t>
+PackedArray_t<Item_t>::~PackedArray_t() = default;
+
+template <typename Item_t>
+Value_t &PackedArray_t<Item_t>::clone(Pool_t &newPool) const {
+    if (!packed) return Array_t::clone(newPool);
+    return makeArray(newPool, items);
+}
+
+template <typename Item_t>
+void PackedArray_t<Item_t>::materialize() const {
+    arrayData.reserve(items.size());
+    for (item_type value: items)
+        arrayData.push_back(&makeItem(pool, value));
+}
+
+template class PackedArray_t<Int_t>;
+template class PackedArray_t<Double_t>;
+
+} // namespace FRPC
@@ -0,0 +1,118 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Arrays of ints and doubles stored in contiguous memory.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPCFRPCPACKEDARRAY_H
+#define FRPCFRPCPACKEDARRAY_H
+
+#include <frpcarray.h>
+#include <frpcint.h>
+#include <frpcdouble.h>
+
+#include <vector>
+
+namespace FRPC {
+
+/**
+@brief Homogeneous array of ints or doubles stored in contiguous memory
+
+It is regular Array_t for all callers (the type is TYPE_ARRAY) but the items
+are kept in std::vector of native numbers. The Int_t/Double_t items are
+created in the pool lazily on the first access through the Array_t
+interface, const accessors included: the first reader allocates them from
+the pool of the array under a lock shared by all arrays, so a decoded tree
+can still be read by more threads at once. The binary marshaller sends the packed array as one block when
+protocol version 3.3 is used, other marshallers and older protocol versions
+get regular array.
+
+Any modification through the Array_t interface (non-const accessors
+included) drops the packed representation and the array then behaves as
+regular Array_t; isPacked() returns false since then.
+*/
+template <typename Item_t>
+class FRPC_DLLEXPORT PackedArray_t : public Array_t {
+    friend class Pool_t;
+public:
+    using item_type = typename Item_t::value_type;
+    using storage_type = std::vector<item_type>;
+
+    /**
+        @brief Destructor
+    */
+    ~PackedArray_t() override;
+
+    /**
+       @brief Method to clone/copy array, the copy is packed as well if this
+       array is packed
+       @param newPool is reference of Pool_t which is used for allocate objects
+       @return reference to new array as Value_t
+    */
+    Value_t& clone(Pool_t &newPool) const override;
+
+    /**
+        @brief Checks whether values() still holds all items of the array
+    */
+    bool isPacked() const { return packed;}
+
+    /**
+        @brief Packed items, valid only when isPacked() returns true
+    */
+    const storage_type &values() const { return items;}
+
+protected:
+    /**
+        @brief Constructor
+        @param pool is a pool for lazily created items
+        @param values is a items of the array
+    */
+    PackedArray_t(Pool_t &pool, storage_type values);
+
+    void materialize() const override;
+
+    Pool_t &pool;
+    storage_type items;
+};
+
+extern template class PackedArray_t<Int_t>;
+extern template class PackedArray_t<Double_t>;
+
+/**
+@brief Packed array of ints
+*/
+using IntArray_t = PackedArray_t<Int_t>;
+
+/**
+@brief Packed array of doubles
+*/
+using DoubleArray_t = PackedArray_t<Double_t>;
+
+} // namespace FRPC
+
+#endif
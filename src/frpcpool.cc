@@ -42,6 +42,7 @@
 #include "frpcdouble.h"
 #include "frpcbinaryref.h"
 #include "frpcnull.h"
+#include "frpcpackedarray.h"
 #include "frpcsecret.h"
 #include "frpcstring.h"
 #include "frpcstring_view.h"
@@ -277,6 +278,24 @@ StringView_t &Pool_t::StringView(const char *ptr, std::size_t length) {
     return *newValue;
 }
 
+IntArray_t& Pool_t::IntArray(std::vector<Int_t::value_type> values)
+{
+    auto *newValue = new IntArray_t(*this, std::move(values));
+
+    pointerStorage.push_back(newValue);
+
+    return *newValue;
+}
+
+DoubleArray_t& Pool_t::DoubleArray(std::vector<double> values)
+{
+    auto *newValue = new DoubleArray_t(*this, std::move(values));
+
+    pointerStorage.push_back(newValue);
+
+    return *newValue;
+}
+
 Array_t& Pool_t::Array()
 {
     auto *newValue =  new Array_t();
@@ -54,6 +54,9 @@ class DateTime_t;
 class Struct_t;
 class Null_t;
 class SecretValue_t;
+template <typename Item_t> class PackedArray_t;
+using IntArray_t = PackedArray_t<Int_t>;
+using DoubleArray_t = PackedArray_t<Double_t>;
 
 /**
 @author Miroslav Talasek
@@ -342,6 +345,18 @@ public:
                    const Value_t &item3, const Value_t &item4,
                    const Value_t &item5);
 
+    /**
+        @brief Create new packed array of ints
+        @param values is a items of the array
+        @return reference to IntArray_t
+    */
+    IntArray_t& IntArray(std::vector<Int_t::value_type> values);
+    /**
+        @brief Create new packed array of doubles
+        @param values is a items of the array
+        @return reference to DoubleArray_t
+    */
+    DoubleArray_t& DoubleArray(std::vector<double> values);
     /**
     @brief Create new empty Struct_t
     @return reference to Struct_t
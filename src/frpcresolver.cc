@@ -0,0 +1,414 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Cache of resolved host addresses shared by the connectors.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include "frpcresolver.h"
+#include "frpchttp.h"
+#include "frpchttperror.h"
+
+namespace FRPC {
+
+namespace {
+
+using Clock_t = std::chrono::steady_clock;
+
+std::int64_t ticks(Clock_t::time_point time) {
+    return time.time_since_epoch().count();
+}
+
+bool sameAddress(const Resolver_t::Address_t &a,
+                 const Resolver_t::Address_t &b)
+{
+    return (a.family == b.family) && (a.length == b.length)
+        && !::memcmp(&a.address, &b.address, a.length);
+}
+
+/** Resolves host by getaddrinfo(), throws HTTPError_t on failure.
+ */
+std::vector<Resolver_t::Address_t> getAddresses(const std::string &host,
+                                          unsigned short port, int family)
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = 0;
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    char service[8] = {0};
+    snprintf(service, sizeof(service), "%u", port);
+
+    struct addrinfo *addrInfo = nullptr;
+    int errcode = getaddrinfo(host.c_str(), service, &hints, &addrInfo);
+    if (errcode != 0) {
+        throw HTTPError_t::format(
+                HTTP_DNS, "Cannot resolve host '%s': <%d, %s>.",
+                host.c_str(), errcode, gai_strerror(errcode));
+    }
+
+    std::vector<Resolver_t::Address_t> addresses;
+    for (struct addrinfo *ai = addrInfo; ai; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(sockaddr_storage)) continue;
+        Resolver_t::Address_t address;
+        memset(&address.address, 0, sizeof(address.address));
+        address.family = ai->ai_family;
+        address.length = ai->ai_addrlen;
+        memcpy(&address.address, ai->ai_addr, ai->ai_addrlen);
+        addresses.push_back(address);
+    }
+    freeaddrinfo(addrInfo);
+
+    if (addresses.empty()) {
+        throw HTTPError_t::format(
+                HTTP_DNS, "Cannot resolve host '%s': no address.",
+                host.c_str());
+    }
+    return addresses;
+}
+
+unsigned int configValue(const char *name, unsigned int defaultValue) {
+    const char *s = getenv(name);
+    return (s == nullptr) ? defaultValue : unsigned(atoi(s));
+}
+
+} // namespace
+
+Resolver_t::Host_t::Host_t(std::vector<Address_t> addresses,
+                           unsigned int failureTimeout)
+    : addresses(std::move(addresses)),
+      failureTimeout(std::chrono::milliseconds(failureTimeout)),
+      next(0),
+      failedUntil(new std::atomic<std::int64_t>[this->addresses.size()])
+{
+    for (std::size_t i = 0; i < this->addresses.size(); ++i) {
+        failedUntil[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::vector<std::size_t> Resolver_t::Host_t::order() const {
+    std::size_t count = addresses.size();
+    std::size_t start = next.fetch_add(1, std::memory_order_relaxed) % count;
+    std::int64_t now = ticks(Clock_t::now());
+
+    std::vector<std::size_t> result;
+    std::vector<std::size_t> failing;
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t index = (start + i) % count;
+        if (failedUntil[index].load(std::memory_order_relaxed) > now) {
+            failing.push_back(index);
+        } else {
+            result.push_back(index);
+        }
+    }
+    result.insert(result.end(), failing.begin(), failing.end());
+    return result;
+}
+
+void Resolver_t::Host_t::failed(std::size_t index) const {
+    failedUntil[index].store(ticks(Clock_t::now() + failureTimeout),
+                             std::memory_order_relaxed);
+}
+
+void Resolver_t::Host_t::succeeded(std::size_t index) const {
+    if (failedUntil[index].load(std::memory_order_relaxed)) {
+        failedUntil[index].store(0, std::memory_order_relaxed);
+    }
+}
+
+struct Resolver_t::State_t {
+    /** Cached resolution result, host is empty for cached failure.
+     */
+    struct Entry_t {
+        Entry_t() : refreshing(false) {}
+
+        std::shared_ptr<Host_t> host;
+        std::string error;
+        Clock_t::time_point expires;
+        bool refreshing;
+    };
+
+    /** Entry waiting for the worker.
+     */
+    struct Refresh_t {
+        std::string key;
+        std::string host;
+        unsigned short port;
+        int family;
+    };
+
+    explicit State_t(const Config_t &config)
+        : config(config), stopping(false)
+#ifndef WIN32
+          , workerPid(0)
+#endif // !WIN32
+    {}
+
+    std::vector<Address_t> lookup(const std::string &host,
+                                  unsigned short port, int family) const
+    {
+        if (config.lookup) return config.lookup(host, port, family);
+        return getAddresses(host, port, family);
+    }
+
+    /** Returns the entry of the key, room for new entry is made by
+     *  dropping entries which cannot be served any more (or the one
+     *  expiring first). The mutex must be locked.
+     */
+    Entry_t& entry(const std::string &key, Clock_t::time_point now) {
+        auto ientry = entries.find(key);
+        if (ientry != entries.end()) return ientry->second;
+        if (!config.maxEntries || (entries.size() < config.maxEntries)) {
+            return entries[key];
+        }
+
+        auto stale = std::chrono::milliseconds(config.ttl);
+        auto first = entries.end();
+        for (auto i = entries.begin(); i != entries.end();) {
+            const Entry_t &old = i->second;
+            if (now >= old.expires + (old.host ? stale : stale.zero())) {
+                i = entries.erase(i);
+                continue;
+            }
+            if ((first == entries.end())
+                || (old.expires < first->second.expires))
+            {
+                first = i;
+            }
+            ++i;
+        }
+        if ((entries.size() >= config.maxEntries) && (first != entries.end()))
+            entries.erase(first);
+        return entries[key];
+    }
+
+    /** Resolves the host and stores the result. Failure of background
+     *  refresh keeps the old addresses, otherwise it is cached and thrown.
+     */
+    HostPtr_t update(const std::string &key, const std::string &host,
+                     unsigned short port, int family, bool background)
+    {
+        std::shared_ptr<Host_t> resolved;
+        std::string error;
+        try {
+            resolved = std::make_shared<Host_t>(
+                    lookup(host, port, family), config.failureTimeout);
+        } catch (const HTTPError_t &e) {
+            error = e.message();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = Clock_t::now();
+        Entry_t &entry = this->entry(key, now);
+        entry.refreshing = false;
+
+        if (resolved) {
+            // keep round-robin position and failures of known addresses
+            if (entry.host) {
+                const Host_t &old = *entry.host;
+                resolved->next.store(old.next.load());
+                for (std::size_t i = 0; i < resolved->size(); ++i) {
+                    for (std::size_t j = 0; j < old.size(); ++j) {
+                        if (sameAddress((*resolved)[i], old[j])) {
+                            resolved->failedUntil[i].store(
+                                    old.failedUntil[j].load());
+                            break;
+                        }
+                    }
+                }
+            }
+            entry.host = resolved;
+            entry.error.clear();
+            entry.expires = now + std::chrono::milliseconds(config.ttl);
+            return resolved;
+        }
+
+        if (background && entry.host) {
+            // serve stale addresses and try again later
+            entry.expires = now
+                + std::chrono::milliseconds(config.negativeTtl);
+            return entry.host;
+        }
+
+        entry.host.reset();
+        entry.error = error;
+        entry.expires = now + std::chrono::milliseconds(config.negativeTtl);
+        throw HTTPError_t(HTTP_DNS, error);
+    }
+
+    /** Hands the entry over to the worker, starts it when needed. The
+     *  mutex must be locked.
+     *
+     *  @return false when the worker cannot be started
+     */
+    bool schedule(Refresh_t refresh) {
+#ifndef WIN32
+        // the worker does not exist in a forked child, its handle is
+        // leaked there since it can be neither joined nor detached
+        if (worker && (workerPid != ::getpid())) worker.release();
+#endif // !WIN32
+        if (!worker) {
+            try {
+                worker.reset(new std::thread([this] { run(); }));
+            } catch (const std::system_error &) {
+                return false;
+            }
+#ifndef WIN32
+            workerPid = ::getpid();
+#endif // !WIN32
+        }
+        queue.push_back(std::move(refresh));
+        wakeup.notify_one();
+        return true;
+    }
+
+    /** Refreshes queued entries one by one until stopped.
+     */
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wakeup.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            Refresh_t refresh = std::move(queue.front());
+            queue.pop_front();
+
+            lock.unlock();
+            try {
+                update(refresh.key, refresh.host, refresh.port,
+                       refresh.family, true);
+            } catch (...) {}
+            lock.lock();
+        }
+    }
+
+    /** Stops the worker, waits for the refresh in progress.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+#ifndef WIN32
+        if (worker && (workerPid != ::getpid())) worker.release();
+#endif // !WIN32
+        if (worker) worker->join();
+    }
+
+    Config_t config;
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry_t> entries;
+
+    std::unique_ptr<std::thread> worker;
+    std::condition_variable wakeup;
+    std::deque<Refresh_t> queue;
+    bool stopping;
+#ifndef WIN32
+    pid_t workerPid;
+#endif // !WIN32
+};
+
+Resolver_t::Resolver_t(const Config_t &config)
+    : state(new State_t(config))
+{}
+
+Resolver_t::~Resolver_t() {
+    state->stop();
+}
+
+Resolver_t& Resolver_t::instance() {
+    auto factory = []() -> Resolver_t* {
+        return new Resolver_t(Config_t(
+                configValue("FASTRPC_RESOLVER_TTL", 60000),
+                configValue("FASTRPC_RESOLVER_NEGATIVE_TTL", 1000),
+                configValue("FASTRPC_RESOLVER_FAILURE_TIMEOUT", 1000),
+                configValue("FASTRPC_RESOLVER_MAX_ENTRIES", 1024)));
+    };
+
+    static std::unique_ptr<Resolver_t> resolver(factory());
+    return *resolver;
+}
+
+Resolver_t::HostPtr_t Resolver_t::resolve(const std::string &host,
+                                          unsigned short port, int family)
+{
+    if (state->config.ttl == 0) {
+        return std::make_shared<Host_t>(state->lookup(host, port, family),
+                                        state->config.failureTimeout);
+    }
+
+    std::string key = std::to_string(family) + '/' + std::to_string(port)
+        + '/' + host;
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto ientry = state->entries.find(key);
+        if (ientry != state->entries.end()) {
+            State_t::Entry_t &entry = ientry->second;
+            auto now = Clock_t::now();
+
+            if (now < entry.expires) {
+                if (!entry.host) throw HTTPError_t(HTTP_DNS, entry.error);
+                return entry.host;
+            }
+
+            // expired recently => refresh in background
+            if (entry.host && (now < entry.expires
+                    + std::chrono::milliseconds(state->config.ttl)))
+            {
+                if (entry.refreshing) return entry.host;
+                // cannot start the worker => resolve synchronously
+                if (state->schedule({key, host, port, family})) {
+                    entry.refreshing = true;
+                    return entry.host;
+                }
+            }
+        }
+    }
+
+    return state->update(key, host, port, family, false);
+}
+
+void Resolver_t::clear() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->entries.clear();
+}
+
+} // namespace FRPC
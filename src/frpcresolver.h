@@ -0,0 +1,217 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Cache of resolved host addresses shared by the connectors.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPCFRPCRESOLVER_H
+#define FRPCFRPCRESOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <frpcplatform.h>
+
+namespace FRPC {
+
+/**
+@brief Cache of resolved host addresses.
+
+Hosts are resolved by getaddrinfo() and all returned addresses are kept for
+ttl. Expired entries are still returned for one more ttl while they are
+refreshed by a worker thread owned by the resolver, so that the callers do
+not wait for the resolver; older entries are resolved synchronously.
+Resolution failures are cached for negativeTtl and rethrown as HTTPError_t
+with HTTP_DNS status. At most maxEntries hosts are cached, entries which
+cannot be served any more are dropped first.
+
+The returned Host_t hands out its addresses round-robin and remembers the
+addresses that refused connection: they are tried last for failureTimeout.
+
+The cache is thread safe. Connectors use the instance() singleton.
+*/
+class FRPC_DLLEXPORT Resolver_t {
+public:
+    /**
+    @brief Single resolved address
+    */
+    struct Address_t {
+        int family;
+        socklen_t length;
+        sockaddr_storage address;
+
+        const sockaddr* get() const {
+            return reinterpret_cast<const sockaddr*>(&address);
+        }
+    };
+
+    /**
+    @brief Function resolving host, port and family to addresses
+
+    It throws HTTPError_t when the host cannot be resolved.
+    */
+    using Lookup_t = std::function<std::vector<Address_t>(
+            const std::string &host, unsigned short port, int family)>;
+
+    /**
+    @brief Resolver configuration
+    */
+    struct Config_t {
+        /**
+        @brief Constructor
+        @param ttl lifetime of resolved addresses in milliseconds
+                   (0 = resolve on every call)
+        @param negativeTtl lifetime of resolution failure in milliseconds
+        @param failureTimeout how long is refused address tried last
+                              in milliseconds
+        @param maxEntries maximum of cached hosts (0 = unlimited)
+        */
+        Config_t(unsigned int ttl = 60000,
+                 unsigned int negativeTtl = 1000,
+                 unsigned int failureTimeout = 1000,
+                 unsigned int maxEntries = 1024)
+            : ttl(ttl), negativeTtl(negativeTtl),
+              failureTimeout(failureTimeout), maxEntries(maxEntries)
+        {}
+
+        unsigned int ttl;
+        unsigned int negativeTtl;
+        unsigned int failureTimeout;
+        unsigned int maxEntries;
+        ///@brief resolves the hosts instead of getaddrinfo() when set
+        Lookup_t lookup;
+    };
+
+    /**
+    @brief Addresses of one host
+    */
+    class FRPC_DLLEXPORT Host_t {
+    public:
+        explicit Host_t(std::vector<Address_t> addresses,
+                        unsigned int failureTimeout = 1000);
+
+        Host_t(const Host_t&) = delete;
+        Host_t& operator=(const Host_t&) = delete;
+
+        /**
+        @brief Indices of addresses in the order they should be tried
+
+        The order starts with the next address in round-robin order,
+        addresses marked as failed are moved to the end.
+        */
+        std::vector<std::size_t> order() const;
+
+        /**
+        @brief Mark the address as refusing connections
+        */
+        void failed(std::size_t index) const;
+
+        /**
+        @brief Clear failure mark of the address after successful connect
+        */
+        void succeeded(std::size_t index) const;
+
+        const Address_t& operator[](std::size_t index) const {
+            return addresses[index];
+        }
+
+        std::size_t size() const {
+            return addresses.size();
+        }
+
+        const std::vector<Address_t>& getAddresses() const {
+            return addresses;
+        }
+
+    private:
+        friend class Resolver_t;
+
+        std::vector<Address_t> addresses;
+        std::chrono::steady_clock::duration failureTimeout;
+        mutable std::atomic<std::size_t> next;
+        //! steady clock ticks until the address is considered failed
+        std::unique_ptr<std::atomic<std::int64_t>[]> failedUntil;
+    };
+
+    using HostPtr_t = std::shared_ptr<const Host_t>;
+
+    /**
+    @brief Constructor
+    @param config resolver configuration
+    */
+    explicit Resolver_t(const Config_t &config = Config_t());
+
+    /**
+    @brief Destructor, waits for the refresh in progress
+    */
+    ~Resolver_t();
+
+    Resolver_t(const Resolver_t&) = delete;
+    Resolver_t& operator=(const Resolver_t&) = delete;
+
+    /**
+    @brief Resolver shared by the connectors
+
+    The configuration is taken from the environment variables
+    FASTRPC_RESOLVER_TTL, FASTRPC_RESOLVER_NEGATIVE_TTL,
+    FASTRPC_RESOLVER_FAILURE_TIMEOUT (all in milliseconds) and
+    FASTRPC_RESOLVER_MAX_ENTRIES.
+    */
+    static Resolver_t& instance();
+
+    /**
+    @brief Resolve host to its addresses
+    @param host host name or numeric address (without brackets)
+    @param port port number
+    @param family AF_INET or AF_INET6
+    @return resolved addresses (never empty)
+
+    Throws HTTPError_t (HTTP_DNS) when host cannot be resolved.
+    */
+    HostPtr_t resolve(const std::string &host, unsigned short port,
+                      int family);
+
+    /**
+    @brief Drop all cached entries
+    */
+    void clear();
+
+private:
+    struct State_t;
+    std::unique_ptr<State_t> state;
+};
+
+} // namespace FRPC
+
+#endif // FRPCFRPCRESOLVER_H
@@ -0,0 +1,246 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Cache of method results used by MethodRegistry_t.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#include "frpcresponsecache.h"
+#include "frpcmarshaller.h"
+#include "frpctreefeeder.h"
+#include "frpcwriter.h"
+#include "frpc.h"
+
+#include <sys/time.h>
+
+namespace FRPC {
+namespace {
+
+uint64_t gettimemilliseconds() {
+    timeval tv = {};
+    gettimeofday(&tv, nullptr);
+    return (uint64_t(tv.tv_sec) * 1000) + ((tv.tv_usec + 500) / 1000);
+}
+
+/** Only values owning all their data can be copied into the cache.
+ */
+bool isCacheable(const Value_t &value) {
+    switch (value.getType()) {
+    case Bool_t::TYPE:
+    case Int_t::TYPE:
+    case Double_t::TYPE:
+    case String_t::TYPE:
+    case Binary_t::TYPE:
+    case DateTime_t::TYPE:
+    case Null_t::TYPE:
+        return true;
+    case Struct_t::TYPE:
+        for (auto &item: Struct(value))
+            if (!isCacheable(*item.second)) return false;
+        return true;
+    case Array_t::TYPE:
+        // packed arrays hold numbers only
+        if (auto *ints = dynamic_cast<const IntArray_t *>(&value))
+            if (ints->isPacked()) return true;
+        if (auto *doubles = dynamic_cast<const DoubleArray_t *>(&value))
+            if (doubles->isPacked()) return true;
+        for (auto *item: Array(value))
+            if (!isCacheable(*item)) return false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** Creates items of lazily materialized (packed) arrays. Cached values are
+ *  read by concurrent callers without the lock, so they need not take the
+ *  materialization lock of Array_t on first access.
+ */
+void materialize(const Value_t &value) {
+    switch (value.getType()) {
+    case Struct_t::TYPE:
+        for (auto &item: Struct(value)) materialize(*item.second);
+        break;
+    case Array_t::TYPE:
+        for (auto *item: Array(value)) materialize(*item);
+        break;
+    default:
+        break;
+    }
+}
+
+uint32_t responseKey(unsigned int typeOut,
+                     const ProtocolVersion_t &protocolVersion)
+{
+    return (typeOut << 16)
+        | (uint32_t(protocolVersion.versionMajor) << 8)
+        | uint32_t(protocolVersion.versionMinor);
+}
+
+class StringWriter_t: public Writer_t {
+public:
+    explicit StringWriter_t(std::string &data): data(data) {}
+
+    void write(const char *chunk, unsigned int size) override {
+        data.append(chunk, size);
+    }
+
+    void flush() override {}
+
+private:
+    std::string &data;
+};
+
+} // namespace
+
+ResponseCache_t::ResponseCache_t(const Config_t &config)
+    : config(config), totalSize(0)
+{}
+
+ResponseCache_t::~ResponseCache_t() = default;
+
+ResponseCache_t::EntryPtr_t ResponseCache_t::find(const Array_t &params) {
+    if (!isCacheable(params)) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Index_t::iterator ientry = index.find(&params);
+    if (ientry == index.end()) return nullptr;
+
+    std::shared_ptr<Entry_t> entry = *ientry->second;
+    if (entry->expires && (entry->expires <= gettimemilliseconds())) {
+        erase(*entry);
+        return nullptr;
+    }
+
+    // move to the front of lru list
+    lru.splice(lru.begin(), lru, entry->lru);
+    return entry;
+}
+
+ResponseCache_t::EntryPtr_t
+ResponseCache_t::insert(const Array_t &params, const Value_t &result) {
+    if (!config.maxEntries) return nullptr;
+    if (!isCacheable(params) || !isCacheable(result)) return nullptr;
+
+    // copy values outside of the lock
+    std::shared_ptr<Entry_t> entry(new Entry_t());
+    entry->paramsCopy = &Array(params.clone(entry->pool));
+    entry->resultCopy = &result.clone(entry->pool);
+    materialize(*entry->paramsCopy);
+    materialize(*entry->resultCopy);
+    if (config.ttl) entry->expires = gettimemilliseconds() + config.ttl;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // replace the entry cached meanwhile by another caller
+    Index_t::iterator ientry = index.find(entry->paramsCopy);
+    if (ientry != index.end()) erase(**ientry->second);
+
+    lru.push_front(entry);
+    entry->lru = lru.begin();
+    entry->cached = true;
+    index.insert(Index_t::value_type(entry->paramsCopy, entry->lru));
+
+    evict(entry.get());
+    return entry;
+}
+
+void ResponseCache_t::write(const Entry_t &entry, Writer_t &writer,
+                            unsigned int typeOut,
+                            const ProtocolVersion_t &protocolVersion)
+{
+    uint32_t key = responseKey(typeOut, protocolVersion);
+    Entry_t::Response_t response;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iresponse = entry.responses.find(key);
+        if (iresponse != entry.responses.end()) response = iresponse->second;
+    }
+
+    if (!response) {
+        // marshall the response outside of the lock, values are immutable
+        std::shared_ptr<std::string> data(new std::string());
+        StringWriter_t stringWriter(*data);
+        std::unique_ptr<Marshaller_t>
+            marshaller(Marshaller_t::create(typeOut, stringWriter,
+                                            protocolVersion));
+        TreeFeeder_t feeder(*marshaller);
+        marshaller->packMethodResponse();
+        feeder.feedValue(entry.result());
+        marshaller->flush();
+        response = data;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry_t &mentry = const_cast<Entry_t &>(entry);
+        auto res = mentry.responses.insert(std::make_pair(key, response));
+        if (!res.second) {
+            response = res.first->second;
+
+        } else if (mentry.cached) {
+            mentry.size += response->size();
+            totalSize += response->size();
+            lru.splice(lru.begin(), lru, mentry.lru);
+            evict(&mentry);
+        }
+    }
+
+    writer.write(response->data(), static_cast<unsigned int>(response->size()));
+    writer.flush();
+}
+
+void ResponseCache_t::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!lru.empty()) erase(*lru.back());
+}
+
+std::size_t ResponseCache_t::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+void ResponseCache_t::erase(Entry_t &entry) {
+    index.erase(entry.paramsCopy);
+    totalSize -= entry.size;
+    entry.cached = false;
+    // the last statement, it can release the entry
+    lru.erase(entry.lru);
+}
+
+void ResponseCache_t::evict(const Entry_t *keep) {
+    while (!lru.empty()
+           && ((index.size() > config.maxEntries)
+               || (totalSize > config.maxSize)))
+    {
+        // the kept entry is at the front of the list so it is the victim
+        // only if it is too big itself; caller still holds it
+        bool last = (lru.back().get() == keep);
+        erase(*lru.back());
+        if (last) break;
+    }
+}
+
+} // namespace FRPC
@@ -0,0 +1,190 @@
+/*
+ * FastRPC -- Fast RPC library compatible with XML-RPC
+ * Copyright (C) 2005-7  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:fastrpc@firma.seznam.cz
+ *
+ * FILE          $Id: $
+ *
+ * DESCRIPTION   Cache of method results used by MethodRegistry_t.
+ *
+ * Copyright (C) Seznam.cz a.s. 2026
+ * All Rights Reserved
+ *
+ */
+
+#ifndef FRPCFRPCRESPONSECACHE_H
+#define FRPCFRPCRESPONSECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <frpcplatform.h>
+#include <frpcpool.h>
+#include <frpchash.h>
+
+namespace FRPC {
+
+class Writer_t;
+class Array_t;
+class Value_t;
+struct ProtocolVersion_t;
+
+/**
+@brief Cache of method results for idempotent methods.
+
+Entries are keyed by the call parameters hashed by FRPC::hash() and matched
+by FRPC::compare(). Every entry holds private copy of the parameters and of
+the result and the already marshalled response for each output protocol (and
+protocol version) that asked for it. Entries expire after ttl and the least recently used entries
+are evicted when the cache exceeds maxEntries or when the marshalled
+responses exceed maxSize bytes.
+
+Values that only reference foreign memory (StringView_t, BinaryRef_t) are not
+cacheable; find() and insert() return empty pointer for them and the caller
+is expected to process the call as usual.
+
+The cache is thread safe.
+*/
+class FRPC_DLLEXPORT ResponseCache_t {
+public:
+    /**
+    @brief Response cache configuration
+    */
+    struct Config_t {
+        /**
+        @brief Constructor
+        @param ttl lifetime of cached result in milliseconds (0 = forever)
+        @param maxEntries maximal number of cached results
+        @param maxSize maximal size of all marshalled responses in bytes
+        */
+        Config_t(unsigned int ttl = 60000,
+                 std::size_t maxEntries = 1024,
+                 std::size_t maxSize = 16 * 1024 * 1024)
+            : ttl(ttl), maxEntries(maxEntries), maxSize(maxSize)
+        {}
+
+        unsigned int ttl;
+        std::size_t maxEntries;
+        std::size_t maxSize;
+    };
+
+    class Entry_t;
+    using EntryPtr_t = std::shared_ptr<const Entry_t>;
+
+    /**
+    @brief Constructor
+    @param config cache configuration
+    */
+    explicit ResponseCache_t(const Config_t &config);
+
+    ~ResponseCache_t();
+
+    /**
+    @brief Look up cached result for given parameters
+    @param params method call parameters
+    @return cached entry or empty pointer if there is no (unexpired) entry
+    */
+    EntryPtr_t find(const Array_t &params);
+
+    /**
+    @brief Insert copy of the method call result into the cache
+    @param params method call parameters
+    @param result method call result
+    @return inserted entry or empty pointer if the values are not cacheable
+    */
+    EntryPtr_t insert(const Array_t &params, const Value_t &result);
+
+    /**
+    @brief Write marshalled response of the entry to the writer
+
+    The response is marshalled only once for each output type and protocol
+    version, following calls write the stored bytes.
+
+    @param entry cache entry obtained by find() or insert()
+    @param writer response writer (it is flushed)
+    @param typeOut Marshaller_t type of response
+    @param protocolVersion version of the binary protocol
+    */
+    void write(const Entry_t &entry, Writer_t &writer, unsigned int typeOut,
+               const ProtocolVersion_t &protocolVersion);
+
+    /**
+    @brief Drop all cached entries
+    */
+    void clear();
+
+    /**
+    @brief Number of cached entries
+    */
+    std::size_t size() const;
+
+    /**
+    @brief Cache entry: private copy of call parameters and call result
+    */
+    class FRPC_DLLEXPORT Entry_t {
+    public:
+        const Array_t &params() const { return *paramsCopy;}
+        const Value_t &result() const { return *resultCopy;}
+
+    private:
+        friend class ResponseCache_t;
+        using Response_t = std::shared_ptr<const std::string>;
+
+        Entry_t(): paramsCopy(nullptr), resultCopy(nullptr), expires(0),
+                   size(0), cached(false)
+        {}
+
+        Pool_t pool;
+        const Array_t *paramsCopy;
+        const Value_t *resultCopy;
+        uint64_t expires;
+        std::size_t size;
+        bool cached;
+        std::map<uint32_t, Response_t> responses;
+        std::list<std::shared_ptr<Entry_t>>::iterator lru;
+    };
+
+private:
+    using Lru_t = std::list<std::shared_ptr<Entry_t>>;
+    using Index_t = std::unordered_map<const Array_t *, Lru_t::iterator,
+                                       ValueHash_t, ValueEqual_t>;
+
+    ResponseCache_t(const ResponseCache_t &);
+    ResponseCache_t &operator=(const ResponseCache_t &);
+
+    void erase(Entry_t &entry);
+    void evict(const Entry_t *keep);
+
+    Config_t config;
+    mutable std::mutex mutex;
+    Lru_t lru;
+    Index_t index;
+    std::size_t totalSize;
+};
+
+} // namespace FRPC
+
+#endif
@@ -53,7 +53,7 @@
 namespace FRPC {
 namespace {
 
-inline unsigned int chooseType(unsigned int type) {
+inline unsigned int chooseType(unsigned int type, bool compactXml) {
     switch(type) {
     case Server_t::BINARY_RPC:
         return Marshaller_t::BINARY_RPC;
@@ -63,7 +63,7 @@ inline unsigned int chooseType(unsigned int type) {
         return Marshaller_t::BASE64_RPC;
     case Server_t::XML_RPC:
     default:
-        return Marshaller_t::XML_RPC;
+        return compactXml? Marshaller_t::XML_RPC_COMPACT: Marshaller_t::XML_RPC;
     }
 }
 
@@ -122,7 +122,7 @@ void Server_t::serve(int fd,
 
         } catch(const StreamError_t &streamError) {
             std::unique_ptr<Marshaller_t>
-                marshaller(Marshaller_t::create(chooseType(outType),
+                marshaller(Marshaller_t::create(chooseType(outType, compactXml),
                                                 *this,
                                                 ProtocolVersion_t()));
 
@@ -164,7 +164,7 @@ void Server_t::serve(int fd,
                                            builder.getUnMarshaledMethodName(),
                                            Array(builder.getUnMarshaledData()),
                                            *this,
-                                           chooseType(outType),
+                                           chooseType(outType, compactXml),
                                            protocolVersion);
             }
         } catch(const HTTPError_t &httpError) {
@@ -191,6 +191,8 @@ void Server_t::readRequest(DataBuilder_t &builder,
     contentLength = 0;
     headersSent = false;
     head = false;
+    responseEncoding = ENCODING_IDENTITY;
+    compressor.reset();
     queryStorage.clear();
     queryStorage.push_back(std::string());
     queryStorage.back().reserve(BUFFER_SIZE + HTTP_BALLAST);
@@ -289,6 +291,31 @@ void Server_t::readRequest(DataBuilder_t &builder,
             }
         }
 
+        // what content-codings are accepted by client
+        std::string acceptEncoding;
+        if (useCompression
+            && (headerIn.get(HTTP_HEADER_ACCEPT_ENCODING, acceptEncoding) == 0))
+        {
+            responseEncoding
+                = chooseContentEncoding(parseAcceptEncoding(acceptEncoding));
+        }
+
+        // is request compressed?
+        std::unique_ptr<Decompressor_t> decompressor;
+        std::string contentEncoding;
+        if (headerIn.get(HTTP_HEADER_CONTENT_ENCODING, contentEncoding) == 0) {
+            int encoding = parseContentEncoding(contentEncoding);
+            if (encoding < 0) {
+                throw HTTPError_t(HTTP_UNSUPPORTED_MEDIA_TYPE,
+                                  "Unsupported Content-Encoding");
+            }
+            if (encoding != ENCODING_IDENTITY) {
+                decompressor.reset(new Decompressor_t(
+                        static_cast<unsigned int>(encoding),
+                        decompressedSizeLimit(io.getBodySizeLimit())));
+            }
+        }
+
         // what type is request
         if (contentType.find("application/x-frpc") != std::string::npos) {
             unmarshaller = std::unique_ptr<UnMarshaller_t>(
@@ -319,14 +346,23 @@ void Server_t::readRequest(DataBuilder_t &builder,
                             UnMarshaller_t::BASE64,
                             builder));
 
+        } else if (contentType.find("application/json") != std::string::npos) {
+            unmarshaller = std::unique_ptr<UnMarshaller_t>(
+                    UnMarshaller_t::create(
+                            UnMarshaller_t::JSON,
+                            builder,
+                            uriPath));
+
         } else {
             throw StreamError_t("Unknown ContentType");
         }
 
-        DataSink_t data(*unmarshaller, UnMarshaller_t::TYPE_METHOD_CALL);
+        DataSink_t data(*unmarshaller, UnMarshaller_t::TYPE_METHOD_CALL,
+                        decompressor.get());
 
         // read body of request
         io.readContent(headerIn, data, true);
+        if (decompressor) decompressor->finish();
 
         unmarshaller->finish();
         protocolVersion = unmarshaller->getProtocolVersion();
@@ -385,6 +421,7 @@ void Server_t::sendHttpError(const HTTPError_t &httpError) {
     if (useBinary)
         os.os << ", application/x-frpc";
     os.os << ", application/x-www-form-urlencoded";
+    os.os << ", application/json";
     os.os << "\r\n";
     os.os << "Server:" << " Fast-RPC  Server Linux\r\n";
 
@@ -396,6 +433,24 @@ void Server_t::sendHttpError(const HTTPError_t &httpError) {
 }
 
 void Server_t::sendResponse(bool last) {
+    // compress body when it is big enough or when it is sent in chunks
+    // (then it is bigger than the chunk); small bodies are sent as is
+    if (!headersSent && !compressor && !head && responseEncoding
+        && ((contentLength >= compressionThreshold) || (useChunks && !last)))
+    {
+        compressor.reset(new Compressor_t(responseEncoding));
+    }
+
+    if (compressor) {
+        std::size_t size = compressor->compress(queryStorage, last || !useChunks);
+        if (!useChunks) {
+            contentLength = static_cast<unsigned int>(size);
+        } else if (!size && !last) {
+            // compressor buffered the data, empty chunk would end the body
+            return;
+        }
+    }
+
     std::string headerData;
     if(!headersSent) {
         StreamHolder_t os;
@@ -446,7 +501,17 @@ void Server_t::sendResponse(bool last) {
             os.os << ", application/x-frpc";
         os.os << ", application/x-www-form-urlencoded";
         os.os << ", application/x-base64-frpc";
+        os.os << ", application/json";
         os.os << "\r\n";
+        os.os << HTTP_HEADER_ACCEPT_ENCODING << ": " << ACCEPT_ENCODINGS
+              << "\r\n";
+        os.os << HTTP_HEADER_X_FASTRPC_PROTOCOL << ": " << FRPC_MAJOR_VERSION
+              << '.' << FRPC_MINOR_VERSION << "\r\n";
+
+        if (compressor) {
+            os.os << HTTP_HEADER_CONTENT_ENCODING << ": "
+                  << contentEncodingName(compressor->encoding()) << "\r\n";
+        }
 
         //append connection header
         os.os << HTTP_HEADER_CONNECTION
@@ -519,9 +584,11 @@ void Server_t::sendResponse(bool last) {
             queryStorage.front().insert(0,headerData);
             headersSent = true;
         }
+        // header shares packet with the body, full buffers are sent with
+        // MSG_MORE so that their tails join the next buffer
         while(queryStorage.size() != 1) {
             io.sendData(queryStorage.front().data(),
-                        queryStorage.front().size() );
+                        queryStorage.front().size(), false, true);
             queryStorage.pop_front();
         }
         io.sendData(queryStorage.back().data(),queryStorage.back().size() );
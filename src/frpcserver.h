@@ -41,8 +41,10 @@
 #include <frpcwriter.h>
 #include <frpc.h>
 #include <frpchttperror.h>
+#include <frpccompression.h>
 
 #include <list>
+#include <memory>
 #include <string>
 
 namespace FRPC {
@@ -81,7 +83,9 @@ public:
             : readTimeout(readTimeout), writeTimeout(writeTimeout),
               keepAlive(keepAlive), useBinary(true),
               maxKeepalive(maxKeepalive),
-              introspectionEnabled(introspectionEnabled), callbacks(callbacks)
+              introspectionEnabled(introspectionEnabled), callbacks(callbacks),
+              useCompression(false), compressionThreshold(1024),
+              compactXml(false)
                 //,path(path)
         {}
 
@@ -106,7 +110,9 @@ public:
             : readTimeout(readTimeout), writeTimeout(writeTimeout),
               keepAlive(keepAlive), useBinary(useBinary),
               maxKeepalive(maxKeepalive),
-              introspectionEnabled(introspectionEnabled), callbacks(callbacks)
+              introspectionEnabled(introspectionEnabled), callbacks(callbacks),
+              useCompression(false), compressionThreshold(1024),
+              compactXml(false)
                 //,path(path)
         {}
         /**
@@ -121,12 +127,16 @@ public:
             @n @b maxKeepalive = 0
             @n @b introspectionEnabled = true
             @n @b callbacks = 0
+            @n @b useCompression = false
+            @n @b compressionThreshold = 1024
+            @n @b compactXml = false
 
         */
         Config_t()
             : readTimeout(10000), writeTimeout(1000), keepAlive(false),
               useBinary(true), maxKeepalive(0), introspectionEnabled(true),
-              callbacks(nullptr)
+              callbacks(nullptr), useCompression(false),
+              compressionThreshold(1024), compactXml(false)
         {}
 
         ///@brief internal representation of readTimeout value
@@ -144,6 +154,12 @@ public:
         bool introspectionEnabled;
 
         MethodRegistry_t::Callbacks_t *callbacks;
+        ///@brief compress responses when client accepts it (Accept-Encoding)
+        bool useCompression;
+        ///@brief responses smaller than threshold are not compressed
+        unsigned int compressionThreshold;
+        ///@brief XML-RPC responses without whitespace between tags
+        bool compactXml;
     };
 
     Server_t(Config_t &config)
@@ -153,7 +169,10 @@ public:
           maxKeepalive(config.maxKeepalive), callbacks(config.callbacks),
           /*path(config.path), */outType(XML_RPC), closeConnection(true),
           contentLength(0), useChunks(false),
-          headersSent(false), head(false), headerOut(nullptr)
+          headersSent(false), head(false), headerOut(nullptr),
+          useCompression(config.useCompression),
+          compressionThreshold(config.compressionThreshold),
+          responseEncoding(ENCODING_IDENTITY), compactXml(config.compactXml)
     {}
 
     void serve(int fd, struct sockaddr_in* addr = nullptr);
@@ -218,6 +237,11 @@ private:
     bool head;
     ProtocolVersion_t protocolVersion;
     HTTPHeader_t *headerOut;
+    bool useCompression;                    //!< allow response compression
+    unsigned int compressionThreshold;
+    unsigned int responseEncoding;          //!< coding accepted by client
+    std::unique_ptr<Compressor_t> compressor;
+    bool compactXml;                        //!< compact XML-RPC responses
 };
 
 } // namespace FRPC
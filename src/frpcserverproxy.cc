@@ -31,33 +31,65 @@
  *
  */
 
+#include "nonglibc.h"
+
 #include <sstream>
 #include <cstdarg>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <set>
+#include <limits>
 
 
 #include "frpcconnector.h"
 #include "frpchttp.h"
+#include "frpcsocket.h"
 #include "frpcserverproxy.h"
 #include <frpc.h>
 #include <frpctreebuilder.h>
 #include <frpctreefeeder.h>
 #include <frpcfault.h>
 #include <frpcresponseerror.h>
+#include <frpcprotocolerror.h>
+#include <frpctypeerror.h>
 #include "frpcinternals.h"
 
 #include <frpcstruct.h>
 #include <frpcstring.h>
 #include <frpcint.h>
 #include <frpcbool.h>
+#include <frpcarray.h>
 
 namespace FRPC {
 namespace {
 
 FRPC::Pool_t localPool;
 
+unsigned int getUnsigned(const FRPC::Struct_t &config,
+                         const std::string &name, unsigned int defaultValue,
+                         unsigned int maxValue
+                         = std::numeric_limits<unsigned int>::max())
+{
+    const FRPC::Value_t *val(config.get(name));
+    if (!val) return defaultValue;
+
+    // counts and enums must not wrap around
+    FRPC::Int_t::value_type value = FRPC::Int(*val);
+    if ((value < 0) || (value > maxValue)) {
+        throw FRPC::TypeError_t::format(
+                "Config option %s = %lld is out of range 0..%u.",
+                name.c_str(), static_cast<long long>(value), maxValue);
+    }
+    return static_cast<unsigned int>(value);
+}
+
 int getTimeout(const FRPC::Struct_t &config, const std::string &name,
                int defaultValue)
 {
@@ -69,6 +101,19 @@ int getTimeout(const FRPC::Struct_t &config, const std::string &name,
     return static_cast<int>(FRPC::Int(*val));
 }
 
+std::set<std::string> getMethods(const FRPC::Struct_t &config,
+                                 const std::string &name)
+{
+    std::set<std::string> methods;
+    const FRPC::Value_t *val(config.get(name));
+    if (!val) return methods;
+
+    for (const FRPC::Value_t *method: FRPC::Array(*val)) {
+        methods.insert(FRPC::String(*method).getString());
+    }
+    return methods;
+}
+
 FRPC::ProtocolVersion_t parseProtocolVersion(const FRPC::Struct_t &config,
                                              const std::string &name)
 {
@@ -97,6 +142,21 @@ FRPC::ServerProxy_t::Config_t configFromStruct(const FRPC::Struct_t &s) {
     config.protocolVersion = parseProtocolVersion(s, "protocolVersion");
     config.connectTimeout = getTimeout(s, "connectTimeout", 10000);
     config.keepAlive = FRPC::Bool(s.get("keepAlive", FRPC::Bool_t::FRPC_FALSE));
+    config.useCompression = FRPC::Bool(s.get("useCompression", FRPC::Bool_t::FRPC_FALSE));
+    config.compressionThreshold = getUnsigned(s, "compressionThreshold", 1024);
+    config.compactXml = FRPC::Bool(s.get("compactXml", FRPC::Bool_t::FRPC_FALSE));
+    config.threadSafe = FRPC::Bool(s.get("threadSafe", FRPC::Bool_t::FRPC_FALSE));
+    config.connectAttemptDelay = getTimeout(s, "connectAttemptDelay", 0);
+    config.balancePolicy = getUnsigned(
+        s, "balancePolicy", FRPC::ServerProxy_t::Config_t::ROUND_ROBIN,
+        FRPC::ServerProxy_t::Config_t::POWER_OF_TWO_CHOICES);
+    config.ejectFailures = getUnsigned(s, "ejectFailures", 3);
+    config.ejectTime = getUnsigned(s, "ejectTime", 10000);
+    config.idempotentMethods = getMethods(s, "idempotentMethods");
+    config.hedgedMethods = getMethods(s, "hedgedMethods");
+    config.maxRetries = getUnsigned(s, "maxRetries", 1);
+    config.retryBudgetPercent = getUnsigned(s, "retryBudgetPercent", 10);
+    config.retryBudgetBurst = getUnsigned(s, "retryBudgetBurst", 10);
 
     return config;
 }
@@ -104,12 +164,17 @@ FRPC::ServerProxy_t::Config_t configFromStruct(const FRPC::Struct_t &s) {
 FRPC::Connector_t* makeConnector(
     const FRPC::URL_t &url,
     const unsigned &connectTimeout,
-    const bool &keepAlive)
+    const bool &keepAlive,
+    const unsigned &connectAttemptDelay)
 {
     if (url.isUnix()) {
         return new FRPC::SimpleConnectorUnix_t(
            url, connectTimeout, keepAlive);
     }
+    if (connectAttemptDelay) {
+        return new FRPC::ParallelConnector_t(
+           url, connectTimeout, keepAlive, connectAttemptDelay);
+    }
     return new FRPC::SimpleConnectorIPv6_t(url, connectTimeout, keepAlive);
 }
 
@@ -117,61 +182,204 @@ FRPC::Connector_t* makeConnector(
 
 class ServerProxyImpl_t {
 public:
-    ServerProxyImpl_t(URL_t url,
+    ServerProxyImpl_t(const std::vector<URL_t> &urls,
                       const ServerProxy_t::Config_t &config)
-        : url(std::move(url)),
-          io(-1, config.readTimeout, config.writeTimeout, -1 ,-1),
+        : io(-1, config.readTimeout, config.writeTimeout, -1 ,-1),
+          readTimeout(config.readTimeout),
+          writeTimeout(config.writeTimeout),
           rpcTransferMode(config.useBinary),
           useHTTP10(config.useHTTP10),
-          serverSupportedProtocols(HTTPClient_t::XML_RPC),
-          protocolVersion(config.protocolVersion),
-          connector(makeConnector(this->url, config.connectTimeout,
-                                             config.keepAlive))
-    {}
+          keepAlive(config.keepAlive),
+          connectTimeout(config.connectTimeout),
+          connectAttemptDelay(config.connectAttemptDelay),
+          useCompression(config.useCompression),
+          compressionThreshold(config.compressionThreshold),
+          xmlType(config.compactXml
+                  ? Marshaller_t::XML_RPC_COMPACT
+                  : Marshaller_t::XML_RPC),
+          balancePolicy(config.balancePolicy),
+          ejectFailures(config.ejectFailures),
+          ejectTime(std::chrono::milliseconds(config.ejectTime)),
+          nextEndpoint(0),
+          maxRetries(0),
+          threadSafe(false)
+    {
+        if (urls.empty()) throw TypeError_t("No server URL given.");
+        for (const URL_t &url: urls)
+            endpoints.emplace_back(new Endpoint_t(url, config));
+        setThreadSafe(config.threadSafe);
+        setCallPolicy(config);
+    }
 
     /** Set new read timeout */
     void setReadTimeout(int timeout) {
         io.setReadTimeout(timeout);
+        readTimeout = timeout;
     }
 
     /** Set new write timeout */
     void setWriteTimeout(int timeout) {
         io.setWriteTimeout(timeout);
+        writeTimeout = timeout;
     }
 
     /** Set new connect timeout */
     void setConnectTimeout(int timeout) {
-        connector->setTimeout(timeout);
+        for (auto &endpoint: endpoints)
+            endpoint->connector->setTimeout(timeout);
+        connectTimeout = timeout;
+    }
+
+    /** Set new delay between parallel connect attempts */
+    void setConnectAttemptDelay(unsigned int delay) {
+        if (delay == connectAttemptDelay) return;
+        for (auto &endpoint: endpoints) {
+            endpoint->connector.reset(makeConnector(
+                    endpoint->url, connectTimeout, keepAlive, delay));
+        }
+        connectAttemptDelay = delay;
     }
 
     void setRpcTransferMode(unsigned int v) {
         rpcTransferMode = v;
     }
 
+    void setCompactXml(bool v) {
+        xmlType = v ? Marshaller_t::XML_RPC_COMPACT : Marshaller_t::XML_RPC;
+    }
+
     void setUseHTTP10(bool v) {
         useHTTP10 = v;
     }
 
+    void setUseCompression(bool v) {
+        useCompression = v;
+    }
+
+    void setCompressionThreshold(unsigned int v) {
+        compressionThreshold = v;
+    }
+
     void setProtocolVersion(ProtocolVersion_t v) {
-        protocolVersion = v;
+        for (auto &endpoint: endpoints)
+            endpoint->server.protocolVersion = v;
+    }
+
+    /** Calls from more threads at once are allowed in thread safe mode,
+     * each of them uses a connection of its own.
+     */
+    void setThreadSafe(bool v) {
+        threadSafe = v;
+        int &fd = io.socket();
+        if (pooledSockets() && (fd > -1)) {
+            endpoints.front()->idleSockets.push_back(fd);
+            fd = -1;
+        }
     }
 
+    /** URL of the (first) server.
+     */
     const URL_t& getURL() {
-        return url;
+        return endpoints.front()->url;
+    }
+
+    /** Only single server proxies with keep alive connections are kept in
+     * ProxyCache_t.
+     */
+    bool isCacheable() const {
+        return keepAlive && (endpoints.size() == 1);
+    }
+
+    /** Server properties learnt from the responses.
+     */
+    struct ServerState_t {
+        explicit ServerState_t(ProtocolVersion_t protocolVersion)
+            : supportedProtocols(HTTPClient_t::XML_RPC),
+              supportedEncodings(ENCODING_IDENTITY),
+              protocolVersion(protocolVersion),
+              serverProtocolVersion(0, 0)
+        {}
+
+        unsigned int supportedProtocols;
+        unsigned int supportedEncodings;
+        ProtocolVersion_t protocolVersion;
+        ProtocolVersion_t serverProtocolVersion;
+    };
+
+    /** Server the calls are sent to: its connector, properties learnt from
+     * its responses, idle connections and statistics of the balancer.
+     */
+    struct Endpoint_t {
+        Endpoint_t(const URL_t &url, const ServerProxy_t::Config_t &config)
+            : url(url),
+              server(config.protocolVersion),
+              connector(makeConnector(this->url, config.connectTimeout,
+                                      config.keepAlive,
+                                      config.connectAttemptDelay)),
+              outstanding(0), latency(0), failures(0), ejectedUntil(0)
+        {}
+
+        ~Endpoint_t() {
+            for (int fd: idleSockets)
+                TEMP_FAILURE_RETRY(::close(fd));
+        }
+
+        int takeSocket();
+        void keepSocket(HTTPIO_t &io, bool keepAlive);
+
+        URL_t url;
+        ServerState_t server;           //!< guarded by proxy mutex
+        std::unique_ptr<Connector_t> connector;
+        std::mutex socketMutex;
+        std::vector<int> idleSockets;   //!< kept alive connections
+
+        std::atomic<unsigned int> outstanding;  //!< running calls
+        std::atomic<std::int64_t> latency;      //!< average call [us]
+        std::atomic<unsigned int> failures;     //!< consecutive failures
+        std::atomic<std::int64_t> ejectedUntil; //!< steady clock ticks
+    };
+
+    /** Protocol version of the next request. The key dictionary (protocol
+     * 3.2) and packed arrays (protocol 3.3) are used only when the server
+     * has announced their support.
+     */
+    static ProtocolVersion_t
+    requestProtocolVersion(const ServerState_t &server) {
+        if (hasKeyDictionary(server.protocolVersion)
+            && !hasKeyDictionary(server.serverProtocolVersion))
+            return ProtocolVersion_t(3, 1);
+        if (hasPackedArrays(server.protocolVersion)
+            && !hasPackedArrays(server.serverProtocolVersion))
+            return ProtocolVersion_t(3, 2);
+        return server.protocolVersion;
     }
 
     /** Create marshaller.
      */
-    Marshaller_t* createMarshaller(HTTPClient_t &client);
+    Marshaller_t* createMarshaller(HTTPClient_t &client,
+                                   const ServerState_t &server,
+                                   bool connected);
+
+    /** Chooses the server for the next call by the balance policy, the
+     * ejected servers are skipped unless all of them are ejected. The
+     * excluded server is chosen only when it is the only one.
+     */
+    Endpoint_t& pickEndpoint(const Endpoint_t *exclude = nullptr);
 
-    void call(DataBuilder_t &builder,
+    /** Sets retried and hedged methods and the retry budget.
+     */
+    void setCallPolicy(const ServerProxy_t::Config_t &config);
+
+    void call(Endpoint_t &endpoint,
+              DataBuilder_t &builder,
               const std::string &methodName,
               const Array_t &params,
               HTTPHeader_t &responseHeaders);
 
     /** Call method with variable number of arguments.
      */
-    Value_t& call(Pool_t &pool,
+    Value_t& call(Endpoint_t &endpoint,
+                  Pool_t &pool,
                   const char *methodName,
                   va_list args,
                   HTTPHeader_t &responseHeaders);
@@ -184,34 +392,144 @@ public:
 
     void deleteRequestHttpHeaders();
 
-    const Connector_t& getConnector() const { return *connector; }
-
 private:
-    URL_t url;
+    class Attempt_t;
+
+    /** Token bucket limiting retries and hedged calls.
+     */
+    class RetryBudget_t {
+    public:
+        RetryBudget_t() : deposit(0), capacity(0), tokens(0) {}
+
+        void configure(unsigned int percent, unsigned int burst);
+
+        /** Adds tokens for the call */
+        void addCall();
+
+        /** Takes one token if there is any */
+        bool take();
+
+    private:
+        std::int64_t deposit;
+        std::int64_t capacity;
+        std::atomic<std::int64_t> tokens;
+    };
+
+    /** Recent call durations of the method.
+     */
+    struct MethodLatency_t {
+        MethodLatency_t() : next(0), added(0), hedgeDelay(0) {}
+
+        void add(std::int64_t duration);
+
+        static const std::size_t WINDOW = 128;
+        std::vector<std::int64_t> samples;  //!< durations [us]
+        std::size_t next;
+        std::size_t added;
+        int hedgeDelay;                     //!< 95th percentile [ms]
+    };
+
+    /** Runs the call, feed marshalls the parameters by given feeder. Calls
+     * of idempotent methods are retried, calls of hedged methods are
+     * hedged.
+     */
+    template <typename Feed_t>
+    void call(Endpoint_t &endpoint, DataBuilder_t &builder,
+              const char *methodName, const Feed_t &feed,
+              HTTPHeader_t &responseHeaders, const Array_t *params);
+
+    /** Sends the call to the server and to another one when the response
+     * does not arrive within usual time of the method.
+     */
+    template <typename Feed_t>
+    void callHedged(Endpoint_t &endpoint, DataBuilder_t &builder,
+                    const char *methodName, const Feed_t &feed,
+                    const HTTPClient_t::HeaderVector_t &headers,
+                    HTTPHeader_t &responseHeaders, const Array_t *params);
+
+    int hedgeDelay(const std::string &methodName);
+    void addLatency(const std::string &methodName,
+                    std::chrono::steady_clock::duration duration);
+
+    /** Copy of the server state to prepare a request.
+     */
+    ServerState_t serverState(const Endpoint_t &endpoint);
+
+    /** Remembers server properties learnt from the response.
+     */
+    void updateServerState(Endpoint_t &endpoint, HTTPClient_t &client);
+
+    /** Moves the headers for call of the calling thread to headers.
+     */
+    void takeRequestHttpHeadersForCall(HTTPClient_t::HeaderVector_t &headers);
+
+    /** Updates statistics of the server after the call.
+     */
+    void finishCall(Endpoint_t &endpoint,
+                    std::chrono::steady_clock::time_point start,
+                    bool succeeded);
+
+    /** Connections are kept per server (instead of the single io) in
+     * thread safe mode and when there are more servers.
+     */
+    bool pooledSockets() const {
+        return threadSafe || (endpoints.size() > 1);
+    }
+
     HTTPIO_t io;
+    int readTimeout;
+    int writeTimeout;
     unsigned int rpcTransferMode;
     bool useHTTP10;
-    unsigned int serverSupportedProtocols;
-    ProtocolVersion_t protocolVersion;
-    std::unique_ptr<Connector_t> connector;
+    bool keepAlive;
+    unsigned int connectTimeout;
+    unsigned int connectAttemptDelay;
     HTTPClient_t::HeaderVector_t requestHttpHeadersForCall;
     HTTPClient_t::HeaderVector_t requestHttpHeaders;
+    bool useCompression;
+    unsigned int compressionThreshold;
+    unsigned int xmlType;               //!< Marshaller_t type of XML-RPC
+
+    // balancing
+    std::vector<std::unique_ptr<Endpoint_t>> endpoints;
+    unsigned int balancePolicy;
+    unsigned int ejectFailures;
+    std::chrono::steady_clock::duration ejectTime;
+    std::atomic<std::size_t> nextEndpoint;
+
+    // retries and hedging
+    std::set<std::string> idempotentMethods;
+    std::set<std::string> hedgedMethods;
+    unsigned int maxRetries;
+    RetryBudget_t retryBudget;
+    std::mutex latencyMutex;
+    std::map<std::string, MethodLatency_t> methodLatency;
+
+    // thread safe mode
+    bool threadSafe;
+    std::mutex mutex;                   //!< guards server state and headers
+    std::map<std::thread::id, HTTPClient_t::HeaderVector_t>
+        threadRequestHttpHeadersForCall;
 };
 
-Marshaller_t* ServerProxyImpl_t::createMarshaller(HTTPClient_t &client) {
+Marshaller_t* ServerProxyImpl_t::createMarshaller(HTTPClient_t &client,
+                                                  const ServerState_t &server,
+                                                  bool connected)
+{
     Marshaller_t *marshaller;
+    ProtocolVersion_t version(requestProtocolVersion(server));
     switch (rpcTransferMode) {
     case ServerProxy_t::Config_t::ON_SUPPORT:
         {
-            if (serverSupportedProtocols & HTTPClient_t::BINARY_RPC) {
+            if (server.supportedProtocols & HTTPClient_t::BINARY_RPC) {
                 //using BINARY_RPC
                 marshaller= Marshaller_t::create(Marshaller_t::BINARY_RPC,
-                                                 client, protocolVersion);
+                                                 client, version);
                 client.prepare(HTTPClient_t::BINARY_RPC);
             } else {
                 //using XML_RPC
                 marshaller = Marshaller_t::create
-                    (Marshaller_t::XML_RPC,client, protocolVersion);
+                    (xmlType,client, version);
                 client.prepare(HTTPClient_t::XML_RPC);
             }
         }
@@ -220,8 +538,8 @@ Marshaller_t* ServerProxyImpl_t::createMarshaller(HTTPClient_t &client) {
     case ServerProxy_t::Config_t::NEVER:
         {
             // never using BINARY_RPC
-            marshaller= Marshaller_t::create(Marshaller_t::XML_RPC,
-                                             client,protocolVersion);
+            marshaller= Marshaller_t::create(xmlType,
+                                             client, version);
             client.prepare(HTTPClient_t::XML_RPC);
         }
     break;
@@ -230,7 +548,7 @@ Marshaller_t* ServerProxyImpl_t::createMarshaller(HTTPClient_t &client) {
         {
             //using BINARY_RPC  always
             marshaller= Marshaller_t::create(Marshaller_t::BINARY_RPC,
-                                             client,protocolVersion);
+                                             client, version);
             client.prepare(HTTPClient_t::BINARY_RPC);
         }
     break;
@@ -238,17 +556,17 @@ Marshaller_t* ServerProxyImpl_t::createMarshaller(HTTPClient_t &client) {
     case ServerProxy_t::Config_t::ON_SUPPORT_ON_KEEP_ALIVE:
     default:
         {
-            if ((serverSupportedProtocols & HTTPClient_t::XML_RPC)
-                || !connector->getKeepAlive()
-                || io.socket() != -1) {
+            if ((server.supportedProtocols & HTTPClient_t::XML_RPC)
+                || !keepAlive
+                || connected) {
                 //using XML_RPC
                 marshaller= Marshaller_t::create
-                    (Marshaller_t::XML_RPC,client, protocolVersion);
+                    (xmlType,client, version);
                 client.prepare(HTTPClient_t::XML_RPC);
             } else {
                 //using BINARY_RPC
                 marshaller= Marshaller_t::create
-                    (Marshaller_t::BINARY_RPC, client,protocolVersion);
+                    (Marshaller_t::BINARY_RPC, client, version);
                 client.prepare(HTTPClient_t::BINARY_RPC);
             }
         }
@@ -423,9 +741,15 @@ public:
         impl->setReadTimeout(config.readTimeout);
         impl->setWriteTimeout(config.writeTimeout);
         impl->setRpcTransferMode(config.useBinary);
+        impl->setCompactXml(config.compactXml);
         impl->setUseHTTP10(config.useHTTP10);
+        impl->setUseCompression(config.useCompression);
+        impl->setCompressionThreshold(config.compressionThreshold);
         impl->setProtocolVersion(config.protocolVersion);
         impl->setConnectTimeout(config.connectTimeout);
+        impl->setConnectAttemptDelay(config.connectAttemptDelay);
+        impl->setThreadSafe(config.threadSafe);
+        impl->setCallPolicy(config);
 
         return impl;
     }
@@ -462,7 +786,18 @@ static ServerProxyImpl_t* createImpl(const std::string &server, const ServerProx
         }
     }
 
-    return new ServerProxyImpl_t(std::move(url), config);
+    return new ServerProxyImpl_t(std::vector<URL_t>(1, url), config);
+}
+
+static ServerProxyImpl_t* createImpl(const std::vector<std::string> &servers,
+                                     const ServerProxy_t::Config_t &config)
+{
+    if (servers.size() == 1) return createImpl(servers.front(), config);
+
+    std::vector<URL_t> urls;
+    for (const std::string &server: servers)
+        urls.emplace_back(server, config.proxyUrl);
+    return new ServerProxyImpl_t(urls, config);
 }
 
 ServerProxy_t::ServerProxy_t(const std::string &server, const Config_t &config)
@@ -473,80 +808,549 @@ ServerProxy_t::ServerProxy_t(const std::string &server, const Struct_t &config)
     : sp(createImpl(server, configFromStruct(config)))
 {}
 
+ServerProxy_t::ServerProxy_t(const std::vector<std::string> &servers,
+                             const Config_t &config)
+    : sp(createImpl(servers, config))
+{}
+
+ServerProxy_t::ServerProxy_t(const std::vector<std::string> &servers,
+                             const Struct_t &config)
+    : sp(createImpl(servers, configFromStruct(config)))
+{}
+
 ServerProxy_t::~ServerProxy_t() {
     // get rid of implementation
-    if (sp->getConnector().getKeepAlive()) {
+    if (sp->isCacheable()) {
         ProxyCache_t::instance()->move_into(sp);
     }
 }
 
+ServerProxyImpl_t::Endpoint_t&
+ServerProxyImpl_t::pickEndpoint(const Endpoint_t *exclude) {
+    std::size_t count = endpoints.size();
+    if (count == 1) return *endpoints.front();
+
+    // servers which are not ejected in round-robin order
+    std::int64_t now = std::chrono::steady_clock::now()
+        .time_since_epoch().count();
+    std::size_t start = nextEndpoint.fetch_add(1, std::memory_order_relaxed);
+    std::vector<Endpoint_t*> healthy;
+    healthy.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        Endpoint_t *endpoint = endpoints[(start + i) % count].get();
+        if ((endpoint != exclude)
+            && (endpoint->ejectedUntil.load(std::memory_order_relaxed)
+                <= now))
+            healthy.push_back(endpoint);
+    }
+    if (healthy.empty()) {
+        Endpoint_t *endpoint = endpoints[start % count].get();
+        return (endpoint != exclude)
+            ? *endpoint : *endpoints[(start + 1) % count];
+    }
+
+    switch (balancePolicy) {
+    case ServerProxy_t::Config_t::LEAST_OUTSTANDING:
+        {
+            Endpoint_t *best = healthy.front();
+            for (Endpoint_t *endpoint: healthy) {
+                if (endpoint->outstanding.load(std::memory_order_relaxed)
+                    < best->outstanding.load(std::memory_order_relaxed))
+                    best = endpoint;
+            }
+            return *best;
+        }
+
+    case ServerProxy_t::Config_t::POWER_OF_TWO_CHOICES:
+        {
+            if (healthy.size() == 1) return *healthy.front();
+
+            // two random servers, the one with lower expected wait wins
+            static thread_local std::minstd_rand random(
+                    std::random_device{}());
+            std::size_t a = random() % healthy.size();
+            std::size_t b = random() % (healthy.size() - 1);
+            if (b >= a) ++b;
+            auto cost = [] (const Endpoint_t &endpoint) {
+                return (endpoint.latency.load(std::memory_order_relaxed) + 1)
+                    * (endpoint.outstanding.load(std::memory_order_relaxed)
+                       + 1);
+            };
+            return (cost(*healthy[b]) < cost(*healthy[a]))
+                ? *healthy[b] : *healthy[a];
+        }
+
+    case ServerProxy_t::Config_t::ROUND_ROBIN:
+    default:
+        return *healthy.front();
+    }
+}
+
+void ServerProxyImpl_t::finishCall(Endpoint_t &endpoint,
+                                   std::chrono::steady_clock::time_point start,
+                                   bool succeeded)
+{
+    auto now = std::chrono::steady_clock::now();
+    endpoint.outstanding.fetch_sub(1, std::memory_order_relaxed);
+
+    if (succeeded) {
+        // exponentially weighted moving average with weight 1/8
+        std::int64_t elapsed = std::chrono::duration_cast<
+            std::chrono::microseconds>(now - start).count();
+        std::int64_t latency = endpoint.latency.load(
+                std::memory_order_relaxed);
+        endpoint.latency.store(latency ? latency + (elapsed - latency) / 8
+                                       : elapsed,
+                               std::memory_order_relaxed);
+        endpoint.failures.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    // passive health check: eject the server failing repeatedly
+    unsigned int failures = endpoint.failures.fetch_add(
+            1, std::memory_order_relaxed) + 1;
+    if (ejectFailures && (failures >= ejectFailures)) {
+        endpoint.ejectedUntil.store((now + ejectTime).time_since_epoch()
+                                    .count(), std::memory_order_relaxed);
+        endpoint.failures.store(0, std::memory_order_relaxed);
+    }
+}
+
+/** Single request sent to one server.
+ */
+class ServerProxyImpl_t::Attempt_t {
+public:
+    /** Prepares the request, pooled attempt uses connection of its own
+     *  instead of the proxy io.
+     */
+    Attempt_t(ServerProxyImpl_t &proxy, Endpoint_t &endpoint, bool pooled)
+        : endpoint(endpoint), proxy(proxy), pooled(pooled),
+          callIO(pooled ? endpoint.takeSocket() : -1,
+                 proxy.readTimeout, proxy.writeTimeout, -1, -1),
+          io(pooled ? callIO : proxy.io),
+          callServer(proxy.serverState(endpoint)),
+          client(io, endpoint.url, endpoint.connector.get(),
+                 proxy.useHTTP10),
+          start(std::chrono::steady_clock::now()),
+          finished(false)
+    {
+        endpoint.outstanding.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Attempt_t() {
+        // abandoned hedged request
+        if (!finished)
+            endpoint.outstanding.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /** Sends the request.
+     */
+    template <typename Feed_t>
+    void send(const char *methodName, const Feed_t &feed,
+              const HTTPClient_t::HeaderVector_t &headers)
+    {
+        try {
+            client.addCustomRequestHeader(headers);
+            if (proxy.useCompression) {
+                client.prepareCompression(callServer.supportedEncodings,
+                                          proxy.compressionThreshold);
+            }
+            std::unique_ptr<Marshaller_t>marshaller
+                (proxy.createMarshaller(client, callServer,
+                                        io.socket() != -1));
+            TreeFeeder_t feeder(*marshaller);
+
+            try {
+                marshaller->packMethodCall(methodName);
+                feed(feeder);
+                marshaller->flush();
+            } catch (const ResponseError_t &e) {}
+        } catch (...) {
+            finish(false);
+            throw;
+        }
+    }
+
+    /** Reads the response, faults are successful calls.
+     */
+    void read(DataBuilder_t &builder, HTTPHeader_t &responseHeaders) {
+        try {
+            client.readResponse(builder, responseHeaders);
+        } catch (const Fault_t &) {
+            finish(true);
+            throw;
+        } catch (...) {
+            finish(false);
+            throw;
+        }
+        proxy.updateServerState(endpoint, client);
+        if (pooled) endpoint.keepSocket(callIO, proxy.keepAlive);
+        finish(true);
+    }
+
+    /** Socket of the request (-1 when closed).
+     */
+    int socket() {
+        return io.socket();
+    }
+
+    Endpoint_t &endpoint;
+
+private:
+    void finish(bool succeeded) {
+        finished = true;
+        proxy.finishCall(endpoint, start, succeeded);
+    }
+
+    ServerProxyImpl_t &proxy;
+    bool pooled;
+    HTTPIO_t callIO;
+    HTTPIO_t &io;
+    ServerState_t callServer;
+    HTTPClient_t client;
+    std::chrono::steady_clock::time_point start;
+    bool finished;
+};
+
+ServerProxyImpl_t::ServerState_t
+ServerProxyImpl_t::serverState(const Endpoint_t &endpoint) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (threadSafe) lock.lock();
+    return endpoint.server;
+}
+
+void ServerProxyImpl_t::updateServerState(Endpoint_t &endpoint,
+                                          HTTPClient_t &client)
+{
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (threadSafe) lock.lock();
+    ServerState_t &server = endpoint.server;
+    server.supportedProtocols = client.getSupportedProtocols();
+    server.supportedEncodings = client.getSupportedEncodings();
+    server.serverProtocolVersion = client.getServerProtocolVersion();
+    // the requested protocol 3.2 and newer is kept, the response has lower
+    // version until the server announces the support
+    if (!hasKeyDictionary(server.protocolVersion))
+        server.protocolVersion = client.getProtocolVersion();
+}
+
+void ServerProxyImpl_t::setCallPolicy(const ServerProxy_t::Config_t &config) {
+    idempotentMethods = config.idempotentMethods;
+    hedgedMethods = config.hedgedMethods;
+    maxRetries = config.maxRetries;
+    retryBudget.configure(config.retryBudgetPercent,
+                          config.retryBudgetBurst);
+}
+
+void ServerProxyImpl_t::RetryBudget_t::configure(unsigned int percent,
+                                                 unsigned int burst)
+{
+    // tokens are kept in thousandths
+    deposit = std::int64_t(percent) * 10;
+    capacity = std::int64_t(burst) * 1000;
+    tokens.store(capacity, std::memory_order_relaxed);
+}
+
+void ServerProxyImpl_t::RetryBudget_t::addCall() {
+    std::int64_t current = tokens.load(std::memory_order_relaxed);
+    while ((current < capacity)
+           && !tokens.compare_exchange_weak(
+                   current, std::min(current + deposit, capacity),
+                   std::memory_order_relaxed))
+        ;
+}
+
+bool ServerProxyImpl_t::RetryBudget_t::take() {
+    std::int64_t current = tokens.load(std::memory_order_relaxed);
+    while (current >= 1000) {
+        if (tokens.compare_exchange_weak(current, current - 1000,
+                                         std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+void ServerProxyImpl_t::MethodLatency_t::add(std::int64_t duration) {
+    if (samples.size() < WINDOW) {
+        samples.push_back(duration);
+    } else {
+        samples[next] = duration;
+    }
+    next = (next + 1) % WINDOW;
+
+    // percentile is recomputed after every 16 samples
+    if ((++added % 16) || (samples.size() < 16)) return;
+    std::vector<std::int64_t> sorted(samples);
+    auto p95 = sorted.begin() + long(sorted.size() * 95 / 100);
+    std::nth_element(sorted.begin(), p95, sorted.end());
+    hedgeDelay = int(std::chrono::ceil<std::chrono::milliseconds>(
+            std::chrono::microseconds(*p95)).count());
+}
+
+int ServerProxyImpl_t::hedgeDelay(const std::string &methodName) {
+    std::lock_guard<std::mutex> guard(latencyMutex);
+    return methodLatency[methodName].hedgeDelay;
+}
+
+void ServerProxyImpl_t::addLatency(const std::string &methodName,
+                                   std::chrono::steady_clock::duration d)
+{
+    std::lock_guard<std::mutex> guard(latencyMutex);
+    methodLatency[methodName].add(
+        std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+
+namespace {
+
+    /** Hold va_list and destroy it (via va_end) on destruction.
+     */
+    struct VaListHolder_t {
+        VaListHolder_t(va_list &args) : args(args) {}
+        ~VaListHolder_t() { va_end(args); }
+        va_list &args;
+    };
+
+    /** Waits for data on the socket.
+     *
+     * @return index of the first readable socket or -1 on timeout
+     */
+    int waitReadable(const int *fds, std::size_t count, int timeout) {
+        pollfd pfds[2];
+        for (std::size_t i = 0; i < count; ++i) {
+            pfds[i].fd = fds[i];
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+
+        auto ready = TEMP_FAILURE_RETRY(::poll(pfds, count, timeout));
+        if (ready < 0) {
+            STRERROR_PRE();
+            throw ProtocolError_t::format(
+                    HTTP_SYSCALL, "Cannot select on socket: <%d, %s>.",
+                    ERRNO, STRERROR(ERRNO));
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            if (pfds[i].revents) return int(i);
+        }
+        return -1;
+    }
+
+    /** Failure of the connection before the response arrived.
+     */
+    bool isRetryable(const ProtocolError_t &e,
+                     const HTTPHeader_t &responseHeaders)
+    {
+        return ((e.errorNum() == HTTP_CLOSED)
+                || (e.errorNum() == HTTP_SYSCALL))
+            && responseHeaders.empty();
+    }
+
+    void logCallEvent(LogEvent_t type, LogEventData_t &event,
+                      const char *methodName, const Array_t *params,
+                      const URL_t &url)
+    {
+        event.callStart.methodName = methodName;
+        event.callStart.params = params;
+        event.callStart.url = &url;
+        callLoggerCallback(type, event);
+    }
+
+} // namespace
+
+template <typename Feed_t>
+void ServerProxyImpl_t::call(Endpoint_t &endpoint, DataBuilder_t &builder,
+                             const char *methodName, const Feed_t &feed,
+                             HTTPHeader_t &responseHeaders,
+                             const Array_t *params)
+{
+    HTTPClient_t::HeaderVector_t headers;
+    {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (threadSafe) lock.lock();
+        headers = requestHttpHeaders;
+        takeRequestHttpHeadersForCall(headers);
+    }
+
+    bool idempotent = !idempotentMethods.empty()
+        && idempotentMethods.count(methodName);
+    bool hedged = !hedgedMethods.empty() && hedgedMethods.count(methodName);
+    auto start = std::chrono::steady_clock::now();
+    retryBudget.addCall();
+
+    Endpoint_t *current = &endpoint;
+    for (unsigned int attempt = 1;; ++attempt) {
+        try {
+            if (hedged) {
+                callHedged(*current, builder, methodName, feed, headers,
+                           responseHeaders, params);
+            } else {
+                Attempt_t single(*this, *current, pooledSockets());
+                single.send(methodName, feed, headers);
+                single.read(builder, responseHeaders);
+            }
+            break;
+
+        } catch (const Fault_t &) {
+            if (hedged)
+                addLatency(methodName, std::chrono::steady_clock::now()
+                           - start);
+            throw;
+
+        } catch (const ProtocolError_t &e) {
+            if (!idempotent || (attempt > maxRetries)
+                || !isRetryable(e, responseHeaders))
+                throw;
+
+            LogEventData_t event;
+            event.callRetry.what = e.what();
+            event.callRetry.attempt = attempt;
+            if (!retryBudget.take()) {
+                logCallEvent(LogEvent_t::CALL_RETRY_THROTTLED, event,
+                             methodName, params, current->url);
+                throw;
+            }
+            current = &pickEndpoint(current);
+            logCallEvent(LogEvent_t::CALL_RETRY, event, methodName, params,
+                         current->url);
+        }
+    }
+
+    if (hedged)
+        addLatency(methodName, std::chrono::steady_clock::now() - start);
+}
+
+template <typename Feed_t>
+void ServerProxyImpl_t::callHedged(Endpoint_t &endpoint,
+                                   DataBuilder_t &builder,
+                                   const char *methodName,
+                                   const Feed_t &feed,
+                                   const HTTPClient_t::HeaderVector_t &headers,
+                                   HTTPHeader_t &responseHeaders,
+                                   const Array_t *params)
+{
+    Attempt_t primary(*this, endpoint, true);
+    primary.send(methodName, feed, headers);
+
+    // wait for the response up to the usual call duration
+    int delay = hedgeDelay(methodName);
+    int fds[2] = {primary.socket(), -1};
+    // there is no other server to send the duplicate to
+    if ((delay <= 0) || (endpoints.size() < 2)
+        || (waitReadable(fds, 1, delay) == 0) || !retryBudget.take())
+    {
+        primary.read(builder, responseHeaders);
+        return;
+    }
+
+    Endpoint_t &other = pickEndpoint(&endpoint);
+    LogEventData_t event;
+    event.callHedge.hedgeUrl = &other.url;
+    event.callHedge.delay = unsigned(delay);
+    logCallEvent(LogEvent_t::CALL_HEDGE, event, methodName, params,
+                 endpoint.url);
+
+    std::unique_ptr<Attempt_t> hedge(new Attempt_t(*this, other, true));
+    try {
+        hedge->send(methodName, feed, headers);
+    } catch (const std::exception &) {
+        // the original request is still running
+        primary.read(builder, responseHeaders);
+        return;
+    }
+
+    // the first response wins, the other request is abandoned
+    fds[1] = hedge->socket();
+    int timeout = (readTimeout < 0) ? -1 : readTimeout;
+    if (waitReadable(fds, 2, timeout) == 1) {
+        hedge->read(builder, responseHeaders);
+    } else {
+        primary.read(builder, responseHeaders);
+    }
+}
+
 void ServerProxyImpl_t::call(
+        Endpoint_t &endpoint,
         DataBuilder_t &builder,
         const std::string &methodName,
         const Array_t &params,
         HTTPHeader_t &responseHeaders)
 {
-    HTTPClient_t client(io, url, connector.get(), useHTTP10);
-    {
-        client.addCustomRequestHeader(requestHttpHeaders);
-        client.addCustomRequestHeader(requestHttpHeadersForCall);
-        requestHttpHeadersForCall.clear();
-    }
-    std::unique_ptr<Marshaller_t>marshaller(createMarshaller(client));
-    TreeFeeder_t feeder(*marshaller);
-
-    try {
-        marshaller->packMethodCall(methodName.c_str());
+    call(endpoint, builder, methodName.c_str(), [&] (TreeFeeder_t &feeder) {
         for (Array_t::const_iterator
                  iparams = params.begin(),
                  eparams = params.end();
              iparams != eparams; ++iparams) {
             feeder.feedValue(**iparams);
         }
-
-        marshaller->flush();
-    } catch (const ResponseError_t &e) {}
-
-    client.readResponse(builder, responseHeaders);
-    serverSupportedProtocols = client.getSupportedProtocols();
-    protocolVersion = client.getProtocolVersion();
+    }, responseHeaders, &params);
 }
 
-Value_t& ServerProxyImpl_t::call(Pool_t &pool,
+Value_t& ServerProxyImpl_t::call(Endpoint_t &endpoint,
+                                 Pool_t &pool,
                                  const char *methodName,
                                  va_list args,
                                  HTTPHeader_t &responseHeaders)
 {
-    HTTPClient_t client(io, url, connector.get(), useHTTP10);
-    {
-        client.addCustomRequestHeader(requestHttpHeaders);
-        client.addCustomRequestHeader(requestHttpHeadersForCall);
-        requestHttpHeadersForCall.clear();
-    }
     TreeBuilder_t builder(pool);
-    std::unique_ptr<Marshaller_t>marshaller(createMarshaller(client));
-    TreeFeeder_t feeder(*marshaller);
+    call(endpoint, builder, methodName, [&] (TreeFeeder_t &feeder) {
+        // marshall all passed values until null pointer, the arguments
+        // are copied since retried call feeds them again
+        va_list copy;
+        va_copy(copy, args);
+        VaListHolder_t copyHolder(copy);
+        while (const Value_t *value = va_arg(copy, Value_t*))
+            feeder.feedValue(*value);
+    }, responseHeaders, nullptr);
 
-    try {
-        marshaller->packMethodCall(methodName);
+    // OK, return unmarshalled data (throws fault if NULL)
+    return builder.getUnMarshaledData();
+}
 
-        // marshall all passed values until null pointer
-        while (const Value_t *value = va_arg(args, Value_t*))
-            feeder.feedValue(*value);
+void ServerProxyImpl_t::takeRequestHttpHeadersForCall(
+        HTTPClient_t::HeaderVector_t &headers)
+{
+    HTTPClient_t::HeaderVector_t *forCall = &requestHttpHeadersForCall;
+    std::map<std::thread::id, HTTPClient_t::HeaderVector_t>::iterator
+        iheaders;
+    if (threadSafe) {
+        iheaders = threadRequestHttpHeadersForCall.find
+            (std::this_thread::get_id());
+        if (iheaders == threadRequestHttpHeadersForCall.end()) return;
+        forCall = &iheaders->second;
+    }
+
+    headers.insert(headers.end(), forCall->begin(), forCall->end());
+    forCall->clear();
+    if (threadSafe) threadRequestHttpHeadersForCall.erase(iheaders);
+}
 
-        marshaller->flush();
-    } catch (const ResponseError_t &e) {}
+int ServerProxyImpl_t::Endpoint_t::takeSocket() {
+    std::lock_guard<std::mutex> guard(socketMutex);
+    if (idleSockets.empty()) return -1;
+    int fd = idleSockets.back();
+    idleSockets.pop_back();
+    return fd;
+}
 
-    client.readResponse(builder, responseHeaders);
-    serverSupportedProtocols = client.getSupportedProtocols();
-    protocolVersion = client.getProtocolVersion();
+void ServerProxyImpl_t::Endpoint_t::keepSocket(HTTPIO_t &io,
+                                               bool keepAlive)
+{
+    int &fd = io.socket();
+    if ((fd < 0) || !keepAlive) return;
 
-    // OK, return unmarshalled data (throws fault if NULL)
-    return builder.getUnMarshaledData();
+    std::lock_guard<std::mutex> guard(socketMutex);
+    idleSockets.push_back(fd);
+    fd = -1;
 }
 
 void ServerProxyImpl_t::addRequestHttpHeaderForCall(const HTTPClient_t::Header_t& header)
 {
+    if (threadSafe) {
+        std::lock_guard<std::mutex> guard(mutex);
+        threadRequestHttpHeadersForCall[std::this_thread::get_id()]
+            .push_back(header);
+        return;
+    }
     requestHttpHeadersForCall.push_back(header);
 }
 
@@ -559,6 +1363,8 @@ void ServerProxyImpl_t::addRequestHttpHeaderForCall(const HTTPClient_t::HeaderVe
 
 void ServerProxyImpl_t::addRequestHttpHeader(const HTTPClient_t::Header_t& header)
 {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (threadSafe) lock.lock();
     requestHttpHeaders.push_back(header);
 }
 
@@ -570,20 +1376,15 @@ void ServerProxyImpl_t::addRequestHttpHeader(const HTTPClient_t::HeaderVector_t&
 }
 
 void ServerProxyImpl_t::deleteRequestHttpHeaders() {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (threadSafe) lock.lock();
     requestHttpHeaders.clear();
     requestHttpHeadersForCall.clear();
+    threadRequestHttpHeadersForCall.erase(std::this_thread::get_id());
 }
 
 namespace {
 
-    /** Hold va_list and destroy it (via va_end) on destruction.
-     */
-    struct VaListHolder_t {
-        VaListHolder_t(va_list &args) : args(args) {}
-        ~VaListHolder_t() { va_end(args); }
-        va_list &args;
-    };
-
     template <typename CallT>
     Value_t *with_logger(
         const char *methodName,
@@ -645,12 +1446,16 @@ Value_t& ServerProxy_t::call(Pool_t &pool, const char *methodName, ...) {
 
     // use implementation
     HTTPHeader_t responseHeaders;
+    auto &endpoint = sp->pickEndpoint();
     return *with_logger(
         methodName,
-        &sp->getURL(),
+        &endpoint.url,
         paramptr,
         responseHeaders,
-        [&] {return &sp->call(pool, methodName, args, responseHeaders);}
+        [&] {
+            return &sp->call(endpoint, pool, methodName, args,
+                             responseHeaders);
+        }
     );
 }
 
@@ -658,14 +1463,16 @@ Value_t& ServerProxy_t::call(Pool_t &pool, const std::string &methodName,
                              const Array_t &params)
 {
     HTTPHeader_t responseHeaders;
+    auto &endpoint = sp->pickEndpoint();
     return *with_logger(
         methodName.c_str(),
-        &sp->getURL(),
+        &endpoint.url,
         &params,
         responseHeaders,
         [&] {
             TreeBuilder_t builder(pool);
-            sp->call(builder, methodName, params, responseHeaders);
+            sp->call(endpoint, builder, methodName, params,
+                     responseHeaders);
             return &builder.getUnMarshaledData();
         }
     );
@@ -675,13 +1482,15 @@ void ServerProxy_t::call(DataBuilder_t &builder,
         const std::string &methodName, const Array_t &params)
 {
     HTTPHeader_t responseHeaders;
+    auto &endpoint = sp->pickEndpoint();
     with_logger(
         methodName.c_str(),
-        &sp->getURL(),
+        &endpoint.url,
         &params,
         responseHeaders,
         [&] {
-            sp->call(builder, methodName, params, responseHeaders);
+            sp->call(endpoint, builder, methodName, params,
+                     responseHeaders);
             return nullptr;
         }
     );
@@ -37,7 +37,9 @@
 
 #include <frpcplatform.h>
 
+#include <set>
 #include <string>
+#include <vector>
 
 #include <frpc.h>
 #include <frpchttpio.h>
@@ -60,6 +62,9 @@ class DataBuilder_t;
 
 
 Server proxy is FastRpc client which call method on remote server
+
+The proxy may be shared by more threads only when created with
+Config_t::threadSafe.
 @author Miroslav Talasek
 */
 
@@ -74,6 +79,8 @@ public:
     class Config_t {
     public:
         enum {ON_SUPPORT_ON_KEEP_ALIVE = 0, ON_SUPPORT, ALWAYS,NEVER};
+        ///@brief how are the calls spread over more servers
+        enum {ROUND_ROBIN = 0, LEAST_OUTSTANDING, POWER_OF_TWO_CHOICES};
         /**
             @brief Constructor of config class
             @param connectTimeout - it is connection timeout in miliseconds
@@ -95,7 +102,11 @@ public:
             : connectTimeout(connectTimeout),readTimeout(readTimeout),
               writeTimeout(writeTimeout),
               keepAlive(keepAlive), useBinary(useBinary), useHTTP10(useHTTP10),
-              useChunks(!useHTTP10)
+              useChunks(!useHTTP10), useCompression(false),
+              compressionThreshold(1024), compactXml(false),
+              threadSafe(false), connectAttemptDelay(0),
+              balancePolicy(ROUND_ROBIN), ejectFailures(3), ejectTime(10000),
+              maxRetries(1), retryBudgetPercent(10), retryBudgetBurst(10)
         {}
 
         /**
@@ -125,7 +136,11 @@ public:
               writeTimeout(writeTimeout),
               keepAlive(keepAlive), useBinary(useBinary),
               useHTTP10(useHTTP10), useChunks(!useHTTP10),
-              protocolVersion(protocolVersionMajor,protocolVersionMinor)
+              protocolVersion(protocolVersionMajor,protocolVersionMinor),
+              useCompression(false), compressionThreshold(1024),
+              compactXml(false), threadSafe(false), connectAttemptDelay(0),
+              balancePolicy(ROUND_ROBIN), ejectFailures(3), ejectTime(10000),
+              maxRetries(1), retryBudgetPercent(10), retryBudgetBurst(10)
         {}
 
         /**
@@ -135,11 +150,26 @@ public:
            @n @b connectTimeout = 10000 ms
            @n @b readTimeout = 10000 ms
            @n @b writeTimeout = 1000 ms
+           @n @b useCompression = false
+           @n @b compressionThreshold = 1024
+           @n @b compactXml = false
+           @n @b threadSafe = false
+           @n @b connectAttemptDelay = 0
+           @n @b balancePolicy = ROUND_ROBIN
+           @n @b ejectFailures = 3
+           @n @b ejectTime = 10000 ms
+           @n @b maxRetries = 1
+           @n @b retryBudgetPercent = 10
+           @n @b retryBudgetBurst = 10
         */
         Config_t()
             : connectTimeout(10000), readTimeout(10000), writeTimeout(1000),
               keepAlive(false), useBinary(ON_SUPPORT_ON_KEEP_ALIVE),
-              useHTTP10(false), useChunks(true)
+              useHTTP10(false), useChunks(true), useCompression(false),
+              compressionThreshold(1024), compactXml(false),
+              threadSafe(false), connectAttemptDelay(0),
+              balancePolicy(ROUND_ROBIN), ejectFailures(3), ejectTime(10000),
+              maxRetries(1), retryBudgetPercent(10), retryBudgetBurst(10)
         {}
 
         ///@brief internal representation of connectTimeout value
@@ -160,6 +190,53 @@ public:
         std::string proxyUrl;
         ///@brief Protocol version
         ProtocolVersion_t protocolVersion;
+        ///@brief compress requests when server accepts it (learnt from
+        ///       Accept-Encoding of the previous response)
+        bool useCompression;
+        ///@brief requests smaller than threshold are not compressed
+        unsigned int compressionThreshold;
+        ///@brief XML-RPC requests without whitespace between tags
+        bool compactXml;
+        ///@brief the proxy can be called from more threads at once, each
+        ///       call uses its own connection (idle keep-alive connections
+        ///       are kept for the next calls) and the headers for call are
+        ///       kept per thread; timeouts and the other headers have to be
+        ///       set before the proxy is shared
+        bool threadSafe;
+        ///@brief when host resolves to more addresses the connect to the
+        ///       next one starts after this delay in miliseconds while the
+        ///       previous connects continue, the first connected socket is
+        ///       used (0 = connect to the addresses one after another)
+        unsigned int connectAttemptDelay;
+        ///@brief choice of the server for the call when the proxy has more
+        ///       servers: ROUND_ROBIN, LEAST_OUTSTANDING (the server with
+        ///       the least running calls) or POWER_OF_TWO_CHOICES (better of
+        ///       two random servers by average latency and running calls)
+        unsigned int balancePolicy;
+        ///@brief the server is not used for ejectTime after this number
+        ///       of consecutive failed calls (0 = never), faults are not
+        ///       failures
+        unsigned int ejectFailures;
+        ///@brief how long is failing server not used in miliseconds
+        unsigned int ejectTime;
+        ///@brief methods which may be called more times: their calls are
+        ///       retried when the connection fails before the response
+        ///       arrives
+        std::set<std::string> idempotentMethods;
+        ///@brief methods whose calls are hedged: when the response does
+        ///       not arrive within 95th percentile of the method call
+        ///       durations the call is sent to another server too and the
+        ///       first response is used (the methods should be idempotent,
+        ///       proxy with single server does not hedge)
+        std::set<std::string> hedgedMethods;
+        ///@brief maximal number of retries of one call
+        unsigned int maxRetries;
+        ///@brief retries and hedged calls are limited by token bucket,
+        ///       each call adds retryBudgetPercent / 100 of token, each
+        ///       retry and hedged call takes one token
+        unsigned int retryBudgetPercent;
+        ///@brief capacity of the retry token bucket
+        unsigned int retryBudgetBurst;
     };
 
     /**
@@ -184,6 +261,26 @@ public:
     */
     ServerProxy_t(const std::string &server, const Struct_t &config);
 
+    /**
+        @brief Constructor of proxy balancing the calls over more servers
+        @param servers addresses of the FastRpc servers (replicas of the
+                       same service), each of them has its own connections
+        @param config is configuration structure ServerProxy_t::Config_t,
+                      see Config_t::balancePolicy and Config_t::ejectFailures
+
+        Proxy with more servers is never kept in the proxy cache.
+    */
+    ServerProxy_t(const std::vector<std::string> &servers,
+                  const Config_t &config);
+
+    /**
+        @brief Constructor of proxy balancing the calls over more servers
+        @param servers addresses of the FastRpc servers
+        @param config generic configuration via FRPC::Struct_t
+    */
+    ServerProxy_t(const std::vector<std::string> &servers,
+                  const Struct_t &config);
+
     /**
         @brief Default destructor
     */
@@ -545,6 +642,7 @@ public:
      *         used on proxy servers. */
     void setForwardHeader(const std::string &forwarded);
 
+    /** @brief URL of the (first) server */
     const URL_t& getURL();
 
     void addRequestHttpHeaderForCall(const HTTPClient_t::Header_t& header);
@@ -230,6 +230,22 @@ void TreeBuilder_t::buildNull()
             throw StreamError_t("Unexpected value after end");
 }
 
+void TreeBuilder_t::buildIntArray(std::vector<Int_t::value_type> values)
+{
+    Value_t &array = pool.IntArray(std::move(values));
+    if (!isMember(array))
+        if (!isFirst(array))
+            throw StreamError_t("Unexpected value after end");
+}
+
+void TreeBuilder_t::buildDoubleArray(std::vector<double> values)
+{
+    Value_t &array = pool.DoubleArray(std::move(values));
+    if (!isMember(array))
+        if (!isFirst(array))
+            throw StreamError_t("Unexpected value after end");
+}
+
 void TreeBuilder_t::buildDateTime(short year, char month, char day, char hour,
                                   char minute, char sec, char weekDay,
                                   time_t unixTime, int timeZone)
@@ -86,6 +86,19 @@ public:
     void openArray(unsigned int numOfItems) override;
     void openStruct(unsigned int numOfMembers) override;
     void buildNull();
+
+    /**
+        @brief Builds packed array of ints (IntArray_t)
+        @param values is a items of the array
+    */
+    void buildIntArray(std::vector<Int_t::value_type> values) override;
+
+    /**
+        @brief Builds packed array of doubles (DoubleArray_t)
+        @param values is a items of the array
+    */
+    void buildDoubleArray(std::vector<double> values) override;
+
     bool isFirst(Value_t  &value) {
         if (first) {
             retValue = &value;
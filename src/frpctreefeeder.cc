@@ -257,6 +257,36 @@ void packStruct( // NOLINT(misc-no-recursion)
     }
 }
 
+/** Pack items of IntArray_t or DoubleArray_t into the marshaller.
+ */
+template <typename MarshallerT, typename ItemT>
+void packItems(MarshallerT &marshaller, const std::vector<ItemT> &values) {
+    marshaller.packArray(static_cast<uint32_t>(values.size()));
+    for (auto value: values) {
+        if constexpr (std::is_same_v<ItemT, double>) {
+            marshaller.packDouble(value);
+        } else {
+            marshaller.packInt(value);
+        }
+    }
+}
+
+/** Pack items of IntArray_t into the binary marshaller as one block.
+ */
+void packItems(BinMarshaller_t &marshaller,
+               const IntArray_t::storage_type &values)
+{
+    marshaller.packIntArray(values.data(), values.size());
+}
+
+/** Pack items of DoubleArray_t into the binary marshaller as one block.
+ */
+void packItems(BinMarshaller_t &marshaller,
+               const DoubleArray_t::storage_type &values)
+{
+    marshaller.packDoubleArray(values.data(), values.size());
+}
+
 /** Feed value implementation that packs the array into the marshaller.
  */
 template <typename SecretsT, typename MarshallerT>
@@ -265,6 +295,17 @@ void packArray( // NOLINT(misc-no-recursion)
     const Array_t &array,
     SecretsT &secrets
 ) {
+    // packed arrays are sent without creating the items
+    if (const auto *ints = dynamic_cast<const IntArray_t *>(&array)) {
+        if (ints->isPacked())
+            return packItems(marshaller, ints->values());
+    } else if (const auto *doubles
+               = dynamic_cast<const DoubleArray_t *>(&array))
+    {
+        if (doubles->isPacked())
+            return packItems(marshaller, doubles->values());
+    }
+
     marshaller.packArray(static_cast<uint32_t>(array.size()));
     for (auto i = 0u; i < array.size(); ++i) {
         PointerExtender_t<SecretsT> ext(secrets, i);
@@ -36,6 +36,7 @@
 #include "frpcxmlunmarshaller.h"
 #include "frpcurlunmarshaller.h"
 #include "frpcb64unmarshaller.h"
+#include "frpcjsonunmarshaller.h"
 #include "frpcunmarshaller.h"
 
 namespace FRPC
@@ -79,6 +80,10 @@ UnMarshaller_t* UnMarshaller_t::create(unsigned int contentType,
         unMarshaller = new Base64UnMarshaller_t(dataBuilder);
         break;
 
+    case JSON:
+        unMarshaller = new JSONUnMarshaller_t(dataBuilder, path);
+        break;
+
     default:
         throw Error_t("This unMarshaller not exists");
         break;
@@ -57,7 +57,8 @@ public:
         BINARY_RPC,
         XML_RPC,
         URL_ENCODED,
-        BASE64
+        BASE64,
+        JSON
     };
 
     UnMarshaller_t();
@@ -31,232 +31,212 @@
  *
  */
 
-#include <sstream>
-#include <limits>
-#include <iomanip>
 #include <cstring>
 #include <cstdio>
+#include <string>
+#include <algorithm>
 
 #include "frpc.h"
 #include "frpclenerror.h"
 #include "frpcxmlmarshaller.h"
+#include "frpcbase64.h"
 
 namespace FRPC {
+namespace {
+
+/** Value tags of XML-RPC. */
+enum Tag_t {
+    TAG_I4, TAG_I8, TAG_DOUBLE, TAG_BOOLEAN, TAG_STRING, TAG_BASE64,
+    TAG_DATETIME, TAG_NIL, TAG_ARRAY, TAG_STRUCT, TAG_COUNT
+};
+
+/** Where the value is placed: directly in params, in array or fault, in
+ * struct member. */
+enum Position_t { IN_PARAMS, IN_ARRAY, IN_STRUCT, POSITION_COUNT };
+
+const char *TAG_NAMES[] = {
+    "i4", "i8", "double", "boolean", "string", "base64", "dateTime.iso8601"
+};
+
+} // namespace
+
+/**
+@brief Constant XML fragments of one output format
+
+Every value is written as one opening fragment, its data and one closing
+fragment. The fragments contain everything between the data of the
+neighbouring values, i.e. the <param> and <member> wrappers as well.
+*/
+struct XmlMarshaller_t::Layout_t {
+    explicit Layout_t(bool compact) {
+        const std::string nl = compact ? "" : "\n";
+        for (int tag = 0; tag < TAG_COUNT; ++tag) {
+            std::string head, tail;
+            switch (tag) {
+            case TAG_NIL:
+                head = "<value><nil/>";
+                tail = "</value>" + nl;
+                break;
+            case TAG_ARRAY:
+                head = "<value>" + nl + "<array>" + nl + "<data>" + nl;
+                tail = "</data>" + nl + "</array>" + nl + "</value>" + nl;
+                break;
+            case TAG_STRUCT:
+                head = "<value>" + nl + "<struct>" + nl;
+                tail = "</struct>" + nl + "</value>" + nl;
+                break;
+            default:
+                head = std::string("<value><") + TAG_NAMES[tag] + ">";
+                tail = std::string("</") + TAG_NAMES[tag] + "></value>" + nl;
+                break;
+            }
+            for (int pos = 0; pos < POSITION_COUNT; ++pos) {
+                open[tag][pos] = head;
+                close[tag][pos] = tail;
+            }
+            open[tag][IN_PARAMS].insert(0, "<param>" + nl);
+            close[tag][IN_PARAMS] += "</param>" + nl;
+            close[tag][IN_STRUCT] += "</member>" + nl;
+            for (int pos = 0; pos < POSITION_COUNT; ++pos)
+                empty[tag][pos] = open[tag][pos] + close[tag][pos];
+        }
 
-XmlMarshaller_t::XmlMarshaller_t(Writer_t &writer,
-                                 const ProtocolVersion_t &protocolVersion)
-    : writer(writer), level(0), mainType(), protocolVersion(protocolVersion) {
+        const std::string decl = "<?xml version=\"1.0\"?>" + nl;
+        magic[0] = decl;
+        magic[1] = decl + "<!--protocolVersion=\"2.0\"-->" + nl;
+        magic[2] = decl + "<!--protocolVersion=\"2.1\"-->" + nl;
+        callOpen = "<methodCall>" + nl + "<methodName>";
+        callParams = "</methodName>" + nl + "<params>" + nl;
+        callClose = "</params>" + nl + "</methodCall>" + nl;
+        responseOpen = "<methodResponse>" + nl + "<params>" + nl;
+        responseClose = "</params>" + nl + "</methodResponse>" + nl;
+        faultOpen = "<methodResponse>" + nl + "<fault>" + nl;
+        faultClose = "</fault>" + nl + "</methodResponse>" + nl;
+        memberOpen = "<member>" + nl + "<name>";
+        memberName = "</name>" + nl;
+    }
+
+    static const Layout_t &get(bool compact) {
+        static const Layout_t pretty(false);
+        static const Layout_t compacted(true);
+        return compact ? compacted : pretty;
+    }
 
+    std::string open[TAG_COUNT][POSITION_COUNT];
+    std::string close[TAG_COUNT][POSITION_COUNT];
+    std::string empty[TAG_COUNT][POSITION_COUNT];
+    std::string magic[3];
+    std::string callOpen;
+    std::string callParams;
+    std::string callClose;
+    std::string responseOpen;
+    std::string responseClose;
+    std::string faultOpen;
+    std::string faultClose;
+    std::string memberOpen;
+    std::string memberName;
+};
+
+XmlMarshaller_t::XmlMarshaller_t(Writer_t &writer,
+                                 const ProtocolVersion_t &protocolVersion,
+                                 bool compact)
+    : writer(writer), layout(Layout_t::get(compact)), mainType(),
+      protocolVersion(protocolVersion), compact(compact)
+{
     if (protocolVersion.versionMajor > FRPC_MAJOR_VERSION) {
         throw Error_t("Not supported protocol version");
     }
-
 }
 
 XmlMarshaller_t::~XmlMarshaller_t() {
     entityStorage.clear();
 }
 
-void XmlMarshaller_t::packArray(unsigned int numOfItems) {
+void XmlMarshaller_t::write(const std::string &fragment) {
+    writer.write(fragment.data(), static_cast<uint32_t>(fragment.size()));
+}
 
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
+int XmlMarshaller_t::position() const {
+    if (entityStorage.empty()) return IN_PARAMS;
+    return entityStorage.back().type == STRUCT? IN_STRUCT: IN_ARRAY;
+}
+
+void XmlMarshaller_t::openValue(int tag) {
+    write(layout.open[tag][position()]);
+}
+
+void XmlMarshaller_t::closeValue(int tag) {
+    write(layout.close[tag][position()]);
+    decrementItem();
+}
+
+void XmlMarshaller_t::decrementItem() {
+    if (entityStorage.empty()) return;
 
-    packSpaces(level);
-    //write array tag
-    writer.write("<value>\n",8);
-    level++;
-    packSpaces(level);
-    writer.write("<array>\n",8);
-    level++;
+    // is value last item of the container?
+    if (--entityStorage.back().numOfItems) return;
 
+    // close the container
+    int tag = (entityStorage.back().type == ARRAY)? TAG_ARRAY: TAG_STRUCT;
+    entityStorage.pop_back();
+    closeValue(tag);
+}
 
-    //write correct spaces
-    packSpaces(level);
-    //write array tag
-    writer.write("<data>\n",7);
-    level++;
+void XmlMarshaller_t::packArray(unsigned int numOfItems) {
     if (numOfItems == 0) {
-        level--;
-        writer.write("</data>\n",8);
-        level--;
-        writer.write("</array>\n",9);
-        level--;
-        writer.write("</value>\n",9);
-        if ( entityStorage.size() == 0)
-            writer.write("</param>\n",9);
+        write(layout.empty[TAG_ARRAY][position()]);
         decrementItem();
     } else {
-        //entity to storage
+        openValue(TAG_ARRAY);
         entityStorage.emplace_back(ARRAY, numOfItems);
     }
 }
 
 void XmlMarshaller_t::packBinary(const char* value, unsigned int size) {
-
-
-
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-    //write correct spaces
-    packSpaces(level);
-    //write tags
-    writer.write("<value><base64>",15);
-    //write value base64
-    //writer.write(value,size);
-    writeEncodeBase64(writer, value, size);
-    //write tags
-    writer.write("</base64></value>\n",18);
-
-
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-    decrementItem();
-
+    openValue(TAG_BASE64);
+    writeEncodeBase64(writer, value, size, !compact);
+    closeValue(TAG_BASE64);
 }
 
 void XmlMarshaller_t::packBool(bool value) {
-
-    char boolean = (value ? '1' : '0');
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-    //write correct spaces
-    packSpaces(level);
-    writer.write("<value><boolean>",16);
-    writer.write(&boolean,1);
-    writer.write("</boolean></value>\n",19);
-
-
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-    decrementItem();
-
+    openValue(TAG_BOOLEAN);
+    writer.write(value ? "1" : "0", 1);
+    closeValue(TAG_BOOLEAN);
 }
 
 void XmlMarshaller_t::packNull() {
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        ++level;
-    }
-    packSpaces(level);
-    writer.write("<value><nil/></value>\n",22);
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        --level;
-    }
-    decrementItem();
+    openValue(TAG_NIL);
+    closeValue(TAG_NIL);
 }
 
 void XmlMarshaller_t::packBinaryRef(BinaryRefFeeder_t feeder) {
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n", 8);
-        level++;
-    }
-    packSpaces(level);
-    writer.write("<value><base64>", 15);
-    writeEncodeBase64(writer, feeder.next);
-    writer.write("</base64></value>\n",18);
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n", 9);
-        level--;
-    }
-    decrementItem();
+    openValue(TAG_BASE64);
+    writeEncodeBase64(writer, feeder.next, !compact);
+    closeValue(TAG_BASE64);
 }
 
 void XmlMarshaller_t::packDateTime(short year, char month, char day, char hour,
                                    char minute, char sec, char,
                                    time_t, int timeZone) {
-    std::string data = getISODateTime(year, month, day, hour, minute,
-                                      sec, timeZone);
-
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-
-    //write correct spaces
-    packSpaces(level);
-    writer.write("<value><dateTime.iso8601>",25);
-    writer.write(data.data(), static_cast<uint32_t>(data.size()));
-    writer.write("</dateTime.iso8601></value>\n",28);
-
-
-
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-
-    decrementItem();
-
-
+    char data[ISO_DATETIME_BUFFER_SIZE];
+    unsigned int length = formatISODateTime(data, year, month, day, hour,
+                                            minute, sec, timeZone);
+    openValue(TAG_DATETIME);
+    writer.write(data, length);
+    closeValue(TAG_DATETIME);
 }
 
 void XmlMarshaller_t::packDouble(double value) {
-    std::ostringstream os;
-    os << std::setprecision(std::numeric_limits<double>::digits10 + 2) << value;
-    std::string buff = os.str();
-
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-
-    //write correct spaces
-    packSpaces(level);
-    writer.write("<value><double>",15);
-    writer.write(buff.data(), static_cast<uint32_t>(buff.size()));
-    writer.write("</double></value>\n",18);
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-    decrementItem();
-
+    char buff[NUMBER_BUFFER_SIZE];
+    unsigned int length = formatNumber(buff, value);
+    openValue(TAG_DOUBLE);
+    writer.write(buff, length);
+    closeValue(TAG_DOUBLE);
 }
 
 void XmlMarshaller_t::packFault(int errNumber, const char* errMsg, unsigned int size) {
-
-    //magic
     packMagic();
-    writer.write("<methodResponse>\n",17);
-    level++;
-    //tag fault
-    packSpaces(level);
-    writer.write("<fault>\n",8);
-    level++;
+    write(layout.faultOpen);
 
     entityStorage.emplace_back(FAULT, 0);
 
@@ -266,210 +246,95 @@ void XmlMarshaller_t::packFault(int errNumber, const char* errMsg, unsigned int
     packStructMember("faultString",11);
     packString(errMsg,size);
 
-    packSpaces(level - 1);
-    writer.write("</fault>\n",9);
-    level--;
-
-    packSpaces(level - 1);
-    writer.write("</methodResponse>\n",18);
-
+    write(layout.faultClose);
     mainType = FAULT;
-
 }
 
 void XmlMarshaller_t::packInt(Int_t::value_type value) {
-
-    std::ostringstream buff;
-    buff << value;
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-
-    //write correct spaces
-    packSpaces(level);
+    char buff[NUMBER_BUFFER_SIZE];
+    unsigned int length = formatNumber(buff, value);
 
     Int_t::value_type absValue = value < 0 ? -value :value;
 
+    int tag = TAG_I4;
     if ((absValue & INT31_MASK)) {
         if (protocolVersion.versionMajor < 2)
             throw StreamError_t("Number is too big for protocol version 1.0");
-
-        writer.write("<value><i8>",11);
-        writer.write(buff.str().data(), static_cast<uint32_t>(buff.str().size()));
-        writer.write("</i8></value>\n",14);
-    } else {
-        writer.write("<value><i4>",11);
-        writer.write(buff.str().data(), static_cast<uint32_t>(buff.str().size()));
-        writer.write("</i4></value>\n",14);
+        tag = TAG_I8;
     }
 
-
-
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-    decrementItem();
+    openValue(tag);
+    writer.write(buff, length);
+    closeValue(tag);
 }
 
 void XmlMarshaller_t::packMethodCall(const char* methodName, unsigned int size) {
-
-
     if (size > 255 || size == 0)
         throw LenError_t::format(
             "Lenght of method name is %d not in interval (1-255)", size);
 
-    //pack MAgic header
     packMagic();
-
-    writer.write("<methodCall>\n",13);
-    level++;
-    packSpaces(level);
-    writer.write("<methodName>",12);
+    write(layout.callOpen);
     writeQuotedString(methodName,size);
-    //writer.write(methodName,nameSize);
-    writer.write("</methodName>\n",14);
-    writer.write("<params>\n",9);
-    level++;
+    write(layout.callParams);
 
     mainType = METHOD_CALL;
-
 }
 
 void XmlMarshaller_t::packMethodResponse() {
     packMagic();
-    writer.write("<methodResponse>\n",17);
-    level++;
-    packSpaces(level);
-    writer.write("<params>\n",9);
-    level++;
+    write(layout.responseOpen);
 
     mainType = METHOD_RESPONSE;
-
 }
 
 void XmlMarshaller_t::packString(const char* value, unsigned int size) {
-
-
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-    //write correct spaces
-    packSpaces(level);
-    //write tags
-    writer.write("<value><string>",15);
-    //write value
+    openValue(TAG_STRING);
     writeQuotedString(value,size);
-    //writer.write(value,strSize);
-    //write tags
-    writer.write("</string></value>\n",18);
-
-    if (entityStorage.empty()) {
-        packSpaces(level - 1);
-        writer.write("</param>\n",9);
-        level--;
-    }
-    decrementItem();
-
+    closeValue(TAG_STRING);
 }
 
 void XmlMarshaller_t::packStruct(unsigned int numOfMembers) {
-    //write correct spaces
-    packSpaces(level);
-    if (entityStorage.empty()) {
-        writer.write("<param>\n",8);
-        level++;
-    }
-
-    packSpaces(level);
-    //write array tag
-    writer.write("<value>\n",8);
-    level++;
-    packSpaces(level);
-    writer.write("<struct>\n",9);
-    level++;
     if (numOfMembers == 0) {
-        level--;
-        writer.write("</struct>\n",10);
-        level--;
-        writer.write("</value>\n",9);
-        if ( entityStorage.size() == 0)
-            writer.write("</param>\n",9);
+        write(layout.empty[TAG_STRUCT][position()]);
         decrementItem();
     } else {
-
-        //entity to storage
-        entityStorage.push_back(TypeStorage_t(STRUCT,numOfMembers));
+        openValue(TAG_STRUCT);
+        entityStorage.emplace_back(STRUCT, numOfMembers);
     }
-
 }
 
 void XmlMarshaller_t::packStructMember(const char* memberName, unsigned int size) {
-
-
     if (size > 255 || size == 0)
         throw LenError_t::format(
             "Lenght of member name is %d not in interval (1-255)", size);
 
-    packSpaces(level);
-    writer.write("<member>\n",9);
-    level++;
-
-    packSpaces(level);
-    writer.write("<name>",6);
+    write(layout.memberOpen);
     writeQuotedString(memberName,size);
-    //writer.write(memberName,nameSize);
-    writer.write("</name>\n",8);
-
+    write(layout.memberName);
 }
-void XmlMarshaller_t::flush() {
 
+void XmlMarshaller_t::flush() {
     switch (mainType) {
-
     case METHOD_CALL:
-        packSpaces(level-1);
-        writer.write("</params>\n",10);
-        level--;
-        packSpaces(level-1);
-        writer.write("</methodCall>\n",14);
+        write(layout.callClose);
         break;
     case METHOD_RESPONSE:
-        packSpaces(level-1);
-        writer.write("</params>\n",10);
-        level--;
-        packSpaces(level-1);
-        writer.write("</methodResponse>\n",18);
+        write(layout.responseClose);
         break;
     }
     writer.flush();
-    level = 0;
     entityStorage.clear();
 }
 
-
 void XmlMarshaller_t::packMagic() {
     if (protocolVersion.versionMajor < 2) {
-        char magic[]="<?xml version=\"1.0\"?>\n";
-        //write magic
-        writer.write(magic, static_cast<uint32_t>(strlen(magic)));
+        write(layout.magic[0]);
     } else if (protocolVersion.versionMajor == 2 && protocolVersion.versionMinor == 0) {
-        char magic[]="<?xml version=\"1.0\"?>\n<!--protocolVersion=\"2.0\"-->\n";
-        //write magic
-        writer.write(magic, static_cast<uint32_t>(strlen(magic)));
+        write(layout.magic[1]);
     } else {
-        char magic[]="<?xml version=\"1.0\"?>\n<!--protocolVersion=\"2.1\"-->\n";
-        //write magic
-        writer.write(magic, static_cast<uint32_t>(strlen(magic)));
+        write(layout.magic[2]);
     }
-
 }
 
 void XmlMarshaller_t::writeEncodeBase64(Writer_t &writer,
@@ -488,87 +353,93 @@ void XmlMarshaller_t::writeEncodeBase64(Writer_t &writer,
                                         Chunks_t chunks,
                                         bool rn)
 {
-    static const char table[]
-        = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    // line of 76 characters
+    const std::size_t LINE_TRIPLETS = 19;
+
+    char buffer[4096];
+    std::size_t used = 0;
+    std::size_t lineTriplets = 0;
+
+    // encodes whole triplets, breaks lines when rn is set
+    auto encode = [&] (const uint8_t *data, std::size_t size) {
+        while (size) {
+            std::size_t triplets = std::min(size / 3,
+                                            (sizeof(buffer) - used - 2) / 4);
+            if (rn)
+                triplets = std::min(triplets, LINE_TRIPLETS - lineTriplets);
+            if (!triplets) {
+                writer.write(buffer, static_cast<unsigned int>(used));
+                used = 0;
+                continue;
+            }
 
-    auto write_first_sextet = [&] (uint8_t octet0) {
-        writer.write(&table[octet0 >> 2], 1);
-    };
-    auto write_second_sextet = [&] (uint8_t octet0, uint8_t octet1) {
-        writer.write(&table[((octet0 & 0x03) << 4) | (octet1 >> 4)], 1);
-    };
-    auto write_third_sextet = [&] (uint8_t octet1, uint8_t octet2) {
-        writer.write(&table[((octet1 & 0x0F) << 2) | (octet2 >> 6)], 1);
-    };
-    auto write_fourth_sextet = [&] (uint8_t octet2) {
-        writer.write(&table[octet2 & 0x3F], 1);
+            used = Base64::encode(data, triplets * 3, buffer + used) - buffer;
+            data += triplets * 3;
+            size -= triplets * 3;
+            if (rn && ((lineTriplets += triplets) == LINE_TRIPLETS)) {
+                buffer[used++] = '\r';
+                buffer[used++] = '\n';
+                lineTriplets = 0;
+            }
+        }
     };
 
-    int input_len = 0;
-    size_t lineLen = 0;
+    // triplet split between chunks
     uint8_t input[3];
+    std::size_t inputLen = 0;
     for (;;) {
         auto chunk = chunks();
         if (chunk.data == nullptr) break;
-        std::size_t i = 0lu;
-        for (;;) {
-            while ((i < chunk.size) && (input_len != 3))
-                input[input_len++] = chunk.data[i++];
-            if (input_len < 3) break;
-            input_len = 0;
-
-            write_first_sextet(input[0]);
-            write_second_sextet(input[0], input[1]);
-            write_third_sextet(input[1], input[2]);
-            write_fourth_sextet(input[2]);
-            if (rn) {
-                lineLen += 4;
-                if (lineLen > 72) {
-                    writer.write("\r\n", 2);
-                    lineLen = 0;
-                }
+        const uint8_t *data = chunk.data;
+        std::size_t size = chunk.size;
+        if (inputLen) {
+            while (size && (inputLen < 3)) {
+                input[inputLen++] = *data++;
+                --size;
             }
+            if (inputLen < 3) continue;
+            encode(input, 3);
+            inputLen = 0;
         }
+        encode(data, size / 3 * 3);
+        std::copy(data + size / 3 * 3, data + size, input);
+        inputLen = size % 3;
     }
 
-    switch (input_len) {
-    case 1:
-        write_first_sextet(input[0]);
-        write_second_sextet(input[0], 0);
-        writer.write("==", 2);
-        break;
-    case 2:
-        write_first_sextet(input[0]);
-        write_second_sextet(input[0], input[1]);
-        write_third_sextet(input[1], 0);
-        writer.write("=", 1);
-        break;
-    default:
-        break;
+    if (used + 6 > sizeof(buffer)) {
+        writer.write(buffer, static_cast<unsigned int>(used));
+        used = 0;
+    }
+
+    // the padded tail does not count to the line length
+    used = Base64::encode(input, inputLen, buffer + used) - buffer;
+    if (lineTriplets && rn) {
+        buffer[used++] = '\r';
+        buffer[used++] = '\n';
     }
-    if (lineLen && rn) writer.write("\r\n", 2);
+    if (used) writer.write(buffer, static_cast<unsigned int>(used));
 }
 
 void XmlMarshaller_t::writeQuotedString(const char *data, unsigned int len) {
-    for (unsigned int i = 0; i < len; i++) {
-        switch (data[i]) {
-        case '<':
-            writer.write("&lt;",4);
-            break;
-        case '>':
-            writer.write("&gt;",4);
-            break;
-        case '"':
-            writer.write("&quot;",6);
-            break;
-        case '&':
-            writer.write("&amp;",5);
-            break;
-        default:
-            writer.write(&data[i],1);
-            break;
+    // write runs of characters which need no escaping at once
+    const char *run = data;
+    for (const char *end = data + len; data != end; ++data) {
+        const char *entity;
+        unsigned int size;
+        switch (*data) {
+        case '<': entity = "&lt;"; size = 4; break;
+        case '>': entity = "&gt;"; size = 4; break;
+        case '"': entity = "&quot;"; size = 6; break;
+        case '&': entity = "&amp;"; size = 5; break;
+        default: continue;
         }
+        if (run != data)
+            writer.write(run, static_cast<uint32_t>(data - run));
+        writer.write(entity, size);
+        run = data + 1;
     }
+    if (run != data)
+        writer.write(run, static_cast<uint32_t>(data - run));
 }
 
 } // namespace FRPC
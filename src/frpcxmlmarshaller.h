@@ -37,13 +37,12 @@
 #include <frpcmarshaller.h>
 #include <vector>
 #include <functional>
+#include <string>
 #include <frpcwriter.h>
 #include <frpcinternals.h>
 #include <frpcint.h>
 #include <frpc.h>
 
-//#define XML_HUMAN_FORMAT
-
 namespace FRPC {
 
 /**
@@ -52,8 +51,16 @@ namespace FRPC {
 class XmlMarshaller_t : public Marshaller_t
 {
 public:
+    /**
+        @brief Constructor
+        @param writer is a object which write output data
+        @param protocolVersion is a version of protocol
+        @param compact writes no whitespace between tags (and no line breaks
+                       in base64) instead of one tag per line
+    */
     XmlMarshaller_t(Writer_t &writer,
-                    const ProtocolVersion_t &protocolVersion);
+                    const ProtocolVersion_t &protocolVersion,
+                    bool compact = false);
 
     ~XmlMarshaller_t() override;
 
@@ -91,78 +98,23 @@ public:
 #endif
 
 private:
+    struct Layout_t;
+
     XmlMarshaller_t();
     void packMagic();
     void writeQuotedString(const char *data, unsigned int len);
-#ifdef XML_HUMAN_FORMAT
-    inline void packSpaces(unsigned int numSpaces)
-    {
-        for(unsigned int i=0; i< numSpaces; i++)
-            writer.write(" ",1);
-    }
-#else
-    void packSpaces(unsigned int /*numSpaces*/)
-    {
-    }
-#endif
+    void write(const std::string &fragment);
+    int position() const;
+    void openValue(int tag);
+    void closeValue(int tag);
+    void decrementItem();
 
-    void decrementItem()
-    {
-        //is vaule any ittem or no ?
-        if(!entityStorage.empty())
-        {
-            if(entityStorage.back().type == STRUCT)
-            {
-               packSpaces(level-1);
-               writer.write("</member>\n",10);
-               level--;
-            }
-            //decrement item count
-            entityStorage.back().numOfItems--;
-            //is value last item ?
-            if(entityStorage.back().numOfItems == 0)
-            {
-
-                //close tag
-                packSpaces(level-1);
-                switch(entityStorage.back().type)
-                {
-                case ARRAY:
-                    writer.write("</data>\n",8);
-                    level--;
-                    packSpaces(level-1);
-                    writer.write("</array>\n",9);
-                    level--;
-                    packSpaces(level-1);
-                    writer.write("</value>\n",9);
-                    break;
-                case STRUCT:
-
-                    writer.write("</struct>\n",10);
-                    level--;
-                    packSpaces(level-1);
-                    writer.write("</value>\n",9);
-                    break;
-                }
-                level--;
-                entityStorage.pop_back();
-
-                if(entityStorage.empty())
-                {
-                    packSpaces(level-1);
-                    writer.write("</param>\n",9);
-                    level--;
-                }
-                decrementItem();
-            }
-        }
-
-    }
     std::vector<TypeStorage_t> entityStorage;
     Writer_t  &writer;
-    unsigned int level;
+    const Layout_t &layout;
     char mainType;
     ProtocolVersion_t protocolVersion;
+    bool compact;
 };
 
 } // namespace FRPC
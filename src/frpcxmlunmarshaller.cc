@@ -33,7 +33,15 @@
 #include <climits>
 #include <cstring>
 #include <cerrno>
+#include <cctype>
 #include <memory.h>
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "frpcxmlunmarshaller.h"
 #include "frpctreebuilder.h"
@@ -225,18 +233,776 @@ const char *error_mapping[] = {
                                   "XML_WAR_NS_URI_RELATIVE", /* 100 */
                                   "XML_ERR_MISSING_ENCODING" /* 101 */
                               };
+
+/** Throws the same error as the libxml2 parser does for the error code. */
+[[noreturn]] void parserError(long code) {
+    const char *msg;
+    if (code < 0
+        || code >= static_cast<long>(sizeof(error_mapping)
+                                     / sizeof(*error_mapping)))
+    {
+        msg = "Unknown";
+    } else
+        msg = error_mapping[code];
+
+    throw FRPC::StreamError_t::format("Parser error: < %s >", msg);
+}
+
+std::atomic<bool> builtinTokenizer(true);
+
+bool isSpace(char c) {
+    return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r');
+}
+
+bool isNameStart(char c) {
+    auto u = static_cast<unsigned char>(c);
+    return ((u | 0x20) >= 'a' && (u | 0x20) <= 'z')
+        || (u == '_') || (u == ':') || (u >= 0x80);
+}
+
+bool isNameChar(char c) {
+    return isNameStart(c) || (c >= '0' && c <= '9') || (c == '.')
+        || (c == '-');
+}
+
+/** Table of text bytes which can't be copied to the value as they are:
+ * markup, entities, ']' of "]]>", '\r', control characters and non-ASCII
+ * bytes (validated as UTF-8).
+ */
+struct TextClass_t {
+    constexpr TextClass_t() : special() {
+        for (int c = 0; c < 0x20; ++c) special[c] = true;
+        for (int c = 0x80; c < 0x100; ++c) special[c] = true;
+        special[int('\t')] = special[int('\n')] = false;
+        special[int('<')] = special[int('&')] = special[int(']')] = true;
+    }
+
+    bool special[256];
+};
+
+constexpr TextClass_t TEXT_CLASS;
+
+/** Finds the first special text byte (see TextClass_t). */
+const char *scanText(const char *p, const char *end) {
+#ifdef __SSE2__
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i bracket = _mm_set1_epi8(']');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i tab = _mm_set1_epi8('\t');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        // signed comparison catches both control and non-ASCII bytes
+        __m128i special = _mm_andnot_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, tab)),
+            _mm_cmplt_epi8(v, space));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, lt));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, amp));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, bracket));
+        if (int mask = _mm_movemask_epi8(special))
+            return p + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+#endif
+    for (; p != end; ++p)
+        if (TEXT_CLASS.special[static_cast<unsigned char>(*p)]) break;
+    return p;
+}
+
+/** Returns the size of the character at p allowed by XML (UTF-8 encoded),
+ * 0 if the data ends in the middle of it.
+ */
+int charSize(const char *p, const char *end) {
+    auto c = static_cast<unsigned char>(*p);
+    if (c < 0x80) {
+        if ((c < 0x20) && (c != '\t') && (c != '\n') && (c != '\r'))
+            parserError(XML_ERR_INVALID_CHAR);
+        return 1;
+    }
+
+    int size;
+    unsigned char low = 0x80, high = 0xbf;
+    if (c < 0xc2) {
+        parserError(XML_ERR_INVALID_CHAR);
+    } else if (c < 0xe0) {
+        size = 2;
+    } else if (c < 0xf0) {
+        size = 3;
+        if (c == 0xe0) low = 0xa0;
+        if (c == 0xed) high = 0x9f; // surrogates
+    } else if (c < 0xf5) {
+        size = 4;
+        if (c == 0xf0) low = 0x90;
+        if (c == 0xf4) high = 0x8f;
+    } else {
+        parserError(XML_ERR_INVALID_CHAR);
+    }
+
+    for (int i = 1; i < size; ++i) {
+        if (p + i == end) return 0;
+        auto next = static_cast<unsigned char>(p[i]);
+        if ((next < low) || (next > high))
+            parserError(XML_ERR_INVALID_CHAR);
+        low = 0x80;
+        high = 0xbf;
+    }
+
+    // U+FFFE and U+FFFF
+    if ((c == 0xef) && (static_cast<unsigned char>(p[1]) == 0xbf)
+        && (static_cast<unsigned char>(p[2]) >= 0xbe))
+    {
+        parserError(XML_ERR_INVALID_CHAR);
+    }
+    return size;
+}
+
+/** Checks that the complete token contains only characters allowed by XML.
+ */
+void checkChars(const char *p, const char *end) {
+    while (p != end) {
+        auto c = static_cast<unsigned char>(*p);
+        if ((c >= 0x20) && (c < 0x80)) {
+            ++p;
+        } else {
+            int size = charSize(p, end);
+            if (!size) parserError(XML_ERR_INVALID_CHAR);
+            p += size;
+        }
+    }
+}
+
+/** Encodes the code point into UTF-8, returns the size. */
+unsigned int encodeChar(uint32_t value, char *buffer) {
+    if (value < 0x80) {
+        buffer[0] = static_cast<char>(value);
+        return 1;
+    } else if (value < 0x800) {
+        buffer[0] = static_cast<char>(0xc0 | (value >> 6));
+        buffer[1] = static_cast<char>(0x80 | (value & 0x3f));
+        return 2;
+    } else if (value < 0x10000) {
+        buffer[0] = static_cast<char>(0xe0 | (value >> 12));
+        buffer[1] = static_cast<char>(0x80 | ((value >> 6) & 0x3f));
+        buffer[2] = static_cast<char>(0x80 | (value & 0x3f));
+        return 3;
+    }
+    buffer[0] = static_cast<char>(0xf0 | (value >> 18));
+    buffer[1] = static_cast<char>(0x80 | ((value >> 12) & 0x3f));
+    buffer[2] = static_cast<char>(0x80 | ((value >> 6) & 0x3f));
+    buffer[3] = static_cast<char>(0x80 | (value & 0x3f));
+    return 4;
+}
+
+/** Checks whether data starts with the literal: 1 yes, -1 no and 0 when
+ * there is not enough data to decide.
+ */
+int startsWith(const char *p, const char *end, const char *literal) {
+    for (; *literal; ++literal, ++p) {
+        if (p == end) return 0;
+        if (*p != *literal) return -1;
+    }
+    return 1;
+}
+
+bool equalsNoCase(std::string_view value, const char *literal) {
+    if (value.size() != strlen(literal)) return false;
+    for (std::size_t i = 0; i < value.size(); ++i)
+        if (tolower(static_cast<unsigned char>(value[i])) != literal[i])
+            return false;
+    return true;
+}
+
+/** Skips XML blanks, returns false when there is none. */
+bool skipBlanks(std::string_view &data) {
+    std::size_t pos = data.find_first_not_of(" \t\r\n");
+    if (pos == std::string_view::npos) pos = data.size();
+    data.remove_prefix(pos);
+    return pos != 0;
+}
+
+/** Parses name S? '=' S? quoted value of the declaration attribute. */
+bool declAttribute(std::string_view &data, const char *name,
+                   std::string_view &value)
+{
+    std::size_t size = strlen(name);
+    if (data.substr(0, size) != name) return false;
+    data.remove_prefix(size);
+    skipBlanks(data);
+    if (data.empty() || (data.front() != '=')) return false;
+    data.remove_prefix(1);
+    skipBlanks(data);
+    if (data.empty() || ((data.front() != '"') && (data.front() != '\'')))
+        return false;
+    std::size_t last = data.find(data.front(), 1);
+    if (last == std::string_view::npos) return false;
+    value = data.substr(1, last - 1);
+    data.remove_prefix(last + 1);
+    return true;
+}
+
+/** Checks whether the XML declaration (the part after "<?xml") is exactly
+ * what libxml2 accepts without any complaint and that it uses UTF-8 (or
+ * says nothing about encoding). Anything else, malformed declarations
+ * included, is left to libxml2 so that the errors stay the same.
+ */
+bool isPlainUtf8Declaration(std::string_view declaration) {
+    std::string_view value;
+    if (!skipBlanks(declaration)
+        || !declAttribute(declaration, "version", value)
+        || (value != "1.0"))
+    {
+        return false;
+    }
+
+    bool blank = skipBlanks(declaration);
+    if (blank && declaration.substr(0, 8) == "encoding") {
+        if (!declAttribute(declaration, "encoding", value)
+            || !(equalsNoCase(value, "utf-8") || equalsNoCase(value, "utf8")))
+        {
+            return false;
+        }
+        blank = skipBlanks(declaration);
+    }
+    if (blank && declaration.substr(0, 10) == "standalone") {
+        if (!declAttribute(declaration, "standalone", value)
+            || ((value != "yes") && (value != "no")))
+        {
+            return false;
+        }
+        skipBlanks(declaration);
+    }
+    return declaration.empty();
+}
+
 } // namespace
 
 namespace FRPC {
 
+/**
+@brief Incremental tokenizer of XML-RPC documents
+
+It recognizes well-formed UTF-8 XML without DTD which is all what XML-RPC
+needs and calls XmlUnMarshaller_t (and so DataBuilder_t) directly. Text
+between tags is passed without copying when it needs no decoding and it is
+not split between chunks. Anything else (DTD, other encodings) is detected
+before the root element and the document is then parsed by libxml2. So are
+XML declarations other than the plain UTF-8 one, malformed ones included, to
+get exactly the libxml2 errors for them.
+*/
+class XmlUnMarshaller_t::Tokenizer_t {
+public:
+    explicit Tokenizer_t(XmlUnMarshaller_t &unmarshaller)
+        : unmarshaller(unmarshaller), state(PROLOG), atStart(true),
+          collect(false), fallback(false), span(nullptr), spanSize(0)
+    {}
+
+    /**
+        @brief Parses the next chunk of data, empty chunk ends the document
+        @return false if the document must be parsed by libxml2, all the
+        data passed so far are available by prologData() then
+    */
+    bool feed(const char *data, unsigned int size);
+
+    /** Data of the document preceding the root element. */
+    std::string &prologData() { return prolog;}
+
+private:
+    enum State_t { PROLOG, ROOT, EPILOG };
+
+    std::size_t parse(const char *begin, const char *end);
+    const char *space(const char *p, const char *end);
+    const char *text(const char *p, const char *end);
+    const char *entity(const char *p, const char *end);
+    const char *startTag(const char *p, const char *end);
+    const char *endTag(const char *p, const char *end);
+    const char *instruction(const char *p, const char *end);
+    const char *declaration(const char *p, const char *end);
+    const char *comment(const char *p, const char *end);
+    const char *cdata(const char *p, const char *end);
+    void closeElement();
+    void appendText(const char *data, std::size_t size);
+    void appendDecoded(const char *data, std::size_t size);
+    void flushText();
+
+    XmlUnMarshaller_t &unmarshaller;
+    State_t state;
+    bool atStart;               //!< nothing but BOM parsed
+    bool collect;               //!< collect text (we are in element)
+    bool fallback;              //!< document is not for the tokenizer
+    const char *span;           //!< not yet copied text
+    std::size_t spanSize;
+    std::string pending;        //!< incomplete token from previous chunk
+    std::string prolog;         //!< data preceding the root element
+    std::string names;          //!< names of the open elements
+    std::vector<std::size_t> nameSizes;
+};
+
+bool XmlUnMarshaller_t::Tokenizer_t::feed(const char *data,
+                                          unsigned int size)
+{
+    if (!size) {
+        if (!pending.empty() || (state != EPILOG))
+            parserError(XML_ERR_DOCUMENT_END);
+        return true;
+    }
+
+    const char *pos = data;
+    const char *end = data + size;
+
+    // complete the token split between chunks, let it grow geometrically
+    while (!pending.empty() && (pos != end)) {
+        std::size_t old = pending.size();
+        std::size_t take = std::min(static_cast<std::size_t>(end - pos),
+                                    std::max(old, std::size_t(64)));
+        pending.append(pos, take);
+        std::size_t used = parse(pending.data(),
+                                 pending.data() + pending.size());
+        if (fallback) return false;
+        if (used >= old) {
+            pos += used - old;
+            pending.clear();
+        } else {
+            pos += take;
+        }
+    }
+
+    if (pending.empty() && (pos != end)) {
+        std::size_t used = parse(pos, end);
+        if (fallback) return false;
+        pending.assign(pos + used, end);
+    }
+
+    if (state == PROLOG) {
+        prolog.append(data, size);
+    } else if (!prolog.empty()) {
+        std::string().swap(prolog);
+    }
+    return true;
+}
+
+std::size_t XmlUnMarshaller_t::Tokenizer_t::parse(const char *begin,
+                                                  const char *end)
+{
+    const char *p = begin;
+    while (p != end) {
+        if (atStart) {
+            auto c = static_cast<unsigned char>(*p);
+            if (!c || (c == 0xfe) || (c == 0xff)) {
+                // UTF-16 or UTF-32
+                fallback = true;
+                return 0;
+            }
+            if (c == 0xef) {
+                int bom = startsWith(p, end, "\xef\xbb\xbf");
+                if (!bom) break;
+                if (bom > 0) p += 3;
+                if (p == end) break;
+            }
+        }
+
+        const char *next;
+        if (*p != '<') {
+            next = (state == ROOT)? text(p, end): space(p, end);
+        } else if (end - p < 2) {
+            break;
+        } else {
+            switch (p[1]) {
+            case '/': next = endTag(p, end); break;
+            case '?': next = instruction(p, end); break;
+            case '!': next = declaration(p, end); break;
+            default: next = startTag(p, end); break;
+            }
+        }
+
+        // incomplete token or fallback
+        if (!next || (next == p)) break;
+        atStart = false;
+        p = next;
+    }
+
+    flushText();
+    return static_cast<std::size_t>(p - begin);
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::space(const char *p,
+                                                  const char *end)
+{
+    while ((p != end) && isSpace(*p)) ++p;
+    if ((p != end) && (*p != '<'))
+        parserError((state == PROLOG)
+                    ? XML_ERR_DOCUMENT_EMPTY
+                    : XML_ERR_DOCUMENT_END);
+    return p;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::text(const char *p,
+                                                 const char *end)
+{
+    while (p != end) {
+        const char *run = p;
+        p = scanText(p, end);
+        appendText(run, static_cast<std::size_t>(p - run));
+        if (p == end) break;
+
+        switch (*p) {
+        case '<':
+            return p;
+
+        case '&':
+            if (const char *next = entity(p, end)) {
+                p = next;
+                continue;
+            }
+            return p;
+
+        case '\r':
+            // line ends are normalized to '\n'
+            if (p + 1 == end) return p;
+            if (p[1] != '\n') appendDecoded("\n", 1);
+            ++p;
+            continue;
+
+        case ']':
+            if ((p + 1 == end) || ((p[1] == ']') && (p + 2 == end)))
+                return p;
+            if ((p[1] == ']') && (p[2] == '>'))
+                parserError(XML_ERR_MISPLACED_CDATA_END);
+            appendText(p, 1);
+            ++p;
+            continue;
+
+        default:
+            if (int size = charSize(p, end)) {
+                appendText(p, static_cast<std::size_t>(size));
+                p += size;
+                continue;
+            }
+            return p;
+        }
+    }
+    return p;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::entity(const char *p,
+                                                   const char *end)
+{
+    const char *q = p + 1;
+    if (q == end) return nullptr;
+
+    if (*q == '#') {
+        if (++q == end) return nullptr;
+        bool hex = (*q == 'x');
+        if (hex && (++q == end)) return nullptr;
+
+        const char *digits = q;
+        uint32_t value = 0;
+        for (; q != end; ++q) {
+            int digit;
+            if ((*q >= '0') && (*q <= '9')) digit = *q - '0';
+            else if (hex && ((*q | 0x20) >= 'a') && ((*q | 0x20) <= 'f'))
+                digit = (*q | 0x20) - 'a' + 10;
+            else break;
+            value = std::min(value * (hex? 16: 10) + uint32_t(digit),
+                             uint32_t(0x110000));
+        }
+        if (q == end) return nullptr;
+        if ((*q != ';') || (q == digits))
+            parserError(hex
+                        ? XML_ERR_INVALID_HEX_CHARREF
+                        : XML_ERR_INVALID_DEC_CHARREF);
+
+        if (!((value == 0x9) || (value == 0xa) || (value == 0xd)
+              || ((value >= 0x20) && (value <= 0xd7ff))
+              || ((value >= 0xe000) && (value <= 0xfffd))
+              || ((value >= 0x10000) && (value <= 0x10ffff))))
+        {
+            parserError(XML_ERR_INVALID_CHAR);
+        }
+
+        char buffer[4];
+        appendDecoded(buffer, encodeChar(value, buffer));
+        return q + 1;
+    }
+
+    if (!isNameStart(*q)) parserError(XML_ERR_NAME_REQUIRED);
+    const char *name = q;
+    while ((q != end) && isNameChar(*q)) ++q;
+    if (q == end) return nullptr;
+    if (*q != ';') parserError(XML_ERR_ENTITYREF_SEMICOL_MISSING);
+
+    std::string_view entity(name, static_cast<std::size_t>(q - name));
+    if (entity == "lt") appendDecoded("<", 1);
+    else if (entity == "gt") appendDecoded(">", 1);
+    else if (entity == "amp") appendDecoded("&", 1);
+    else if (entity == "quot") appendDecoded("\"", 1);
+    else if (entity == "apos") appendDecoded("'", 1);
+    else parserError(XML_ERR_UNDECLARED_ENTITY);
+    return q + 1;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::startTag(const char *p,
+                                                     const char *end)
+{
+    const char *name = p + 1;
+    if (!isNameStart(*name)) parserError(XML_ERR_NAME_REQUIRED);
+    const char *q = name;
+    while ((q != end) && isNameChar(*q)) ++q;
+    if (q == end) return nullptr;
+    const char *nameEnd = q;
+
+    // attributes are checked and ignored
+    bool empty = false;
+    for (;;) {
+        const char *separator = q;
+        while ((q != end) && isSpace(*q)) ++q;
+        if (q == end) return nullptr;
+        if (*q == '>') {
+            ++q;
+            break;
+        }
+        if (*q == '/') {
+            if (q + 1 == end) return nullptr;
+            if (q[1] != '>') parserError(XML_ERR_GT_REQUIRED);
+            q += 2;
+            empty = true;
+            break;
+        }
+        if (separator == q)
+            parserError((q == nameEnd)
+                        ? XML_ERR_GT_REQUIRED
+                        : XML_ERR_SPACE_REQUIRED);
+        if (!isNameStart(*q)) parserError(XML_ERR_NAME_REQUIRED);
+
+        const char *attribute = q;
+        while ((q != end) && isNameChar(*q)) ++q;
+        if (q == end) return nullptr;
+        checkChars(attribute, q);
+        while ((q != end) && isSpace(*q)) ++q;
+        if (q == end) return nullptr;
+        if (*q != '=') parserError(XML_ERR_ATTRIBUTE_WITHOUT_VALUE);
+        ++q;
+        while ((q != end) && isSpace(*q)) ++q;
+        if (q == end) return nullptr;
+        if ((*q != '"') && (*q != '\''))
+            parserError(XML_ERR_ATTRIBUTE_NOT_STARTED);
+
+        const char *value = q + 1;
+        q = std::find(value, end, *q);
+        if (q == end) return nullptr;
+        if (std::find(value, q, '<') != q)
+            parserError(XML_ERR_GT_REQUIRED);
+        checkChars(value, q);
+        ++q;
+    }
+
+    if (state == EPILOG) parserError(XML_ERR_DOCUMENT_END);
+    state = ROOT;
+
+    auto size = static_cast<unsigned int>(nameEnd - name);
+    checkChars(name, nameEnd);
+    names.append(name, size);
+    nameSizes.push_back(size);
+
+    unmarshaller.localBuffer.clear();
+    spanSize = 0;
+    collect = true;
+    unmarshaller.setValueType(name, size);
+    if (empty) closeElement();
+    return q;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::endTag(const char *p,
+                                                   const char *end)
+{
+    const char *name = p + 2;
+    const char *q = name;
+    while ((q != end) && isNameChar(*q)) ++q;
+    if (q == end) return nullptr;
+
+    if (state != ROOT)
+        parserError((state == PROLOG)
+                    ? XML_ERR_DOCUMENT_EMPTY
+                    : XML_ERR_DOCUMENT_END);
+
+    auto size = static_cast<std::size_t>(q - name);
+    if ((size != nameSizes.back())
+        || memcmp(names.data() + names.size() - size, name, size))
+    {
+        parserError(XML_ERR_TAG_NAME_MISMATCH);
+    }
+
+    while ((q != end) && isSpace(*q)) ++q;
+    if (q == end) return nullptr;
+    if (*q != '>') parserError(XML_ERR_GT_REQUIRED);
+
+    closeElement();
+    return q + 1;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::instruction(const char *p,
+                                                        const char *end)
+{
+    const char *target = p + 2;
+    std::size_t close = std::string_view(
+        target, static_cast<std::size_t>(end - target)).find("?>");
+    if (close == std::string_view::npos) return nullptr;
+    const char *stop = target + close;
+
+    const char *q = target;
+    if ((q == stop) || !isNameStart(*q)) parserError(XML_ERR_PI_NOT_STARTED);
+    while ((q != stop) && isNameChar(*q)) ++q;
+    if ((q != stop) && !isSpace(*q)) parserError(XML_ERR_SPACE_REQUIRED);
+    checkChars(q, stop);
+
+    std::string_view name(target, static_cast<std::size_t>(q - target));
+    if (equalsNoCase(name, "xml")) {
+        // XML declaration is allowed only at the beginning
+        if (!atStart || (name != "xml"))
+            parserError(XML_ERR_RESERVED_XML_NAME);
+        if (!isPlainUtf8Declaration(std::string_view(
+                    q, static_cast<std::size_t>(stop - q))))
+        {
+            fallback = true;
+            return nullptr;
+        }
+    }
+    return stop + 2;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::declaration(const char *p,
+                                                        const char *end)
+{
+    int isComment = startsWith(p, end, "<!--");
+    if (isComment > 0) return comment(p, end);
+    int isCdata = startsWith(p, end, "<![CDATA[");
+    if (isCdata > 0) return cdata(p, end);
+    int isDoctype = startsWith(p, end, "<!DOCTYPE");
+    if (isDoctype > 0) {
+        if (state != PROLOG) parserError(XML_ERR_INTERNAL_ERROR);
+        // DTD may change almost everything, let libxml2 do it
+        fallback = true;
+        return nullptr;
+    }
+    if (!isComment || !isCdata || !isDoctype) return nullptr;
+    parserError(XML_ERR_INTERNAL_ERROR);
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::comment(const char *p,
+                                                    const char *end)
+{
+    const char *body = p + 4;
+    std::size_t close = std::string_view(
+        body, static_cast<std::size_t>(end - body)).find("--");
+    if (close == std::string_view::npos) return nullptr;
+    const char *stop = body + close;
+    if (stop + 2 == end) return nullptr;
+    if (stop[2] != '>') parserError(XML_ERR_HYPHEN_IN_COMMENT);
+    checkChars(body, stop);
+    return stop + 3;
+}
+
+const char *XmlUnMarshaller_t::Tokenizer_t::cdata(const char *p,
+                                                  const char *end)
+{
+    if (state != ROOT)
+        parserError((state == PROLOG)
+                    ? XML_ERR_DOCUMENT_EMPTY
+                    : XML_ERR_DOCUMENT_END);
+
+    const char *body = p + 9;
+    std::size_t close = std::string_view(
+        body, static_cast<std::size_t>(end - body)).find("]]>");
+    if (close == std::string_view::npos) return nullptr;
+    const char *stop = body + close;
+    checkChars(body, stop);
+
+    // line ends are normalized to '\n'
+    for (const char *run = body; run != stop;) {
+        const char *cr = std::find(run, stop, '\r');
+        appendText(run, static_cast<std::size_t>(cr - run));
+        if (cr == stop) break;
+        if ((cr + 1 == stop) || (cr[1] != '\n')) appendDecoded("\n", 1);
+        run = cr + 1;
+    }
+    return stop + 3;
+}
+
+void XmlUnMarshaller_t::Tokenizer_t::closeElement() {
+    if (spanSize) {
+        unmarshaller.setValueData(span, static_cast<uint32_t>(spanSize));
+    } else {
+        unmarshaller.setValueData(
+            unmarshaller.localBuffer.data(),
+            static_cast<uint32_t>(unmarshaller.localBuffer.size()));
+    }
+
+    // text after the end tag is never used
+    unmarshaller.localBuffer.clear();
+    spanSize = 0;
+    collect = false;
+
+    std::size_t size = nameSizes.back();
+    unmarshaller.closeEntity(names.data() + names.size() - size,
+                             static_cast<unsigned int>(size));
+    names.resize(names.size() - size);
+    nameSizes.pop_back();
+    if (nameSizes.empty()) state = EPILOG;
+}
+
+void XmlUnMarshaller_t::Tokenizer_t::appendText(const char *data,
+                                                std::size_t size)
+{
+    if (!collect || !size) return;
+    if (spanSize && (span + spanSize == data)) {
+        spanSize += size;
+    } else if (!spanSize && unmarshaller.localBuffer.empty()) {
+        span = data;
+        spanSize = size;
+    } else {
+        flushText();
+        unmarshaller.localBuffer.append(data, size);
+    }
+}
+
+void XmlUnMarshaller_t::Tokenizer_t::appendDecoded(const char *data,
+                                                   std::size_t size)
+{
+    if (!collect) return;
+    flushText();
+    unmarshaller.localBuffer.append(data, size);
+}
+
+void XmlUnMarshaller_t::Tokenizer_t::flushText() {
+    if (spanSize) {
+        unmarshaller.localBuffer.append(span, spanSize);
+        spanSize = 0;
+    }
+}
+
 XmlUnMarshaller_t::XmlUnMarshaller_t(DataBuilder_t & dataBuilder)
         : exception(0),
           dataBuilder(dataBuilder),
           internalType(NONE),
           mainInternalType(NONE),
           faultCode(0),
+          parser(nullptr),
           versionCheck(true)
 {
+    if (builtinTokenizer)
+        tokenizer.reset(new Tokenizer_t(*this));
+    else
+        createParser();
+}
+
+XmlUnMarshaller_t::~XmlUnMarshaller_t() {
+    if (parser) {
+        // document is created by libxml2 when it parses DTD
+        if (parser->myDoc) xmlFreeDoc(parser->myDoc);
+        xmlFreeParserCtxt(parser);
+    }
+}
+
+void XmlUnMarshaller_t::createParser() {
     memset(&callbacks, 0, sizeof(xmlSAXHandler));
 
     //callbacks.initialized = XML_SAX2_MAGIC;
@@ -247,16 +1013,16 @@ XmlUnMarshaller_t::XmlUnMarshaller_t(DataBuilder_t & dataBuilder)
     callbacks.characters = &charactersXML;
 
     parser =  xmlCreatePushParserCtxt(&callbacks, this, nullptr, 0, nullptr);
-    parser->options = parser->options | XML_PARSE_HUGE;
 
 //    xmlCtxtResetPush(parser,0,0,0,"UTF-8");
 
     if (!parser)
         throw Error_t("Failed to create Xml parser");
+    parser->options = parser->options | XML_PARSE_HUGE;
 }
 
-XmlUnMarshaller_t::~XmlUnMarshaller_t() {
-    xmlFreeParserCtxt(parser);
+void XmlUnMarshaller_t::useBuiltinTokenizer(bool use) {
+    builtinTokenizer = use;
 }
 
 void XmlUnMarshaller_t::finish() {
@@ -274,7 +1040,6 @@ void XmlUnMarshaller_t::unMarshall(
         unsigned int size,
         char type)
 {
-    int terminate = (size == 0)?1:0;
     wantType = type;
     //try obtain version from xml
     if (size && versionCheck) {
@@ -292,17 +1057,27 @@ void XmlUnMarshaller_t::unMarshall(
         versionCheck = false;
     }
 
-    if (xmlParseChunk(parser, data, size, terminate)) {
-        const char *msg;
-        long code =  parser->errNo;
-        if (code < 0 || code >= static_cast<long>(sizeof(error_mapping))) {
-            msg = "Unknown";
-        } else
-            msg = error_mapping[code];
+    if (tokenizer) {
+        if (tokenizer->feed(data, size)) return;
 
-        throw StreamError_t::format("Parser error: < %s >", msg);
+        // the document is not for the tokenizer, libxml2 parses it from
+        // the beginning (nothing has been built yet)
+        std::string prolog;
+        prolog.swap(tokenizer->prologData());
+        tokenizer.reset();
+        createParser();
+        parseChunk(prolog.data(), static_cast<uint32_t>(prolog.size()), false);
     }
 
+    parseChunk(data, size, size == 0);
+}
+
+void XmlUnMarshaller_t::parseChunk(const char *data, unsigned int size,
+                                   bool terminate)
+{
+    if (xmlParseChunk(parser, data, static_cast<int>(size), terminate))
+        parserError(parser->errNo);
+
     switch (exception) {
 
     case EXC_STREAM:
@@ -322,129 +1097,56 @@ void XmlUnMarshaller_t::unMarshall(
 
 namespace {
 
-char getValueType(const char *name) {
-    long len = strlen(name);
-    if (len < 2)
-        return NONE;
-
-    switch (name[0]) {
-    case 'i': {
-        if (name[1] == 'n') {
-            //int
-            if (strcmp(name,"int") == 0)
-                return INT;
-        } else if (name[1] == '4' && len == 2) {
-            return INT;
-        } else if (name[1] == '8' && len == 2) {
-            return INT;
-        } else
-            return NONE;
-    }
-    break;
-    case 'd': {
-        if (name[1] == 'o') {
-            //double
-            if (strcmp(name,"double") == 0)
-                return DOUBLE;
-        } else if (name[1] == 'a') {
-            //date time
-            if (strcmp(name,"dateTime.iso8601") == 0)
-                return DATETIME;
-        } else
-            return NONE;
-    }
-    break;
-    case 's': {
-        if (len < 4 )
-            return NONE;
-
-        if (name[3] == 'i') {
-            //string
-            if (strcmp(name,"string") == 0)
-                return STRING;
-        } else if (name[3] == 'u') {
-            // struct
-            if (strcmp(name,"struct") == 0)
-                return STRUCT;
-        } else
-            return NONE;
-
-    }
-    break;
-    case 'b': {
-
-        if (name[1] == 'a') {
-            //binary
-            if (strcmp(name,"base64") == 0)
-                return BINARY;
-        } else if (name[1] == 'o') {//bool
-            if (strcmp(name,"boolean") == 0)
-                return BOOL;
-        } else
-            return NONE;
-    }
-    break;
-
+/** Type of the element, elements are recognized by length and first bytes.
+ */
+char getValueType(const char *name, unsigned int len) {
+    auto is = [&] (const char *literal) {
+        return !memcmp(name, literal, len);
+    };
 
-    case 'a': {
-        //array
-        if (strcmp(name,"array") == 0)
-            return ARRAY;
-    }
-    break;
-    case 'n': {
-        //membername structs
-        if (name[1] == 'a' && strcmp(name,"name") == 0) {
-            return MEMBER_NAME;
-        } else if (name[1] == 'i' && strcmp(name,"nil") == 0) {
-            return NULLTYPE;
-        } else {
-            return NONE;
-        }
-    }
-    break;
-    case 'm': {
-        if (len < 7)
-            return NONE;
-        switch (name[6]) {
-        case 'N': {
-            //method name
-            if (strcmp(name,"methodName") == 0)
-                return METHOD_NAME;
-        }
+    switch (len) {
+    case 2:
+        if ((name[0] == 'i') && ((name[1] == '4') || (name[1] == '8')))
+            return INT;
         break;
-        case 'C': {
-            //methodCall
-            if (strcmp(name,"methodCall") == 0)
-                return METHOD_CALL;
-        }
+    case 3:
+        if (name[0] == 'i' && is("int")) return INT;
+        if (name[0] == 'n' && is("nil")) return NULLTYPE;
         break;
-        case 'R': {
-            //method response
-            if (strcmp(name,"methodResponse") == 0)
-                return METHOD_RESPONSE;
+    case 4:
+        if (is("name")) return MEMBER_NAME;
+        break;
+    case 5:
+        switch (name[0]) {
+        // value: default to string
+        case 'v': if (is("value")) return STRING; break;
+        case 'a': if (is("array")) return ARRAY; break;
+        case 'f': if (is("fault")) return FAULT; break;
         }
         break;
-
-        default:
-            return NONE;
+    case 6:
+        switch (name[0]) {
+        case 'd': if (is("double")) return DOUBLE; break;
+        case 'b': if (is("base64")) return BINARY; break;
+        case 's':
+            if (name[3] == 'i' && is("string")) return STRING;
+            if (name[3] == 'u' && is("struct")) return STRUCT;
+            break;
         }
-    }
-    break;
-    case 'f': {
-        //fault
-        if (strcmp(name,"fault") == 0)
-            return FAULT;
-    }
-    break;
-    case 'v': {
-        // value: default to string
-        if (strcmp(name, "value") == 0)
-            return STRING;
-    }
-    break;
-    default:
-        return NONE;
+        break;
+    case 7:
+        if (is("boolean")) return BOOL;
+        break;
+    case 10:
+        if (name[6] == 'N' && is("methodName")) return METHOD_NAME;
+        if (name[6] == 'C' && is("methodCall")) return METHOD_CALL;
+        break;
+    case 14:
+        if (is("methodResponse")) return METHOD_RESPONSE;
+        break;
+    case 16:
+        if (is("dateTime.iso8601")) return DATETIME;
+        break;
     }
     return NONE;
 }
@@ -452,8 +1154,12 @@ char getValueType(const char *name) {
 } // namespace
 
 void XmlUnMarshaller_t::setValueType(const char *name) {
+    setValueType(name, static_cast<uint32_t>(strlen(name)));
+}
+
+void XmlUnMarshaller_t::setValueType(const char *name, unsigned int len) {
     char type;
-    switch (type = getValueType(name)) {
+    switch (type = getValueType(name, len)) {
     case INT:
     case BOOL:
     case DATETIME:
@@ -539,6 +1245,7 @@ void XmlUnMarshaller_t::setValueData(const char *data, unsigned int len) {
     case INT: {
         std::string intStr(data,len);
         char *end ;
+        errno = 0;
         long value = strtol(intStr.c_str(),&end,10);
         if (*end)
             throw StreamError_t("Integrity xml Int error !!!");
@@ -607,7 +1314,11 @@ void XmlUnMarshaller_t::setValueData(const char *data, unsigned int len) {
     }
 }
 void XmlUnMarshaller_t::closeEntity(const char *name) {
-    char type = getValueType(name);
+    closeEntity(name, static_cast<uint32_t>(strlen(name)));
+}
+
+void XmlUnMarshaller_t::closeEntity(const char *name, unsigned int len) {
+    char type = getValueType(name, len);
     internalType = NONE;
 
     if (mainInternalType == FAULT) {
@@ -42,6 +42,7 @@
 #include <libxml/parserInternals.h>
 #include <frpcerror.h>
 #include <string.h>
+#include <memory>
 
 
 
@@ -59,8 +60,10 @@ public:
 
     virtual ~XmlUnMarshaller_t();
     void setValueType(const char *name);
+    void setValueType(const char *name, unsigned int len);
     void setValueData(const char *data, unsigned int len);
     void closeEntity(const char *name);
+    void closeEntity(const char *name, unsigned int len);
 
     virtual void unMarshall(const char *data, unsigned int size, char type);
     virtual void finish();
@@ -75,7 +78,21 @@ public:
     /*! init xmlInitParser() for its thread sahttp://xmlsoft.org/threads.html */
     static void initXmlUnMarshaller_t();
     static void cleanupXmlUnMarshaller_t();
+
+    /**
+        @brief Enables or disables the built-in XML-RPC tokenizer for new
+        unmarshallers (enabled by default)
+
+        The tokenizer parses UTF-8 documents without DTD, other documents
+        are passed to libxml2. Disabled tokenizer means that libxml2 parses
+        all documents.
+    */
+    static void useBuiltinTokenizer(bool use);
 private:
+    class Tokenizer_t;
+
+    void createParser();
+    void parseChunk(const char *data, unsigned int size, bool terminate);
     //static void initCallbacks();
 
     DataBuilder_t &dataBuilder;
@@ -92,6 +109,7 @@ private:
     bool versionCheck;
 
     std::string faultString;
+    std::unique_ptr<Tokenizer_t> tokenizer;
 };
 
 }
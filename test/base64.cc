@@ -1,9 +1,13 @@
 #include <iostream>
+#include <cstdlib>
+#include <algorithm>
 #include <cassert>
 #include <memory>
+#include <string>
 
 #include "frpcbase64.h"
 #include "frpcb64writer.h"
+#include "frpcxmlmarshaller.h"
 
 using namespace FRPC;
 
@@ -84,6 +88,97 @@ void test_decode(std::string value, unsigned line_num) {
     test_stream_decode(value, line_num);
 }
 
+// straightforward encoder the block codecs are checked against
+std::string reference_b64(const std::string &value) {
+    static const char table[]
+        = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    unsigned int bits = 0;
+    int count = 0;
+    for (unsigned char c: value) {
+        bits = (bits << 8) | c;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            result += table[(bits >> count) & 0x3f];
+        }
+    }
+    if (count) result += table[(bits << (6 - count)) & 0x3f];
+    while (result.size() % 4) result += '=';
+    return result;
+}
+
+std::string random_data(size_t size, unsigned int seed) {
+    std::string data;
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        data += static_cast<char>(seed >> 16);
+    }
+    return data;
+}
+
+void test_block_codec() {
+    TEST(encode_b64("") == "");
+    TEST(encode_b64("f") == "Zg==");
+    TEST(encode_b64("fo") == "Zm8=");
+    TEST(encode_b64("foo") == "Zm9v");
+    TEST(encode_b64("foob") == "Zm9vYg==");
+    TEST(encode_b64("fooba") == "Zm9vYmE=");
+    TEST(encode_b64("foobar") == "Zm9vYmFy");
+
+    for (size_t size: {0, 1, 2, 11, 12, 13, 16, 27, 28, 29, 47, 48, 49,
+                       100, 255, 1000, 4099})
+    {
+        std::string value = random_data(size, static_cast<unsigned>(size));
+        std::string expected = reference_b64(value);
+
+        // one shot and split in two writes
+        TEST(encode_b64(value) == expected);
+        for (size_t i = 0; i <= std::min(size, size_t(50)); ++i) {
+            MyWriter_t mywriter;
+            Base64Writer_t writer(mywriter);
+            writer.write(value.data(), static_cast<unsigned>(i));
+            writer.write(value.data() + i,
+                         static_cast<unsigned>(size - i));
+            writer.flush();
+            TEST(mywriter.data == expected);
+        }
+
+        TEST(Base64::decode(expected.data(), expected.size()) == value);
+
+        // decoding in place
+        std::string inplace = expected;
+        Base64 decoder;
+        size_t decoded = decoder.process(inplace.data(), inplace.size(),
+                                         &inplace[0]);
+        TEST(inplace.substr(0, decoded) == value);
+
+        // lines of XML-RPC base64 end with CRLF, it is decoded as well
+        MyWriter_t xmlwriter;
+        XmlMarshaller_t::writeEncodeBase64(
+            xmlwriter, value.data(), static_cast<unsigned>(size));
+        std::string lines;
+        size_t quads = size / 3;
+        for (size_t i = 0; i < quads; ++i) {
+            lines += expected.substr(i * 4, 4);
+            if (!((i + 1) % 19)) lines += "\r\n";
+        }
+        lines += expected.substr(quads * 4);
+        if (quads % 19) lines += "\r\n";
+        TEST(xmlwriter.data == lines);
+        TEST(Base64::decode(lines.data(), lines.size()) == value);
+    }
+
+    // whitespace anywhere in a long sequence
+    std::string value = random_data(300, 1);
+    std::string encoded = reference_b64(value);
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        std::string spaced = encoded;
+        spaced.insert(i, " \n");
+        TEST(Base64::decode(spaced.data(), spaced.size()) == value);
+    }
+}
+
 // encode -> decode test
 // g++ base64.cc ../src/frpcwriter.cc  ../src/frpcbase64.cc ../src/frpcb64writer.cc && ./a.out
 int main(int /*argc*/, const char */*argv*/[])
@@ -101,5 +196,7 @@ int main(int /*argc*/, const char */*argv*/[])
     test_decode(std::string(101, '2'), __LINE__);
     test_decode(std::string(401, 'a'), __LINE__);
 
-    return 0;
+    test_block_codec();
+
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
 }
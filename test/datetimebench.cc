@@ -0,0 +1,194 @@
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "frpc.h"
+#include "frpcinternals.h"
+
+// Benchmark of ISO 8601 datetime handling: the previous implementation of
+// parseISODateTime() against the current one, and the allocating
+// getISODateTime() against formatISODateTime(). Both parsers must produce
+// the same values.
+
+struct Parsed_t {
+    short year;
+    char month, day, hour, minute, sec;
+    int timeZone;
+
+    bool operator==(const Parsed_t &other) const {
+        return (year == other.year) && (month == other.month)
+            && (day == other.day) && (hour == other.hour)
+            && (minute == other.minute) && (sec == other.sec)
+            && (timeZone == other.timeZone);
+    }
+};
+
+// the previous implementation of parseISODateTime()
+void previousParse(const char *data, long len, Parsed_t &result) {
+    result = Parsed_t();
+    const char *sit = data;
+    const char *end = data + len;
+
+    auto number = [&](int digits) {
+        std::string tmp;
+        for (int i = 0; sit != end && i < digits && isdigit(*sit); ++i)
+            tmp += *sit++;
+        return tmp;
+    };
+
+    while (sit != end && isspace(*sit)) ++sit;
+    std::string tmp = number(4);
+    if (tmp.empty()) throw FRPC::StreamError_t("Bad DATE format");
+    result.year = static_cast<short>(atoi(tmp.c_str()));
+    if (sit != end && *sit == '-') ++sit;
+    tmp = number(2);
+    if (tmp.empty()) throw FRPC::StreamError_t("Bad DATE format");
+    result.month = static_cast<char>(atoi(tmp.c_str()));
+    if (sit != end && *sit == '-') ++sit;
+    tmp = number(2);
+    if (tmp.empty()) throw FRPC::StreamError_t("Bad DATE format");
+    result.day = static_cast<char>(atoi(tmp.c_str()));
+    if (sit != end && (*sit == 'T' || *sit == 't' || *sit == ' ')) ++sit;
+    else return;
+    tmp = number(2);
+    if (tmp.empty()) return;
+    result.hour = static_cast<char>(atoi(tmp.c_str()));
+    if (sit != end && *sit == ':') ++sit;
+    tmp = number(2);
+    if (tmp.empty()) return;
+    result.minute = static_cast<char>(atoi(tmp.c_str()));
+    if (sit != end && *sit == ':') ++sit;
+    tmp = number(2);
+    if (tmp.empty()) return;
+    result.sec = static_cast<char>(atoi(tmp.c_str()));
+    if (sit != end && *sit == '.') {
+        ++sit;
+        while (sit != end && isdigit(*sit)) ++sit;
+    }
+    int tzsign = 0, tzhour = 0, tzmin = 0;
+    if (sit != end) tzsign = *sit++;
+    if (tzsign == '+' || tzsign == '-') {
+        tmp = number(2);
+        if (tmp.empty()) return;
+        tzhour = atoi(tmp.c_str());
+        if (sit != end && *sit == ':') ++sit;
+        tmp = number(2);
+        if (tmp.empty()) return;
+        tzmin = atoi(tmp.c_str());
+    }
+    while (sit != end && isspace(*sit)) ++sit;
+    if (sit != end) return;
+    result.timeZone = (tzhour * 60 + tzmin) * ((tzsign == '+')? -60: 60);
+}
+
+void currentParse(const char *data, long len, Parsed_t &result) {
+    FRPC::parseISODateTime(data, len, result.year, result.month, result.day,
+                           result.hour, result.minute, result.sec,
+                           result.timeZone);
+}
+
+std::vector<std::string> makeDates(int count, bool extended) {
+    std::vector<std::string> dates;
+    dates.reserve(count);
+    char buffer[64];
+    for (int i = 0; i < count; ++i) {
+        unsigned int seed = static_cast<unsigned int>(i) * 2654435761u;
+        int year = 1900 + seed % 250, month = 1 + seed / 7 % 12;
+        int day = 1 + seed / 11 % 28, hour = seed / 13 % 24;
+        int minute = seed / 17 % 60, sec = seed / 19 % 60;
+        int tz = static_cast<int>(seed / 23 % 49) - 24;
+        if (extended) {
+            snprintf(buffer, sizeof(buffer),
+                     "%04d-%02d-%02dT%02d:%02d:%02d.%03u%+03d:%02d", year,
+                     month, day, hour, minute, sec, seed % 1000, tz / 2,
+                     tz % 2 ? 30 : 0);
+            dates.emplace_back(buffer);
+        } else {
+            char text[FRPC::ISO_DATETIME_BUFFER_SIZE];
+            dates.emplace_back(text, FRPC::formatISODateTime(
+                text, static_cast<short>(year), static_cast<char>(month),
+                static_cast<char>(day), static_cast<char>(hour),
+                static_cast<char>(minute), static_cast<char>(sec),
+                tz * 1800));
+        }
+    }
+    return dates;
+}
+
+template <typename Function_t>
+double measure(int iterations, Function_t function) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) function();
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void report(const char *name, double seconds, std::size_t count) {
+    std::cout << std::setw(24) << std::left << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(8)
+              << seconds * 1e9 / double(count) << " ns/datetime" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 5;
+    const int count = 1000000;
+    long sink = 0;
+
+    for (bool extended: {false, true}) {
+        std::vector<std::string> dates = makeDates(count, extended);
+        for (const std::string &date: dates) {
+            Parsed_t previous, current;
+            previousParse(date.data(), long(date.size()), previous);
+            currentParse(date.data(), long(date.size()), current);
+            if (!(previous == current)) {
+                std::cerr << "Parsed values differ: " << date << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        std::size_t total = dates.size() * std::size_t(iterations);
+        report(extended ? "previous parse extended" : "previous parse",
+               measure(iterations, [&] {
+            for (const std::string &date: dates) {
+                Parsed_t parsed;
+                previousParse(date.data(), long(date.size()), parsed);
+                sink += parsed.sec;
+            }
+        }), total);
+        report(extended ? "current parse extended" : "current parse",
+               measure(iterations, [&] {
+            for (const std::string &date: dates) {
+                Parsed_t parsed;
+                currentParse(date.data(), long(date.size()), parsed);
+                sink += parsed.sec;
+            }
+        }), total);
+    }
+
+    std::size_t total = std::size_t(count) * std::size_t(iterations);
+    report("getISODateTime", measure(iterations, [&] {
+        for (int i = 0; i < count; ++i) {
+            sink += long(FRPC::getISODateTime(
+                static_cast<short>(1900 + i % 250), char(1 + i % 12),
+                char(1 + i % 28), char(i % 24), char(i % 60), char(i % 59),
+                i % 49 * 1800).size());
+        }
+    }), total);
+    report("formatISODateTime", measure(iterations, [&] {
+        char buffer[FRPC::ISO_DATETIME_BUFFER_SIZE];
+        for (int i = 0; i < count; ++i) {
+            sink += long(FRPC::formatISODateTime(
+                buffer, static_cast<short>(1900 + i % 250), char(1 + i % 12),
+                char(1 + i % 28), char(i % 24), char(i % 60), char(i % 59),
+                i % 49 * 1800));
+        }
+    }), total);
+
+    // keep the results alive
+    return (sink == 42) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
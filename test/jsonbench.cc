@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "frpc.h"
+#include "frpcwriter.h"
+#include "frpcmarshaller.h"
+
+// Benchmark of JSON string escaping: the previous byte by byte implementation
+// of JSONMarshaller_t string quoting against the current one. Both are run
+// on the same data and they must produce the same output.
+
+class StringWriter_t: public FRPC::Writer_t {
+public:
+    void write(const char *data, unsigned int size) override {
+        target.append(data, size);
+    }
+
+    void flush() override {}
+
+    std::string target;
+};
+
+// the previous implementation of JSONMarshaller_t string quoting
+std::string escape(unsigned int ch) {
+    std::ostringstream os;
+    os << "\\u"
+       << std::hex
+       << std::setfill('0')
+       << std::setw(4)
+       << ch;
+    return os.str();
+}
+
+void quote(FRPC::Writer_t &writer, const char *ipos, unsigned int size) {
+    writer.write("\"", 1);
+    for (const char *epos = ipos + size; ipos != epos; ++ipos) {
+        switch (*ipos) {
+        case '"':
+            writer.write("\\\"", 2);
+            break;
+        case '\\':
+            writer.write("\\\\", 2);
+            break;
+        case '\r':
+            writer.write("\\r", 2);
+            break;
+        case '\n':
+            writer.write("\\n", 2);
+            break;
+        case '\t':
+            writer.write("\\t", 2);
+            break;
+        default:
+            if (::iscntrl(*ipos)) {
+                writer.write(escape(*ipos).c_str(), 6);
+            } else {
+                writer.write(ipos, 1);
+            }
+        }
+    }
+    writer.write("\"", 1);
+}
+
+std::string reference(const std::string &value) {
+    StringWriter_t writer;
+    quote(writer, value.data(), static_cast<unsigned int>(value.size()));
+    return writer.target;
+}
+
+std::string current(const std::string &value) {
+    StringWriter_t writer;
+    FRPC::ProtocolVersion_t version;
+    std::unique_ptr<FRPC::Marshaller_t> marshaller(
+        FRPC::Marshaller_t::create(FRPC::Marshaller_t::JSON, writer, version));
+    marshaller->packString(value.data(),
+                           static_cast<unsigned int>(value.size()));
+    marshaller->flush();
+    return writer.target;
+}
+
+std::string makeData(std::size_t size, unsigned int escapeEvery) {
+    const std::string text = "Příliš žluťoučký kůň úpěl ďábelské ódy. "
+                             "The quick brown fox jumps over the lazy dog. ";
+    std::string data;
+    data.reserve(size);
+    for (std::size_t i = 0; data.size() < size; ++i) {
+        data += text[i % text.size()];
+        if (escapeEvery && !(i % escapeEvery))
+            data += "\"\\\n\x01"[i % 4];
+    }
+    return data;
+}
+
+template <typename Quote_t>
+double measure(Quote_t quote, const std::string &data, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        quote(data);
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+    return double(data.size()) * iterations / elapsed.count() / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 20;
+
+    // every byte value is escaped the same way
+    std::string bytes;
+    for (int ch = 0; ch < 256; ++ch) bytes += static_cast<char>(ch);
+    for (std::size_t i = 0; i <= bytes.size(); ++i) {
+        if (current(bytes.substr(i)) != reference(bytes.substr(i))) {
+            std::cerr << "Output differs from the reference" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const struct {
+        const char *name;
+        unsigned int escapeEvery;
+    } cases[] = {
+        {"plain text", 0},
+        {"sparse escapes", 1000},
+        {"dense escapes", 8},
+    };
+
+    for (const auto &c: cases) {
+        std::string data = makeData(1 << 20, c.escapeEvery);
+        if (current(data) != reference(data)) {
+            std::cerr << "Output differs from the reference" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        double before = measure(reference, data, iterations);
+        double after = measure(current, data, iterations);
+        std::cout << std::setw(16) << std::left << c.name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << " previous " << std::setw(8) << before << " MB/s"
+                  << "   current " << std::setw(8) << after << " MB/s"
+                  << "   speedup " << after / before << "x" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
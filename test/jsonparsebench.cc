@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "frpc.h"
+#include "frpccompare.h"
+#include "frpcwriter.h"
+#include "frpcmarshaller.h"
+#include "frpcunmarshaller.h"
+#include "frpctreebuilder.h"
+#include "frpctreefeeder.h"
+
+// Benchmark of JSON method call parsing (JSONUnMarshaller_t) against
+// XML-RPC parsing of the same call. Both have to produce the same
+// parameters.
+
+class StringWriter_t: public FRPC::Writer_t {
+public:
+    void write(const char *data, unsigned int size) override {
+        target.append(data, size);
+    }
+
+    void flush() override {}
+
+    std::string target;
+};
+
+FRPC::Array_t &makeParams(FRPC::Pool_t &pool, int items) {
+    FRPC::Array_t &list = pool.Array();
+    for (int i = 0; i < items; ++i) {
+        list.append(pool.Struct(
+            "id", pool.Int(i * 7919),
+            "name", pool.String("Item \"name\" number " + std::to_string(i)),
+            "ratio", pool.Double(i / 3.0 + 0.1),
+            "active", pool.Bool(i % 2),
+            "tags", pool.Array(pool.String("first"), pool.String("second"))));
+    }
+    return pool.Array(list, pool.String("options"), pool.Int(42));
+}
+
+std::string marshall(unsigned int type, FRPC::Array_t &params) {
+    StringWriter_t writer;
+    FRPC::ProtocolVersion_t version;
+    std::unique_ptr<FRPC::Marshaller_t> marshaller(
+        FRPC::Marshaller_t::create(type, writer, version));
+    FRPC::TreeFeeder_t feeder(*marshaller);
+    if (type == FRPC::Marshaller_t::JSON) {
+        // JSON array is the parameter list
+        feeder.feedValue(params);
+    } else {
+        marshaller->packMethodCall("bench.method");
+        for (std::size_t i = 0; i < params.size(); ++i)
+            feeder.feedValue(params[i]);
+    }
+    marshaller->flush();
+    return writer.target;
+}
+
+FRPC::Value_t &unmarshall(FRPC::Pool_t &pool, unsigned int type,
+                          const std::string &data)
+{
+    FRPC::TreeBuilder_t builder(pool);
+    std::unique_ptr<FRPC::UnMarshaller_t> unmarshaller(
+        FRPC::UnMarshaller_t::create(type, builder, "/bench/method"));
+    // data come in chunks from the network
+    const std::size_t chunk = 1 << 14;
+    for (std::size_t i = 0; i < data.size(); i += chunk) {
+        unmarshaller->unMarshall(
+            data.data() + i,
+            static_cast<unsigned int>(std::min(chunk, data.size() - i)),
+            FRPC::UnMarshaller_t::TYPE_METHOD_CALL);
+    }
+    unmarshaller->finish();
+    if (builder.getUnMarshaledMethodName() != "bench.method")
+        throw std::runtime_error("Invalid method name");
+    return builder.getUnMarshaledData();
+}
+
+// returns seconds per call
+double measure(unsigned int type, const std::string &data, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        FRPC::Pool_t pool;
+        unmarshall(pool, type, data);
+    }
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void report(const char *name, const std::string &data, double seconds) {
+    std::cout << std::setw(5) << std::left << name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(8) << double(data.size()) / seconds / 1e6
+              << " MB/s " << std::setw(8) << 1.0 / seconds << " calls/s"
+              << "   (" << data.size() << " bytes per call)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 20;
+
+    FRPC::Pool_t pool;
+    FRPC::Array_t &params = makeParams(pool, 10000);
+    std::string json = marshall(FRPC::Marshaller_t::JSON, params);
+    std::string xml = marshall(FRPC::Marshaller_t::XML_RPC_COMPACT, params);
+
+    // both formats carry the same data
+    if ((FRPC::compare(unmarshall(pool, FRPC::UnMarshaller_t::JSON, json),
+                       params) != 0)
+        || (FRPC::compare(unmarshall(pool, FRPC::UnMarshaller_t::XML_RPC, xml),
+                          params) != 0))
+    {
+        std::cerr << "Unmarshalled data differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    report("json", json, measure(FRPC::UnMarshaller_t::JSON, json, iterations));
+    report("xml", xml, measure(FRPC::UnMarshaller_t::XML_RPC, xml, iterations));
+
+    return EXIT_SUCCESS;
+}
@@ -17,6 +17,7 @@
 #include "frpcwriter.h"
 #include "frpctreefeeder.h"
 #include "frpccompare.h"
+#include "frpchash.h"
 
 /*
 
@@ -225,7 +226,8 @@ enum ErrorType_t {
     ERROR_INVALID_MESSAGE_TYPE,
     ERROR_DATA_AFTER_END,
     ERROR_ENTITY_TOO_LARGE,
-    ERROR_BAD_CALL_NAME
+    ERROR_BAD_CALL_NAME,
+    ERROR_INVALID_KEY_INDEX
 };
 
 const char *errorTypeStr(ErrorType_t et) {
@@ -245,6 +247,7 @@ const char *errorTypeStr(ErrorType_t et) {
     case ERROR_DATA_AFTER_END:       return "data after end";
     case ERROR_ENTITY_TOO_LARGE:     return "entity too large";
     case ERROR_BAD_CALL_NAME:        return "bad call name";
+    case ERROR_INVALID_KEY_INDEX:    return "bad key index";
     case ERROR_UNKNOWN:
     default:
         return "unknown";
@@ -290,6 +293,9 @@ ErrorType_t parseErrorType(const FRPC::StreamError_t &err) {
     if (err.what() == std::string("Size of int is 0 or > 4 !!!"))
         return ERROR_INVALID_INT_SIZE;
 
+    if (err.what() == std::string("Invalid packed array item width"))
+        return ERROR_INVALID_INT_SIZE;
+
     if (err.what() == std::string("Size of string length is 0 !!!"))
         return ERROR_INVALID_STR_SIZE;
 
@@ -341,6 +347,9 @@ ErrorType_t parseErrorType(const FRPC::StreamError_t &err) {
     if (err.what() == std::string("Bad call name"))
         return ERROR_BAD_CALL_NAME;
 
+    if (err.what() == std::string("Invalid struct member index"))
+        return ERROR_INVALID_KEY_INDEX;
+
     error() << "Unhandled FRPC::StreamError_t " << err.what() << std::endl;
 
     return ERROR_UNKNOWN;
@@ -571,6 +580,18 @@ runTest(const TestSettings_t &ts, const TestInstance_t &ti,
             result.set(TEST_FAILED, result.corrected + " <> " + ti.text);
             return result;
         }
+
+        // the hash of encoded data must match the hash of the value
+        const std::string &mname = builder.getUnMarshaledMethodName();
+        uint64_t hash = mname.empty()
+            ? FRPC::hash(builder.getUnMarshaledData())
+            : FRPC::hash(mname, FRPC::Array(builder.getUnMarshaledData()));
+        if (FRPC::hashBinary(ti.binary.data(), ti.binary.size()) != hash) {
+            result.set(TEST_FAILED, "Hash of binary data differs");
+            return result;
+        }
+        ++passedChecks;
+
         bool wasError = false;
 
         // run the test with combo of offsets+sizes
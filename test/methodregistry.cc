@@ -0,0 +1,253 @@
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "frpc.h"
+#include "frpcwriter.h"
+#include "frpcvalue.h"
+#include "frpcarray.h"
+#include "frpcstruct.h"
+#include "frpcpool.h"
+#include "frpcpackedarray.h"
+#include "frpcint.h"
+#include "frpcstring.h"
+#include "frpcfault.h"
+#include "frpcmarshaller.h"
+#include "frpcmethodregistry.h"
+
+size_t tests = 0;
+size_t fails = 0;
+
+bool expect(bool condition, const char *mark, const char *file, int line) {
+    ++tests;
+    if (!condition) {
+        fails++;
+        std::cerr << file << ":" << line
+                  << ":1: error: FAILED TEST: " << mark << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#define TEST(condition) expect(condition, ""#condition"", __FILE__, __LINE__)
+
+class StringWriter_t : public FRPC::Writer_t {
+public:
+    virtual void write(const char *data, unsigned int size ) {
+        target.append(data, size);
+    }
+
+    virtual void flush() {
+    }
+
+
+    std::string target;
+};
+
+struct Counter_t {
+    Counter_t(): calls(0) {}
+
+    FRPC::Value_t &lookup(FRPC::Pool_t &pool, FRPC::Array_t &params) {
+        ++calls;
+        if (params.size() && params[0].getType() == FRPC::Int_t::TYPE
+            && FRPC::Int(params[0]).getValue() < 0)
+            throw FRPC::Fault_t(400, "negative id");
+        return pool.Struct("status", pool.Int(200),
+                           "calls", pool.Int(calls),
+                           "params", params.clone(pool));
+    }
+
+    int calls;
+};
+
+std::string call(FRPC::MethodRegistry_t &registry, const std::string &name,
+                 FRPC::Array_t &params, unsigned int typeOut)
+{
+    StringWriter_t sw;
+    registry.processCall("127.0.0.1", name, params, sw, typeOut,
+                         FRPC::ProtocolVersion_t(3, 0));
+    return sw.target;
+}
+
+void testResponseCache() {
+    Counter_t counter;
+    FRPC::MethodRegistry_t registry(nullptr, false);
+    registry.registerMethod("lookup",
+                            FRPC::boundMethod(&Counter_t::lookup, counter));
+    registry.registerMethod("uncached",
+                            FRPC::boundMethod(&Counter_t::lookup, counter));
+    registry.enableResponseCache("lookup",
+                                 FRPC::ResponseCache_t::Config_t(0, 2));
+    TEST(registry.responseCache("lookup") != nullptr);
+    TEST(registry.responseCache("uncached") == nullptr);
+
+    FRPC::Pool_t pool;
+    FRPC::Array_t &params1 = pool.Array(pool.Int(1), pool.String("a"));
+    FRPC::Array_t &params1b = pool.Array(pool.Int(1), pool.String("a"));
+    FRPC::Array_t &params2 = pool.Array(pool.Int(2), pool.String("a"));
+    FRPC::Array_t &params3 = pool.Array(pool.Int(3));
+    FRPC::Array_t &fault = pool.Array(pool.Int(-1));
+
+    // the first call is dispatched, the equal one is served from cache
+    std::string bin = call(registry, "lookup", params1,
+                           FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 1);
+    TEST(call(registry, "lookup", params1b,
+              FRPC::Marshaller_t::BINARY_RPC) == bin);
+    TEST(counter.calls == 1);
+
+    // other protocol is marshalled from cached result
+    std::string xml = call(registry, "lookup", params1,
+                           FRPC::Marshaller_t::XML_RPC);
+    TEST(counter.calls == 1);
+    TEST(xml.find("<i4>1</i4>") != std::string::npos);
+    TEST(call(registry, "lookup", params1,
+              FRPC::Marshaller_t::XML_RPC) == xml);
+
+    // the pool variant shares the cache
+    FRPC::Pool_t resultPool;
+    FRPC::Struct_t &res = FRPC::Struct(
+            registry.processCall("127.0.0.1", "lookup", params1, resultPool));
+    TEST(counter.calls == 1);
+    TEST(FRPC::Int(res["calls"]).getValue() == 1);
+
+    // different params are dispatched
+    call(registry, "lookup", params2, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 2);
+    TEST(registry.responseCache("lookup")->size() == 2);
+
+    // least recently used entry (params2) is evicted
+    call(registry, "lookup", params1, FRPC::Marshaller_t::BINARY_RPC);
+    call(registry, "lookup", params3, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 3);
+    TEST(registry.responseCache("lookup")->size() == 2);
+    call(registry, "lookup", params1, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 3);
+    call(registry, "lookup", params2, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 4);
+
+    // faults are not cached
+    call(registry, "lookup", fault, FRPC::Marshaller_t::BINARY_RPC);
+    call(registry, "lookup", fault, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 6);
+
+    // uncached method is always dispatched
+    call(registry, "uncached", params1, FRPC::Marshaller_t::BINARY_RPC);
+    call(registry, "uncached", params1, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 8);
+
+    // disabling drops the cache
+    registry.disableResponseCache("lookup");
+    call(registry, "lookup", params1, FRPC::Marshaller_t::BINARY_RPC);
+    TEST(counter.calls == 9);
+
+    bool thrown = false;
+    try {
+        registry.enableResponseCache("unknown");
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    TEST(thrown);
+}
+
+struct Numbers_t {
+    Numbers_t(): calls(0) {}
+
+    FRPC::Value_t &numbers(FRPC::Pool_t &pool, FRPC::Array_t &) {
+        ++calls;
+        std::vector<FRPC::Int_t::value_type> values(100);
+        for (std::size_t i = 0; i < values.size(); ++i)
+            values[i] = FRPC::Int_t::value_type(i);
+        return pool.Struct("numbers", pool.IntArray(values));
+    }
+
+    int calls;
+};
+
+/** Reads results passed to callbacks (cached ones on cache hit).
+ */
+struct SumCallbacks_t: public FRPC::MethodRegistry_t::Callbacks_t {
+    SumCallbacks_t(): errors(0) {}
+
+    void preRead() override {}
+
+    void preProcess(const std::string &, const std::string &,
+                    FRPC::Array_t &) override
+    {}
+
+    void postProcess(const std::string &, const std::string &,
+                     const FRPC::Array_t &, const FRPC::Value_t &result,
+                     const FRPC::MethodRegistry_t::TimeDiff_t &) override
+    {
+        FRPC::Int_t::value_type sum = 0;
+        for (auto *item: FRPC::Array(FRPC::Struct(result)["numbers"]))
+            sum += FRPC::Int(*item).getValue();
+        if (sum != 4950) ++errors;
+    }
+
+    void postProcess(const std::string &, const std::string &,
+                     const FRPC::Array_t &, const FRPC::Fault_t &,
+                     const FRPC::MethodRegistry_t::TimeDiff_t &) override
+    {
+        ++errors;
+    }
+
+    std::atomic<int> errors;
+};
+
+void testCachedPackedArray() {
+    Numbers_t numbers;
+    SumCallbacks_t callbacks;
+    FRPC::MethodRegistry_t registry(&callbacks, false);
+    registry.registerMethod("numbers",
+                            FRPC::boundMethod(&Numbers_t::numbers, numbers));
+    registry.enableResponseCache("numbers",
+                                 FRPC::ResponseCache_t::Config_t(0, 2));
+
+    // the cached copy is not accessed before the threads start
+    FRPC::Pool_t pool;
+    registry.processCall("127.0.0.1", "numbers", pool.Array(), pool);
+
+    // cached packed array is first read by concurrent callers
+    std::atomic<int> errors(0);
+    std::atomic<int> started(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (++started; started < 4;) std::this_thread::yield();
+            for (int i = 0; i < 50; ++i) {
+                FRPC::Pool_t resultPool;
+                FRPC::Array_t &callParams = resultPool.Array();
+                FRPC::Value_t &res = registry.processCall(
+                        "127.0.0.1", "numbers", callParams, resultPool);
+                FRPC::Int_t::value_type sum = 0;
+                for (auto *item: FRPC::Array(FRPC::Struct(res)["numbers"]))
+                    sum += FRPC::Int(*item).getValue();
+                if (sum != 4950) ++errors;
+                if (call(registry, "numbers", callParams,
+                         FRPC::Marshaller_t::XML_RPC).find("<i4>99</i4>")
+                    == std::string::npos)
+                    ++errors;
+                if (call(registry, "numbers", callParams,
+                         FRPC::Marshaller_t::JSON).find("[0,1,2,")
+                    == std::string::npos)
+                    ++errors;
+            }
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    TEST(errors == 0);
+    TEST(callbacks.errors == 0);
+    TEST(numbers.calls == 1);
+}
+
+int main(int /*argc*/, char */*argv*/[]) {
+    testResponseCache();
+    testCachedPackedArray();
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
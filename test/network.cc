@@ -0,0 +1,883 @@
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "frpc.h"
+#include "frpclistener.h"
+#include "frpcresolver.h"
+#include "frpcconnector.h"
+#include "frpchttp.h"
+#include "frpchttperror.h"
+#include "frpctypeerror.h"
+#include "frpcserver.h"
+#include "frpcserverproxy.h"
+#include "frpclogging.h"
+
+size_t tests = 0;
+size_t fails = 0;
+
+bool expect(bool condition, const char *mark, const char *file, int line) {
+    ++tests;
+    if (!condition) {
+        fails++;
+        std::cerr << file << ":" << line
+                  << ":1: error: FAILED TEST: " << mark << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#define TEST(condition) expect(condition, ""#condition"", __FILE__, __LINE__)
+
+/** Connects to the TCP port on loopback, -1 on failure. */
+int connectTcp(unsigned short port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/** Binds (and maybe connects) unix-domain socket, -1 on failure. */
+int unixSocket(const std::string &path, bool connect) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    auto *raw = reinterpret_cast<struct sockaddr*>(&address);
+    if ((connect ? ::connect(fd, raw, sizeof(address))
+                 : ::bind(fd, raw, sizeof(address))) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool exists(const std::string &path) {
+    return !::access(path.c_str(), F_OK);
+}
+
+void testListener() {
+    {
+        FRPC::Listener_t listener("http://127.0.0.1:0");
+        TEST(listener.port() != 0);
+
+        int client = connectTcp(listener.port());
+        if (TEST(client >= 0)) {
+            std::string address = "unknown";
+            int server = listener.accept(&address);
+            TEST(server >= 0);
+            TEST(address == "127.0.0.1");
+            TEST(::write(client, "x", 1) == 1);
+            char data = 0;
+            TEST((::read(server, &data, 1) == 1) && (data == 'x'));
+            ::close(server);
+            ::close(client);
+        }
+    }
+
+    std::string path = "/tmp/frpc-test-listener."
+        + std::to_string(::getpid());
+    std::string url = "unix://" + path;
+    ::unlink(path.c_str());
+    {
+        FRPC::Listener_t listener(url);
+        TEST(listener.port() == 0);
+        TEST(exists(path));
+
+        int client = unixSocket(path, true);
+        if (TEST(client >= 0)) {
+            std::string address = "unknown";
+            int server = listener.accept(&address);
+            TEST(server >= 0);
+            TEST(address.empty());
+            ::close(server);
+            ::close(client);
+        }
+
+        // live socket is not replaced
+        bool inUse = false;
+        try {
+            FRPC::Listener_t other(url);
+        } catch (const FRPC::HTTPError_t &e) {
+            inUse = strstr(e.message().c_str(), "in use") != nullptr;
+        }
+        TEST(inUse);
+        client = unixSocket(path, true);
+        if (TEST(client >= 0)) {
+            ::close(listener.accept());
+            ::close(client);
+        }
+    }
+    TEST(!exists(path));
+
+    // socket file of a process which is gone is replaced
+    int stale = unixSocket(path, false);
+    TEST(stale >= 0);
+    ::close(stale);
+    TEST(exists(path));
+    {
+        FRPC::Listener_t listener(url);
+        int client = unixSocket(path, true);
+        if (TEST(client >= 0)) {
+            ::close(listener.accept());
+            ::close(client);
+        }
+    }
+    TEST(!exists(path));
+}
+
+FRPC::Resolver_t::Address_t address(const char *ip, unsigned short port) {
+    FRPC::Resolver_t::Address_t result;
+    memset(&result.address, 0, sizeof(result.address));
+    auto *in = reinterpret_cast<struct sockaddr_in*>(&result.address);
+    in->sin_family = AF_INET;
+    in->sin_port = htons(port);
+    inet_pton(AF_INET, ip, &in->sin_addr);
+    result.family = AF_INET;
+    result.length = sizeof(struct sockaddr_in);
+    return result;
+}
+
+std::string ip(const FRPC::Resolver_t::Address_t &address) {
+    char buffer[INET6_ADDRSTRLEN] = {0};
+    const void *raw = (address.family == AF_INET6)
+        ? static_cast<const void*>(&reinterpret_cast<const sockaddr_in6*>(
+                  &address.address)->sin6_addr)
+        : static_cast<const void*>(&reinterpret_cast<const sockaddr_in*>(
+                  &address.address)->sin_addr);
+    return inet_ntop(address.family, raw, buffer, sizeof(buffer));
+}
+
+/** Lookup resolving every host to 127.0.0.1 and 127.0.0.2.
+ */
+struct FakeDns_t {
+    FakeDns_t(): calls(0), fail(false) {}
+
+    std::vector<FRPC::Resolver_t::Address_t>
+    operator()(const std::string &host, unsigned short port, int) {
+        ++calls;
+        if (fail) {
+            throw FRPC::HTTPError_t(FRPC::HTTP_DNS,
+                                    "Cannot resolve host '" + host + "'.");
+        }
+        return {address("127.0.0.1", port), address("127.0.0.2", port)};
+    }
+
+    std::atomic<int> calls;
+    std::atomic<bool> fail;
+};
+
+void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+std::string resolveError(FRPC::Resolver_t &resolver, const std::string &host) {
+    try {
+        resolver.resolve(host, 80, AF_INET);
+    } catch (const FRPC::HTTPError_t &e) {
+        return (e.errorNum() == FRPC::HTTP_DNS) ? e.message() : "";
+    }
+    return "";
+}
+
+void testResolver() {
+    {
+        FRPC::Resolver_t resolver;
+        auto host = resolver.resolve("127.0.0.1", 8080, AF_INET);
+        TEST(host->size() == 1);
+        TEST(ip((*host)[0]) == "127.0.0.1");
+        TEST(ntohs(reinterpret_cast<const sockaddr_in*>(
+                       &(*host)[0].address)->sin_port) == 8080);
+        TEST(resolver.resolve("127.0.0.1", 8080, AF_INET) == host);
+        TEST(resolver.resolve("127.0.0.1", 8081, AF_INET) != host);
+        auto host6 = resolver.resolve("::1", 8080, AF_INET6);
+        TEST((host6->size() == 1) && (ip((*host6)[0]) == "::1"));
+    }
+    {
+        // ttl 0 disables the cache
+        FRPC::Resolver_t resolver(FRPC::Resolver_t::Config_t(0));
+        TEST(resolver.resolve("127.0.0.1", 80, AF_INET)
+             != resolver.resolve("127.0.0.1", 80, AF_INET));
+    }
+    {
+        FakeDns_t dns;
+        FRPC::Resolver_t::Config_t config(100, 100);
+        config.lookup = std::ref(dns);
+        FRPC::Resolver_t resolver(config);
+
+        auto host = resolver.resolve("fake", 80, AF_INET);
+        TEST((host->size() == 2) && (ip((*host)[1]) == "127.0.0.2"));
+        TEST(resolver.resolve("fake", 80, AF_INET) == host);
+        TEST(dns.calls == 1);
+
+        // expired entry is served while the worker refreshes it
+        sleepMs(120);
+        TEST(resolver.resolve("fake", 80, AF_INET) == host);
+        for (int i = 0; (i < 100) && (dns.calls < 2); ++i) sleepMs(10);
+        TEST(dns.calls == 2);
+        for (int i = 0; (i < 100) && (resolver.resolve("fake", 80, AF_INET)
+                                      == host); ++i)
+        {
+            sleepMs(10);
+        }
+        auto refreshed = resolver.resolve("fake", 80, AF_INET);
+        TEST(refreshed != host);
+
+        // older entry is resolved right away
+        sleepMs(250);
+        TEST(resolver.resolve("fake", 80, AF_INET) != refreshed);
+        TEST(dns.calls == 3);
+
+        // failure is cached for negativeTtl
+        dns.fail = true;
+        TEST(resolveError(resolver, "other") == "Cannot resolve host 'other'.");
+        TEST(resolveError(resolver, "other") == "Cannot resolve host 'other'.");
+        TEST(dns.calls == 4);
+        sleepMs(120);
+        TEST(!resolveError(resolver, "other").empty());
+        TEST(dns.calls == 5);
+        dns.fail = false;
+        sleepMs(120);
+        TEST(resolveError(resolver, "other").empty());
+        TEST(dns.calls == 6);
+    }
+    {
+        // the least recently resolved entry is dropped to make room
+        FakeDns_t dns;
+        FRPC::Resolver_t::Config_t config(60000, 1000, 1000, 2);
+        config.lookup = std::ref(dns);
+        FRPC::Resolver_t resolver(config);
+        resolver.resolve("a", 80, AF_INET);
+        sleepMs(2);
+        resolver.resolve("b", 80, AF_INET);
+        resolver.resolve("c", 80, AF_INET);
+        TEST(dns.calls == 3);
+        resolver.resolve("b", 80, AF_INET);
+        resolver.resolve("c", 80, AF_INET);
+        TEST(dns.calls == 3);
+        resolver.resolve("a", 80, AF_INET);
+        TEST(dns.calls == 4);
+    }
+    {
+        FRPC::Resolver_t::Host_t host({address("127.0.0.1", 80),
+                                       address("127.0.0.2", 80),
+                                       address("127.0.0.3", 80)}, 100);
+        using Order_t = std::vector<std::size_t>;
+        TEST(host.order() == Order_t({0, 1, 2}));
+        TEST(host.order() == Order_t({1, 2, 0}));
+        TEST(host.order() == Order_t({2, 0, 1}));
+
+        // failed address is tried last until failureTimeout passes
+        host.failed(1);
+        TEST(host.order() == Order_t({0, 2, 1}));
+        TEST(host.order() == Order_t({2, 0, 1}));
+        host.succeeded(1);
+        TEST(host.order() == Order_t({2, 0, 1}));
+        host.failed(2);
+        TEST(host.order() == Order_t({0, 1, 2}));
+        sleepMs(120);
+        TEST(host.order() == Order_t({1, 2, 0}));
+    }
+}
+
+/** Lookup resolving every host to the addresses.
+ */
+struct StaticDns_t {
+    std::vector<FRPC::Resolver_t::Address_t>
+    operator()(const std::string &, unsigned short port, int) const {
+        std::vector<FRPC::Resolver_t::Address_t> result;
+        for (const char *ip: ips) result.push_back(address(ip, port));
+        return result;
+    }
+
+    std::vector<const char*> ips;
+};
+
+void testParallelConnector() {
+    FRPC::Listener_t listener("http://127.0.0.2:0");
+    std::string url = "http://fake:" + std::to_string(listener.port())
+        + "/RPC2";
+
+    // nobody listens on 127.0.0.1 at the port, it refuses the connection
+    FRPC::Resolver_t::Config_t config;
+    config.lookup = StaticDns_t{{"127.0.0.1", "127.0.0.2"}};
+    FRPC::Resolver_t resolver(config);
+    FRPC::ParallelConnector_t connector(FRPC::URL_t(url), 5000, false,
+                                        1000, &resolver);
+
+    for (int i = 0; i < 3; ++i) {
+        int fd = -1;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            connector.connectSocket(fd);
+        } catch (const FRPC::HTTPError_t &e) {
+            std::cerr << e.message() << std::endl;
+        }
+        // refused address does not wait for attemptDelay
+        TEST(std::chrono::steady_clock::now() - start
+             < std::chrono::milliseconds(500));
+        if (!TEST(fd >= 0)) continue;
+
+        struct sockaddr_storage peer;
+        socklen_t length = sizeof(peer);
+        TEST(!::getpeername(fd, reinterpret_cast<struct sockaddr*>(&peer),
+                            &length));
+        FRPC::Resolver_t::Address_t connected;
+        connected.family = peer.ss_family;
+        connected.length = length;
+        connected.address = peer;
+        TEST(ip(connected) == "127.0.0.2");
+        ::close(listener.accept());
+        ::close(fd);
+    }
+
+    // nothing accepts => the last error is reported
+    FRPC::Resolver_t::Config_t refused;
+    refused.lookup = StaticDns_t{{"127.0.0.1", "127.0.0.3"}};
+    FRPC::Resolver_t refusedResolver(refused);
+    FRPC::ParallelConnector_t failing(FRPC::URL_t(url), 5000, false, 1000,
+                                      &refusedResolver);
+    int fd = -1;
+    std::string error;
+    try {
+        failing.connectSocket(fd);
+    } catch (const FRPC::HTTPError_t &e) {
+        error = e.message();
+    }
+    TEST(fd < 0);
+    TEST(error.find("Cannot connect socket") != std::string::npos);
+}
+
+/** Headers of the request being served (set for handlers of TestServer_t).
+ */
+thread_local const FRPC::HTTPHeader_t *requestHeaders = nullptr;
+
+using Handler_t = std::function<FRPC::Value_t&(FRPC::Pool_t&,
+                                               FRPC::Array_t&)>;
+using Methods_t = std::map<std::string, Handler_t>;
+
+class FunctionMethod_t: public FRPC::Method_t {
+public:
+    explicit FunctionMethod_t(const Handler_t &handler): handler(handler) {}
+
+    FRPC::Value_t& call(FRPC::Pool_t &pool, FRPC::Array_t &params) override {
+        return handler(pool, params);
+    }
+
+private:
+    Handler_t handler;
+};
+
+/** Keep-alive FastRPC server on loopback, each connection has own thread.
+ */
+class TestServer_t {
+public:
+    explicit TestServer_t(const Methods_t &methods, unsigned short port = 0)
+        : connections(0), listener("http://127.0.0.1:"
+                                   + std::to_string(port)),
+          methods(methods), stopping(false), acceptor([this] { run(); })
+    {}
+
+    ~TestServer_t() {
+        // wake the acceptor up, connections end when clients close them
+        stopping = true;
+        int fd = connectTcp(listener.port());
+        if (fd >= 0) ::close(fd);
+        acceptor.join();
+        for (auto &worker: workers) worker.join();
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port()) + "/RPC2";
+    }
+
+    unsigned short port() const {
+        return listener.port();
+    }
+
+    std::atomic<int> connections;
+
+private:
+    void run() {
+        for (;;) {
+            std::string address;
+            int fd = -1;
+            try {
+                fd = listener.accept(&address);
+            } catch (const FRPC::HTTPError_t &) {
+                continue;
+            }
+            if (stopping) {
+                ::close(fd);
+                return;
+            }
+            ++connections;
+            workers.emplace_back([this, fd, address] {
+                serve(fd, address);
+            });
+        }
+    }
+
+    void serve(int fd, const std::string &address) {
+        FRPC::Server_t::Config_t config;
+        config.keepAlive = true;
+        config.maxKeepalive = 1000;
+        config.readTimeout = 1000;
+        FRPC::Server_t server(config);
+        for (const auto &method: methods) {
+            server.registry().registerMethod(
+                    method.first, new FunctionMethod_t(method.second));
+        }
+
+        FRPC::HTTPHeader_t headerIn;
+        FRPC::HTTPHeader_t headerOut;
+        requestHeaders = &headerIn;
+        try {
+            server.serve(fd, address, headerIn, headerOut);
+        } catch (const std::exception &) {}
+        requestHeaders = nullptr;
+        ::close(fd);
+    }
+
+    FRPC::Listener_t listener;
+    Methods_t methods;
+    std::atomic<bool> stopping;
+    std::vector<std::thread> workers;
+    std::thread acceptor;
+};
+
+/** Server answering method who by its index (after delay ms).
+ */
+Methods_t who(int index, int delay = 0) {
+    return {{"who", [=] (FRPC::Pool_t &pool, FRPC::Array_t &)
+                    -> FRPC::Value_t&
+             {
+                 if (delay) sleepMs(delay);
+                 return pool.Int(index);
+             }}};
+}
+
+int callInt(FRPC::ServerProxy_t &proxy, const std::string &method) {
+    FRPC::Pool_t pool;
+    return static_cast<int>(FRPC::Int(proxy.call(pool, method,
+                                                 pool.Array())));
+}
+
+FRPC::ServerProxy_t::Config_t balancing(unsigned int policy) {
+    FRPC::ServerProxy_t::Config_t config;
+    config.keepAlive = true;
+    config.balancePolicy = policy;
+    return config;
+}
+
+void testBalancing() {
+    using Config_t = FRPC::ServerProxy_t::Config_t;
+    {
+        TestServer_t s0(who(0)), s1(who(1)), s2(who(2));
+        FRPC::ServerProxy_t proxy({s0.url(), s1.url(), s2.url()},
+                                  balancing(Config_t::ROUND_ROBIN));
+        std::vector<int> order;
+        for (int i = 0; i < 6; ++i) order.push_back(callInt(proxy, "who"));
+        TEST(order == std::vector<int>({0, 1, 2, 0, 1, 2}));
+    }
+    {
+        // servers busy with a call are avoided
+        std::atomic<int> busy(-1);
+        auto methods = [&busy] (int index) {
+            Methods_t methods = who(index);
+            methods["slow"] = [&busy, index] (FRPC::Pool_t &pool,
+                                              FRPC::Array_t &)
+                -> FRPC::Value_t&
+            {
+                busy = index;
+                sleepMs(300);
+                return pool.Int(index);
+            };
+            return methods;
+        };
+        TestServer_t s0(methods(0)), s1(methods(1)), s2(methods(2));
+        Config_t config = balancing(Config_t::LEAST_OUTSTANDING);
+        config.threadSafe = true;
+        FRPC::ServerProxy_t proxy({s0.url(), s1.url(), s2.url()}, config);
+
+        int slow = -1;
+        std::thread caller([&] { slow = callInt(proxy, "slow"); });
+        for (int i = 0; (i < 100) && (busy < 0); ++i) sleepMs(1);
+        std::vector<int> order;
+        for (int i = 0; i < 6; ++i) order.push_back(callInt(proxy, "who"));
+        caller.join();
+        TEST(slow == busy);
+        TEST(std::count(order.begin(), order.end(), busy.load()) == 0);
+    }
+    {
+        // slow server is tried once, then its latency keeps calls away
+        TestServer_t s0(who(0, 30)), s1(who(1));
+        FRPC::ServerProxy_t proxy({s0.url(), s1.url()},
+                                  balancing(Config_t::POWER_OF_TWO_CHOICES));
+        std::vector<int> order;
+        for (int i = 0; i < 20; ++i) order.push_back(callInt(proxy, "who"));
+        TEST(std::count(order.begin(), order.end(), 0) == 1);
+        TEST(std::count(order.begin() + 2, order.end(), 1) == 18);
+    }
+}
+
+void testEjection() {
+    unsigned short port = 0;
+    {
+        FRPC::Listener_t listener("http://127.0.0.1:0");
+        port = listener.port();
+    }
+    std::string dead = "http://127.0.0.1:" + std::to_string(port) + "/RPC2";
+
+    TestServer_t s0(who(0));
+    FRPC::Pool_t pool;
+    FRPC::ServerProxy_t proxy({s0.url(), dead},
+                              pool.Struct("keepAlive", pool.Bool(true),
+                                          "ejectFailures", pool.Int(2),
+                                          "ejectTime", pool.Int(300)));
+    auto attempt = [&proxy] {
+        try {
+            return callInt(proxy, "who");
+        } catch (const FRPC::ProtocolError_t &) {
+            return -1;
+        }
+    };
+
+    // second failure in a row ejects the server
+    std::vector<int> order;
+    for (int i = 0; i < 10; ++i) order.push_back(attempt());
+    TEST(order == std::vector<int>({0, -1, 0, -1, 0, 0, 0, 0, 0, 0}));
+
+    // it is used again once ejectTime passes
+    TestServer_t s1(who(1), port);
+    sleepMs(350);
+    order.clear();
+    for (int i = 0; i < 4; ++i) order.push_back(attempt());
+    TEST(std::count(order.begin(), order.end(), -1) == 0);
+    TEST(std::count(order.begin(), order.end(), 1) == 2);
+}
+
+/** Server closing every connection without reading the request.
+ */
+class ResettingServer_t {
+public:
+    ResettingServer_t()
+        : listener("http://127.0.0.1:0"), stopping(false),
+          acceptor([this] {
+              for (;;) {
+                  int fd = -1;
+                  try {
+                      fd = listener.accept();
+                  } catch (const FRPC::HTTPError_t &) {
+                      continue;
+                  }
+                  ::close(fd);
+                  if (stopping) return;
+              }
+          })
+    {}
+
+    ~ResettingServer_t() {
+        stopping = true;
+        int fd = connectTcp(listener.port());
+        if (fd >= 0) ::close(fd);
+        acceptor.join();
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port()) + "/RPC2";
+    }
+
+    unsigned short port() const {
+        return listener.port();
+    }
+
+private:
+    FRPC::Listener_t listener;
+    std::atomic<bool> stopping;
+    std::thread acceptor;
+};
+
+/** Hedge and retry events logged by the proxies.
+ */
+struct CallEvent_t {
+    FRPC::LogEvent_t type;
+    unsigned short port;        // url of the event
+    unsigned short hedgePort;   // hedgeUrl of CALL_HEDGE
+};
+
+std::mutex callEventsMutex;
+std::vector<CallEvent_t> callEvents;
+
+void logCallEvents(FRPC::LogEvent_t type, FRPC::LogEventData_t &data,
+                   void *)
+{
+    switch (type) {
+    case FRPC::LogEvent_t::CALL_HEDGE:
+    case FRPC::LogEvent_t::CALL_RETRY:
+    case FRPC::LogEvent_t::CALL_RETRY_THROTTLED:
+        {
+            std::lock_guard<std::mutex> guard(callEventsMutex);
+            callEvents.push_back({type, data.callHedge.url->port,
+                                  (type == FRPC::LogEvent_t::CALL_HEDGE)
+                                  ? data.callHedge.hedgeUrl->port
+                                  : static_cast<unsigned short>(0)});
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+std::vector<CallEvent_t> takeCallEvents() {
+    std::lock_guard<std::mutex> guard(callEventsMutex);
+    std::vector<CallEvent_t> result;
+    result.swap(callEvents);
+    return result;
+}
+
+/** Error of proxy creation with the option, empty when created.
+ */
+std::string configError(const char *name, FRPC::Int_t::value_type value) {
+    FRPC::Pool_t pool;
+    try {
+        FRPC::ServerProxy_t proxy("http://127.0.0.1:1/RPC2",
+                                  pool.Struct(name, pool.Int(value)));
+    } catch (const FRPC::TypeError_t &e) {
+        return e.message();
+    }
+    return "";
+}
+
+void testProxyConfig() {
+    TEST(configError("balancePolicy", 2).empty());
+    TEST(configError("balancePolicy", 7)
+         == "Config option balancePolicy = 7 is out of range 0..2.");
+    TEST(configError("ejectFailures", 0).empty());
+    TEST(!configError("ejectFailures", -1).empty());
+    TEST(!configError("ejectTime", 1ll << 32).empty());
+    TEST(!configError("compressionThreshold", -1).empty());
+    TEST(!configError("maxRetries", -1).empty());
+    TEST(!configError("retryBudgetPercent", -1).empty());
+    TEST(!configError("retryBudgetBurst", -1).empty());
+}
+
+void testHedging() {
+    FRPC::setLoggerCallback(logCallEvents, nullptr);
+    std::atomic<bool> slow(false);
+    auto methods = [&slow] (int index) {
+        return Methods_t{{"who", [&slow, index] (FRPC::Pool_t &pool,
+                                                 FRPC::Array_t &)
+                                 -> FRPC::Value_t&
+                          {
+                              if (!index && slow) sleepMs(300);
+                              return pool.Int(index);
+                          }}};
+    };
+    TestServer_t s0(methods(0)), s1(methods(1));
+    FRPC::Pool_t pool;
+    const FRPC::Struct_t &config
+        = pool.Struct("keepAlive", pool.Bool(true),
+                      "hedgedMethods", pool.Array(pool.String("who")));
+
+    // single server has nobody to send the duplicate to
+    {
+        FRPC::ServerProxy_t proxy(std::vector<std::string>{s0.url()},
+                                  config);
+        for (int i = 0; i < 16; ++i) callInt(proxy, "who");
+        slow = true;
+        TEST(callInt(proxy, "who") == 0);
+        TEST(takeCallEvents().empty());
+        slow = false;
+    }
+
+    // slow call is answered by the other server
+    FRPC::ServerProxy_t proxy({s0.url(), s1.url()}, config);
+    for (int i = 0; i < 16; ++i) callInt(proxy, "who");
+    takeCallEvents();
+    slow = true;
+    auto start = std::chrono::steady_clock::now();
+    TEST(callInt(proxy, "who") == 1);
+    TEST(std::chrono::steady_clock::now() - start
+         < std::chrono::milliseconds(250));
+    auto events = takeCallEvents();
+    TEST(std::count_if(events.begin(), events.end(),
+                       [&] (const CallEvent_t &event) {
+                           return (event.type == FRPC::LogEvent_t::CALL_HEDGE)
+                               && (event.port == s0.port())
+                               && (event.hedgePort == s1.port());
+                       }) == 1);
+}
+
+void testRetries() {
+    FRPC::setLoggerCallback(logCallEvents, nullptr);
+    takeCallEvents();
+    ResettingServer_t reset;
+    TestServer_t s1(who(1));
+    FRPC::Pool_t pool;
+    FRPC::ServerProxy_t proxy(
+            {reset.url(), s1.url()},
+            pool.Struct("keepAlive", pool.Bool(true),
+                        "idempotentMethods", pool.Array(pool.String("who")),
+                        "maxRetries", pool.Int(1),
+                        "retryBudgetPercent", pool.Int(0),
+                        "retryBudgetBurst", pool.Int(1)));
+
+    // failed call is retried on the other server
+    TEST(callInt(proxy, "who") == 1);
+    auto events = takeCallEvents();
+    TEST((events.size() == 1)
+         && (events[0].type == FRPC::LogEvent_t::CALL_RETRY)
+         && (events[0].port == s1.port()));
+
+    // the only token of the budget is spent
+    bool failed = false;
+    try {
+        callInt(proxy, "who");
+    } catch (const FRPC::ProtocolError_t &) {
+        failed = true;
+    }
+    TEST(failed);
+    events = takeCallEvents();
+    TEST((events.size() == 1)
+         && (events[0].type == FRPC::LogEvent_t::CALL_RETRY_THROTTLED)
+         && (events[0].port == reset.port()));
+}
+
+void testSharedProxy() {
+    TestServer_t server({{"forwarded", [] (FRPC::Pool_t &pool,
+                                          FRPC::Array_t &) -> FRPC::Value_t&
+                          {
+                              std::string value;
+                              requestHeaders->get(
+                                      FRPC::HTTP_HEADER_X_FORWARDED_FOR,
+                                      value);
+                              return pool.String(value);
+                          }}});
+    FRPC::ServerProxy_t::Config_t config;
+    config.keepAlive = true;
+    config.threadSafe = true;
+    FRPC::ServerProxy_t proxy(server.url(), config);
+
+    // each thread sends the header it set, once
+    const int THREADS = 4;
+    const int CALLS = 20;
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&proxy, &wrong, t] {
+            std::string forwarded = "10.0.0." + std::to_string(t);
+            for (int i = 0; i < CALLS; ++i) {
+                FRPC::Pool_t pool;
+                if (i % 2) proxy.setForwardHeader(forwarded);
+                std::string value = FRPC::String(
+                        proxy.call(pool, std::string("forwarded"),
+                                   pool.Array()));
+                if (value != ((i % 2) ? forwarded : "")) ++wrong;
+            }
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    TEST(wrong == 0);
+
+    // connections are kept for the following calls
+    TEST((server.connections > 0) && (server.connections <= THREADS));
+}
+
+/** Server answering method header by value of the request header.
+ */
+Methods_t echoHeader(const std::string &name) {
+    return {{"header", [name] (FRPC::Pool_t &pool, FRPC::Array_t &)
+                       -> FRPC::Value_t&
+             {
+                 std::string value;
+                 requestHeaders->get(name, value);
+                 return pool.String(value);
+             }}};
+}
+
+std::string callString(FRPC::ServerProxy_t &proxy,
+                       const std::string &method)
+{
+    FRPC::Pool_t pool;
+    return FRPC::String(proxy.call(pool, method, pool.Array()));
+}
+
+void testCachedProxy() {
+    TestServer_t server(echoHeader(FRPC::HTTP_HEADER_CONTENT_ENCODING));
+    auto encoding = [&server] (bool useCompression) {
+        FRPC::ServerProxy_t::Config_t config;
+        config.keepAlive = true;
+        config.useCompression = useCompression;
+        config.compressionThreshold = 0;
+        FRPC::ServerProxy_t proxy(server.url(), config);
+        // codings accepted by the server are known after the first call
+        callString(proxy, "header");
+        return callString(proxy, "header");
+    };
+
+    // proxy taken from the cache uses compression of its own config
+    TEST(!encoding(true).empty());
+    TEST(encoding(false).empty());
+    TEST(!encoding(true).empty());
+    TEST(server.connections == 1);
+
+    // and its XML format
+    TestServer_t xmlServer(echoHeader(FRPC::HTTP_HEADER_CONTENT_LENGTH));
+    auto length = [&xmlServer] (bool compactXml) {
+        FRPC::ServerProxy_t::Config_t config;
+        config.keepAlive = true;
+        config.useBinary = FRPC::ServerProxy_t::Config_t::NEVER;
+        config.compactXml = compactXml;
+        FRPC::ServerProxy_t proxy(xmlServer.url(), config);
+        return std::stoi(callString(proxy, "header"));
+    };
+    int pretty = length(false);
+    TEST(length(true) < pretty);
+    TEST(length(false) == pretty);
+    TEST(xmlServer.connections == 1);
+}
+
+int main(int /*argc*/, char */*argv*/[]) {
+    // destroyed keep-alive proxies are kept for the following ones
+    ::setenv("FASTRPC_SERVER_PROXY_CACHE_TIMEOUT", "60", 1);
+
+    testListener();
+    testResolver();
+    testParallelConnector();
+    testBalancing();
+    testEjection();
+    testProxyConfig();
+    testHedging();
+    testRetries();
+    testSharedProxy();
+    testCachedProxy();
+    return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,19 +1,36 @@
 #include <string>
+#include <cmath>
 #include <limits>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <list>
+#include <thread>
 
 #include "frpc.h"
 #include "frpcwriter.h"
 #include "frpcvalue.h"
 #include "frpcarray.h"
+#include "frpcstruct.h"
 #include "frpcdatetime.h"
 #include "frpcpool.h"
 #include "frpcint.h"
 #include "frpcbinmarshaller.h"
 #include "frpcbinunmarshaller.h"
+#include "frpcunmarshaller.h"
 #include "frpctreefeeder.h"
 #include "frpctreebuilder.h"
+#include "frpcstring_view.h"
+#include "frpcbinaryref.h"
+#include "frpchash.h"
+#include "frpcinternals.h"
+#include "frpcxmlunmarshaller.h"
+#include "frpclocaltime.h"
+#include "frpccompression.h"
+#include "frpcstreamerror.h"
 
 size_t tests = 0;
 size_t fails = 0;
@@ -125,10 +142,745 @@ void testEncodeDecode(char major, char minor) {
     bum.finish();
 
     reviewValue(tb.getUnMarshaledData(), major, minor);
+
+    // the hash of the encoded data is the hash of decoded value
+    TEST(FRPC::hashBinary(sw.target.data(), sw.target.size())
+         == FRPC::hash(tb.getUnMarshaledData()));
+}
+
+void testHash() {
+    FRPC::Pool_t pool;
+    const std::string data = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+    // views have the same hash as the owning values
+    FRPC::Value_t &str = pool.String(data);
+    FRPC::Value_t &view = pool.StringView(data.data(), data.size());
+    TEST(FRPC::compare(str, view) == 0);
+    TEST(FRPC::hash(str) == FRPC::hash(view));
+
+    size_t chunk = 0;
+    FRPC::BinaryRefFeeder_t feeder = {
+        [&] { return data.size();},
+        [&] () -> FRPC::BinaryRefFeeder_t::Chunk_t {
+            // feed the data in 5 bytes long chunks
+            if (chunk >= data.size()) return {nullptr, 0};
+            size_t size = std::min<size_t>(5, data.size() - chunk);
+            auto *ptr = reinterpret_cast<const uint8_t *>(&data[chunk]);
+            chunk += size;
+            return {ptr, size};
+        }
+    };
+    FRPC::Value_t &bin = pool.Binary(data);
+    FRPC::Value_t &ref = pool.BinaryRef(feeder);
+    TEST(FRPC::compare(bin, ref) == 0);
+    chunk = 0;
+    TEST(FRPC::hash(bin) == FRPC::hash(ref));
+    TEST(FRPC::hash(bin) != FRPC::hash(str));
+
+    // equal values have equal hashes
+    TEST(FRPC::hash(pool.Double(0.0)) == FRPC::hash(pool.Double(-0.0)));
+    FRPC::Value_t &nan = pool.Double(std::nan(""));
+    FRPC::Value_t &otherNan = pool.Double(-std::nan("7"));
+    TEST(FRPC::compare(nan, otherNan) == 0);
+    TEST(FRPC::hash(nan) == FRPC::hash(otherNan));
+    TEST(FRPC::compare(nan, pool.Double(1.0)) > 0);
+    TEST(FRPC::compare(pool.Double(1.0), nan) < 0);
+    TEST(FRPC::hash(pool.Int(1)) != FRPC::hash(pool.Int(2)));
+    TEST(FRPC::hash(pool.Array(pool.Int(1), pool.Int(2)))
+         != FRPC::hash(pool.Array(pool.Int(2), pool.Int(1))));
+    TEST(FRPC::hash(pool.Struct("a", pool.Int(1), "b", pool.Int(2)))
+         == FRPC::hash(pool.Struct("b", pool.Int(2), "a", pool.Int(1))));
+    TEST(FRPC::hash(pool.Struct("a", pool.Int(1), "b", pool.Int(2)))
+         != FRPC::hash(pool.Struct("a", pool.Int(2), "b", pool.Int(1))));
+
+    // the hash is stable
+    TEST(FRPC::hash(pool.Int(1)) == 0x7b2075f90a671183ULL);
+
+    // struct member order in encoded data does not matter
+    // {"b": 2, "a": 1} as v2 method response
+    const char unordered[] = "\xCA\x11\x02\x01\x70\x50\x02"
+                             "\x01" "b" "\x38\x02"
+                             "\x01" "a" "\x38\x01";
+    TEST(FRPC::hashBinary(unordered, sizeof(unordered) - 1)
+         == FRPC::hash(pool.Struct("a", pool.Int(1), "b", pool.Int(2))));
+}
+
+std::string encode(FRPC::Value_t &value, const FRPC::ProtocolVersion_t &pv) {
+    StringWriter_t sw;
+    FRPC::BinMarshaller_t bm(sw, pv);
+    bm.packMethodResponse();
+    FRPC::TreeFeeder_t feeder(bm);
+    feeder.feedValue(value);
+    bm.flush();
+    return sw.target;
+}
+
+void testKeyDictionary() {
+    FRPC::Pool_t pool;
+
+    // more than 256 distinct keys switches to two bytes long indices
+    FRPC::Array_t &records = pool.Array();
+    for (int i = 0; i < 3; ++i) {
+        FRPC::Struct_t &record = pool.Struct();
+        for (int key = 0; key < 300; ++key)
+            record.append("key" + std::to_string(key), pool.Int(i + key));
+        records.append(record);
+    }
+
+    std::string plain = encode(records, FRPC::ProtocolVersion_t(3, 1));
+    std::string packed = encode(records, FRPC::ProtocolVersion_t(3, 2));
+    TEST(packed.size() < plain.size());
+
+    // the same value is decoded from both
+    FRPC::TreeBuilder_t tb(pool);
+    FRPC::BinUnMarshaller_t bum(tb);
+    bum.unMarshall(packed.data(), static_cast<uint32_t>(packed.size()),
+                   FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+    bum.finish();
+    TEST(bum.getProtocolVersion().versionMinor == 2);
+    TEST(FRPC::compare(records, tb.getUnMarshaledData()) == 0);
+    TEST(FRPC::hashBinary(packed.data(), packed.size())
+         == FRPC::hash(records));
+
+    // every message has its own dictionary
+    std::string again = encode(records, FRPC::ProtocolVersion_t(3, 2));
+    TEST(again == packed);
+}
+
+/** Tree builder building regular arrays from packed ones.
+ */
+class RegularTreeBuilder_t: public FRPC::TreeBuilder_t {
+public:
+    using FRPC::TreeBuilder_t::TreeBuilder_t;
+
+    void buildIntArray(std::vector<FRPC::Int_t::value_type> values) override {
+        DataBuilder_t::buildIntArray(std::move(values));
+    }
+
+    void buildDoubleArray(std::vector<double> values) override {
+        DataBuilder_t::buildDoubleArray(std::move(values));
+    }
+};
+
+void testPackedArrays() {
+    FRPC::Pool_t pool;
+
+    std::vector<FRPC::Int_t::value_type> ints;
+    for (int i = 0; i < 100000; ++i) ints.push_back((i % 2) ? -i : i * 1000);
+    std::vector<double> doubles = {0.5, -1.25, 1e300};
+
+    FRPC::Array_t &value = pool.Array(pool.IntArray(ints),
+                                      pool.DoubleArray(doubles));
+    FRPC::Array_t &regular = FRPC::Array(value.clone(pool));
+
+    std::string plain = encode(value, FRPC::ProtocolVersion_t(3, 2));
+    std::string packed = encode(value, FRPC::ProtocolVersion_t(3, 3));
+    TEST(packed.size() < plain.size());
+
+    // the packed arrays equal to regular ones
+    FRPC::TreeBuilder_t tb(pool);
+    FRPC::BinUnMarshaller_t bum(tb);
+    bum.unMarshall(packed.data(), static_cast<uint32_t>(packed.size()),
+                   FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+    bum.finish();
+    FRPC::Array_t &decoded = FRPC::Array(tb.getUnMarshaledData());
+    auto *decodedInts = dynamic_cast<FRPC::IntArray_t *>(&decoded[0]);
+    TEST(decodedInts && decodedInts->isPacked());
+    TEST(decodedInts && (decodedInts->values() == ints));
+    TEST(FRPC::hash(decoded) == FRPC::hash(value));
+    TEST(FRPC::hashBinary(packed.data(), packed.size())
+         == FRPC::hash(value));
+    TEST(FRPC::compare(regular, decoded) == 0);
+    TEST(FRPC::Int(FRPC::Array(decoded[0])[3]).getValue() == -3);
+    TEST(FRPC::Double(FRPC::Array(decoded[1])[2]).getValue() == 1e300);
+
+    // decoded tree is read by more threads at once through const accessors
+    FRPC::TreeBuilder_t shared(pool);
+    FRPC::BinUnMarshaller_t sharedBum(shared);
+    sharedBum.unMarshall(packed.data(), static_cast<uint32_t>(packed.size()),
+                         FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+    sharedBum.finish();
+    const FRPC::Array_t &tree = FRPC::Array(shared.getUnMarshaledData());
+    std::vector<FRPC::Int_t::value_type> sums(4, 0);
+    std::vector<std::size_t> counts(4, 0);
+    std::vector<std::thread> readers;
+    for (std::size_t i = 0; i < sums.size(); ++i) {
+        readers.emplace_back([&tree, &sums, &counts, i] {
+            for (auto *item: FRPC::Array(tree[0]))
+                sums[i] += FRPC::Int(*item).getValue();
+            for (auto *item: FRPC::Array(tree[1]))
+                counts[i] += FRPC::Double(*item).getValue() != 0;
+        });
+    }
+    for (auto &reader: readers) reader.join();
+    FRPC::Int_t::value_type sum = 0;
+    for (auto item: ints) sum += item;
+    TEST(std::count(sums.begin(), sums.end(), sum) == 4);
+    TEST(std::count(counts.begin(), counts.end(), doubles.size()) == 4);
+
+    // builder decides how the packed block is built
+    RegularTreeBuilder_t rtb(pool);
+    FRPC::BinUnMarshaller_t rbum(rtb);
+    rbum.unMarshall(packed.data(), static_cast<uint32_t>(packed.size()),
+                    FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+    rbum.finish();
+    FRPC::Array_t &built = FRPC::Array(rtb.getUnMarshaledData());
+    TEST(!dynamic_cast<FRPC::IntArray_t *>(&built[0]));
+    TEST(!dynamic_cast<FRPC::DoubleArray_t *>(&built[1]));
+    TEST(FRPC::compare(regular, built) == 0);
+
+    // modified array is not packed anymore
+    FRPC::IntArray_t &modified = pool.IntArray(ints);
+    modified.append(pool.Int(1));
+    TEST(!modified.isPacked());
+    TEST(modified.size() == ints.size() + 1);
+    FRPC::Array_t &wrapped = pool.Array(modified);
+    // the same encoding except the version in the header
+    TEST(encode(wrapped, FRPC::ProtocolVersion_t(3, 3)).substr(4)
+         == encode(wrapped, FRPC::ProtocolVersion_t(3, 2)).substr(4));
+}
+
+std::string xml(FRPC::Value_t &value, unsigned int type) {
+    StringWriter_t sw;
+    std::unique_ptr<FRPC::Marshaller_t> marshaller(
+        FRPC::Marshaller_t::create(type, sw, FRPC::ProtocolVersion_t()));
+    marshaller->packMethodResponse();
+    FRPC::TreeFeeder_t feeder(*marshaller);
+    feeder.feedValue(value);
+    marshaller->flush();
+    return sw.target;
+}
+
+std::string json(FRPC::Value_t &value) {
+    StringWriter_t sw;
+    FRPC::ProtocolVersion_t pv;
+    std::unique_ptr<FRPC::Marshaller_t> marshaller(
+        FRPC::Marshaller_t::create(FRPC::Marshaller_t::JSON, sw, pv));
+    FRPC::TreeFeeder_t feeder(*marshaller);
+    feeder.feedValue(value);
+    marshaller->flush();
+    return sw.target;
+}
+
+void testNumberFormatting() {
+    FRPC::Pool_t pool;
+
+    // doubles are written in the shortest form which parses back exactly
+    const double doubles[] = {0.1, 1.5, -2.0, 1e300, 5e-324, 1.0 / 3,
+                              std::numeric_limits<double>::max()};
+    for (double value: doubles) {
+        std::string text = json(pool.Double(value));
+        TEST(std::strtod(text.c_str(), nullptr) == value);
+    }
+    TEST(json(pool.Double(0.1)) == "0.1");
+    TEST(json(pool.Double(-2.0)) == "-2");
+
+    // plain notation in the range of the former %.17g output (XML-RPC
+    // double does not allow exponent), exponent outside of it
+    const struct { double value; const char *text; } notations[] = {
+        {1e5, "100000"}, {1e-4, "0.0001"}, {1e16, "10000000000000000"},
+        {0.1, "0.1"}, {1.23e8, "123000000"}, {-1.5e-3, "-0.0015"},
+        {0.0, "0"}, {1e17, "1e+17"}, {1.5e-5, "1.5e-05"}};
+    for (const auto &n: notations) {
+        TEST(json(pool.Double(n.value)) == n.text);
+        TEST(xml(pool.Double(n.value), FRPC::Marshaller_t::XML_RPC_COMPACT)
+             .find(std::string("<double>") + n.text + "</double>")
+             != std::string::npos);
+    }
+
+    TEST(json(pool.Int(std::numeric_limits<int64_t>::min()))
+         == "-9223372036854775808");
+    TEST(json(pool.Int(std::numeric_limits<int64_t>::max()))
+         == "9223372036854775807");
+    TEST(json(pool.Array(pool.Int(0), pool.Int(-1))) == "[0,-1]");
+
+    // same text as the allocating formatter
+    const struct { short year; char month, day, hour, min, sec; int tz; }
+    dates[] = {{2024, 2, 29, 23, 59, 59, 0},
+               {1970, 1, 1, 0, 0, 0, -3600},
+               {2100, 12, 31, 1, 2, 3, 19800},
+               {1600, 1, 1, 0, 0, 0, 45 * 60},
+               {12345, 1, 1, 0, 0, 0, 0}};
+    for (const auto &d: dates) {
+        char buffer[FRPC::ISO_DATETIME_BUFFER_SIZE];
+        unsigned int length = FRPC::formatISODateTime(
+            buffer, d.year, d.month, d.day, d.hour, d.min, d.sec, d.tz);
+        TEST(std::string(buffer, length)
+             == FRPC::getISODateTime(d.year, d.month, d.day,
+                                     d.hour, d.min, d.sec, d.tz));
+    }
+}
+
+struct ISODateTime_t {
+    short year;
+    char month, day, hour, minute, sec;
+    int timeZone;
+};
+
+ISODateTime_t parseISO(const std::string &text) {
+    ISODateTime_t result;
+    FRPC::parseISODateTime(text.data(), long(text.size()), result.year,
+                           result.month, result.day, result.hour,
+                           result.minute, result.sec, result.timeZone);
+    return result;
+}
+
+bool sameISO(const ISODateTime_t &parsed, short year, char month, char day,
+             char hour, char minute, char sec, int timeZone)
+{
+    return (parsed.year == year) && (parsed.month == month)
+        && (parsed.day == day) && (parsed.hour == hour)
+        && (parsed.minute == minute) && (parsed.sec == sec)
+        && (parsed.timeZone == timeZone);
+}
+
+void testISODateTime() {
+    // own layout, formatted text parses back
+    for (int tz: {0, -3600, 19800, -45 * 60, 23 * 3600 + 59 * 60}) {
+        std::string text = FRPC::getISODateTime(2024, 2, 29, 23, 59, 60, tz);
+        TEST(sameISO(parseISO(text), 2024, 2, 29, 23, 59, 60, tz));
+    }
+    TEST(sameISO(parseISO("00000000T00:00:00+0000"), 0, 0, 0, 0, 0, 0, 0));
+
+    // other forms of ISO 8601
+    TEST(sameISO(parseISO("2017-01-27T12:39:19.123+01:30"),
+                 2017, 1, 27, 12, 39, 19, -5400));
+    TEST(sameISO(parseISO(" 2017-01-27 12:39:19Z\n"),
+                 2017, 1, 27, 12, 39, 19, 0));
+    TEST(sameISO(parseISO("20170127t123919-0100"),
+                 2017, 1, 27, 12, 39, 19, 3600));
+    TEST(sameISO(parseISO("2016-01-02"), 2016, 1, 2, 0, 0, 0, 0));
+    TEST(sameISO(parseISO("2016-01-02T10"), 2016, 1, 2, 10, 0, 0, 0));
+    // extra characters leave the time zone unset
+    TEST(sameISO(parseISO("20170127T12:39:19+0100x"),
+                 2017, 1, 27, 12, 39, 19, 0));
+
+    const char *malformed[] = {
+        "", "x2017", "2017-", "2017-01-", "20171327T12:39:19+0000",
+        "20170132T12:39:19+0000", "20170127T24:39:19+0000",
+        "20170127T12:60:19+0000", "20170127T12:39:61+0000",
+        "20170127T12:39:19+2400", "20170127T12:39:19+0060",
+        "2017-13-01",
+    };
+    for (const char *text: malformed) {
+        bool failed = false;
+        try {
+            parseISO(text);
+        } catch (const FRPC::StreamError_t &) {
+            failed = true;
+        }
+        if (!TEST(failed)) std::cerr << "datetime: " << text << std::endl;
+    }
+}
+
+void testCompactXml() {
+    FRPC::Pool_t pool;
+    FRPC::Struct_t &value = pool.Struct();
+    value.append("items", makeTestValue(pool))
+         .append("empty", pool.Array(pool.Array(), pool.Struct()))
+         .append("name", pool.String("<a & b>"))
+         .append("data", pool.Binary(std::string(100, 'x')))
+         .append("nested", pool.Struct("ok", pool.Bool(true),
+                                       "ratio", pool.Double(0.25)));
+
+    std::string pretty = xml(value, FRPC::Marshaller_t::XML_RPC);
+    std::string compact = xml(value, FRPC::Marshaller_t::XML_RPC_COMPACT);
+    TEST(compact.size() < pretty.size());
+    TEST(compact.find_first_of("\r\n") == std::string::npos);
+
+    // without whitespace both formats are the same
+    std::string stripped;
+    for (char c: pretty)
+        if ((c != '\r') && (c != '\n')) stripped += c;
+    TEST(stripped == compact);
+
+    FRPC::TreeBuilder_t tb(pool);
+    std::unique_ptr<FRPC::UnMarshaller_t> unmarshaller(
+        FRPC::UnMarshaller_t::create(FRPC::UnMarshaller_t::XML_RPC, tb));
+    unmarshaller->unMarshall(compact.data(),
+                             static_cast<uint32_t>(compact.size()),
+                             FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+    unmarshaller->finish();
+    TEST(FRPC::compare(value, tb.getUnMarshaledData()) == 0);
+}
+
+std::string parseXml(const std::string &data, bool builtin, std::size_t chunk) {
+    FRPC::XmlUnMarshaller_t::useBuiltinTokenizer(builtin);
+    FRPC::Pool_t pool;
+    FRPC::TreeBuilder_t tb(pool);
+    std::unique_ptr<FRPC::UnMarshaller_t> unmarshaller(
+        FRPC::UnMarshaller_t::create(FRPC::UnMarshaller_t::XML_RPC, tb));
+    std::string result;
+    try {
+        for (std::size_t i = 0; i < data.size(); i += chunk) {
+            std::size_t size = std::min(chunk, data.size() - i);
+            unmarshaller->unMarshall(data.data() + i,
+                                     static_cast<uint32_t>(size),
+                                     FRPC::UnMarshaller_t::TYPE_ANY);
+        }
+        unmarshaller->finish();
+        if (tb.getUnMarshaledDataPtr())
+            FRPC::dumpFastrpcTree(tb.getUnMarshaledData(), result, -1);
+        else
+            result = tb.getUnMarshaledMethodName();
+    } catch (const FRPC::StreamError_t &e) {
+        result = "error: " + e.message();
+    }
+    FRPC::XmlUnMarshaller_t::useBuiltinTokenizer(true);
+    return result;
+}
+
+void testXmlTokenizer() {
+    FRPC::Pool_t pool;
+    FRPC::Struct_t &value = pool.Struct();
+    value.append("items", makeTestValue(pool))
+         .append("name", pool.String("<a & b> \"c\" 'd' \xc5\xbe"))
+         .append("data", pool.Binary(std::string(100, 'x')));
+
+    const std::string param = "<methodResponse><params><param><value>";
+    const std::string end = "</value></param></params></methodResponse>";
+    std::vector<std::string> docs = {
+        xml(value, FRPC::Marshaller_t::XML_RPC),
+        xml(value, FRPC::Marshaller_t::XML_RPC_COMPACT),
+        "<?xml version=\"1.0\"?>\n<methodCall><methodName>x.y</methodName>"
+        "<params><param><value><i4>1</i4></value></param></params>"
+        "</methodCall>",
+        "\xef\xbb\xbf<methodCall><methodName>x</methodName></methodCall>",
+        "<methodResponse><fault><value><struct><member><name>faultCode"
+        "</name><value><int>500</int></value></member><member><name>"
+        "faultString</name><value><string>x</string></value></member>"
+        "</struct></value></fault></methodResponse>",
+        param + "a&amp;&lt;&gt;&quot;&apos;&#65;&#x17E;b" + end,
+        param + "<![CDATA[<x>&amp;]]>" + end,
+        param + "a\rb\r\nc" + end,
+        param + "<nil/>" + end,
+        param + "<string a=\"1\" b='2'>x</string >" + end,
+        "<methodResponse><!-- a --><params/></methodResponse>\n<?pi x?>\n",
+        "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>"
+            + param + "\xe9" + end,
+        "<!DOCTYPE methodResponse [<!ENTITY e \"ent\">]>"
+            + param + "&e;" + end,
+        "<?xml version = '1.0'\tencoding=\"utf8\" standalone='yes' ?>"
+            + param + "x" + end,
+        "<?xml version=\"1.1\"?>" + param + "x" + end,
+        // malformed documents
+        "",
+        "<methodResponse>",
+        "<methodResponse></methodCall>",
+        "x<methodResponse/>",
+        "<methodResponse/>x",
+        "<methodResponse/><methodResponse/>",
+        param + "a&foo;b" + end,
+        param + "a&#1;b" + end,
+        param + "a\x01" "b" + end,
+        param + "a\xff" "b" + end,
+        param + "\xed\xa0\x80" + end,
+        param + "a]]>b" + end,
+        param + "a&lt" + end,
+        param + "<1a/>" + end,
+        param + "<a b='<'/>" + end,
+        param + "x</ value>" + end,
+        "<methodResponse><?xml version=\"1.0\"?></methodResponse>",
+        "<?xml?><methodResponse/>",
+        "<?xml ?><methodResponse/>",
+        "<?xml version=1.0?><methodResponse/>",
+        "<?xml version=\"2.0\"?><methodResponse/>",
+        "<?xml version=\"1.x\"?><methodResponse/>",
+        "<?xml version=\"1.0'?><methodResponse/>",
+        "<?xml encoding=\"UTF-8\"?><methodResponse/>",
+        "<?xml version=\"1.0\"encoding=\"UTF-8\"?><methodResponse/>",
+        "<?xml version=\"1.0\" version=\"1.0\"?><methodResponse/>",
+        "<?xml version=\"1.0\" foo=\"bar\"?><methodResponse/>",
+        "<?xml version=\"1.0\" encoding=\"\"?><methodResponse/>",
+        "<?xml version=\"1.0\" standalone=\"maybe\"?><methodResponse/>",
+        "<?xml version=\"1.0\" standalone=\"no\" encoding=\"UTF-8\"?>"
+            "<methodResponse/>",
+        "<methodResponse><!-- a -- b --></methodResponse>",
+        param + "<i4>x</i4>" + end,
+    };
+
+    for (const std::string &doc: docs) {
+        std::string expected = parseXml(doc, false, doc.size() + 1);
+        for (std::size_t chunk: {std::size_t(1), std::size_t(2),
+                                 std::size_t(3), std::size_t(7),
+                                 doc.size() + 1})
+        {
+            std::string result = parseXml(doc, true, chunk);
+            if (!TEST(result == expected)) {
+                std::cerr << "chunk " << chunk << ": " << result
+                          << " != " << expected << std::endl;
+            }
+        }
+    }
+}
+
+FRPC::Value_t &parseJson(FRPC::Pool_t &pool, const std::string &data,
+                         std::size_t chunk, std::string &method)
+{
+    FRPC::TreeBuilder_t tb(pool);
+    std::unique_ptr<FRPC::UnMarshaller_t> unmarshaller(
+        FRPC::UnMarshaller_t::create(FRPC::UnMarshaller_t::JSON, tb,
+                                     "/test/method"));
+    for (std::size_t i = 0; i < data.size(); i += chunk) {
+        std::size_t size = std::min(chunk, data.size() - i);
+        unmarshaller->unMarshall(data.data() + i,
+                                 static_cast<uint32_t>(size),
+                                 FRPC::UnMarshaller_t::TYPE_METHOD_CALL);
+    }
+    unmarshaller->finish();
+    method = tb.getUnMarshaledMethodName();
+    return tb.getUnMarshaledData();
+}
+
+void testJsonUnMarshaller() {
+    FRPC::Pool_t pool;
+    FRPC::Struct_t &value = pool.Struct();
+    value.append("ints", pool.Array(pool.Int(0), pool.Int(-1),
+                                    pool.Int(std::numeric_limits<int64_t>::min()),
+                                    pool.Int(std::numeric_limits<int64_t>::max())))
+         .append("doubles", pool.Array(pool.Double(0.5), pool.Double(-1e300),
+                                       pool.Double(1.0 / 3)))
+         .append("string", pool.String("a \"quoted\"\\ \x01\t\n\xc5\xbe"))
+         .append("empty", pool.Array(pool.Array(), pool.Struct(),
+                                     pool.String("")))
+         .append("other", pool.Array(pool.Bool(true), pool.Bool(false),
+                                     pool.Null()));
+
+    const struct {
+        std::string body;
+        FRPC::Array_t &params;
+    } calls[] = {
+        {"[" + json(value) + ", 1, \"x\"]",
+         pool.Array(value, pool.Int(1), pool.String("x"))},
+        {json(value), pool.Array(value)},
+        {" \r\n\t", pool.Array()},
+        {"", pool.Array()},
+        {"[ ]", pool.Array()},
+        {"[[]]", pool.Array(pool.Array())},
+        {"-0.0e+1", pool.Array(pool.Double(-0.0))},
+        {"[1E2, 2e-1, 10]",
+         pool.Array(pool.Double(100), pool.Double(0.2), pool.Int(10))},
+        {"\"\\u00e9\\ud83d\\ude00\\/\\b\\f\\r\\u0000\"",
+         pool.Array(pool.String(std::string("\xc3\xa9\xf0\x9f\x98\x80/\b\f\r\0",
+                                            11)))},
+    };
+
+    for (const auto &call: calls) {
+        for (std::size_t chunk: {std::size_t(1), std::size_t(2),
+                                 std::size_t(3), std::size_t(7),
+                                 call.body.size() + 1})
+        {
+            std::string method;
+            FRPC::Value_t &params = parseJson(pool, call.body, chunk, method);
+            TEST(method == "test.method");
+            if (!TEST(FRPC::compare(params, call.params) == 0))
+                std::cerr << "chunk " << chunk << ": " << call.body << std::endl;
+        }
+    }
+
+    const char *malformed[] = {
+        "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "{1:2}", "[01]", "[1.]",
+        "[.5]", "[1e]", "[-]", "[+1]", "[\"a]", "[tru]", "[nul", "[True]",
+        "[\"\\x\"]", "[\"\\ud800\"]", "[\"\\udc00\"]", "[\"\\u12g4\"]",
+        "[1] 2", "1 2", "[99999999999999999999]", "[1e999]", "[", "{\"a\":1",
+        "[\"a\x01\"]", "]", "[}", "{]",
+    };
+    for (const char *body: malformed) {
+        for (std::size_t chunk: {std::size_t(1), std::size_t(3),
+                                 std::strlen(body)})
+        {
+            bool failed = false;
+            try {
+                std::string method;
+                parseJson(pool, body, chunk, method);
+            } catch (const FRPC::StreamError_t &) {
+                failed = true;
+            }
+            if (!TEST(failed))
+                std::cerr << "chunk " << chunk << ": " << body << std::endl;
+        }
+    }
+}
+
+bool sameTm(const struct tm &first, const struct tm &second) {
+    return (first.tm_year == second.tm_year) && (first.tm_mon == second.tm_mon)
+        && (first.tm_mday == second.tm_mday)
+        && (first.tm_hour == second.tm_hour)
+        && (first.tm_min == second.tm_min) && (first.tm_sec == second.tm_sec)
+        && (first.tm_wday == second.tm_wday)
+        && (first.tm_yday == second.tm_yday)
+        && (first.tm_isdst == second.tm_isdst)
+        && (first.tm_gmtoff == second.tm_gmtoff);
+}
+
+void testLocalTime() {
+    for (int64_t days = -800000; days < 800000; days += 997) {
+        int64_t year;
+        unsigned int month, day;
+        FRPC::civilFromDays(days, year, month, day);
+        TEST(FRPC::daysFromCivil(year, month, day) == days);
+    }
+
+    std::vector<time_t> times;
+    // every ~11 days during the years in the table and around
+    for (time_t t = -2300000000LL; t < 7400000000LL; t += 999999)
+        times.push_back(t);
+    // every minute around daylight saving time changes
+    for (time_t change: {1774746000, 1792890000, 2140045200}) {
+        for (time_t t = change - 7200; t < change + 7200; t += 60)
+            times.push_back(t);
+    }
+
+    for (time_t t: times) {
+        struct tm expected = {}, result = {};
+        localtime_r(&t, &expected);
+        TEST(FRPC::localTime(t, result) && sameTm(result, expected));
+
+        // local time and its neighbours, some not normalized
+        for (int shift: {0, 1, -1, 1800, -1800, 3600, -3600}) {
+            struct tm local = expected;
+            local.tm_sec += shift;
+            local.tm_isdst = -1;
+            struct tm expectedLocal = local;
+            time_t expectedTime = mktime(&expectedLocal);
+            if (!TEST(FRPC::makeTime(local) == expectedTime
+                      && sameTm(local, expectedLocal)))
+            {
+                std::cerr << "time " << t << " shifted by " << shift
+                          << std::endl;
+            }
+        }
+    }
+
+    struct tm odd = {};
+    odd.tm_year = 2025 - 1900;
+    odd.tm_mon = 14;
+    odd.tm_mday = 0;
+    odd.tm_sec = -1;
+    odd.tm_isdst = -1;
+    struct tm expected = odd;
+    TEST(FRPC::makeTime(odd) == mktime(&expected) && sameTm(odd, expected));
+}
+
+std::string encodeResponse(FRPC::Value_t &value) {
+    StringWriter_t sw;
+    FRPC::BinMarshaller_t bm(sw, FRPC::ProtocolVersion_t(3, 0));
+    bm.packMethodResponse();
+    FRPC::TreeFeeder_t feeder(bm);
+    feeder.feedValue(value);
+    bm.flush();
+    return sw.target;
+}
+
+/** Decompresses data fed in pieces of given size, returns the decoded value
+ *  or nullptr when the decompressor or unmarshaller throws.
+ */
+FRPC::Value_t *decompressResponse(FRPC::Pool_t &pool, unsigned int encoding,
+                                  const std::string &data, std::size_t piece,
+                                  std::size_t sizeLimit
+                                      = FRPC::DECOMPRESSED_SIZE_LIMIT)
+{
+    FRPC::TreeBuilder_t tb(pool);
+    FRPC::BinUnMarshaller_t bum(tb);
+    FRPC::Decompressor_t decompressor(encoding, sizeLimit);
+    try {
+        for (std::size_t i = 0; i < data.size(); i += piece) {
+            decompressor.decompress(
+                    data.data() + i, std::min(piece, data.size() - i), bum,
+                    FRPC::UnMarshaller_t::TYPE_METHOD_RESPONSE);
+        }
+        decompressor.finish();
+        bum.finish();
+    } catch (const FRPC::StreamError_t &) {
+        return nullptr;
+    }
+    return &tb.getUnMarshaledData();
+}
+
+void testCompression() {
+    FRPC::Pool_t pool;
+    FRPC::Array_t &value = pool.Array();
+    for (int i = 0; i < 1000; ++i)
+        value.append(pool.Struct("id", pool.Int(i), "name", pool.String("x")));
+    std::string plain = encodeResponse(value);
+
+    for (unsigned int encoding: {FRPC::ENCODING_GZIP,
+                                 FRPC::ENCODING_DEFLATE})
+    {
+        // compress in two parts through the body storage
+        FRPC::Compressor_t compressor(encoding);
+        std::list<std::string> storage{plain.substr(0, 100)};
+        std::string compressed;
+        compressor.compress(storage, false);
+        compressed += storage.front();
+        storage.front() = plain.substr(100);
+        compressor.compress(storage, true);
+        compressed += storage.front();
+        TEST(compressed.size() < plain.size() / 4);
+
+        // whole and byte by byte input
+        for (std::size_t piece: {compressed.size(), std::size_t(1)}) {
+            FRPC::Value_t *decoded
+                = decompressResponse(pool, encoding, compressed, piece);
+            TEST(decoded && (FRPC::compare(*decoded, value) == 0));
+        }
+
+        // truncated stream, trailing garbage and corrupted data
+        TEST(!decompressResponse(pool, encoding,
+                                 compressed.substr(0, compressed.size() - 5),
+                                 compressed.size()));
+        TEST(!decompressResponse(pool, encoding, compressed + "x",
+                                 compressed.size() + 1));
+        std::string corrupted(compressed);
+        corrupted[corrupted.size() / 2] ^= 0x55;
+        TEST(!decompressResponse(pool, encoding, corrupted, 16));
+
+        // decompressed size is limited
+        TEST(!decompressResponse(pool, encoding, compressed, 16,
+                                 plain.size() - 1));
+        TEST(decompressResponse(pool, encoding, compressed, 16,
+                                plain.size()));
+    }
+
+    TEST(FRPC::decompressedSizeLimit(-1) == FRPC::DECOMPRESSED_SIZE_LIMIT);
+    TEST(FRPC::decompressedSizeLimit(1000) == 32000);
+
+    TEST(FRPC::parseContentEncoding(" GZIP ") == FRPC::ENCODING_GZIP);
+    TEST(FRPC::parseContentEncoding("identity") == FRPC::ENCODING_IDENTITY);
+    TEST(FRPC::parseContentEncoding("br") == -1);
+
+    TEST(FRPC::parseAcceptEncoding("") == FRPC::ENCODING_IDENTITY);
+    TEST(FRPC::parseAcceptEncoding("gzip, deflate")
+         == (FRPC::ENCODING_GZIP | FRPC::ENCODING_DEFLATE));
+    TEST(FRPC::parseAcceptEncoding("br;q=1.0, Deflate ;q=0.5")
+         == FRPC::ENCODING_DEFLATE);
+    TEST(FRPC::parseAcceptEncoding("*, gzip;q=0") == FRPC::ENCODING_DEFLATE);
+    TEST(FRPC::parseAcceptEncoding("*;q=0") == FRPC::ENCODING_IDENTITY);
+    TEST(FRPC::parseAcceptEncoding("gzip;q=0, x-gzip;q=0.000")
+         == FRPC::ENCODING_IDENTITY);
+    TEST(FRPC::chooseContentEncoding(FRPC::ENCODING_DEFLATE
+                                     | FRPC::ENCODING_GZIP)
+         == FRPC::ENCODING_GZIP);
 }
 
 int main(int /*argc*/, char */*argv*/[]) {
+    // central european time, no time zone database needed
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+
     testEncodeDecode(2, 1);
     testEncodeDecode(3, 1);
+    testEncodeDecode(3, 2);
+    testEncodeDecode(3, 3);
+    testHash();
+    testKeyDictionary();
+    testPackedArrays();
+    testNumberFormatting();
+    testISODateTime();
+    testCompactXml();
+    testXmlTokenizer();
+    testJsonUnMarshaller();
+    testLocalTime();
+    testCompression();
     return fails ? EXIT_FAILURE : EXIT_SUCCESS;
 }